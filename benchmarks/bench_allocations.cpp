@@ -0,0 +1,184 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+/**
+    Measures heap allocations per request. Global operator new is replaced to count
+    allocations of the whole process, the client uses plain sockets and allocates nothing
+    while requests are measured.
+
+    Usage: cpp-restify-bench-allocations [backend] [requests]
+        backend     mongoose or epoll. Defaults to epoll when available.
+*/
+
+#include <restify/server.h>
+#include <restify/request.h>
+#include <restify/response.h>
+#include <restify/helpers.h>
+#include "restify_build_config.h"
+#ifdef CPPRESTIFY_WITH_EPOLL
+#include <restify/epoll/epoll_backend.h>
+#endif
+#include <json/json.h>
+
+#include <atomic>
+#include <new>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+static std::atomic<uint64_t> allocations(0);
+
+void *operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size > 0 ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+static const int Port = 8091;
+
+static int connectToServer() {
+    const int s = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (s < 0)
+        return -1;
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(Port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(s);
+        return -1;
+    }
+    return s;
+}
+
+/** Send request and read a response framed by Content-Length. */
+static bool roundTrip(int s, const char *request, size_t length) {
+    if (::send(s, request, length, 0) != (ssize_t)length)
+        return false;
+
+    char buffer[4096];
+    size_t size = 0;
+    while (size < sizeof(buffer)) {
+        const ssize_t n = ::recv(s, buffer + size, sizeof(buffer) - size, 0);
+        if (n <= 0)
+            return false;
+        size += (size_t)n;
+
+        const char *end = static_cast<const char*>(memmem(buffer, size, "\r\n\r\n", 4));
+        if (!end)
+            continue;
+
+        const char *cl = static_cast<const char*>(memmem(buffer, end - buffer, "Content-Length: ", 16));
+        const size_t headLength = end + 4 - buffer;
+        const size_t bodyLength = cl ? (size_t)strtoul(cl + 16, nullptr, 10) : 0;
+        if (size >= headLength + bodyLength)
+            return true;
+    }
+    return false;
+}
+
+struct Scenario {
+    const char *name;
+    const char *request;
+    bool keepAlive;
+};
+
+int main(int argc, char **argv) {
+#ifdef CPPRESTIFY_WITH_EPOLL
+    const std::string backend = argc > 1 ? argv[1] : "epoll";
+#else
+    const std::string backend = argc > 1 ? argv[1] : "mongoose";
+#endif
+    const int requests = argc > 2 ? atoi(argv[2]) : 10000;
+
+    restify::Server server;
+#ifdef CPPRESTIFY_WITH_EPOLL
+    if (backend == "epoll")
+        server.setBackend(std::make_shared<restify::EpollBackend>());
+#endif
+    server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:" + std::to_string(Port))
+        ("backend.num_threads", 1)
+    );
+    server.route(restify::json()("path", "/text"), [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("ok");
+        return true;
+    });
+    server.route(restify::json()("path", "/json"), [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody(restify::json()("id", 42)("name", "restify"));
+        return true;
+    });
+    server.route(restify::json()("path", "/items/:id")("methods", "POST"), [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody(req.getBody());
+        return true;
+    });
+    server.start();
+
+    static const Scenario scenarios[] = {
+        { "text", "GET /text HTTP/1.1\r\nHost: localhost\r\n\r\n", true },
+        { "json", "GET /json HTTP/1.1\r\nHost: localhost\r\n\r\n", true },
+        { "post-json", "POST /items/42 HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\nContent-Length: 35\r\n\r\n{\"value\": 3, \"name\": \"a long name\"}", true },
+        { "new-connection", "GET /json HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n", false },
+    };
+
+    for (const Scenario &sc : scenarios) {
+        const size_t length = strlen(sc.request);
+        int s = -1;
+        bool ok = true;
+        uint64_t before = 0;
+
+        // First requests warm up caches and pools.
+        const int warmup = 100;
+        for (int i = 0; ok && i < warmup + requests; ++i) {
+            if (i == warmup)
+                before = allocations.load();
+            if (s < 0)
+                s = connectToServer();
+            ok = s >= 0 && roundTrip(s, sc.request, length);
+            if (!sc.keepAlive) {
+                ::close(s);
+                s = -1;
+            }
+        }
+        const uint64_t total = allocations.load() - before;
+        if (s >= 0)
+            ::close(s);
+
+        if (!ok) {
+            printf("backend=%s scenario=%s failed\n", backend.c_str(), sc.name);
+            continue;
+        }
+        printf("backend=%s scenario=%s requests=%d allocations/request=%.2f\n",
+            backend.c_str(), sc.name, requests, (double)total / requests);
+    }
+
+    server.stop();
+    return 0;
+}
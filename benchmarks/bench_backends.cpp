@@ -0,0 +1,177 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+/**
+    Compares backends on the same handler set. Every client keeps one connection
+    alive and cycles through a small text response, a JSON document and a 64 KB
+    body, so parsing, dispatch and sending all take part.
+
+    Usage: cpp-restify-bench-backends [backend] [seconds] [clients] [server threads]
+        backend     mongoose, epoll or io_uring. Defaults to mongoose.
+*/
+
+#include <restify/server.h>
+#include <restify/request.h>
+#include <restify/response.h>
+#include <restify/helpers.h>
+#include <json/json.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+static const int Port = 8090;
+static const size_t LargeSize = 64 * 1024;
+
+static const char *const Requests[] = {
+    "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n",
+    "GET /json?name=bench HTTP/1.1\r\nHost: localhost\r\n\r\n",
+    "GET /large HTTP/1.1\r\nHost: localhost\r\n\r\n",
+};
+
+/** Keep-alive client reading responses by their Content-Length. */
+class Client {
+public:
+    Client() : _socket(::socket(AF_INET, SOCK_STREAM, 0)) {
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(Port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int one = 1;
+        setsockopt(_socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        _connected = ::connect(_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+
+    ~Client() {
+        ::close(_socket);
+    }
+
+    bool request(const char *request) {
+        const size_t length = strlen(request);
+        if (!_connected || ::send(_socket, request, length, MSG_NOSIGNAL) != (ssize_t)length)
+            return false;
+
+        // Read the head, then the rest of the body.
+        size_t headEnd;
+        while ((headEnd = _input.find("\r\n\r\n")) == std::string::npos) {
+            if (!fill())
+                return false;
+        }
+        const size_t field = _input.find("Content-Length: ");
+        if (field == std::string::npos || field > headEnd)
+            return false;
+        const size_t total = headEnd + 4 + (size_t)atol(_input.c_str() + field + 16);
+        while (_input.size() < total) {
+            if (!fill())
+                return false;
+        }
+        const bool ok = _input.compare(0, 12, "HTTP/1.1 200") == 0;
+        _input.erase(0, total);
+        return ok;
+    }
+
+private:
+    bool fill() {
+        char buffer[16384];
+        const ssize_t n = ::recv(_socket, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+            return false;
+        _input.append(buffer, (size_t)n);
+        return true;
+    }
+
+    int _socket;
+    bool _connected;
+    std::string _input;
+};
+
+int main(int argc, char **argv) {
+    const std::string backend = argc > 1 ? argv[1] : "mongoose";
+    const int seconds = argc > 2 ? atoi(argv[2]) : 3;
+    const int clients = argc > 3 ? atoi(argv[3]) : 8;
+    const int serverThreads = argc > 4 ? atoi(argv[4]) : 8;
+
+    restify::Server server;
+    server.setConfig(
+        restify::json()
+        ("backend.type", backend)
+        ("backend.listening_ports", "127.0.0.1:" + std::to_string(Port))
+        ("backend.num_threads", serverThreads)
+    );
+
+    const std::string large(LargeSize, 'x');
+    server.route(restify::json()("path", "/hello"), [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    server.route(restify::json()("path", "/json"), [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody(restify::json()("name", req.getParam("name"))("values", restify::json()("a", 1)("b", 2)));
+        return true;
+    });
+    server.route(restify::json()("path", "/large"), [&large](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody(large);
+        return true;
+    });
+    server.start();
+
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> completed(0);
+    std::atomic<uint64_t> failed(0);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; ++i) {
+        threads.emplace_back([&, i]() {
+            Client client;
+            size_t next = (size_t)i;
+            uint64_t n = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                if (!client.request(Requests[next++ % 3])) {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                    break;
+                }
+                ++n;
+            }
+            completed.fetch_add(n, std::memory_order_relaxed);
+        });
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    done = true;
+    for (auto &t : threads)
+        t.join();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const Json::Value stats = server.getStatistics()["backend"];
+    server.stop();
+
+    printf("backend=%s clients=%d server_threads=%d requests/s=%.0f failed=%llu",
+        backend.c_str(), clients, serverThreads, completed.load() / elapsed, (unsigned long long)failed.load());
+    if (stats.isMember("io_uring") && completed.load() > 0) {
+        const Json::Value &uring = stats["io_uring"];
+        printf(" enters/request=%.2f zero_copy_sends=%llu/%llu",
+            uring["enters"].asUInt64() / (double)completed.load(),
+            (unsigned long long)uring["zeroCopySends"].asUInt64(), (unsigned long long)uring["sends"].asUInt64());
+    }
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,116 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+/**
+    Measures new connections per second. Every request is sent on a fresh
+    TCP connection with Connection: close, so accepting and handing off 
+    sockets dominates.
+
+    Usage: cpp-restify-bench-connections [backend] [seconds] [clients] [server threads]
+        backend     mongoose, epoll or io_uring. Defaults to mongoose.
+*/
+
+#include <restify/server.h>
+#include <restify/request.h>
+#include <restify/response.h>
+#include <restify/helpers.h>
+#include <json/json.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+static const int Port = 8090;
+
+static bool requestOnNewConnection() {
+    const int s = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (s < 0)
+        return false;
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(Port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    bool ok = ::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+
+    static const char request[] = "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    ok = ok && ::send(s, request, sizeof(request) - 1, 0) == (ssize_t)(sizeof(request) - 1);
+
+    // Read until the server closes.
+    char buffer[1024];
+    size_t total = 0;
+    ssize_t n;
+    while (ok && (n = ::recv(s, buffer, sizeof(buffer), 0)) > 0)
+        total += (size_t)n;
+
+    ::close(s);
+    return ok && total > 0;
+}
+
+int main(int argc, char **argv) {
+    const std::string backend = argc > 1 ? argv[1] : "mongoose";
+    const int seconds = argc > 2 ? atoi(argv[2]) : 3;
+    const int clients = argc > 3 ? atoi(argv[3]) : 8;
+    const int serverThreads = argc > 4 ? atoi(argv[4]) : 8;
+
+    restify::Server server;
+    server.setConfig(
+        restify::json()
+        ("backend.type", backend)
+        ("backend.listening_ports", "127.0.0.1:" + std::to_string(Port))
+        ("backend.num_threads", serverThreads)
+    );
+    server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("ok");
+        return true;
+    });
+    server.start();
+
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> completed(0);
+    std::atomic<uint64_t> failed(0);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; ++i) {
+        threads.emplace_back([&]() {
+            while (!done.load(std::memory_order_relaxed)) {
+                if (requestOnNewConnection())
+                    completed.fetch_add(1, std::memory_order_relaxed);
+                else
+                    failed.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    done = true;
+    for (auto &t : threads)
+        t.join();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    server.stop();
+
+    printf("backend=%s clients=%d server_threads=%d connections/s=%.0f failed=%llu\n",
+        backend.c_str(), clients, serverThreads, completed.load() / elapsed, (unsigned long long)failed.load());
+    return 0;
+}
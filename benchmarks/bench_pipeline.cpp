@@ -0,0 +1,106 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+/**
+    Measures requests per second through the request pipeline alone: parsing, header and 
+    body readers, router, handler and response writer. Requests are fed through a loopback
+    backend on keep-alive connections, no sockets are involved.
+
+    Usage: cpp-restify-bench-pipeline [seconds] [threads]
+*/
+
+#include <restify/server.h>
+#include <restify/request.h>
+#include <restify/response.h>
+#include <restify/helpers.h>
+#include <restify/loopback/loopback_backend.h>
+#include <json/json.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+
+struct Scenario {
+    const char *name;
+    const char *request;
+};
+
+int main(int argc, char **argv) {
+    const int seconds = argc > 1 ? atoi(argv[1]) : 2;
+    const int numThreads = argc > 2 ? atoi(argv[2]) : 1;
+
+    std::shared_ptr<restify::LoopbackBackend> backend = std::make_shared<restify::LoopbackBackend>();
+
+    restify::Server server;
+    server.setBackend(backend);
+    server.route(restify::json()("path", "/text"), [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("ok");
+        return true;
+    });
+    server.route(restify::json()("path", "/json"), [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody(restify::json()("id", 42)("name", "restify"));
+        return true;
+    });
+    server.route(restify::json()("path", "/items/:id")("methods", "POST"), [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody(req.getBody());
+        return true;
+    });
+    server.start();
+
+    static const Scenario scenarios[] = {
+        { "text", "GET /text HTTP/1.1\r\nHost: localhost\r\n\r\n" },
+        { "json", "GET /json HTTP/1.1\r\nHost: localhost\r\n\r\n" },
+        { "post-json", "POST /items/42 HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\nContent-Length: 35\r\n\r\n{\"value\": 3, \"name\": \"a long name\"}" },
+    };
+
+    for (const Scenario &sc : scenarios) {
+        const size_t length = strlen(sc.request);
+        std::atomic<bool> done(false);
+        std::atomic<uint64_t> completed(0);
+        std::atomic<uint64_t> failed(0);
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < numThreads; ++i) {
+            threads.emplace_back([&]() {
+                std::unique_ptr<restify::LoopbackConnection> c = backend->connect();
+                std::string response;
+                uint64_t n = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    response.clear();
+                    if (backend->exchange(*c, sc.request, length, response) && !response.empty())
+                        ++n;
+                    else
+                        failed.fetch_add(1, std::memory_order_relaxed);
+                }
+                completed.fetch_add(n, std::memory_order_relaxed);
+            });
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        done = true;
+        for (auto &t : threads)
+            t.join();
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        printf("scenario=%s threads=%d requests/s=%.0f ns/request=%.0f failed=%llu\n",
+            sc.name, numThreads, completed.load() / elapsed, elapsed * 1e9 * numThreads / std::max<uint64_t>(1, completed.load()),
+            (unsigned long long)failed.load());
+    }
+
+    server.stop();
+    return 0;
+}
@@ -0,0 +1,86 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_ADMISSION_CONTROL_H
+#define CPP_RESTIFY_ADMISSION_CONTROL_H
+
+#include <restify/interface.h>
+#include <restify/non_copyable.h>
+#include <json/json-forwards.h>
+#include <memory>
+#include <string>
+#include <cstddef>
+
+namespace restify {
+
+    /**
+        Bounds the load a backend accepts. Connections waiting for a worker and requests being
+        processed are counted, excess load is shed with a pre-rendered 503 response carrying
+        Retry-After instead of queueing invisibly in the socket queue and the kernel backlog.
+
+        Backends read their limits from these options, zero disables a limit
+            max_in_flight       Maximum number of requests processed concurrently. Defaults to 0.
+            max_queued          Maximum number of accepted connections waiting for a worker. Defaults to 0.
+            max_queue_wait_ms   Maximum time in milliseconds a connection may wait for a worker. Defaults to 0.
+            retry_after         Seconds announced in Retry-After of rejections. Defaults to 1.
+    */
+    class CPPRESTIFY_INTERFACE AdmissionControl : NonCopyable {
+    public:
+        struct Limits {
+            size_t maxInFlight;
+            size_t maxQueued;
+            double maxQueueWait;
+            int retryAfter;
+
+            Limits();
+
+            /** Read limits from backend options. */
+            static Limits fromConfig(const Json::Value &config);
+        };
+
+        AdmissionControl(const Limits &limits = Limits());
+        ~AdmissionControl();
+
+        /** Replace limits and reset counters. Not to be called while the backend runs. */
+        void setLimits(const Limits &limits);
+        const Limits &getLimits() const;
+
+        /** Add default options to backend configuration. */
+        static void addDefaultOptions(Json::Value &config);
+
+        /** Remove admission options from backend configuration. */
+        static void removeOptions(Json::Value &config);
+
+        /** Account connection entering the queue. False if the queue is full and the connection is to be rejected. */
+        bool enterQueue();
+
+        /** Account connection leaving the queue after waiting ms milliseconds. False if it waited too long and is to be rejected. */
+        bool leaveQueue(double waited);
+
+        /** Account request starting. False if too many requests are in flight and the request is to be rejected. */
+        bool beginRequest();
+
+        /** Account request started by a successful beginRequest having finished. */
+        void endRequest();
+
+        /** Complete 503 response to send to rejected clients. The connection is to be closed afterwards. */
+        const std::string &getRejection() const;
+
+        /** Counters as Json. */
+        Json::Value getStatistics() const;
+
+    private:
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+}
+
+#endif
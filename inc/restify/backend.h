@@ -16,6 +16,8 @@
 #include <restify/non_copyable.h>
 #include <json/json-forwards.h>
 #include <memory>
+#include <vector>
+#include <cstddef>
 
 namespace restify {
 
@@ -35,6 +37,30 @@ namespace restify {
         virtual bool stop() = 0;
         virtual bool setRequestCallback(const BackendRequestHandler &handler) = 0;
 
+        /** 
+            Set handler of WebSocket upgrade requests. Returns false when the backend does not support
+            WebSocket, which the default implementation does. Upgrade requests are then served like 
+            any other request.
+        */
+        virtual bool setWebSocketCallback(const BackendWebSocketHandler &handler);
+
+        /** Return runtime statistics of the backend. Default implementation returns null. */
+        virtual Json::Value getStatistics() const;
+
+        /** 
+            Stop accepting connections and close open ones once their current request is answered. 
+            Returns false when draining is not supported, which the default implementation does.
+        */
+        virtual bool beginDrain();
+
+        /** Number of accepted connections not yet closed. Default implementation returns 0. */
+        virtual size_t getOpenConnectionCount() const;
+
+        /** 
+            Descriptors of the listening sockets, e.g. to hand them to a successor process through 
+            ListenerHandoff. Valid while running and not draining. Default implementation returns none.
+        */
+        virtual std::vector<int> getListeningSockets() const;
     };
 
    
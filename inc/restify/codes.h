@@ -11,33 +11,91 @@
 #ifndef CPP_RESTIFY_CODES_H
 #define CPP_RESTIFY_CODES_H
 
+#include <restify/interface.h>
+#include <cstddef>
 
 namespace restify {
     
+    /** HTTP status codes as registered with IANA. */
     enum class StatusCode {
-        Ok                  = 200,
-        Created             = 201,
-        Accepted            = 202,
-        NoContent           = 204,
-        
-        Moved               = 301,
-        Found               = 302,
-        SeeOther            = 303,
-        
-        
-        BadRequest          = 400,
-        Unauthorized        = 401,
-        Forbidden           = 403,
-        NotFound            = 404,
-        MethodNotAllowed    = 405,
-        NotAcceptable       = 406,
+        Continue                        = 100,
+        SwitchingProtocols              = 101,
+        Processing                      = 102,
+        EarlyHints                      = 103,
+
+        Ok                              = 200,
+        Created                         = 201,
+        Accepted                        = 202,
+        NonAuthoritativeInformation     = 203,
+        NoContent                       = 204,
+        ResetContent                    = 205,
+        PartialContent                  = 206,
+        MultiStatus                     = 207,
+        AlreadyReported                 = 208,
+        IMUsed                          = 226,
         
+        MultipleChoices                 = 300,
+        Moved                           = 301,
+        Found                           = 302,
+        SeeOther                        = 303,
+        NotModified                     = 304,
+        UseProxy                        = 305,
+        TemporaryRedirect               = 307,
+        PermanentRedirect               = 308,
         
-        InternalServerError = 500
+        BadRequest                      = 400,
+        Unauthorized                    = 401,
+        PaymentRequired                 = 402,
+        Forbidden                       = 403,
+        NotFound                        = 404,
+        MethodNotAllowed                = 405,
+        NotAcceptable                   = 406,
+        ProxyAuthenticationRequired     = 407,
+        RequestTimeout                  = 408,
+        Conflict                        = 409,
+        Gone                            = 410,
+        LengthRequired                  = 411,
+        PreconditionFailed              = 412,
+        ContentTooLarge                 = 413,
+        URITooLong                      = 414,
+        UnsupportedMediaType            = 415,
+        RangeNotSatisfiable             = 416,
+        ExpectationFailed               = 417,
+        MisdirectedRequest              = 421,
+        UnprocessableContent            = 422,
+        Locked                          = 423,
+        FailedDependency                = 424,
+        TooEarly                        = 425,
+        UpgradeRequired                 = 426,
+        PreconditionRequired            = 428,
+        TooManyRequests                 = 429,
+        RequestHeaderFieldsTooLarge     = 431,
+        UnavailableForLegalReasons      = 451,
         
+        InternalServerError             = 500,
+        NotImplemented                  = 501,
+        BadGateway                      = 502,
+        ServiceUnavailable              = 503,
+        GatewayTimeout                  = 504,
+        HTTPVersionNotSupported         = 505,
+        VariantAlsoNegotiates           = 506,
+        InsufficientStorage             = 507,
+        LoopDetected                    = 508,
+        NotExtended                     = 510,
+        NetworkAuthenticationRequired   = 511
     };
 
+    /** Return the reason phrase of a registered status code or nullptr. */
+    CPPRESTIFY_INTERFACE
+    const char *reasonPhrase(int code);
+
+    /** 
+        Return the pre-rendered status line 'HTTP/1.1 NNN Reason\r\n' of a registered 
+        status code or nullptr. Length receives the number of bytes in the line. 
+    */
+    CPPRESTIFY_INTERFACE
+    const char *statusLine(int code, size_t &length);
 
 }
 
-#endif
\ No newline at end of file
+#endif
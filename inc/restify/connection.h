@@ -15,15 +15,56 @@
 #include <restify/forward.h>
 #include <json/json-forwards.h>
 #include <iosfwd>
+#include <string>
+#include <memory>
 #include <cstdint>
+#include <cstddef>
 
 namespace restify {
 
+    /** Data attached to a connection. Lives as long as the connection, across keep-alive requests. */
+    class CPPRESTIFY_INTERFACE ConnectionData {
+    public:
+        virtual ~ConnectionData();
+    };
+
     class CPPRESTIFY_INTERFACE Connection {
     public:
         virtual int64_t readStream(std::ostream &stream) = 0;
         virtual int64_t writeStream(std::istream &stream) = 0;
+
+        /** Write raw bytes. Returns the number of bytes written or -1 on error. */
+        virtual int64_t write(const char *data, size_t length) = 0;
+
+        /** Close connection once the current request is done. */
         virtual void closeConnection() = 0;
+
+        /** True when the connection stays open for further requests after the current one. */
+        virtual bool isKeepAlive() const = 0;
+
+        /** HTTP version of the current request without prefix, e.g. "1.0". Defaults to "1.1". */
+        virtual std::string getVersion() const;
+
+        /** Return data attached to this connection or nullptr. */
+        virtual ConnectionData *getConnectionData() const = 0;
+
+        /** Attach data to this connection, replacing any previous data. */
+        virtual void setConnectionData(std::unique_ptr<ConnectionData> data) = 0;
+
+        /** 
+            Keep the connection open after the backend handler returned without a response. No further
+            requests are read until the returned resumer is invoked. A task run by the resumer may suspend
+            the connection again to keep it for further tasks, e.g. to push events. Returns an empty resumer
+            if the backend cannot suspend connections.
+        */
+        virtual ConnectionResumer suspend() = 0;
+
+        /**
+            Override handler and write timeouts of the current request in milliseconds, see
+            RequestTimeouts. Negative keeps the timeout of the backend, zero disables it. Returns
+            false when the backend does not enforce timeouts per request, the default.
+        */
+        virtual bool setTimeouts(int handler, int write);
     };
 }
 
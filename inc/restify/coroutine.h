@@ -0,0 +1,245 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_COROUTINE_H
+#define CPP_RESTIFY_COROUTINE_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/frame_pool.h>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <chrono>
+
+namespace restify {
+
+    namespace detail {
+
+        /** Allocates coroutine frames from the frame pool of the current connection. */
+        struct PooledPromise {
+            static void *operator new(size_t size) {
+                return FramePool::allocate(size);
+            }
+
+            static void operator delete(void *p) {
+                FramePool::deallocate(p);
+            }
+        };
+
+        template<class Promise>
+        struct FinalAwaiter {
+            bool await_ready() noexcept {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+                std::coroutine_handle<> c = h.promise().continuation;
+                return c ? c : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        template<class Derived>
+        struct TaskPromiseBase : PooledPromise {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr error;
+
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            FinalAwaiter<Derived> final_suspend() noexcept {
+                return {};
+            }
+
+            void unhandled_exception() {
+                error = std::current_exception();
+            }
+        };
+
+        /** Coroutine running eagerly and destroying itself when done. */
+        struct DetachedTask {
+            struct promise_type : PooledPromise {
+                DetachedTask get_return_object() noexcept { return {}; }
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() noexcept {}
+                void unhandled_exception() noexcept { std::terminate(); }
+            };
+        };
+    }
+
+    /**
+        Lazily started coroutine producing a T. Starts when awaited and resumes the awaiting
+        coroutine when done, rethrowing exceptions there.
+    */
+    template<class T = void>
+    class Task {
+    public:
+        struct promise_type : detail::TaskPromiseBase<promise_type> {
+            std::optional<T> value;
+
+            Task get_return_object() noexcept {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            template<class U>
+            void return_value(U &&v) {
+                value.emplace(std::forward<U>(v));
+            }
+        };
+
+        Task(Task &&other) noexcept
+            :_h(std::exchange(other._h, nullptr))
+        {}
+
+        Task &operator=(Task &&other) noexcept {
+            if (this != &other) {
+                if (_h)
+                    _h.destroy();
+                _h = std::exchange(other._h, nullptr);
+            }
+            return *this;
+        }
+
+        ~Task() {
+            if (_h)
+                _h.destroy();
+        }
+
+        bool await_ready() const noexcept {
+            return !_h || _h.done();
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            _h.promise().continuation = awaiting;
+            return _h;
+        }
+
+        T await_resume() {
+            if (_h.promise().error)
+                std::rethrow_exception(_h.promise().error);
+            return std::move(*_h.promise().value);
+        }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> h)
+            :_h(h)
+        {}
+
+        std::coroutine_handle<promise_type> _h;
+    };
+
+    template<>
+    class Task<void> {
+    public:
+        struct promise_type : detail::TaskPromiseBase<promise_type> {
+            Task get_return_object() noexcept {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            void return_void() noexcept {}
+        };
+
+        Task(Task &&other) noexcept
+            :_h(std::exchange(other._h, nullptr))
+        {}
+
+        Task &operator=(Task &&other) noexcept {
+            if (this != &other) {
+                if (_h)
+                    _h.destroy();
+                _h = std::exchange(other._h, nullptr);
+            }
+            return *this;
+        }
+
+        ~Task() {
+            if (_h)
+                _h.destroy();
+        }
+
+        bool await_ready() const noexcept {
+            return !_h || _h.done();
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            _h.promise().continuation = awaiting;
+            return _h;
+        }
+
+        void await_resume() {
+            if (_h.promise().error)
+                std::rethrow_exception(_h.promise().error);
+        }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> h)
+            :_h(h)
+        {}
+
+        std::coroutine_handle<promise_type> _h;
+    };
+
+    /** Awaitable resuming the coroutine on a timer thread once a point in time has passed. */
+    class CPPRESTIFY_INTERFACE SleepAwaitable {
+    public:
+        SleepAwaitable(std::chrono::steady_clock::time_point when);
+
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> h);
+        void await_resume() noexcept {}
+
+    private:
+        std::chrono::steady_clock::time_point _when;
+    };
+
+    /** Awaitable continuing the coroutine on a thread of an executor. */
+    class CPPRESTIFY_INTERFACE ResumeOnAwaitable {
+    public:
+        ResumeOnAwaitable(Executor &executor, int affinity);
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h);
+        void await_resume() noexcept {}
+
+    private:
+        Executor &_executor;
+        int _affinity;
+    };
+
+    /** Suspend without blocking a thread for at least duration. */
+    CPPRESTIFY_INTERFACE SleepAwaitable sleepFor(std::chrono::steady_clock::duration duration);
+
+    /** Continue on executor, e.g. before calling blocking code. */
+    CPPRESTIFY_INTERFACE ResumeOnAwaitable resumeOn(Executor &executor, int affinity = -1);
+
+    /** Run blocking function on executor and continue there with its result, e.g. for Client::invoke. */
+    template<class Function>
+    auto runOn(Executor &executor, Function f) -> Task<decltype(f())> {
+        co_await resumeOn(executor);
+        co_return f();
+    }
+
+    /** Handler written as coroutine. Request and response stay valid until it finishes. */
+    typedef std::function<Task<void>(const Request &req, Response &rep)> CoroutineRequestHandler;
+
+    /** 
+        Adapt coroutine handler for Server::routeAsync. The response is completed when the
+        coroutine finishes, exceptions escaping it are answered like those of other handlers. 
+    */
+    CPPRESTIFY_INTERFACE AsyncRequestHandler coroutineHandler(const CoroutineRequestHandler &handler);
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_EPOLL_BACKEND_H
+#define CPP_RESTIFY_EPOLL_BACKEND_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/non_copyable.h>
+#include <restify/backend.h>
+#include <json/json-forwards.h>
+#include <memory>
+#include <vector>
+
+namespace restify {
+
+    /**
+        Linux backend running one epoll event loop per thread. Connections are
+        non-blocking and pinned to the loop that accepted them, requests are 
+        dispatched on the loop thread.
+
+        Options
+            listening_ports     Comma separated list of [host:]port and unix:PATH, the latter listens
+                                on a unix domain socket. Defaults to "127.0.0.1:8080".
+            unix_socket_mode    Permissions of unix domain sockets as octal string such as "0660".
+                                Empty keeps permissions derived from the umask. Defaults to "".
+            num_threads         Number of event loops. Defaults to the number of hardware threads.
+            max_request_size    Maximum size of a request head in bytes. Defaults to 16384.
+            max_body_size       Maximum size of a request body in bytes. Defaults to 64MB.
+            max_concurrent_streams
+                                HTTP/2 streams a client may open concurrently. Connections speak
+                                cleartext HTTP/2 when they start with the HTTP/2 preface (prior
+                                knowledge) or their first request asks to upgrade to h2c, all
+                                streams of a connection are multiplexed by its loop. Zero disables
+                                HTTP/2. Defaults to 100. See Http2Session.
+            listen_backlog      Backlog passed to listen. Defaults to SOMAXCONN.
+            reuse_port          When true every loop opens its own listening sockets using
+                                SO_REUSEPORT and the kernel balances connections between
+                                them. Otherwise loops share listeners. A unix domain socket
+                                path can be bound only once, use shared listeners for them.
+                                Defaults to false.
+            cpu_affinity        CPU list such as "0-7,16-23", loops are pinned to one of its CPUs
+                                each, round robin. Empty leaves loops unpinned. Defaults to "".
+            numa                When true loops are spread over NUMA nodes, each pinned to a CPU
+                                of its node, within cpu_affinity if set, and allocating from the
+                                node's memory. Combine with reuse_port for per-loop listeners.
+                                Defaults to false. See ThreadPlacement.
+            listening_sockets   Array of listening socket descriptors to accept on instead of
+                                binding listening_ports, e.g. claimed through ListenerHandoff.
+                                With reuse_port each loop takes an equal, consecutive share.
+                                The backend owns the sockets once started.
+
+        and the admission control option max_in_flight and retry_after, see AdmissionControl.
+        Connections are served by the loop that accepted them without an intermediate queue,
+        so max_queued and max_queue_wait_ms have no effect.
+
+        The request timeouts header_timeout_ms, body_timeout_ms, handler_timeout_ms and 
+        write_timeout_ms bound the phases of requests, see RequestTimeouts. Each loop times the
+        phases of its connections on a TimerWheel. Handlers run on the loop and cannot be cut
+        short, handler_timeout_ms bounds deferred responses only. Timeouts of HTTP/2 connections
+        apply to the connection rather than streams, see HttpServerConnection::getPhase.
+
+        Open event streams (Server::events) cost their loop a socket and pending output only, 
+        they take no admission slot. Peers leaving more than 1MB of their output unsent are cut
+        off. Draining ends streams once their next event or heartbeat is written.
+    */
+    class CPPRESTIFY_INTERFACE EpollBackend : public Backend, NonCopyable
+    {
+    public:
+
+        EpollBackend();
+        ~EpollBackend();
+
+        // Inherited via Backend
+        virtual bool setConfig(const Json::Value & options) override;
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual bool setRequestCallback(const BackendRequestHandler & handler) override;
+
+        /**
+            Returns admission control counters in "admission" and in "accept" the times a loop
+            stopped accepting for a while as "pauses", which happens when file descriptors ran out.
+        */
+        virtual Json::Value getStatistics() const override;
+
+        virtual bool beginDrain() override;
+        virtual size_t getOpenConnectionCount() const override;
+        virtual std::vector<int> getListeningSockets() const override;
+
+    private:
+        struct EventLoop;
+
+        void runLoop(EventLoop &loop);
+
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+}
+
+#endif
@@ -0,0 +1,67 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_EPOLL_CONNECTION_H
+#define CPP_RESTIFY_EPOLL_CONNECTION_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/http/http_server_connection.h>
+#include <restify/event_loop.h>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+namespace restify {
+
+    /** HTTP connection over a non-blocking socket owned by an epoll event loop. */
+    class CPPRESTIFY_INTERFACE EpollConnection : public HttpServerConnection {
+    public:
+        /** 
+            Hands a task for the connection on socket to the owning event loop. Callable from any thread.
+            serial tells the connection apart from later ones reusing the socket descriptor.
+        */
+        typedef std::function<void(int socket, uint64_t serial, const ConnectionTask &task)> TaskPoster;
+
+        /** Takes ownership of socket. Without poster the connection cannot be suspended. */
+        EpollConnection(int socket, const Limits &limits = Limits(), const TaskPoster &poster = TaskPoster());
+        ~EpollConnection();
+
+        int getSocket() const;
+
+        /** Number unique to this connection within the process. */
+        uint64_t getSerial() const;
+
+        /** Admission slots held by deferred requests of this connection. */
+        size_t getAdmittedCount() const;
+        void setAdmittedCount(size_t count);
+
+        /** Events currently registered with epoll. */
+        uint32_t getEvents() const;
+        void setEvents(uint32_t events);
+
+        /** Deadline of the phase the connection is in. */
+        PhaseDeadline &getDeadline();
+
+    protected:
+        virtual int64_t trySend(const char *data, size_t length) override;
+        virtual ConnectionResumer createResumer() override;
+
+    private:
+        int _socket;
+        uint64_t _serial;
+        uint32_t _events;
+        size_t _admitted;
+        CPPRESTIFY_NO_INTERFACE_WARN(PhaseDeadline, _deadline);
+        CPPRESTIFY_NO_INTERFACE_WARN(TaskPoster, _poster);
+    };
+}
+
+#endif
@@ -0,0 +1,108 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_EVENT_LOOP_H
+#define CPP_RESTIFY_EVENT_LOOP_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/non_copyable.h>
+#include <restify/timer_wheel.h>
+#include <restify/http/http_server_connection.h>
+#include <json/json-forwards.h>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace restify {
+
+    /** Task for the connection on socket, dropped unless the connection has serial. */
+    struct LoopTask {
+        int socket;
+        uint64_t serial;
+        ConnectionTask task;
+
+        LoopTask(int s, uint64_t n, const ConnectionTask &t)
+            :socket(s), serial(n), task(t)
+        {}
+    };
+
+    /**
+        Tasks handed to an event loop by other threads, e.g. to resume suspended connections.
+        Posting to an empty queue signals wakeup, an eventfd the loop waits on.
+    */
+    class CPPRESTIFY_INTERFACE LoopTaskQueue : NonCopyable {
+    public:
+        LoopTaskQueue(int wakeup);
+        ~LoopTaskQueue();
+
+        void post(int socket, uint64_t serial, const ConnectionTask &task);
+
+        /** Swap queued tasks into dst, which should be empty. */
+        void take(std::vector<LoopTask> &dst);
+
+        /** Drop queued tasks and ignore further ones, the loop is gone. */
+        void close();
+
+        /** Signal wakeup without posting a task. */
+        void wake();
+
+    private:
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+    /**
+        Deadline of the phase a connection of an event loop is in, timed by the loop's wheel. 
+        The timer is owned by the connection.
+    */
+    struct CPPRESTIFY_INTERFACE PhaseDeadline {
+        TimerWheel::Timer timer;
+        RequestPhase phase;
+        uint64_t requests;
+        uint64_t sent;
+
+        PhaseDeadline(HttpServerConnection *owner);
+
+        /**
+            Arm the timer for the phase of c once it entered another one, served another request
+            or sent output. sending tells output is in flight besides the pending one.
+        */
+        void update(const HttpServerConnection &c, bool sending, TimerWheel &wheel, uint64_t now);
+    };
+
+    /**
+        Startup shared by the Linux event loop backends. Reads the options listening_ports,
+        unix_socket_mode, listen_backlog, listening_sockets, cpu_affinity and numa as documented
+        with EpollBackend.
+    */
+    class CPPRESTIFY_INTERFACE EventLoopSetup {
+    public:
+        /**
+            Bind and listen on listening_ports, non-blocking. Sockets opened are appended to
+            listeners even when a later one fails.
+        */
+        static bool openListeners(const Json::Value &config, bool reusePort, std::vector<int> &listeners);
+
+        /** Sockets of listening_sockets, made non-blocking and close-on-exec. */
+        static std::vector<int> inheritListeners(const Json::Value &config);
+
+        static bool isUnixSocket(int fd);
+
+        /**
+            CPU each of numLoops loops is pinned to, round robin and in NUMA mode alternating
+            between nodes. Empty when loops stay unpinned, false on an invalid cpu_affinity.
+        */
+        static bool placeLoops(const Json::Value &config, size_t numLoops, std::vector<int> &cpus);
+    };
+
+}
+
+#endif
@@ -0,0 +1,99 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_EVENT_STREAM_H
+#define CPP_RESTIFY_EVENT_STREAM_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/non_copyable.h>
+#include <memory>
+#include <string>
+#include <cstddef>
+
+namespace restify {
+
+    /**
+        Server side of an open text/event-stream response (Server-Sent Events). Events may be sent
+        from any thread, they are queued and written by the backend thread serving the connection,
+        which is suspended in between. A stream closes once the client is gone, a write fails or
+        more than maxQueued events wait to be written.
+    */
+    class CPPRESTIFY_INTERFACE EventStream : public std::enable_shared_from_this<EventStream>, NonCopyable {
+    public:
+        /** Stream over the connection resumer belongs to, whose response head was written. */
+        EventStream(const ConnectionResumer &resumer, size_t maxQueued);
+        ~EventStream();
+
+        /** Send event, see format. Returns false when the stream is closed. */
+        bool send(const std::string &data, const std::string &event = std::string(), const std::string &id = std::string());
+
+        /** Send formatted bytes. The buffer is shared, not copied, and must not change afterwards. */
+        bool send(const std::shared_ptr<const std::string> &bytes);
+
+        /** Send a comment line, ignored by clients but keeping intermediaries from timing out. */
+        bool heartbeat();
+
+        /** Write queued events and end the response. */
+        void close();
+
+        bool isOpen() const;
+
+        /** Connection is gone, drop queued events. Called by the server on the I/O thread. */
+        void detach();
+
+        /**
+            Serialize event with data split into one data field per line. event and id must not
+            contain line breaks, empty ones are omitted.
+        */
+        static std::string format(const std::string &data, const std::string &event = std::string(), const std::string &id = std::string());
+
+    private:
+        void write(Connection &c);
+
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+    /**
+        Fans events out to subscribed streams. Each event is serialized once and the same buffer is
+        queued on every subscriber. Closed streams are dropped on the next broadcast or heartbeat.
+    */
+    class CPPRESTIFY_INTERFACE EventHub : NonCopyable {
+    public:
+        /** Sends a heartbeat to all subscribers every heartbeatInterval milliseconds, 0 disables them. */
+        EventHub(int heartbeatInterval = 15000);
+
+        /** Stops heartbeats, subscribed streams stay open. */
+        ~EventHub();
+
+        void subscribe(const std::shared_ptr<EventStream> &stream);
+        void unsubscribe(const std::shared_ptr<EventStream> &stream);
+
+        /** Send event to all subscribers. Returns the number of streams it was queued on. */
+        size_t broadcast(const std::string &data, const std::string &event = std::string(), const std::string &id = std::string());
+        size_t broadcast(const std::shared_ptr<const std::string> &bytes);
+
+        /** Send a heartbeat to all subscribers now. Returns the number of open streams. */
+        size_t heartbeat();
+
+        /** Close and unsubscribe all streams. */
+        void close();
+
+        size_t getSubscriberCount() const;
+
+    private:
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_EXECUTOR_H
+#define CPP_RESTIFY_EXECUTOR_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/non_copyable.h>
+#include <memory>
+#include <cstddef>
+
+namespace restify {
+
+    /** Runs tasks on threads other than the caller's. */
+    class CPPRESTIFY_INTERFACE Executor {
+    public:
+        virtual ~Executor();
+
+        /** 
+            Schedule task for execution. Tasks with the same non-negative affinity 
+            prefer the same thread. 
+        */
+        virtual void submit(const ExecutorTask &task, int affinity = -1) = 0;
+    };
+
+    /**
+        Fixed size thread pool where each thread owns a task queue. Threads run their 
+        own tasks newest first and steal the oldest tasks of other threads when idle.
+    */
+    class CPPRESTIFY_INTERFACE WorkStealingExecutor : public Executor, NonCopyable {
+    public:
+        /** Create executor with numThreads threads, zero uses the number of hardware threads. */
+        WorkStealingExecutor(size_t numThreads = 0);
+
+        /** Runs remaining tasks and joins all threads. */
+        ~WorkStealingExecutor();
+
+        virtual void submit(const ExecutorTask &task, int affinity = -1) override;
+
+        size_t getThreadCount() const;
+
+    private:
+        void run(size_t index);
+        bool tryRun(size_t index);
+
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+}
+
+#endif
@@ -13,7 +13,9 @@
 
 //#include <restify/request_handler.h>
 #include <functional>
+#include <memory>
 #include <string>
+#include <cstddef>
 
 namespace restify {
 
@@ -25,6 +27,7 @@ namespace restify {
     class Client;
     class JsonBuilder;
     class Connection;
+    class ConnectionData;
     class RequestHeaderReader;
     class RequestBodyReader;
     class ResponseWriter;
@@ -34,11 +37,57 @@ namespace restify {
     class BackendContext;
     class Backend;
     class MimeTypes;
+    class Executor;
+    class ResponseCompletion;
+    class WebSocket;
+    struct WebSocketHandlers;
+    class EventStream;
+    class EventHub;
 
 
     typedef std::function<bool(const Request &req, Response &rep)> RequestHandler;
 
+    /** 
+        Handler completing its response later, possibly from another thread. Request and response
+        stay valid as long as a copy of done exists.
+    */
+    typedef std::function<void(const Request &req, Response &rep, const ResponseCompletion &done)> AsyncRequestHandler;
+
     typedef std::function<bool(const BackendContext &ctx, Connection &c)> BackendRequestHandler;
+
+    /**
+        Handles a request asking to upgrade to WebSocket. Returns true and sets handlers when the
+        upgrade is accepted, req then holds the request including route parameters. Otherwise
+        returns false after writing a response to c, such as the one of a plain HTTP route.
+    */
+    typedef std::function<bool(const BackendContext &ctx, Connection &c, Request &req, WebSocketHandlers &handlers)> BackendWebSocketHandler;
+
+    /** 
+        Handles a request for an event stream once its response head was written. The stream may be
+        kept to send events later, e.g. by subscribing it to an EventHub.
+    */
+    typedef std::function<void(const Request &req, const std::shared_ptr<EventStream> &stream)> EventStreamHandler;
+
+    /** Task run on the I/O thread serving a connection. */
+    typedef std::function<void(Connection &c)> ConnectionTask;
+
+    /** 
+        Resumes a suspended connection by running a task on its I/O thread. Callable from any thread,
+        the task is dropped when the connection is gone.
+    */
+    typedef std::function<void(const ConnectionTask &task)> ConnectionResumer;
+
+    /** 
+        Produces a response body piece by piece. Called repeatedly on the worker thread, 
+        appends the next chunk to chunk and returns false once the body is complete. 
+    */
+    typedef std::function<bool(std::string &chunk)> ResponseBodyProducer;
+
+    /** Unit of work run by an Executor. */
+    typedef std::function<void()> ExecutorTask;
+
+    /** Told the number of connections still open while a server drains. */
+    typedef std::function<void(size_t openConnections)> DrainProgress;
 }
 
 #endif
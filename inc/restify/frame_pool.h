@@ -0,0 +1,68 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_FRAME_POOL_H
+#define CPP_RESTIFY_FRAME_POOL_H
+
+#include <restify/interface.h>
+#include <restify/non_copyable.h>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace restify {
+
+    /**
+        Recycles memory blocks of coroutine frames and similar short lived objects. The server
+        keeps one pool per connection and activates it on the thread running a handler. Blocks
+        may be released from any thread and keep their pool alive.
+    */
+    class CPPRESTIFY_INTERFACE FramePool : public std::enable_shared_from_this<FramePool>, NonCopyable {
+    public:
+        /** Makes a pool the active one of the calling thread for its lifetime. */
+        class CPPRESTIFY_INTERFACE Scope : NonCopyable {
+        public:
+            Scope(const std::shared_ptr<FramePool> &pool);
+            ~Scope();
+        private:
+            CPPRESTIFY_NO_INTERFACE_WARN(std::shared_ptr<FramePool>, _pool);
+            FramePool *_previous;
+        };
+
+        /** Keep at most maxCachedBlocks free blocks per size class. */
+        FramePool(size_t maxCachedBlocks = 32);
+        ~FramePool();
+
+        /** Pool active on the calling thread or nullptr. */
+        static FramePool *current();
+
+        /** Allocate from the active pool, or the global heap if there is none. */
+        static void *allocate(size_t size);
+
+        /** Release block returned by allocate. */
+        static void deallocate(void *block);
+
+        /** Number of free blocks held for reuse. */
+        size_t getCachedBlockCount() const;
+
+        /** Number of blocks handed out that did not need the global heap. */
+        uint64_t getReusedBlockCount() const;
+
+    private:
+        void *take(size_t sizeClass);
+        bool give(void *block, size_t sizeClass);
+
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+}
+
+#endif
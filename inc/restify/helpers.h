@@ -47,6 +47,10 @@ namespace restify {
     CPPRESTIFY_INTERFACE
     std::string toLowerCase(const std::string &str);
 
+    /** Decode percent-encoded characters. When decodePlus is set, '+' is decoded to space. */
+    CPPRESTIFY_INTERFACE
+    std::string urlDecode(const char *str, size_t length, bool decodePlus = false);
+
     
     // Explicit Json conversion
 
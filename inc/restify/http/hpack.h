@@ -0,0 +1,103 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_HPACK_H
+#define CPP_RESTIFY_HPACK_H
+
+#include <restify/interface.h>
+#include <restify/non_copyable.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace restify {
+
+    /**
+        Decoder of HPACK header blocks (RFC 7541). Keeps the dynamic table of one direction of
+        a HTTP/2 connection, so blocks have to be decoded in the order they were received.
+    */
+    class CPPRESTIFY_INTERFACE HpackDecoder : NonCopyable {
+    public:
+        typedef std::pair<std::string, std::string> Header;
+
+        /** Table size updates of the encoder may not exceed maxTableSize bytes. */
+        HpackDecoder(size_t maxTableSize = 4096);
+        ~HpackDecoder();
+
+        /**
+            Decode a complete header block and append its fields to headers. False on malformed
+            blocks, the decoder state is undefined afterwards and the connection is to be closed.
+        */
+        bool decode(const char *data, size_t length, std::vector<Header> &headers);
+
+        /**
+            Decode as above, appending fields only while the size of the header list as defined by
+            RFC 7540 6.5.2 stays within maxListSize. Beyond it, fields of the block appended so far
+            are removed again and tooLarge is set. The rest of the block is still decoded, which keeps
+            the dynamic table in sync, but its fields are not materialised.
+        */
+        bool decode(const char *data, size_t length, std::vector<Header> &headers, size_t maxListSize, bool &tooLarge);
+
+        /** Bytes occupied by the dynamic table as defined by RFC 7541. */
+        size_t getTableSize() const;
+
+        /** Number of dynamic table entries. */
+        size_t getTableCount() const;
+
+    private:
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+    /**
+        Encoder of HPACK header blocks. Fields are indexed in the static and dynamic table when
+        possible, repeated fields such as content-type shrink to a single byte.
+    */
+    class CPPRESTIFY_INTERFACE HpackEncoder : NonCopyable {
+    public:
+        typedef std::pair<std::string, std::string> Header;
+
+        HpackEncoder(size_t maxTableSize = 4096);
+        ~HpackEncoder();
+
+        /**
+            Limit the dynamic table to the size the decoder announced, at most the size passed on
+            construction. The next block starts with a table size update.
+        */
+        void setMaxTableSize(size_t size);
+
+        /** Append header block of fields with lower case names to block. */
+        void encode(const std::vector<Header> &headers, std::string &block);
+
+        /** Bytes occupied by the dynamic table as defined by RFC 7541. */
+        size_t getTableSize() const;
+
+    private:
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+    /** Append Huffman code of RFC 7541 for data to out. */
+    CPPRESTIFY_INTERFACE
+    void huffmanEncode(const char *data, size_t length, std::string &out);
+
+    /** Length of the Huffman code of data in bytes. */
+    CPPRESTIFY_INTERFACE
+    size_t huffmanEncodedLength(const char *data, size_t length);
+
+    /** Append decoded Huffman code to out. False on invalid codes or padding. */
+    CPPRESTIFY_INTERFACE
+    bool huffmanDecode(const char *data, size_t length, std::string &out);
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_HTTP2_SESSION_H
+#define CPP_RESTIFY_HTTP2_SESSION_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/non_copyable.h>
+#include <restify/http/http_server_connection.h>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace restify {
+
+    struct HttpRequestHead;
+
+    /**
+        Server side of a cleartext HTTP/2 connection (RFC 7540) running on top of a HttpServerConnection
+        that switched protocols. Frames are decoded from the connection's input, every stream becomes
+        a HttpConnection of its own that is dispatched to the backend handler once its request is
+        complete. Responses written to a stream as HTTP/1.1 messages are translated into HEADERS and
+        DATA frames and sent as the flow control windows of peer allow, streams take turns.
+
+        Streams whose handler defers the response do not hold up others, their resumers route tasks
+        to the stream through the transport's resumer. Server push and priorities are not supported.
+    */
+    class CPPRESTIFY_INTERFACE Http2Session : NonCopyable {
+    public:
+        /** Frames are written to transport, which also provides resumers and connection data. */
+        Http2Session(HttpServerConnection &transport, const HttpServerConnection::Limits &limits);
+        ~Http2Session();
+
+        /** Client connection preface. */
+        static const char Preface[];
+        static const size_t PrefaceLength;
+
+        /**
+            Take over a HTTP/1.1 request asking to upgrade to h2c as stream 1. settings is the value
+            of HTTP2-Settings. Returns false when settings are malformed, nothing is written then.
+        */
+        bool upgrade(const HttpRequestHead &head, const char *body, size_t length, const std::string &settings);
+
+        /** Send the server preface. Called once, after the 101 response of an upgrade. */
+        void start();
+
+        /**
+            Process frames at the beginning of data, dispatch complete requests and send what flow
+            control permits. Returns the number of bytes consumed.
+        */
+        size_t process(const char *data, size_t length, const BackendRequestHandler &handler, const BackendContext &ctx);
+
+        /** Route task of a stream resumer to its stream. Tasks of reset streams are dropped. */
+        void resume(const ConnectionTask &task);
+
+        /** Announce GOAWAY and close once the streams in progress are answered. */
+        void drain();
+
+        /** True when the connection is to be closed once pending output is sent. */
+        bool shouldClose() const;
+
+        /** Number of streams dispatched so far. */
+        uint64_t getRequestCount() const;
+
+        /** Number of dispatched streams waiting for deferred responses. */
+        size_t getDeferredCount() const;
+
+        /** Number of streams not yet closed. */
+        size_t getOpenStreamCount() const;
+
+    private:
+        struct Stream;
+        struct StreamTask;
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+}
+
+#endif
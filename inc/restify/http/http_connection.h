@@ -0,0 +1,30 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_HTTP_CONNECTION_H
+#define CPP_RESTIFY_HTTP_CONNECTION_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/connection.h>
+
+namespace restify {
+
+    struct HttpRequestHead;
+
+    /** Connection of a backend that parses HTTP/1.x on its own. */
+    class CPPRESTIFY_INTERFACE HttpConnection : public Connection {
+    public:
+        /** Return the parsed head of the current request. */
+        virtual const HttpRequestHead &getRequestHead() const = 0;
+    };
+}
+
+#endif
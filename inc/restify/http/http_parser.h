@@ -0,0 +1,93 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_HTTP_PARSER_H
+#define CPP_RESTIFY_HTTP_PARSER_H
+
+#include <restify/interface.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+namespace restify {
+
+    /** Parsed HTTP/1.x request line and headers. */
+    struct CPPRESTIFY_INTERFACE HttpRequestHead {
+        typedef std::pair<std::string, std::string> Header;
+
+        std::string method;
+        /** URI decoded path. */
+        std::string path;
+        /** Raw query string without '?'. */
+        std::string query;
+        bool hasQuery;
+        /** Version without prefix, e.g. "1.1". */
+        std::string version;
+        std::vector<Header> headers;
+        /** Value of Content-Length or -1 if not present. */
+        int64_t contentLength;
+        bool chunked;
+        bool keepAlive;
+        bool expectContinue;
+
+        HttpRequestHead();
+
+        /** Reset to empty state, keeping allocated capacity. */
+        void clear();
+
+        /** Return value of header with case insensitive name or nullptr. */
+        const std::string *findHeader(const char *name) const;
+    };
+
+    /**
+        Incremental parser for HTTP/1.x request heads. Feed the bytes received so far
+        until the parser reports a complete head.
+    */
+    class CPPRESTIFY_INTERFACE HttpRequestParser {
+    public:
+        enum class Result {
+            Incomplete,
+            Complete,
+            Invalid
+        };
+
+        HttpRequestParser(size_t maxHeadSize = 16384, size_t maxHeaders = 64);
+
+        /**
+            Parse request head at the beginning of data. Data must start with the same bytes
+            passed on previous calls since the last reset.
+        */
+        Result parse(const char *data, size_t length, HttpRequestHead &head);
+
+        /** Number of bytes occupied by the head after parse returned Complete. */
+        size_t getHeadLength() const;
+
+        /** Status code to answer with after parse returned Invalid. */
+        int getErrorCode() const;
+
+        /** Prepare for next request. */
+        void reset();
+
+    private:
+        Result fail(int code);
+        Result parseHead(const char *data, size_t length, HttpRequestHead &head);
+
+        size_t _maxHeadSize;
+        size_t _maxHeaders;
+        size_t _scanned;
+        size_t _headLength;
+        int _errorCode;
+    };
+
+}
+
+#endif
@@ -0,0 +1,49 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_HTTP_REQUEST_READER_H
+#define CPP_RESTIFY_HTTP_REQUEST_READER_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/non_copyable.h>
+#include <restify/request_reader.h>
+#include <restify/backend.h>
+#include <memory>
+
+namespace restify {
+
+    struct HttpRequestHead;
+
+    /** Reads request headers from a HttpConnection. */
+    class CPPRESTIFY_INTERFACE HttpRequestHeaderReader : public RequestHeaderReader {
+    public:
+        virtual void readRequestHeader(Connection & c, Request & r) const override;
+    private:
+        void readQueryString(const HttpRequestHead &head, Request &request) const;
+    };
+
+    /** Backend context for backends based on HttpConnection. */
+    class CPPRESTIFY_INTERFACE HttpBackendContext : public BackendContext, NonCopyable {
+    public:
+        HttpBackendContext();
+        ~HttpBackendContext();
+
+        // Inherited via BackendContext
+        virtual const RequestHeaderReader & getRequestHeaderReader() const override;
+        virtual const RequestBodyReader & getRequestBodyReader() const override;
+
+    private:
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+}
+
+#endif
@@ -0,0 +1,163 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_HTTP_SERVER_CONNECTION_H
+#define CPP_RESTIFY_HTTP_SERVER_CONNECTION_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/non_copyable.h>
+#include <restify/http/http_connection.h>
+#include <restify/request_timeouts.h>
+#include <memory>
+#include <iosfwd>
+#include <cstdint>
+#include <cstddef>
+
+namespace restify {
+
+    /**
+        Transport independent server side of a HTTP/1.x connection. Buffers received
+        bytes, parses requests, dispatches complete requests to the backend handler and
+        buffers output until the transport is able to send it.
+
+        Connections starting with the HTTP/2 connection preface or asking to upgrade to h2c
+        with their first request switch to HTTP/2, see Http2Session. Streams are dispatched
+        as connections of their own then. Writing to this connection sends frames and suspend
+        hands out resumers for streams without suspending the connection.
+    */
+    class CPPRESTIFY_INTERFACE HttpServerConnection : public HttpConnection, NonCopyable {
+    public:
+        struct Limits {
+            size_t maxHeadSize;
+            size_t maxBodySize;
+            /** Stop dispatching pipelined requests while more output than this is pending. */
+            size_t maxPendingOutput;
+            /** HTTP/2 streams a client may open concurrently. Zero disables HTTP/2. */
+            size_t maxConcurrentStreams;
+            /** Deadlines the transport enforces, see getPhase. */
+            RequestTimeouts timeouts;
+
+            Limits();
+        };
+
+        HttpServerConnection(const Limits &limits = Limits());
+        virtual ~HttpServerConnection();
+
+        /** Return writable space of at least length bytes for receiving data. */
+        char *prepareReceive(size_t length);
+
+        /** Commit length bytes received into the space returned by prepareReceive. */
+        void commitReceive(size_t length);
+
+        /** Append received bytes. */
+        void receive(const char *data, size_t length);
+
+        /** Dispatch all complete requests received so far. */
+        void process(const BackendRequestHandler &handler, const BackendContext &ctx);
+
+        /** Return pending output bytes. */
+        const char *getPendingOutput() const;
+
+        /** Return number of pending output bytes. */
+        size_t getPendingOutputSize() const;
+
+        /** Remove length bytes from pending output after they have been sent. */
+        void consumeOutput(size_t length);
+
+        /** True when connection should be closed once pending output is sent. */
+        bool shouldClose() const;
+
+        /** Number of requests dispatched so far. */
+        uint64_t getRequestCount() const;
+
+        /** True while a dispatched request waits for its deferred response and no input is processed. */
+        bool isSuspended() const;
+
+        /** 
+            Number of dispatched requests waiting for deferred responses. A HTTP/1.x connection has
+            at most one and is suspended meanwhile, HTTP/2 streams wait without suspending others.
+        */
+        size_t getDeferredCount() const;
+
+        /** True once the connection switched to HTTP/2. */
+        bool isHttp2() const;
+
+        /** 
+            Run task of a resumer on the I/O thread and leave the suspended state. The task may 
+            suspend the connection again, except while draining. Call process afterwards to dispatch
+            requests received in the meantime.
+        */
+        void resume(const ConnectionTask &task);
+
+        /** 
+            Close the connection once the request being received or processed is answered, right 
+            away when there is none. Pending output is still to be sent.
+        */
+        void drain();
+
+        /**
+            Phase the connection is in, the transport bounds it by getPhaseTimeout. HTTP/2 connections
+            are writing while output is pending, otherwise reading a header unless streams wait for
+            deferred responses. Their streams are not bounded individually.
+        */
+        RequestPhase getPhase() const;
+
+        /** Timeout of phase in milliseconds for the current request, zero for none. */
+        uint32_t getPhaseTimeout(RequestPhase phase) const;
+
+        /**
+            The deadline of phase expired. Returns true when a 408 or 503 response was queued, the
+            connection closes once it is sent. Returns false when the transport is to close the
+            connection right away.
+        */
+        bool expirePhase(RequestPhase phase);
+
+        /** Number of output bytes handed to the transport so far, tells a slow client from a stuck one. */
+        uint64_t getBytesSent() const;
+
+        // Inherited via HttpConnection
+        virtual const HttpRequestHead &getRequestHead() const override;
+        virtual int64_t readStream(std::ostream &stream) override;
+        virtual int64_t writeStream(std::istream &stream) override;
+        virtual int64_t write(const char *data, size_t length) override;
+        virtual void closeConnection() override;
+        virtual bool isKeepAlive() const override;
+        virtual std::string getVersion() const override;
+        virtual ConnectionData *getConnectionData() const override;
+        virtual void setConnectionData(std::unique_ptr<ConnectionData> data) override;
+        virtual ConnectionResumer suspend() override;
+        virtual bool setTimeouts(int handler, int write) override;
+
+    protected:
+        /**
+            Try to send bytes directly when no output is pending. Returns number of bytes sent
+            or -1 on a broken transport. Default implementation sends nothing.
+        */
+        virtual int64_t trySend(const char *data, size_t length);
+
+        /** 
+            Create resumer handing tasks to the I/O thread of this connection. Default implementation
+            returns an empty resumer, connections cannot be suspended.
+        */
+        virtual ConnectionResumer createResumer();
+
+    private:
+        void writeError(int code);
+        void startHttp2(const BackendRequestHandler &handler, const BackendContext &ctx);
+        bool upgradeHttp2(const BackendRequestHandler &handler, const BackendContext &ctx);
+        void processHttp2(const BackendRequestHandler &handler, const BackendContext &ctx);
+
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+}
+
+#endif
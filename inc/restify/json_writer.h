@@ -0,0 +1,79 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_JSON_WRITER_H
+#define CPP_RESTIFY_JSON_WRITER_H
+
+#include <restify/interface.h>
+#include <restify/non_copyable.h>
+#include <json/json-forwards.h>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace restify {
+
+    /**
+        Compact Json serializer writing into a fixed size buffer. Whenever the buffer
+        fills up its content is handed to the flush handler, so documents of any size
+        are written without a full-document temporary.
+    */
+    class CPPRESTIFY_INTERFACE JsonStreamWriter : NonCopyable {
+    public:
+        typedef std::function<void(const char *data, size_t length)> FlushHandler;
+
+        JsonStreamWriter(const FlushHandler &flush, size_t bufferSize = 8192);
+
+        /** Serialize into buffer owned by the caller, which needs to hold at least 64 chars. */
+        JsonStreamWriter(const FlushHandler &flush, char *buffer, size_t bufferSize);
+        ~JsonStreamWriter();
+
+        /** Serialize value. */
+        JsonStreamWriter &write(const Json::Value &value);
+
+        /** Hand pending bytes to the flush handler. */
+        void flush();
+
+        /** Return pending bytes not yet flushed. */
+        const char *data() const;
+
+        /** Return number of pending bytes. */
+        size_t size() const;
+
+        /** Return number of bytes handed to the flush handler so far. */
+        uint64_t getFlushedBytes() const;
+
+        /** Format integer into dst, which needs to hold at least 20 chars. Returns length. */
+        static size_t formatInt(int64_t value, char *dst);
+
+        /** Format unsigned integer into dst, which needs to hold at least 20 chars. Returns length. */
+        static size_t formatUInt(uint64_t value, char *dst);
+
+        /** Format shortest round-trip representation of value into dst, which needs to hold at least 32 chars. Returns length. */
+        static size_t formatDouble(double value, char *dst);
+
+    private:
+        void writeValue(const Json::Value &value);
+        void writeString(const char *begin, const char *end);
+        void append(const char *data, size_t length);
+        void reserve(size_t length);
+
+        CPPRESTIFY_NO_INTERFACE_WARN(FlushHandler, _flush);
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<char[]>, _ownedBuffer);
+        char *_buffer;
+        size_t _capacity;
+        size_t _size;
+        uint64_t _flushed;
+    };
+
+}
+
+#endif
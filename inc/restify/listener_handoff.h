@@ -0,0 +1,64 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_LISTENER_HANDOFF_H
+#define CPP_RESTIFY_LISTENER_HANDOFF_H
+
+#include <restify/interface.h>
+#include <json/json-forwards.h>
+#include <string>
+#include <vector>
+
+namespace restify {
+
+    /**
+        Passes listening sockets from a running server to its successor process over a Unix 
+        domain socket, so a restart neither refuses connections nor has to wait for ports to be
+        released. Both processes accept on the same sockets until the old one drains.
+
+        The running process offers its sockets, typically from a thread waiting for the next 
+        deploy, and drains once they are claimed
+
+            if (ListenerHandoff::offer("/run/app.handoff", server.getListeningSockets(), -1))
+                server.drain(30000);
+
+        The successor claims them and passes them to its backend instead of binding ports
+
+            std::vector<int> sockets;
+            if (ListenerHandoff::claim("/run/app.handoff", sockets, 5000))
+                server.setConfig(json()("backend.listening_sockets", ListenerHandoff::toJson(sockets)));
+            server.start();
+
+        Not supported on Windows, where offer and claim fail.
+    */
+    class CPPRESTIFY_INTERFACE ListenerHandoff {
+    public:
+        /** Maximum number of sockets passed at once. */
+        enum { MaxSockets = 64 };
+
+        /** 
+            Listen on path and send sockets to the first process claiming them. Waits at most timeout 
+            milliseconds, negative waits forever. Returns true once the claimant confirmed receipt.
+        */
+        static bool offer(const std::string &path, const std::vector<int> &sockets, int timeout);
+
+        /** 
+            Connect to path and receive the offered sockets, which are owned by the caller afterwards. 
+            Retries for at most timeout milliseconds while nobody offers.
+        */
+        static bool claim(const std::string &path, std::vector<int> &sockets, int timeout);
+
+        /** Sockets as array for backend option listening_sockets. */
+        static Json::Value toJson(const std::vector<int> &sockets);
+    };
+
+}
+
+#endif
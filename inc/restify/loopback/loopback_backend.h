@@ -0,0 +1,72 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_LOOPBACK_BACKEND_H
+#define CPP_RESTIFY_LOOPBACK_BACKEND_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/non_copyable.h>
+#include <restify/backend.h>
+#include <restify/loopback/loopback_connection.h>
+#include <json/json-forwards.h>
+#include <memory>
+#include <string>
+
+namespace restify {
+
+    /**
+        Backend without network for tests and benchmarks of the request pipeline. Raw HTTP 
+        requests passed to exchange are parsed, dispatched to the request callback and answered 
+        on the calling thread, which also waits for deferred responses. Exchanges on different
+        connections may run concurrently.
+
+        Options
+            max_request_size    Maximum size of a request head in bytes. Defaults to 16384.
+            max_body_size       Maximum size of a request body in bytes. Defaults to 64MB.
+            max_concurrent_streams
+                                HTTP/2 streams a client may open concurrently on a connection
+                                that sent the HTTP/2 preface or upgraded to h2c. Zero disables
+                                HTTP/2. Defaults to 100.
+    */
+    class CPPRESTIFY_INTERFACE LoopbackBackend : public Backend, NonCopyable
+    {
+    public:
+
+        LoopbackBackend();
+        ~LoopbackBackend();
+
+        // Inherited via Backend
+        virtual bool setConfig(const Json::Value & options) override;
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual bool setRequestCallback(const BackendRequestHandler & handler) override;
+
+        /** Open a connection. Like a client socket it keeps state between exchanges. */
+        std::unique_ptr<LoopbackConnection> connect() const;
+
+        /** 
+            Send raw request bytes on connection and append what is written in response, including 
+            deferred responses. Incomplete requests are kept for the next exchange. Returns false 
+            when the backend is not running or the connection was closed before.
+        */
+        bool exchange(LoopbackConnection &c, const char *data, size_t length, std::string &response) const;
+
+        /** Send raw request bytes on a new connection and return the raw response. */
+        std::string exchange(const std::string &request) const;
+
+    private:
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+}
+
+#endif
@@ -0,0 +1,43 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_LOOPBACK_CONNECTION_H
+#define CPP_RESTIFY_LOOPBACK_CONNECTION_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/http/http_server_connection.h>
+#include <memory>
+
+namespace restify {
+
+    /** 
+        HTTP connection in memory. Request bytes are passed to receive, responses accumulate as 
+        pending output. The thread calling resumeNext takes the role of the I/O thread for 
+        deferred responses.
+    */
+    class CPPRESTIFY_INTERFACE LoopbackConnection : public HttpServerConnection {
+    public:
+        LoopbackConnection(const Limits &limits = Limits());
+        ~LoopbackConnection();
+
+        /** Wait for the task of a resumer and resume the connection with it. */
+        void resumeNext();
+
+    protected:
+        virtual ConnectionResumer createResumer() override;
+
+    private:
+        struct Mailbox;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::shared_ptr<Mailbox>, _mailbox);
+    };
+}
+
+#endif
@@ -37,6 +37,55 @@ namespace restify {
         CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
     };
 
+    /**
+        Backend based on mongoose. Options are passed on to mongoose except for
+
+            num_shards      Number of independent mongoose contexts, each with its own
+                            acceptor and worker threads, listening on the same ports 
+                            using SO_REUSEPORT. num_threads is split between shards.
+                            Zero uses one shard per hardware thread. Defaults to 1.
+            numa            When true every NUMA node gets a shard with its own listeners, whose
+                            threads run on the node's CPUs and allocate from its memory. 
+                            Replaces num_shards. Defaults to false.
+            listening_sockets   Array of listening socket descriptors to accept on instead
+                                of binding listening_ports, e.g. claimed through ListenerHandoff.
+                                With several shards each takes an equal, consecutive share.
+                                The backend owns the sockets once started.
+
+        and the admission control options max_in_flight, max_queued, max_queue_wait_ms and 
+        retry_after, see AdmissionControl. Connections count as queued from accept until a
+        worker takes them from the socket queue. Limits are shared by all shards.
+
+        num_threads bounds the worker pool of a shard. With min_threads below it the pool is
+        elastic: it starts with min_threads workers, adds one whenever the oldest queued
+        connection waited thread_spawn_wait_ms (defaults to 10) and retires workers idle for
+        thread_idle_timeout_ms (defaults to 60000). min_threads defaults to num_threads.
+
+        cpu_affinity restricts acceptor and worker threads to a CPU list such as "0-7,16-23",
+        in NUMA mode to those CPUs of each node. local_memory "yes" lets threads allocate from
+        the node they run on. See ThreadPlacement.
+
+        Besides [host:]port[s] listening_ports accepts unix:PATH to listen on a unix domain
+        socket, unix_socket_mode sets its permissions as octal string such as "0660". A socket
+        file left behind by a previous process is replaced. A path can be bound only once,
+        so unix domain sockets require a single shard.
+
+        WebSocket upgrades are handshaked by mongoose, see Server::websocket. An open WebSocket 
+        occupies its worker for as long as it lives, num_threads bounds them along with all other
+        connections. Sockets waiting for frames outlast request_timeout_ms. Draining and stopping
+        close them with 1001 Going Away. websocket_max_message_size limits the size of a message
+        in bytes, larger ones close the socket with 1009. Defaults to 1MB.
+
+        Event streams (Server::events) likewise occupy their worker and an admission slot while
+        open. Draining ends them once their next event or heartbeat is written.
+
+        The request timeouts header_timeout_ms, body_timeout_ms, handler_timeout_ms and 
+        write_timeout_ms bound the phases of requests, see RequestTimeouts. A watchdog thread 
+        times them for all workers and shuts down the sockets of expired requests, which frees
+        their workers, see MongooseWatchdog. Handlers still running finish, but their output is
+        dropped. Writes of a response are bounded in chunks of 16KB. request_timeout_ms remains
+        the timeout of single socket operations.
+    */
     class CPPRESTIFY_INTERFACE MongooseBackend : public Backend, NonCopyable
     {
     public:
@@ -49,12 +98,32 @@ namespace restify {
         virtual bool start() override;
         virtual bool stop() override;
         virtual bool setRequestCallback(const BackendRequestHandler & handler) override;
+        virtual bool setWebSocketCallback(const BackendWebSocketHandler & handler) override;
 
+        /** 
+            Returns admission control counters in "admission", the worker pool in "workers"
+            with threads, idle, min, max and counts of spawned and retired threads and the 
+            number of open WebSockets in "websockets".
+        */
+        virtual Json::Value getStatistics() const override;
+
+        virtual bool beginDrain() override;
+        virtual size_t getOpenConnectionCount() const override;
+        virtual std::vector<int> getListeningSockets() const override;
 
     private:
         static int onBeginRequestCallback(struct mg_connection *conn);
+        static int onAcceptSocketCallback(void *userData, int sock, int isSsl);
+        static int onDequeueSocketCallback(void *userData, int sock, int isSsl, double waited);
+        static void onReadHeadCallback(void *userData, int sock, int isSsl, int state);
+
+        static int onWebSocketConnectCallback(const struct mg_connection *conn);
+        static void onWebSocketReadyCallback(struct mg_connection *conn);
+        static int onWebSocketDataCallback(struct mg_connection *conn, int bits, char *data, size_t length);
+        static void onEndRequestCallback(const struct mg_connection *conn, int status);
 
         bool handleRequest(struct mg_connection *conn, const struct mg_request_info *info);
+        bool handleWebSocketRequest(struct mg_connection *conn);
         
         struct PrivateData;
         CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
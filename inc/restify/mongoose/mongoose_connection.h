@@ -15,6 +15,8 @@
 #include <restify/forward.h>
 #include <restify/connection.h>
 #include <iosfwd>
+#include <memory>
+#include <mutex>
 #include <cstdint>
 
 struct mg_connection;
@@ -22,19 +24,49 @@ struct mg_request_info;
 
 namespace restify {
 
+    class MongooseWatchdog;
+
     class CPPRESTIFY_INTERFACE MongooseConnection : public Connection {
     public:
-        MongooseConnection(struct mg_connection *conn);
+        /** Reading the body and writing enter their phases with watchdog unless nullptr. */
+        MongooseConnection(struct mg_connection *conn, MongooseWatchdog *watchdog = nullptr);
 
         virtual int64_t readStream(std::ostream & stream) override;
         virtual int64_t writeStream(std::istream &stream) override;
+        virtual int64_t write(const char *data, size_t length) override;
         virtual void closeConnection() override;
+        virtual bool isKeepAlive() const override;
+        virtual std::string getVersion() const override;
+        virtual ConnectionData *getConnectionData() const override;
+        virtual void setConnectionData(std::unique_ptr<ConnectionData> data) override;
+
+        /** Mongoose serves a connection on a single worker, which blocks in waitForResume while suspended. */
+        virtual ConnectionResumer suspend() override;
+        virtual bool setTimeouts(int handler, int write) override;
         
         
         const struct mg_request_info *getMongooseRequestInfo() const;
 
+        /** True once suspend was called, until the connection is resumed. */
+        bool isSuspended() const;
+
+        /** 
+            Block until resumed and run the resumer's task, which may suspend the connection again. 
+            Returns false when abandoned.
+        */
+        bool waitForResume();
+
+        /** Wake the thread blocked in waitForResume without running a task. Callable from any thread. */
+        void abandon();
+
     private:
         struct mg_connection *_conn;
+        MongooseWatchdog *_watchdog;
+
+        struct Suspension;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::shared_ptr<Suspension>, _suspension);
+        /** Guards _suspension, which abandon reads from other threads. */
+        CPPRESTIFY_NO_INTERFACE_WARN(std::mutex, _suspensionMutex);
     };
 }
 
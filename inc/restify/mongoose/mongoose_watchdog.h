@@ -0,0 +1,74 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_MONGOOSE_WATCHDOG_H
+#define CPP_RESTIFY_MONGOOSE_WATCHDOG_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/non_copyable.h>
+#include <restify/request_timeouts.h>
+#include <memory>
+
+namespace restify {
+
+    class MongooseConnection;
+
+    /**
+        Enforces RequestTimeouts on mongoose workers. A worker serves one connection at a time and
+        tracks the phase of its request in a deadline of its own, a single thread times the deadlines
+        of all workers on a TimerWheel. Requests past their deadline are answered with 408 or 503
+        on non-SSL sockets, the socket is shut down, which fails the blocking calls of its worker
+        and frees it. Suspended requests are abandoned.
+
+        Phases are entered by the worker threads, the watchdog keeps the deadline of each by thread id.
+    */
+    class CPPRESTIFY_INTERFACE MongooseWatchdog : NonCopyable {
+    public:
+        MongooseWatchdog();
+        ~MongooseWatchdog();
+
+        void start(const RequestTimeouts &timeouts);
+
+        /** Stop timing. Not to be called before the workers are stopped. */
+        void stop();
+
+        /** The calling worker starts waiting for the head of a request on sock. */
+        void beginHead(int sock, bool ssl);
+
+        /** Bytes of the head awaited by the calling worker arrived. */
+        void receivedHead();
+
+        /**
+            Enter phase with the request of the calling worker. Entering the phase it is in restarts
+            its deadline. Returns false once the deadline of the request expired, the worker is not
+            to continue it.
+        */
+        bool enter(RequestPhase phase);
+
+        /** True once the deadline of the calling worker's request expired. */
+        bool isExpired();
+
+        /** Override handler and write timeouts of the calling worker's request, see Connection::setTimeouts. */
+        void setTimeouts(int handler, int write);
+
+        /** Connection of the calling worker abandoned when its handler deadline expires, nullptr for none. */
+        void attach(MongooseConnection *conn);
+
+    private:
+        struct Worker;
+
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_MONGOOSE_WEBSOCKET_H
+#define CPP_RESTIFY_MONGOOSE_WEBSOCKET_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/non_copyable.h>
+#include <restify/websocket.h>
+#include <memory>
+#include <cstddef>
+
+struct mg_connection;
+
+namespace restify {
+
+    /**
+        WebSocket on a mongoose connection. The worker serving the connection passes received
+        frames to receive, messages are written under a lock from any thread until the worker
+        detaches the socket from its connection.
+    */
+    class CPPRESTIFY_INTERFACE MongooseWebSocket : public WebSocket, public std::enable_shared_from_this<MongooseWebSocket>, NonCopyable {
+    public:
+        /** Messages larger than maxMessageSize bytes close the socket with 1009. */
+        MongooseWebSocket(struct mg_connection *conn, size_t maxMessageSize);
+        ~MongooseWebSocket();
+
+        using WebSocket::send;
+        virtual bool send(const char *data, size_t length, bool binary = false) override;
+        virtual bool close(int code = 1000) override;
+        virtual bool isOpen() const override;
+        virtual const Request &getRequest() const override;
+
+        /** Request and handlers to be set before the handshake. */
+        Request &getRequest();
+        void setHandlers(const WebSocketHandlers &handlers);
+
+        /** Handshake was sent, call onOpen. */
+        void open();
+
+        /** Handle frame with first header byte bits. Returns false when the connection is to be closed. */
+        bool receive(int bits, const char *data, size_t length);
+
+        /** Connection is done. Waits for sends in progress, calls onClose if the socket was opened. */
+        void detach();
+
+    private:
+        bool writeFrame(int opcode, const char *data, size_t length);
+        bool fail(int code);
+
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+}
+
+#endif
@@ -0,0 +1,125 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_OBJECT_POOL_H
+#define CPP_RESTIFY_OBJECT_POOL_H
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace restify {
+
+    /**
+        Customization of ObjectPool for a type. Specialize to change how objects are created,
+        how they are prepared for reuse and how many each thread keeps.
+    */
+    template<class T>
+    struct ObjectPoolTraits {
+        enum { Capacity = 16 };
+
+        static T *create() {
+            return new T();
+        }
+
+        /** Bring object back into a reusable state, keeping allocated capacity. */
+        static void recycle(T &) {}
+    };
+
+    /**
+        Per-thread cache of objects that are expensive to construct. Objects are taken from
+        the cache of the acquiring thread and returned to the cache of the releasing thread,
+        so no locking is involved. Each thread keeps at most ObjectPoolTraits<T>::Capacity
+        objects, further ones are deleted.
+    */
+    template<class T>
+    class ObjectPool {
+    public:
+        struct Recycler {
+            void operator()(T *p) const {
+                ObjectPool<T>::release(p);
+            }
+        };
+
+        typedef std::unique_ptr<T, Recycler> Ptr;
+
+        /** Take a cached object or create a new one. */
+        static Ptr acquire() {
+            FreeList *l = freeList();
+            if (l && !l->objects.empty()) {
+                T *p = l->objects.back();
+                l->objects.pop_back();
+                return Ptr(p);
+            }
+            return Ptr(ObjectPoolTraits<T>::create());
+        }
+
+        /** Take a cached object or create a new one, returned to the pool once the last reference is gone. */
+        static std::shared_ptr<T> acquireShared() {
+            return std::shared_ptr<T>(acquire().release(), Recycler());
+        }
+
+        /** Number of objects cached by the calling thread. */
+        static size_t getCachedCount() {
+            FreeList *l = freeList();
+            return l ? l->objects.size() : 0;
+        }
+
+    private:
+        struct FreeList {
+            std::vector<T*> objects;
+
+            FreeList() {
+                objects.reserve(ObjectPoolTraits<T>::Capacity);
+            }
+
+            ~FreeList() {
+                destroyed() = true;
+                for (T *p : objects)
+                    delete p;
+            }
+        };
+
+        /** Constant initialized, hence still valid while thread local objects are destroyed. */
+        static bool &destroyed() {
+            static thread_local bool d = false;
+            return d;
+        }
+
+        /** Free list of the calling thread or nullptr once the thread has destroyed it. */
+        static FreeList *freeList() {
+            if (destroyed())
+                return nullptr;
+            static thread_local FreeList l;
+            return &l;
+        }
+
+        static void release(T *p) {
+            if (!p)
+                return;
+
+            FreeList *l = freeList();
+            if (!l || l->objects.size() >= (size_t)ObjectPoolTraits<T>::Capacity) {
+                delete p;
+                return;
+            }
+
+            try {
+                ObjectPoolTraits<T>::recycle(*p);
+                l->objects.push_back(p);
+            } catch (...) {
+                delete p;
+            }
+        }
+    };
+
+}
+
+#endif
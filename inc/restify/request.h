@@ -32,6 +32,9 @@ namespace restify {
         Request(const Json::Value &opts);
         ~Request();
 
+        /** Reset to the state of a default constructed request for reuse. */
+        void clear();
+
         /** Return the HTTP method. */
         std::string getMethod() const;
 
@@ -0,0 +1,120 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_REQUEST_ARENA_H
+#define CPP_RESTIFY_REQUEST_ARENA_H
+
+#include <restify/interface.h>
+#include <restify/non_copyable.h>
+#include <memory>
+#include <string>
+#include <new>
+#include <cstddef>
+
+namespace restify {
+
+    /**
+        Monotonic allocator for memory needed while a single request is processed. Allocations
+        are never freed one by one, the server resets the arena once the request is done and
+        keeps its chunks for the next request of the connection.
+    */
+    class CPPRESTIFY_INTERFACE RequestArena : NonCopyable {
+    public:
+        /** Makes an arena the active one of the calling thread for its lifetime. */
+        class CPPRESTIFY_INTERFACE Scope : NonCopyable {
+        public:
+            Scope(RequestArena *arena);
+            ~Scope();
+        private:
+            RequestArena *_previous;
+        };
+
+        /** First chunk holds initialSize bytes, reset keeps up to maxRetainedSize bytes of chunks. */
+        RequestArena(size_t initialSize = 4096, size_t maxRetainedSize = 64 * 1024);
+        ~RequestArena();
+
+        /** Arena active on the calling thread or nullptr. */
+        static RequestArena *current();
+
+        void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        /** Release all allocations at once. */
+        void reset();
+
+        /** Bytes allocated since the last reset. */
+        size_t getUsed() const;
+
+        /** Bytes of chunks currently held. */
+        size_t getCapacity() const;
+
+        /** Largest number of bytes used between two resets. */
+        size_t getHighWaterMark() const;
+
+    private:
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+    /** 
+        Standard allocator drawing from the arena active at construction, or the global heap if 
+        there is none. Containers using it must not outlive the request.
+    */
+    template<class T>
+    class ArenaAllocator {
+    public:
+        typedef T value_type;
+
+        ArenaAllocator() noexcept
+            :_arena(RequestArena::current())
+        {}
+
+        explicit ArenaAllocator(RequestArena *arena) noexcept
+            :_arena(arena)
+        {}
+
+        template<class U>
+        ArenaAllocator(const ArenaAllocator<U> &other) noexcept
+            :_arena(other.getArena())
+        {}
+
+        T *allocate(size_t n) {
+            if (_arena)
+                return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T *p, size_t) noexcept {
+            if (!_arena)
+                ::operator delete(p);
+        }
+
+        RequestArena *getArena() const noexcept {
+            return _arena;
+        }
+
+    private:
+        RequestArena *_arena;
+    };
+
+    template<class T, class U>
+    inline bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) noexcept {
+        return a.getArena() == b.getArena();
+    }
+
+    template<class T, class U>
+    inline bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) noexcept {
+        return a.getArena() != b.getArena();
+    }
+
+    typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>> ArenaString;
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_REQUEST_TIMEOUTS_H
+#define CPP_RESTIFY_REQUEST_TIMEOUTS_H
+
+#include <restify/interface.h>
+#include <json/json-forwards.h>
+#include <cstdint>
+
+namespace restify {
+
+    /** Phases of serving a request, each bounded by a timeout of its own. */
+    enum class RequestPhase {
+        /** Nothing to bound, e.g. an event stream waiting for its next event. */
+        None,
+        /** Waiting for the head of a request, keep-alive connections waiting idle included. */
+        ReadHeader,
+        ReadBody,
+        /** Request is complete, its response did not begin. */
+        Handler,
+        /** Response output is waiting for the client to take it. */
+        WriteResponse
+    };
+
+    /**
+        Deadlines of the phases of a request, enforced by backends to keep slow or stuck clients
+        from holding connections, workers and admission slots. Backends read them from these 
+        options in milliseconds, zero disables a timeout
+            header_timeout_ms   Time to receive the head of a request. Defaults to 30000.
+            body_timeout_ms     Time to receive the body once the head arrived. Defaults to 60000.
+            handler_timeout_ms  Time until the response begins once the request is complete. 
+                                Defaults to 0.
+            write_timeout_ms    Time pending output may go without the client taking any of it.
+                                Defaults to 60000.
+
+        Expired requests are answered with 408 Request Timeout while being received, with 503 
+        Service Unavailable while waiting for their handler. Connections are closed afterwards, 
+        right away when idle or while writing. Routes may override handler and write timeouts
+        of their requests, see ParameterRoute.
+    */
+    struct CPPRESTIFY_INTERFACE RequestTimeouts {
+        uint32_t header;
+        uint32_t body;
+        uint32_t handler;
+        uint32_t write;
+
+        RequestTimeouts();
+
+        /** Timeout of phase, zero for none. */
+        uint32_t get(RequestPhase phase) const;
+
+        /** Read timeouts from backend options. */
+        static RequestTimeouts fromConfig(const Json::Value &config);
+
+        /** Add default options to backend configuration. */
+        static void addDefaultOptions(Json::Value &config);
+
+        /** Remove timeout options from backend configuration. */
+        static void removeOptions(Json::Value &config);
+    };
+
+}
+
+#endif
@@ -12,9 +12,12 @@
 #define CPP_RESTIFY_RESPONSE_H
 
 #include <restify/interface.h>
+#include <restify/forward.h>
 #include <restify/codes.h>
 #include <restify/helpers.h>
 #include <json/json.h>
+#include <memory>
+#include <string>
 
 namespace restify {
 
@@ -33,6 +36,9 @@ namespace restify {
         Response(const Json::Value &opts);
         ~Response();
 
+        /** Reset to the state of a default constructed response for reuse. */
+        void clear();
+
         class CPPRESTIFY_INTERFACE JsonBodyBuilder {
         public:
             JsonBodyBuilder(Response &response);
@@ -48,6 +54,24 @@ namespace restify {
         Response &setBody(const Json::Value &value);
         JsonBodyBuilder beginBody();
 
+        /** 
+            Stream body using chunked transfer encoding. The producer is invoked on the 
+            worker thread while the response is written, each chunk is sent right away. 
+        */
+        Response &setBodyStream(const ResponseBodyProducer &producer, size_t chunkSize = 4096);
+
+        /** 
+            Use pre-serialized bytes as body. The buffer is shared, not copied, so the same 
+            payload can be written to many connections. 
+        */
+        Response &setRawBody(std::shared_ptr<const std::string> bytes, const std::string &contentType = "application/json; charset=utf-8");
+
+        /** Use binary bytes as body. Bytes are written as is, without passing through Json. */
+        Response &setBinaryBody(std::string bytes, const std::string &contentType = "application/octet-stream");
+
+        /** Use binary bytes as body. Bytes are written as is, without passing through Json. */
+        Response &setBinaryBody(const void *data, size_t length, const std::string &contentType = "application/octet-stream");
+
         Response &setHeader(const std::string &key, const Json::Value &value);
         Response &setVersion(const std::string &value);
 
@@ -59,11 +83,29 @@ namespace restify {
         const Json::Value &toJson() const;
         Json::Value &toJson();
 
+        /** Return body producer or an empty function if body is not streamed. */
+        const ResponseBodyProducer &getBodyStream() const;
+
+        /** Return the chunk size hint for streamed bodies. */
+        size_t getBodyStreamChunkSize() const;
+
+        /** Return raw body bytes or nullptr if body is not raw. */
+        const std::shared_ptr<const std::string> &getRawBody() const;
+
+        /** Return content type of raw body. */
+        const std::string &getRawBodyContentType() const;
+
     private:
 
+        void clearBody();
+
         friend class JsonBodyBuilder;
 
         CPPRESTIFY_NO_INTERFACE_WARN(Json::Value, _root);
+        CPPRESTIFY_NO_INTERFACE_WARN(ResponseBodyProducer, _bodyStream);
+        size_t _bodyStreamChunkSize;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::shared_ptr<const std::string>, _rawBody);
+        CPPRESTIFY_NO_INTERFACE_WARN(std::string, _rawBodyContentType);
     };
 
 }
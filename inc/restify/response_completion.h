@@ -0,0 +1,51 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_RESPONSE_COMPLETION_H
+#define CPP_RESTIFY_RESPONSE_COMPLETION_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <functional>
+#include <exception>
+#include <memory>
+
+namespace restify {
+
+    /**
+        Token for finishing a deferred response. Copies refer to the same response and may be
+        used from any thread. Only the first call to complete or fail takes effect. When the last
+        copy is destroyed before either was called, the request fails with 500 Internal Server Error.
+    */
+    class CPPRESTIFY_INTERFACE ResponseCompletion {
+    public:
+        /** Receives nullptr on success or the error to answer with. */
+        typedef std::function<void(std::exception_ptr error)> Callback;
+
+        ResponseCompletion(const Callback &callback);
+
+        /** Send the response filled in by the handler. Returns false if already done. */
+        bool complete() const;
+
+        /** Answer with error instead, converted like exceptions thrown by handlers. Returns false if already done. */
+        bool fail(std::exception_ptr error) const;
+        bool fail(const Error &error) const;
+
+        /** True once complete or fail has been called. */
+        bool isDone() const;
+
+    private:
+        struct State;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::shared_ptr<State>, _state);
+    };
+
+}
+
+#endif
@@ -15,6 +15,7 @@
 #include <restify/forward.h>
 #include <json/json-forwards.h>
 #include <memory>
+#include <string>
 
 namespace restify {
 
@@ -27,9 +28,14 @@ namespace restify {
     public:
         virtual void writeResponse(Connection &c, Response &r) const;
     private:
-        virtual std::string renderMessage(const Json::Value &jroot) const;
-        virtual std::string renderBody(const Json::Value &jroot, Json::Value &generatedHeaders) const;
-        virtual std::string reasonPhraseFromStatusCode(int setCode) const;
+        virtual void writeStreamedResponse(Connection &c, Response &r) const;
+        virtual void writeRawResponse(Connection &c, Response &r) const;
+        virtual void writeJsonResponse(Connection &c, Response &r) const;
+        /** Render methods append to the given buffer, which is reused across responses. */
+        virtual void renderMessage(Connection &c, const Json::Value &jroot, std::string &message, std::string &scratch) const;
+        virtual void renderHead(Connection &c, const Json::Value &jroot, Json::Value &generatedHeaders, std::string &http) const;
+        virtual void renderBody(const Json::Value &jroot, Json::Value &generatedHeaders, std::string &body) const;
+        virtual const char *reasonPhraseFromStatusCode(int setCode) const;
     };
 }
 
@@ -14,6 +14,7 @@
 #include <restify/interface.h>
 #include <restify/forward.h>
 #include <restify/non_copyable.h>
+#include <restify/websocket.h>
 #include <json/json-forwards.h>
 #include <memory>
 
@@ -24,37 +25,101 @@ namespace restify {
         virtual bool match(const Request &request, Json::Value &extractedParams) const = 0;
         virtual void updateRequest(Request &request, const Json::Value &extractedParams) const = 0;
         virtual void call(Request &request, Response &rep) const = 0;
+
+        /** Invoke handler, done is completed once the response is ready. */
+        virtual void call(Request &request, Response &rep, const ResponseCompletion &done) const = 0;
+
+        /** True when the handler completes its response on its own, possibly later. */
+        virtual bool isAsync() const = 0;
+
+        /** Preferred executor thread for the handler of this route or -1 for none. */
+        virtual int getAffinity() const = 0;
+
+        /** Handler and write timeouts in milliseconds of requests routed here, -1 keeps those of the backend. */
+        virtual int getHandlerTimeout() const = 0;
+        virtual int getWriteTimeout() const = 0;
     };
 
     class CPPRESTIFY_INTERFACE RequestHandlerRoute : public Route {
     public:
         RequestHandlerRoute(const RequestHandler &handler);
+        RequestHandlerRoute(const AsyncRequestHandler &handler);
 
+        /** Waits for asynchronous handlers to complete. */
         void call(Request &request, Response &rep) const override;
+        void call(Request &request, Response &rep, const ResponseCompletion &done) const override;
+        bool isAsync() const override;
+        int getAffinity() const override;
+        int getHandlerTimeout() const override;
+        int getWriteTimeout() const override;
     private:
         CPPRESTIFY_NO_INTERFACE_WARN(RequestHandler, _handler);
+        CPPRESTIFY_NO_INTERFACE_WARN(AsyncRequestHandler, _asyncHandler);
     };
 
     class CPPRESTIFY_INTERFACE AnyRoute : public RequestHandlerRoute {
     public:
         AnyRoute(const RequestHandler &handler);
+        AnyRoute(const AsyncRequestHandler &handler);
 
         virtual bool match(const Request & request, Json::Value & extractedParams) const override;
         virtual void updateRequest(Request & request, const Json::Value & extractedParams) const override;
     };
 
+    /**
+        Route matching path and methods. Option timeouts may hold handler and write, timeouts in
+        milliseconds of matching requests overriding those of the backend, see RequestTimeouts.
+    */
     class CPPRESTIFY_INTERFACE ParameterRoute : public RequestHandlerRoute, NonCopyable {
     public:
         ParameterRoute(const Json::Value &config, const RequestHandler &handler);
+        ParameterRoute(const Json::Value &config, const AsyncRequestHandler &handler);
         ~ParameterRoute();
 
         virtual bool match(const Request & request, Json::Value & extractedParams) const override;
         virtual void updateRequest(Request & request, const Json::Value & extractedParams) const override;
+        virtual int getAffinity() const override;
+        virtual int getHandlerTimeout() const override;
+        virtual int getWriteTimeout() const override;
     private:
+        void setup(const Json::Value &config);
+
         struct PrivateData;
         CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
     };
 
+    /** 
+        Route of a WebSocket endpoint, configured like a ParameterRoute. Plain HTTP requests
+        matching it are answered with 426 Upgrade Required.
+    */
+    class CPPRESTIFY_INTERFACE WebSocketRoute : public ParameterRoute {
+    public:
+        WebSocketRoute(const Json::Value &config, const WebSocketHandlers &handlers);
+
+        const WebSocketHandlers &getHandlers() const;
+    private:
+        CPPRESTIFY_NO_INTERFACE_WARN(WebSocketHandlers, _handlers);
+    };
+
+    /**
+        Route of an event stream endpoint, configured like a ParameterRoute. Option maxQueuedEvents
+        limits the events waiting to be written per stream, defaults to 1024. The server answers
+        matching requests with a text/event-stream response and passes the stream to the handler.
+    */
+    class CPPRESTIFY_INTERFACE EventStreamRoute : public ParameterRoute {
+    public:
+        EventStreamRoute(const Json::Value &config, const EventStreamHandler &handler);
+
+        /** Streams complete their response on their own. */
+        virtual bool isAsync() const override;
+
+        const EventStreamHandler &getHandler() const;
+        size_t getMaxQueuedEvents() const;
+    private:
+        CPPRESTIFY_NO_INTERFACE_WARN(EventStreamHandler, _handler);
+        size_t _maxQueuedEvents;
+    };
+
 }
 
 #endif
\ No newline at end of file
@@ -38,6 +38,12 @@ namespace restify {
         /** Dispatch a request. */
         bool route(Request &req, Response &rep) const;
 
+        /** 
+            Find the first route matching request and merge extracted parameters into 
+            the request. Returns nullptr if no route matches.
+        */
+        std::shared_ptr<const Route> match(Request &req) const;
+
        
     private:
         struct PrivateData;
@@ -16,6 +16,7 @@
 #include <restify/non_copyable.h>
 #include <json/json-forwards.h>
 #include <memory>
+#include <vector>
 
 namespace restify {
 
@@ -28,17 +29,72 @@ namespace restify {
         ~Server();
         
         Server &setBackend(std::shared_ptr<Backend> backend);
+
+        /** 
+            Run route handlers on executor instead of backend threads. Backend threads only
+            read requests and write responses, connections wait suspended while handlers run. 
+            Pass nullptr to run handlers inline again.
+        */
+        Server &setExecutor(std::shared_ptr<Executor> executor);
+
+        /**
+            Merge options. Options in "backend" go to the backend. When they hold "type", one of
+            "mongoose", "epoll" or "io_uring", a new backend of that type replaces the current one
+            and receives all backend options given so far. Throws Error for types not available
+            in this build or on this kernel.
+        */
         Server &setConfig(const Json::Value &options);        
         Server &route(const Json::Value &opts, const RequestHandler &handler);
         Server &otherwise(const RequestHandler &handler);
 
+        /** 
+            Add route whose handler completes the response through a ResponseCompletion, possibly
+            later and from another thread. The connection stays open until then.
+        */
+        Server &routeAsync(const Json::Value &opts, const AsyncRequestHandler &handler);
+        Server &otherwiseAsync(const AsyncRequestHandler &handler);
+
+        /**
+            Add WebSocket endpoint. opts are those of route, upgrade requests are routed along with
+            all other requests. Plain HTTP requests to the endpoint are answered with 426 Upgrade 
+            Required, as are upgrade requests when the backend does not support WebSocket.
+        */
+        Server &websocket(const Json::Value &opts, const WebSocketHandlers &handlers);
+
+        /**
+            Add Server-Sent Events endpoint. opts are those of route plus maxQueuedEvents, see 
+            EventStreamRoute. Matching requests are answered with a text/event-stream response kept
+            open, handler receives its EventStream. Backend threads are not held by open streams 
+            unless the backend serves every connection on a thread of its own, like MongooseBackend.
+        */
+        Server &events(const Json::Value &opts, const EventStreamHandler &handler);
+
         Server &start();
         Server &stop();
 
+        /** 
+            Stop accepting connections, let requests in flight complete for at most timeout milliseconds 
+            and stop. progress is called whenever the number of open connections changes. Returns true
+            when all connections were closed in time, false when remaining ones were cut off. Backends
+            not supporting drain are stopped right away.
+        */
+        bool drain(int timeout, const DrainProgress &progress = DrainProgress());
+
+        /** Descriptors of the backend listening sockets, see ListenerHandoff. */
+        std::vector<int> getListeningSockets() const;
+
+        /** 
+            Return runtime statistics. With option arena.statistics enabled, "arena" holds the number
+            of requests and the mean and maximum bytes of request arena used per request. "backend"
+            holds statistics of the backend, such as admission control counters, when it provides any.
+        */
+        Json::Value getStatistics() const;
+
 
     private:
 
         bool onBackendRequest(const BackendContext &ctx, Connection &conn) const;
+        bool onBackendWebSocket(const BackendContext &ctx, Connection &conn, Request &request, WebSocketHandlers &handlers) const;
 
 
         struct PrivateData;
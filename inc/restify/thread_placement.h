@@ -0,0 +1,53 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_THREAD_PLACEMENT_H
+#define CPP_RESTIFY_THREAD_PLACEMENT_H
+
+#include <restify/interface.h>
+#include <string>
+#include <vector>
+
+namespace restify {
+
+    /**
+        Places backend threads on CPUs and memory nodes. CPUs are numbered as by the operating
+        system and written as lists such as "0-3,8,10-11", the format of Linux' cpulist files.
+
+        Backends pin their threads through the option cpu_affinity. With numa enabled they
+        split their threads by memory node, each thread running on CPUs of one node and 
+        allocating from that node's memory.
+
+        Only supported on Linux, elsewhere pinning fails and a single node is reported.
+    */
+    class CPPRESTIFY_INTERFACE ThreadPlacement {
+    public:
+        /** Parse a CPU list into ascending CPU numbers. False on syntax errors. */
+        static bool parseCpuList(const std::string &list, std::vector<int> &cpus);
+
+        /** Format ascending CPU numbers as CPU list. */
+        static std::string formatCpuList(const std::vector<int> &cpus);
+
+        /** CPUs of each NUMA node having CPUs. A single node with all CPUs when unknown. */
+        static std::vector<std::vector<int>> getNumaNodes();
+
+        /** Restrict the calling thread to cpus. */
+        static bool pinCurrentThread(const std::vector<int> &cpus);
+
+        /** CPUs the calling thread may run on. */
+        static std::vector<int> getCurrentThreadCpus();
+
+        /** Let the calling thread allocate from the memory node it runs on. */
+        static bool useLocalMemory();
+    };
+
+}
+
+#endif
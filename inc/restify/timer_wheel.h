@@ -0,0 +1,92 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_TIMER_WHEEL_H
+#define CPP_RESTIFY_TIMER_WHEEL_H
+
+#include <restify/interface.h>
+#include <restify/non_copyable.h>
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace restify {
+
+    /**
+        Hashed timer wheel. Timers are hashed by their expiry tick into a ring of slots, scheduling
+        and cancelling take constant time regardless of the number of timers, expiring visits only
+        the slots of the ticks passed. Timers further away than one revolution stay in their slot
+        until a visit finds them due.
+
+        Timers are intrusive, owners embed them and the wheel allocates nothing. Not thread-safe,
+        the thread owning the wheel schedules, cancels and advances.
+    */
+    class CPPRESTIFY_INTERFACE TimerWheel : NonCopyable {
+    public:
+        /** Timer of a wheel. Destroying a scheduled timer cancels it. */
+        class CPPRESTIFY_INTERFACE Timer : NonCopyable {
+        public:
+            explicit Timer(void *owner = nullptr);
+            ~Timer();
+
+            bool isScheduled() const;
+
+            /** Object this timer belongs to, passed at construction. */
+            void *getOwner() const;
+
+        private:
+            friend class TimerWheel;
+
+            void unlink();
+
+            Timer *_prev;
+            Timer *_next;
+            TimerWheel *_wheel;
+            uint64_t _tick;
+            void *_owner;
+        };
+
+        typedef std::function<void(Timer &timer)> ExpiryCallback;
+
+        /** Wheel of slots ticks of resolution milliseconds each, starting at time start. */
+        TimerWheel(uint32_t resolution = 10, size_t slots = 1024, uint64_t start = now());
+        ~TimerWheel();
+
+        /** Expire timer delay milliseconds after now, rescheduling it when scheduled already. */
+        void schedule(Timer &timer, uint64_t now, uint32_t delay);
+
+        void cancel(Timer &timer);
+
+        /**
+            Unschedule timers due at now and pass them to callback. The callback may schedule,
+            cancel and destroy any timer. Returns the number of timers expired.
+        */
+        size_t advance(uint64_t now, const ExpiryCallback &callback);
+
+        /** Milliseconds from now until the next timer may be due, -1 when none is scheduled. */
+        int getWaitTime(uint64_t now) const;
+
+        /** Number of scheduled timers. */
+        size_t size() const;
+
+        /** Milliseconds of the monotonic clock. */
+        static uint64_t now();
+
+    private:
+        std::vector<Timer> _slots;
+        uint32_t _resolution;
+        uint64_t _tick;
+        size_t _size;
+    };
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_URING_BACKEND_H
+#define CPP_RESTIFY_URING_BACKEND_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/non_copyable.h>
+#include <restify/backend.h>
+#include <json/json-forwards.h>
+#include <memory>
+#include <vector>
+
+namespace restify {
+
+    /**
+        Linux backend running one io_uring event loop per thread, requires Linux 6.0 or later.
+        Loops accept, receive, send and close through their ring and wait for completions
+        with a single system call per batch. Requests are dispatched on the loop thread.
+
+        Listeners are accepted on by multishot accepts. Connections receive through a multishot
+        receive drawing from a ring of buffers registered per loop, sends copy output into
+        send buffers registered with the kernel as well. Sends filling a whole send buffer go
+        out zero copy from it. The last send of a connection to close is linked to its close,
+        both are submitted at once.
+
+        Options are those of EpollBackend including request timeouts, see there, and
+            queue_depth         Submission queue entries per loop. Defaults to 4096.
+            receive_buffers     Receive buffers per loop, rounded up to a power of two. Defaults to 512.
+            receive_buffer_size Size of a receive buffer in bytes. Defaults to 8192.
+            send_buffers        Send buffers per loop. Output waiting while all are in flight is
+                                sent from a copy. Defaults to 256.
+            send_buffer_size    Size of a send buffer, larger output is sent in chunks of it.
+                                Defaults to 16384.
+            zero_copy_sends     When false all sends are copied by the kernel. Defaults to true.
+
+        Registering send buffers counts against RLIMIT_MEMLOCK. When that fails sends are
+        copied by the kernel, see getStatistics.
+
+        Select it by Server option backend.type "io_uring" or set it with Server::setBackend.
+        Check isSupported first, starting fails on kernels without io_uring or with io_uring
+        disabled.
+    */
+    class CPPRESTIFY_INTERFACE UringBackend : public Backend, NonCopyable
+    {
+    public:
+
+        UringBackend();
+        ~UringBackend();
+
+        /** True when the running kernel provides the io_uring features this backend uses. */
+        static bool isSupported();
+
+        // Inherited via Backend
+        virtual bool setConfig(const Json::Value & options) override;
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual bool setRequestCallback(const BackendRequestHandler & handler) override;
+
+        /**
+            Returns admission control counters in "admission", accept pauses in "accept" as
+            EpollBackend does, and in "io_uring" the system calls entering the rings as "enters",
+            completions reaped as "completions", "sends" and of those "zeroCopySends".
+            "registeredSendBuffers" is false when registering send buffers failed on any loop.
+        */
+        virtual Json::Value getStatistics() const override;
+
+        virtual bool beginDrain() override;
+        virtual size_t getOpenConnectionCount() const override;
+        virtual std::vector<int> getListeningSockets() const override;
+
+    private:
+        struct EventLoop;
+
+        void runLoop(EventLoop &loop);
+
+        struct PrivateData;
+        CPPRESTIFY_NO_INTERFACE_WARN(std::unique_ptr<PrivateData>, _data);
+    };
+
+}
+
+#endif
@@ -0,0 +1,95 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_URING_CONNECTION_H
+#define CPP_RESTIFY_URING_CONNECTION_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <restify/http/http_server_connection.h>
+#include <restify/event_loop.h>
+#include <functional>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace restify {
+
+    /**
+        HTTP connection whose socket is read and written through the io_uring of the event
+        loop owning it. Output is buffered until the loop submits it, trySend sends nothing.
+    */
+    class CPPRESTIFY_INTERFACE UringConnection : public HttpServerConnection {
+    public:
+        /**
+            Hands a task for the connection on socket to the owning event loop. Callable from any thread.
+            serial tells the connection apart from later ones reusing the socket descriptor.
+        */
+        typedef std::function<void(int socket, uint64_t serial, const ConnectionTask &task)> TaskPoster;
+
+        /** Operations the loop has submitted for the connection. */
+        struct Operations {
+            /** Completions still to come, the connection is freed once there are none. */
+            size_t inFlight;
+            /** Multishot receive is armed. */
+            bool receiving;
+            /** Cancelling the armed receive is submitted. */
+            bool receiveCanceled;
+            /** Bytes received while suspended, receiving pauses beyond the head size limit. */
+            size_t receivedWhileSuspended;
+            /** A send is in flight, at most one is. */
+            bool sending;
+            /** Send buffer of the loop holding the bytes in flight, -1 when sendCopy does. */
+            int sendBuffer;
+            /** Bytes in flight when no send buffer was free. */
+            std::string sendCopy;
+            /** Bytes in flight, a send completing with fewer leaves the peer broken. */
+            size_t sendLength;
+            /** Socket is closed or a close is submitted, no further operations are. */
+            bool closing;
+
+            Operations();
+        };
+
+        /** Takes ownership of socket. Without poster the connection cannot be suspended. */
+        UringConnection(int socket, const Limits &limits = Limits(), const TaskPoster &poster = TaskPoster());
+        ~UringConnection();
+
+        int getSocket() const;
+
+        /** The loop closed the socket, the destructor leaves it alone. */
+        void releaseSocket();
+
+        /** Number unique to this connection within the process. */
+        uint64_t getSerial() const;
+
+        /** Admission slots held by deferred requests of this connection. */
+        size_t getAdmittedCount() const;
+        void setAdmittedCount(size_t count);
+
+        Operations &getOperations();
+
+        /** Deadline of the phase the connection is in. */
+        PhaseDeadline &getDeadline();
+
+    protected:
+        virtual ConnectionResumer createResumer() override;
+
+    private:
+        int _socket;
+        uint64_t _serial;
+        size_t _admitted;
+        CPPRESTIFY_NO_INTERFACE_WARN(PhaseDeadline, _deadline);
+        CPPRESTIFY_NO_INTERFACE_WARN(Operations, _operations);
+        CPPRESTIFY_NO_INTERFACE_WARN(TaskPoster, _poster);
+    };
+}
+
+#endif
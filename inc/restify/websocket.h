@@ -0,0 +1,69 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#ifndef CPP_RESTIFY_WEBSOCKET_H
+#define CPP_RESTIFY_WEBSOCKET_H
+
+#include <restify/interface.h>
+#include <restify/forward.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <cstddef>
+
+namespace restify {
+
+    /**
+        Server side of an open WebSocket connection (RFC 6455). Messages may be sent from any
+        thread, also long after the handler that received the socket returned, e.g. to push
+        updates. Sending fails once the connection is closing.
+    */
+    class CPPRESTIFY_INTERFACE WebSocket {
+    public:
+        virtual ~WebSocket();
+
+        /** Send a text message, or a binary one. Returns false when the socket is not open. */
+        virtual bool send(const char *data, size_t length, bool binary = false) = 0;
+        bool send(const std::string &message, bool binary = false);
+
+        /** Start the closing handshake with status code. Returns false when not open. */
+        virtual bool close(int code = 1000) = 0;
+
+        /** True from the handshake until a close frame was sent or received or the connection dropped. */
+        virtual bool isOpen() const = 0;
+
+        /** The upgrade request, including route parameters. */
+        virtual const Request &getRequest() const = 0;
+    };
+
+    /** Decides on an upgrade request before the handshake. Returning false answers 403 Forbidden. */
+    typedef std::function<bool(const Request &req)> WebSocketAcceptHandler;
+    typedef std::function<void(const std::shared_ptr<WebSocket> &ws)> WebSocketOpenHandler;
+    typedef std::function<void(const std::shared_ptr<WebSocket> &ws, const std::string &message, bool binary)> WebSocketMessageHandler;
+    typedef std::function<void(const std::shared_ptr<WebSocket> &ws)> WebSocketCloseHandler;
+
+    /**
+        Callbacks of a WebSocket route, all of them optional. They run on the backend thread
+        reading the socket, one at a time per socket. Errors thrown by onAccept are answered
+        like those of request handlers, errors thrown by the others close the socket with 1011.
+    */
+    struct WebSocketHandlers {
+        WebSocketAcceptHandler onAccept;
+        /** Handshake completed, the socket may be kept to send messages later. */
+        WebSocketOpenHandler onOpen;
+        /** Complete text or binary message, fragments are joined. */
+        WebSocketMessageHandler onMessage;
+        /** Called once the connection is gone, for whatever reason. */
+        WebSocketCloseHandler onClose;
+    };
+
+}
+
+#endif
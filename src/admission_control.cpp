@@ -0,0 +1,161 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/admission_control.h>
+#include <restify/codes.h>
+#include <restify/helpers.h>
+#include <json/json.h>
+#include <atomic>
+#include <algorithm>
+
+namespace restify {
+
+    AdmissionControl::Limits::Limits()
+        :maxInFlight(0), maxQueued(0), maxQueueWait(0), retryAfter(1)
+    {}
+
+    AdmissionControl::Limits AdmissionControl::Limits::fromConfig(const Json::Value & config) {
+        Limits l;
+        l.maxInFlight = (size_t)std::max(0, json_cast<int>(config.get("max_in_flight", 0)));
+        l.maxQueued = (size_t)std::max(0, json_cast<int>(config.get("max_queued", 0)));
+        l.maxQueueWait = std::max(0, json_cast<int>(config.get("max_queue_wait_ms", 0)));
+        l.retryAfter = std::max(0, json_cast<int>(config.get("retry_after", 1)));
+        return l;
+    }
+
+    struct AdmissionControl::PrivateData {
+        Limits limits;
+        std::string rejection;
+
+        std::atomic<int64_t> inFlight;
+        std::atomic<int64_t> queued;
+        std::atomic<uint64_t> admitted;
+        std::atomic<uint64_t> shedInFlight;
+        std::atomic<uint64_t> shedQueueFull;
+        std::atomic<uint64_t> shedQueueWait;
+
+        PrivateData()
+            :inFlight(0), queued(0), admitted(0), shedInFlight(0), shedQueueFull(0), shedQueueWait(0)
+        {}
+
+        void renderRejection() {
+            const std::string body =
+                "{\"message\":\"Server is overloaded, retry later.\",\"statusCode\":" +
+                std::to_string((int)StatusCode::ServiceUnavailable) + "}";
+
+            size_t length = 0;
+            const char *line = statusLine((int)StatusCode::ServiceUnavailable, length);
+
+            rejection.assign(line, length);
+            rejection
+                .append("Retry-After: ").append(std::to_string(limits.retryAfter)).append("\r\n")
+                .append("Content-Type: application/json; charset=utf-8\r\n")
+                .append("Content-Length: ").append(std::to_string(body.size())).append("\r\n")
+                .append("Connection: close\r\n\r\n")
+                .append(body);
+        }
+    };
+
+    AdmissionControl::AdmissionControl(const Limits & limits)
+        :_data(new PrivateData())
+    {
+        setLimits(limits);
+    }
+
+    AdmissionControl::~AdmissionControl()
+    {}
+
+    void AdmissionControl::setLimits(const Limits & limits) {
+        PrivateData &d = *_data;
+        d.limits = limits;
+        d.renderRejection();
+
+        d.inFlight = 0;
+        d.queued = 0;
+        d.admitted = 0;
+        d.shedInFlight = 0;
+        d.shedQueueFull = 0;
+        d.shedQueueWait = 0;
+    }
+
+    const AdmissionControl::Limits & AdmissionControl::getLimits() const {
+        return _data->limits;
+    }
+
+    void AdmissionControl::addDefaultOptions(Json::Value & config) {
+        json(config)
+            ("max_in_flight", 0)
+            ("max_queued", 0)
+            ("max_queue_wait_ms", 0)
+            ("retry_after", 1);
+    }
+
+    void AdmissionControl::removeOptions(Json::Value & config) {
+        config.removeMember("max_in_flight");
+        config.removeMember("max_queued");
+        config.removeMember("max_queue_wait_ms");
+        config.removeMember("retry_after");
+    }
+
+    bool AdmissionControl::enterQueue() {
+        PrivateData &d = *_data;
+        const int64_t q = d.queued.fetch_add(1, std::memory_order_relaxed);
+        if (d.limits.maxQueued > 0 && q >= (int64_t)d.limits.maxQueued) {
+            d.queued.fetch_sub(1, std::memory_order_relaxed);
+            d.shedQueueFull.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    bool AdmissionControl::leaveQueue(double waited) {
+        PrivateData &d = *_data;
+        d.queued.fetch_sub(1, std::memory_order_relaxed);
+        if (d.limits.maxQueueWait > 0 && waited > d.limits.maxQueueWait) {
+            d.shedQueueWait.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    bool AdmissionControl::beginRequest() {
+        PrivateData &d = *_data;
+        const int64_t n = d.inFlight.fetch_add(1, std::memory_order_relaxed);
+        if (d.limits.maxInFlight > 0 && n >= (int64_t)d.limits.maxInFlight) {
+            d.inFlight.fetch_sub(1, std::memory_order_relaxed);
+            d.shedInFlight.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        d.admitted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void AdmissionControl::endRequest() {
+        _data->inFlight.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    const std::string & AdmissionControl::getRejection() const {
+        return _data->rejection;
+    }
+
+    Json::Value AdmissionControl::getStatistics() const {
+        const PrivateData &d = *_data;
+
+        Json::Value stats(Json::objectValue);
+        stats["inFlight"] = Json::Int64(d.inFlight.load(std::memory_order_relaxed));
+        stats["queued"] = Json::Int64(d.queued.load(std::memory_order_relaxed));
+        stats["admitted"] = Json::UInt64(d.admitted.load(std::memory_order_relaxed));
+        stats["shed"]["inFlight"] = Json::UInt64(d.shedInFlight.load(std::memory_order_relaxed));
+        stats["shed"]["queueFull"] = Json::UInt64(d.shedQueueFull.load(std::memory_order_relaxed));
+        stats["shed"]["queueWait"] = Json::UInt64(d.shedQueueWait.load(std::memory_order_relaxed));
+        return stats;
+    }
+
+}
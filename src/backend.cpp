@@ -9,9 +9,29 @@
 */
 
 #include <restify/backend.h>
+#include <json/json.h>
 
 namespace restify {
 
+    bool Backend::setWebSocketCallback(const BackendWebSocketHandler & handler) {
+        return false;
+    }
+
+    Json::Value Backend::getStatistics() const {
+        return Json::Value();
+    }
+
+    bool Backend::beginDrain() {
+        return false;
+    }
+
+    size_t Backend::getOpenConnectionCount() const {
+        return 0;
+    }
+
+    std::vector<int> Backend::getListeningSockets() const {
+        return std::vector<int>();
+    }
 
 }
 
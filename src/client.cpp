@@ -12,6 +12,7 @@
 #include <restify/helpers.h>
 #include <json/json.h>
 #include <regex>
+#include <cstring>
 
 #include <curl/curl.h>
 
@@ -82,7 +83,7 @@ namespace restify {
         // Setup options
 
         const bool verbose = restify::json_cast<bool>(req.get("verbose", false));
-        curl_easy_setopt(curl, CURLOPT_VERBOSE, verbose ? 1 : 0);
+        curl_easy_setopt(curl, CURLOPT_VERBOSE, verbose ? 1L : 0L);
 
         const std::string url = restify::json_cast<std::string>(req.get("url", "http://127.0.0.1:8080"));
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
@@ -91,12 +92,12 @@ namespace restify {
         curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
 
         const int timeout = restify::json_cast<int>(req.get("timeout", 500));
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long)timeout);
 
         Json::Value jsonbody = req.get("body", "");
         const std::string body = restify::json_cast<std::string>(req.get("body", ""));
         curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (int)body.size());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)body.size());
 
         const bool followRedirects = restify::json_cast<bool>(req.get("followRedirects", false));
         curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, followRedirects ? 1L : 0L);
@@ -140,7 +141,7 @@ namespace restify {
         
 
         if (res == CURLE_OK) {
-            response["statusCode"] = getCurlInfo<int>(curl, CURLINFO_RESPONSE_CODE);
+            response["statusCode"] = (int)getCurlInfo<long>(curl, CURLINFO_RESPONSE_CODE);
             std::string contentType = getCurlInfo<std::string>(curl, CURLINFO_CONTENT_TYPE);
 
             const static std::regex isJson(R"(/json)", std::regex::icase);
@@ -0,0 +1,136 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/codes.h>
+
+namespace restify {
+
+    struct StatusEntry {
+        int code;
+        const char *reason;
+        const char *line;
+        size_t length;
+    };
+
+#define CPPRESTIFY_STATUS(code, reason) \
+    { code, reason, "HTTP/1.1 " #code " " reason "\r\n", sizeof("HTTP/1.1 " #code " " reason "\r\n") - 1 }
+
+    static const StatusEntry StatusEntries[] = {
+        CPPRESTIFY_STATUS(100, "Continue"),
+        CPPRESTIFY_STATUS(101, "Switching Protocols"),
+        CPPRESTIFY_STATUS(102, "Processing"),
+        CPPRESTIFY_STATUS(103, "Early Hints"),
+
+        CPPRESTIFY_STATUS(200, "OK"),
+        CPPRESTIFY_STATUS(201, "Created"),
+        CPPRESTIFY_STATUS(202, "Accepted"),
+        CPPRESTIFY_STATUS(203, "Non-Authoritative Information"),
+        CPPRESTIFY_STATUS(204, "No Content"),
+        CPPRESTIFY_STATUS(205, "Reset Content"),
+        CPPRESTIFY_STATUS(206, "Partial Content"),
+        CPPRESTIFY_STATUS(207, "Multi-Status"),
+        CPPRESTIFY_STATUS(208, "Already Reported"),
+        CPPRESTIFY_STATUS(226, "IM Used"),
+
+        CPPRESTIFY_STATUS(300, "Multiple Choices"),
+        CPPRESTIFY_STATUS(301, "Moved Permanently"),
+        CPPRESTIFY_STATUS(302, "Found"),
+        CPPRESTIFY_STATUS(303, "See Other"),
+        CPPRESTIFY_STATUS(304, "Not Modified"),
+        CPPRESTIFY_STATUS(305, "Use Proxy"),
+        CPPRESTIFY_STATUS(307, "Temporary Redirect"),
+        CPPRESTIFY_STATUS(308, "Permanent Redirect"),
+
+        CPPRESTIFY_STATUS(400, "Bad Request"),
+        CPPRESTIFY_STATUS(401, "Unauthorized"),
+        CPPRESTIFY_STATUS(402, "Payment Required"),
+        CPPRESTIFY_STATUS(403, "Forbidden"),
+        CPPRESTIFY_STATUS(404, "Not Found"),
+        CPPRESTIFY_STATUS(405, "Method Not Allowed"),
+        CPPRESTIFY_STATUS(406, "Not Acceptable"),
+        CPPRESTIFY_STATUS(407, "Proxy Authentication Required"),
+        CPPRESTIFY_STATUS(408, "Request Timeout"),
+        CPPRESTIFY_STATUS(409, "Conflict"),
+        CPPRESTIFY_STATUS(410, "Gone"),
+        CPPRESTIFY_STATUS(411, "Length Required"),
+        CPPRESTIFY_STATUS(412, "Precondition Failed"),
+        CPPRESTIFY_STATUS(413, "Content Too Large"),
+        CPPRESTIFY_STATUS(414, "URI Too Long"),
+        CPPRESTIFY_STATUS(415, "Unsupported Media Type"),
+        CPPRESTIFY_STATUS(416, "Range Not Satisfiable"),
+        CPPRESTIFY_STATUS(417, "Expectation Failed"),
+        CPPRESTIFY_STATUS(421, "Misdirected Request"),
+        CPPRESTIFY_STATUS(422, "Unprocessable Content"),
+        CPPRESTIFY_STATUS(423, "Locked"),
+        CPPRESTIFY_STATUS(424, "Failed Dependency"),
+        CPPRESTIFY_STATUS(425, "Too Early"),
+        CPPRESTIFY_STATUS(426, "Upgrade Required"),
+        CPPRESTIFY_STATUS(428, "Precondition Required"),
+        CPPRESTIFY_STATUS(429, "Too Many Requests"),
+        CPPRESTIFY_STATUS(431, "Request Header Fields Too Large"),
+        CPPRESTIFY_STATUS(451, "Unavailable For Legal Reasons"),
+
+        CPPRESTIFY_STATUS(500, "Internal Server Error"),
+        CPPRESTIFY_STATUS(501, "Not Implemented"),
+        CPPRESTIFY_STATUS(502, "Bad Gateway"),
+        CPPRESTIFY_STATUS(503, "Service Unavailable"),
+        CPPRESTIFY_STATUS(504, "Gateway Timeout"),
+        CPPRESTIFY_STATUS(505, "HTTP Version Not Supported"),
+        CPPRESTIFY_STATUS(506, "Variant Also Negotiates"),
+        CPPRESTIFY_STATUS(507, "Insufficient Storage"),
+        CPPRESTIFY_STATUS(508, "Loop Detected"),
+        CPPRESTIFY_STATUS(510, "Not Extended"),
+        CPPRESTIFY_STATUS(511, "Network Authentication Required"),
+    };
+
+#undef CPPRESTIFY_STATUS
+
+    static const int MinStatusCode = 100;
+    static const int MaxStatusCode = 599;
+
+    /** Direct lookup table from status code to entry. */
+    struct StatusTable {
+        const StatusEntry *entries[MaxStatusCode - MinStatusCode + 1];
+
+        StatusTable() {
+            for (auto &e : entries)
+                e = nullptr;
+            for (const auto &s : StatusEntries)
+                entries[s.code - MinStatusCode] = &s;
+        }
+
+        const StatusEntry *find(int code) const {
+            if (code < MinStatusCode || code > MaxStatusCode)
+                return nullptr;
+            return entries[code - MinStatusCode];
+        }
+    };
+
+    static const StatusTable &statuses() {
+        static const StatusTable table;
+        return table;
+    }
+
+    const char *reasonPhrase(int code) {
+        const StatusEntry *e = statuses().find(code);
+        return e ? e->reason : nullptr;
+    }
+
+    const char *statusLine(int code, size_t &length) {
+        const StatusEntry *e = statuses().find(code);
+        if (!e) {
+            length = 0;
+            return nullptr;
+        }
+        length = e->length;
+        return e->line;
+    }
+
+}
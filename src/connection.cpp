@@ -12,4 +12,15 @@
 
 namespace restify {
 
+    ConnectionData::~ConnectionData()
+    {}
+
+    std::string Connection::getVersion() const {
+        return "1.1";
+    }
+
+    bool Connection::setTimeouts(int handler, int write) {
+        return false;
+    }
+
 }
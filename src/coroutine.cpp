@@ -0,0 +1,154 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/coroutine.h>
+#include <restify/executor.h>
+#include <restify/response_completion.h>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <queue>
+#include <vector>
+
+namespace restify {
+
+    /** Single thread resuming sleeping coroutines in order of their deadlines. */
+    class SleepTimer {
+    public:
+        static SleepTimer &instance() {
+            static SleepTimer timer;
+            return timer;
+        }
+
+        void schedule(std::chrono::steady_clock::time_point when, std::coroutine_handle<> h, std::shared_ptr<FramePool> pool) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _entries.push(Entry{ when, _sequence++, h, std::move(pool) });
+            _cv.notify_one();
+        }
+
+        ~SleepTimer() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stopping = true;
+                _cv.notify_one();
+            }
+            _thread.join();
+        }
+
+    private:
+        struct Entry {
+            std::chrono::steady_clock::time_point when;
+            uint64_t sequence;
+            std::coroutine_handle<> h;
+            std::shared_ptr<FramePool> pool;
+
+            bool operator>(const Entry &other) const {
+                return when > other.when || (when == other.when && sequence > other.sequence);
+            }
+        };
+
+        SleepTimer()
+            :_sequence(0), _stopping(false)
+        {
+            _thread = std::thread([this]() { run(); });
+        }
+
+        void run() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (!_stopping) {
+                if (_entries.empty()) {
+                    _cv.wait(lock);
+                    continue;
+                }
+
+                const auto when = _entries.top().when;
+                if (std::chrono::steady_clock::now() < when) {
+                    _cv.wait_until(lock, when);
+                    continue;
+                }
+
+                Entry e = _entries.top();
+                _entries.pop();
+
+                lock.unlock();
+                {
+                    FramePool::Scope scope(e.pool);
+                    e.h.resume();
+                }
+                lock.lock();
+            }
+        }
+
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> _entries;
+        uint64_t _sequence;
+        bool _stopping;
+        std::thread _thread;
+    };
+
+    static std::shared_ptr<FramePool> currentPoolRef() {
+        FramePool *pool = FramePool::current();
+        return pool ? pool->shared_from_this() : std::shared_ptr<FramePool>();
+    }
+
+    SleepAwaitable::SleepAwaitable(std::chrono::steady_clock::time_point when)
+        :_when(when)
+    {}
+
+    bool SleepAwaitable::await_ready() const noexcept {
+        return _when <= std::chrono::steady_clock::now();
+    }
+
+    void SleepAwaitable::await_suspend(std::coroutine_handle<> h) {
+        SleepTimer::instance().schedule(_when, h, currentPoolRef());
+    }
+
+    ResumeOnAwaitable::ResumeOnAwaitable(Executor & executor, int affinity)
+        :_executor(executor), _affinity(affinity)
+    {}
+
+    void ResumeOnAwaitable::await_suspend(std::coroutine_handle<> h) {
+        std::shared_ptr<FramePool> pool = currentPoolRef();
+        _executor.submit([h, pool]() {
+            FramePool::Scope scope(pool);
+            h.resume();
+        }, _affinity);
+    }
+
+    SleepAwaitable sleepFor(std::chrono::steady_clock::duration duration) {
+        return SleepAwaitable(std::chrono::steady_clock::now() + duration);
+    }
+
+    ResumeOnAwaitable resumeOn(Executor & executor, int affinity) {
+        return ResumeOnAwaitable(executor, affinity);
+    }
+
+    static detail::DetachedTask drive(Task<void> task, ResponseCompletion done) {
+        std::exception_ptr error;
+        try {
+            co_await task;
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        if (error)
+            done.fail(error);
+        else
+            done.complete();
+    }
+
+    AsyncRequestHandler coroutineHandler(const CoroutineRequestHandler & handler) {
+        return [handler](const Request &req, Response &rep, const ResponseCompletion &done) {
+            drive(handler(req, rep), done);
+        };
+    }
+
+}
@@ -0,0 +1,618 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/epoll/epoll_backend.h>
+#include <restify/epoll/epoll_connection.h>
+#include <restify/http/http_request_reader.h>
+#include <restify/helpers.h>
+#include <restify/admission_control.h>
+#include <restify/thread_placement.h>
+#include <restify/event_loop.h>
+#include <json/json.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <cerrno>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1u << 28)
+#endif
+
+namespace restify {
+
+    static const size_t ReceiveChunkSize = 16384;
+    static const int MaxEventsPerWait = 128;
+    /** Milliseconds listeners rest when accepting ran out of file descriptors. */
+    static const uint32_t AcceptRetryDelay = 100;
+
+    struct EpollBackend::EventLoop {
+        int epoll;
+        int wakeup;
+        /** Shared with resumers of suspended connections, which may outlive the loop. */
+        std::shared_ptr<LoopTaskQueue> tasks;
+        std::thread thread;
+        /** Listeners this loop waits on. */
+        std::vector<int> listeners;
+        /** True when listeners are private to this loop. */
+        bool ownsListeners;
+        /** Listeners bound to unix domain sockets, their connections take no TCP options. */
+        std::vector<int> unixListeners;
+        /** Deadlines of connections, declared first to outlive them. */
+        TimerWheel wheel;
+        /** Re-registers listeners taken out of the epoll set while descriptors ran out. */
+        TimerWheel::Timer acceptRetry;
+        /** Connections indexed by socket. */
+        std::vector<std::unique_ptr<EpollConnection>> connections;
+        /** CPUs to pin the loop thread to, empty leaves it unpinned. */
+        std::vector<int> cpus;
+        bool localMemory;
+
+        EventLoop()
+            :epoll(-1), wakeup(-1), ownsListeners(false), acceptRetry(this), localMemory(false)
+        {}
+
+        /** Wait for connections on listeners, exclusive ones when they are shared by loops. */
+        bool watchListeners() {
+            epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            bool ok = true;
+            for (int l : listeners) {
+                ev.events = ownsListeners ? EPOLLIN : EPOLLIN | EPOLLEXCLUSIVE;
+                ev.data.fd = l;
+                ok = ok && epoll_ctl(epoll, EPOLL_CTL_ADD, l, &ev) == 0;
+            }
+            return ok;
+        }
+
+        bool isListener(int fd) const {
+            for (int l : listeners) {
+                if (l == fd)
+                    return true;
+            }
+            return false;
+        }
+
+        bool isUnixListener(int fd) const {
+            return std::find(unixListeners.begin(), unixListeners.end(), fd) != unixListeners.end();
+        }
+
+        ~EventLoop() {
+            if (tasks)
+                tasks->close();
+            connections.clear();
+            if (ownsListeners) {
+                for (int l : listeners)
+                    ::close(l);
+            }
+            if (wakeup >= 0) ::close(wakeup);
+            if (epoll >= 0) ::close(epoll);
+        }
+    };
+
+    struct EpollBackend::PrivateData {
+        Json::Value config;
+        BackendRequestHandler handler;
+        HttpBackendContext context;
+        HttpServerConnection::Limits limits;
+        AdmissionControl admission;
+        std::vector<int> listeners;
+        /** Guards listeners of the backend and of its loops, which loops give up while draining. */
+        mutable std::mutex listenersMutex;
+        std::vector<std::unique_ptr<EventLoop>> loops;
+        std::atomic<bool> stopping;
+        std::atomic<bool> draining;
+        /** Loops that stopped accepting since draining began. */
+        std::atomic<size_t> drainedLoops;
+        std::atomic<size_t> openConnections;
+        /** Times a loop stopped accepting because file descriptors ran out. */
+        std::atomic<uint64_t> acceptPauses;
+        bool isRunning;
+
+        PrivateData()
+            :stopping(false), draining(false), drainedLoops(0), openConnections(0), acceptPauses(0), isRunning(false)
+        {}
+
+        void closeListeners() {
+            std::lock_guard<std::mutex> lock(listenersMutex);
+            for (int l : listeners)
+                ::close(l);
+            listeners.clear();
+        }
+    };
+
+    EpollBackend::EpollBackend()
+        :_data(new PrivateData)
+    {
+        json(_data->config)
+            ("listening_ports", "127.0.0.1:8080")
+            ("num_threads", (int)std::max(1u, std::thread::hardware_concurrency()))
+            ("max_request_size", 16384)
+            ("max_body_size", 64 * 1024 * 1024)
+            ("listen_backlog", SOMAXCONN)
+            ("reuse_port", false)
+            ("unix_socket_mode", "")
+            ("cpu_affinity", "")
+            ("numa", false)
+            ("max_concurrent_streams", 100);
+        AdmissionControl::addDefaultOptions(_data->config);
+        RequestTimeouts::addDefaultOptions(_data->config);
+    }
+
+    EpollBackend::~EpollBackend()
+    {
+        stop();
+    }
+
+    bool EpollBackend::setConfig(const Json::Value & options) {
+        return jsonMerge(_data->config, options);
+    }
+
+    bool EpollBackend::setRequestCallback(const BackendRequestHandler & handler) {
+        if (_data->isRunning)
+            return false;
+
+        _data->handler = handler;
+        return true;
+    }
+
+    bool EpollBackend::start()
+    {
+        if (_data->isRunning)
+            return false;
+
+        _data->limits.maxHeadSize = (size_t)json_cast<int>(_data->config["max_request_size"]);
+        _data->limits.maxBodySize = (size_t)json_cast<int>(_data->config["max_body_size"]);
+        _data->limits.maxConcurrentStreams = (size_t)std::max(0, json_cast<int>(_data->config["max_concurrent_streams"]));
+        _data->limits.timeouts = RequestTimeouts::fromConfig(_data->config);
+        const int numThreads = std::max(1, json_cast<int>(_data->config["num_threads"]));
+        const bool reusePort = json_cast<bool>(_data->config["reuse_port"]);
+        const bool numa = json_cast<bool>(_data->config["numa"]);
+        _data->admission.setLimits(AdmissionControl::Limits::fromConfig(_data->config));
+
+        // Inherited sockets replace binding, loops with private listeners take equal shares.
+        const std::vector<int> inherited = EventLoopSetup::inheritListeners(_data->config);
+        if (reusePort && inherited.size() % (size_t)numThreads != 0)
+            return false;
+
+        if (!reusePort && !inherited.empty()) {
+            _data->listeners = inherited;
+        } else if (!reusePort && !EventLoopSetup::openListeners(_data->config, false, _data->listeners)) {
+            _data->closeListeners();
+            return false;
+        }
+
+        std::vector<int> cpus;
+        if (!EventLoopSetup::placeLoops(_data->config, (size_t)numThreads, cpus)) {
+            _data->closeListeners();
+            return false;
+        }
+
+        _data->stopping = false;
+        _data->draining = false;
+        _data->drainedLoops = 0;
+        _data->openConnections = 0;
+
+        bool ok = true;
+        for (int i = 0; i < numThreads && ok; ++i) {
+            std::unique_ptr<EventLoop> loop(new EventLoop());
+            loop->epoll = epoll_create1(EPOLL_CLOEXEC);
+            loop->wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            ok = loop->epoll >= 0 && loop->wakeup >= 0;
+
+            epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.fd = loop->wakeup;
+            ok = ok && epoll_ctl(loop->epoll, EPOLL_CTL_ADD, loop->wakeup, &ev) == 0;
+            loop->tasks = std::make_shared<LoopTaskQueue>(loop->wakeup);
+
+            if (!cpus.empty()) {
+                loop->cpus.push_back(cpus[i]);
+                loop->localMemory = numa;
+            }
+
+            if (reusePort) {
+                // Private listeners, the kernel picks the loop when the connection arrives.
+                loop->ownsListeners = true;
+                if (!inherited.empty()) {
+                    const size_t share = inherited.size() / (size_t)numThreads;
+                    loop->listeners.assign(inherited.begin() + i * share, inherited.begin() + (i + 1) * share);
+                } else {
+                    ok = ok && EventLoopSetup::openListeners(_data->config, true, loop->listeners);
+                }
+            } else {
+                // Every loop waits on every listener, the kernel wakes only one of them per connection.
+                loop->listeners = _data->listeners;
+            }
+            ok = ok && loop->watchListeners();
+
+            for (int l : loop->listeners) {
+                if (EventLoopSetup::isUnixSocket(l))
+                    loop->unixListeners.push_back(l);
+            }
+
+            _data->loops.push_back(std::move(loop));
+        }
+
+        if (!ok) {
+            _data->loops.clear();
+            _data->closeListeners();
+            return false;
+        }
+
+        for (auto &loop : _data->loops) {
+            EventLoop *l = loop.get();
+            l->thread = std::thread([this, l]() {
+                if (!l->cpus.empty())
+                    ThreadPlacement::pinCurrentThread(l->cpus);
+                if (l->localMemory)
+                    ThreadPlacement::useLocalMemory();
+                runLoop(*l);
+            });
+        }
+
+        _data->isRunning = true;
+        return true;
+    }
+
+    bool EpollBackend::stop()
+    {
+        if (!_data->isRunning)
+            return true;
+
+        _data->stopping = true;
+        for (auto &loop : _data->loops)
+            loop->tasks->wake();
+        for (auto &loop : _data->loops) {
+            if (loop->thread.joinable())
+                loop->thread.join();
+        }
+
+        _data->loops.clear();
+        _data->closeListeners();
+        _data->isRunning = false;
+        return true;
+    }
+
+    Json::Value EpollBackend::getStatistics() const {
+        Json::Value stats(Json::objectValue);
+        stats["admission"] = _data->admission.getStatistics();
+        stats["accept"]["pauses"] = (Json::UInt64)_data->acceptPauses.load();
+        return stats;
+    }
+
+    bool EpollBackend::beginDrain() {
+        if (!_data->isRunning)
+            return false;
+
+        _data->draining = true;
+        for (auto &loop : _data->loops)
+            loop->tasks->wake();
+        return true;
+    }
+
+    size_t EpollBackend::getOpenConnectionCount() const {
+        return _data->openConnections.load();
+    }
+
+    std::vector<int> EpollBackend::getListeningSockets() const {
+        std::lock_guard<std::mutex> lock(_data->listenersMutex);
+        std::vector<int> sockets = _data->listeners;
+        for (auto &loop : _data->loops) {
+            if (loop->ownsListeners)
+                sockets.insert(sockets.end(), loop->listeners.begin(), loop->listeners.end());
+        }
+        return sockets;
+    }
+
+    static bool flushConnection(EpollConnection &c) {
+        while (c.getPendingOutputSize() > 0) {
+            const ssize_t n = ::send(c.getSocket(), c.getPendingOutput(), c.getPendingOutputSize(), MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n > 0) {
+                c.consumeOutput((size_t)n);
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void EpollBackend::runLoop(EventLoop & loop) {
+        PrivateData &d = *_data;
+        epoll_event events[MaxEventsPerWait];
+
+        std::shared_ptr<LoopTaskQueue> queue = loop.tasks;
+        const EpollConnection::TaskPoster poster = [queue](int socket, uint64_t serial, const ConnectionTask &task) {
+            queue->post(socket, serial, task);
+        };
+        std::vector<LoopTask> tasks;
+        bool drained = false;
+        uint64_t now = TimerWheel::now();
+
+        // Requests hold their admission slot until answered, deferred ones until resumed. Handlers
+        // receive HTTP/2 streams rather than the connection, which counts their deferrals. Tasks 
+        // suspending a connection again, such as those of event streams, take no slot.
+        EpollConnection *current = nullptr;
+        BackendRequestHandler handler;
+        if (d.handler) {
+            handler = [&d, &current](const BackendContext &ctx, Connection &conn) {
+                if (!d.admission.beginRequest()) {
+                    const std::string &r = d.admission.getRejection();
+                    conn.write(r.data(), r.size());
+                    conn.closeConnection();
+                    return true;
+                }
+
+                const size_t deferred = current->getDeferredCount();
+                bool handled = false;
+                try {
+                    handled = d.handler(ctx, conn);
+                } catch (...) {
+                    if (current->getDeferredCount() == deferred)
+                        d.admission.endRequest();
+                    else
+                        current->setAdmittedCount(current->getAdmittedCount() + 1);
+                    throw;
+                }
+                if (current->getDeferredCount() == deferred)
+                    d.admission.endRequest();
+                else
+                    current->setAdmittedCount(current->getAdmittedCount() + 1);
+                return handled;
+            };
+        }
+
+        auto closeConnection = [&loop, &d](int fd) {
+            epoll_ctl(loop.epoll, EPOLL_CTL_DEL, fd, nullptr);
+            for (size_t i = loop.connections[fd]->getAdmittedCount(); i > 0; --i)
+                d.admission.endRequest();
+            loop.connections[fd].reset();
+            d.openConnections.fetch_sub(1);
+        };
+
+        auto serviceConnection = [&loop, &d, &handler, &current, &now, &closeConnection](int fd, bool peerClosed) {
+            EpollConnection &c = *loop.connections[fd];
+            current = &c;
+
+            // Dispatch and send until no further pipelined requests are released.
+            bool ok = true;
+            for (;;) {
+                const uint64_t dispatched = c.getRequestCount();
+                c.process(handler, d.context);
+                ok = flushConnection(c);
+                if (!ok || c.getRequestCount() == dispatched || c.getPendingOutputSize() > 0)
+                    break;
+            }
+
+            if (peerClosed)
+                c.closeConnection();
+
+            if (!ok) {
+                // Resumers of a suspended connection find it gone and drop their task.
+                closeConnection(fd);
+                return;
+            }
+
+            uint32_t wanted = 0;
+            if (c.isSuspended()) {
+                // Response is deferred, ignore requests until the connection is resumed. Output of
+                // tasks suspending it again is still sent, peers not keeping up with it are cut off.
+                if (c.getPendingOutputSize() > d.limits.maxPendingOutput) {
+                    closeConnection(fd);
+                    return;
+                }
+                if (c.getPendingOutputSize() > 0)
+                    wanted = EPOLLOUT;
+            } else {
+                if (c.shouldClose() && c.getPendingOutputSize() == 0) {
+                    closeConnection(fd);
+                    return;
+                }
+
+                if (c.getPendingOutputSize() > 0)
+                    wanted |= EPOLLOUT;
+                if (!c.shouldClose() && c.getPendingOutputSize() <= d.limits.maxPendingOutput)
+                    wanted |= EPOLLIN | EPOLLRDHUP;
+            }
+
+            if (wanted == 0) {
+                if (c.getEvents() != 0) {
+                    epoll_ctl(loop.epoll, EPOLL_CTL_DEL, fd, nullptr);
+                    c.setEvents(0);
+                }
+            } else if (wanted != c.getEvents()) {
+                epoll_event cev;
+                memset(&cev, 0, sizeof(cev));
+                cev.events = wanted;
+                cev.data.fd = fd;
+                epoll_ctl(loop.epoll, c.getEvents() == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &cev);
+                c.setEvents(wanted);
+            }
+
+            c.getDeadline().update(c, false, loop.wheel, now);
+        };
+
+        // Requests past their deadline are answered if they can be, their connections closed.
+        const TimerWheel::ExpiryCallback expire = [&loop, &serviceConnection, &closeConnection](TimerWheel::Timer &timer) {
+            if (&timer == &loop.acceptRetry) {
+                loop.watchListeners();
+                return;
+            }
+
+            EpollConnection &c = *static_cast<EpollConnection*>(timer.getOwner());
+            if (c.expirePhase(c.getDeadline().phase))
+                serviceConnection(c.getSocket(), false);
+            else
+                closeConnection(c.getSocket());
+        };
+
+        while (!d.stopping.load(std::memory_order_relaxed)) {
+            now = TimerWheel::now();
+            loop.wheel.advance(now, expire);
+
+            const int n = epoll_wait(loop.epoll, events, MaxEventsPerWait, loop.wheel.getWaitTime(now));
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            now = TimerWheel::now();
+
+            for (int i = 0; i < n; ++i) {
+                const int fd = events[i].data.fd;
+                const uint32_t ev = events[i].events;
+
+                if (fd == loop.wakeup) {
+                    uint64_t value;
+                    ssize_t ignored = ::read(loop.wakeup, &value, sizeof(value));
+                    (void)ignored;
+
+                    // Resume connections whose deferred responses completed.
+                    tasks.clear();
+                    queue->take(tasks);
+                    for (auto &t : tasks) {
+                        const int s = t.socket;
+                        if ((size_t)s >= loop.connections.size() || !loop.connections[s])
+                            continue;
+                        EpollConnection &c = *loop.connections[s];
+                        if (c.getSerial() != t.serial || c.getDeferredCount() == 0)
+                            continue;
+                        if (c.getAdmittedCount() > 0) {
+                            c.setAdmittedCount(c.getAdmittedCount() - 1);
+                            d.admission.endRequest();
+                        }
+                        c.resume(t.task);
+                        t.task = nullptr;
+                        serviceConnection(s, false);
+                    }
+
+                    if (d.draining.load() && !drained) {
+                        // Stop accepting, the last loop doing so closes shared listeners.
+                        drained = true;
+                        {
+                            std::lock_guard<std::mutex> lock(d.listenersMutex);
+                            for (int l : loop.listeners) {
+                                epoll_ctl(loop.epoll, EPOLL_CTL_DEL, l, nullptr);
+                                if (loop.ownsListeners)
+                                    ::close(l);
+                            }
+                            loop.listeners.clear();
+                            loop.unixListeners.clear();
+                        }
+                        if (d.drainedLoops.fetch_add(1) + 1 == d.loops.size())
+                            d.closeListeners();
+
+                        for (size_t s = 0; s < loop.connections.size(); ++s) {
+                            if (!loop.connections[s])
+                                continue;
+                            loop.connections[s]->drain();
+                            serviceConnection((int)s, false);
+                        }
+                    }
+                    continue;
+                }
+
+                if (loop.isListener(fd)) {
+                    for (;;) {
+                        const int s = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                        if (s < 0) {
+                            if (errno == EINTR || errno == ECONNABORTED)
+                                continue;
+                            if ((errno == EMFILE || errno == ENFILE) && !loop.acceptRetry.isScheduled()) {
+                                // Pending connections keep listeners readable, rest them until
+                                // descriptors may have been released instead of spinning.
+                                for (int l : loop.listeners)
+                                    epoll_ctl(loop.epoll, EPOLL_CTL_DEL, l, nullptr);
+                                loop.wheel.schedule(loop.acceptRetry, now, AcceptRetryDelay);
+                                d.acceptPauses.fetch_add(1);
+                            }
+                            break;
+                        }
+
+                        if (!loop.isUnixListener(fd)) {
+                            int one = 1;
+                            setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                        }
+
+                        if ((size_t)s >= loop.connections.size())
+                            loop.connections.resize(s + 1);
+                        loop.connections[s].reset(new EpollConnection(s, d.limits, poster));
+
+                        epoll_event cev;
+                        memset(&cev, 0, sizeof(cev));
+                        cev.events = EPOLLIN | EPOLLRDHUP;
+                        cev.data.fd = s;
+                        if (epoll_ctl(loop.epoll, EPOLL_CTL_ADD, s, &cev) != 0) {
+                            loop.connections[s].reset();
+                        } else {
+                            EpollConnection &c = *loop.connections[s];
+                            c.setEvents(cev.events);
+                            c.getDeadline().update(c, false, loop.wheel, now);
+                            d.openConnections.fetch_add(1);
+                        }
+                    }
+                    continue;
+                }
+
+                if ((size_t)fd >= loop.connections.size() || !loop.connections[fd])
+                    continue;
+                EpollConnection &c = *loop.connections[fd];
+
+                bool peerClosed = false;
+                if (ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                    bool failed = false;
+                    for (;;) {
+                        char *buffer = c.prepareReceive(ReceiveChunkSize);
+                        const ssize_t r = ::recv(fd, buffer, ReceiveChunkSize, 0);
+                        if (r > 0) {
+                            c.commitReceive((size_t)r);
+                            if ((size_t)r < ReceiveChunkSize)
+                                break;
+                        } else if (r == 0) {
+                            peerClosed = true;
+                            break;
+                        } else if (errno == EINTR) {
+                            continue;
+                        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                            break;
+                        } else {
+                            failed = true;
+                            break;
+                        }
+                    }
+
+                    if (failed) {
+                        closeConnection(fd);
+                        continue;
+                    }
+                }
+
+                serviceConnection(fd, peerClosed);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,89 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/epoll/epoll_connection.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <atomic>
+
+namespace restify {
+
+    static std::atomic<uint64_t> nextSerial(1);
+
+    EpollConnection::EpollConnection(int socket, const Limits &limits, const TaskPoster &poster)
+        :HttpServerConnection(limits), _socket(socket), _serial(nextSerial.fetch_add(1, std::memory_order_relaxed)),
+        _events(0), _admitted(0), _deadline(this), _poster(poster)
+    {}
+
+    EpollConnection::~EpollConnection()
+    {
+        if (_socket >= 0)
+            ::close(_socket);
+    }
+
+    int EpollConnection::getSocket() const {
+        return _socket;
+    }
+
+    uint64_t EpollConnection::getSerial() const {
+        return _serial;
+    }
+
+    size_t EpollConnection::getAdmittedCount() const {
+        return _admitted;
+    }
+
+    void EpollConnection::setAdmittedCount(size_t count) {
+        _admitted = count;
+    }
+
+    uint32_t EpollConnection::getEvents() const {
+        return _events;
+    }
+
+    void EpollConnection::setEvents(uint32_t events) {
+        _events = events;
+    }
+
+    PhaseDeadline & EpollConnection::getDeadline() {
+        return _deadline;
+    }
+
+    int64_t EpollConnection::trySend(const char * data, size_t length) {
+        size_t total = 0;
+        while (total < length) {
+            const ssize_t n = ::send(_socket, data + total, length - total, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n > 0) {
+                total += (size_t)n;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                return -1;
+            }
+        }
+        return (int64_t)total;
+    }
+
+    ConnectionResumer EpollConnection::createResumer() {
+        if (!_poster)
+            return ConnectionResumer();
+
+        const TaskPoster poster = _poster;
+        const int socket = _socket;
+        const uint64_t serial = _serial;
+        return [poster, socket, serial](const ConnectionTask &task) {
+            poster(socket, serial, task);
+        };
+    }
+
+}
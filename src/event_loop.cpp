@@ -0,0 +1,272 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/event_loop.h>
+#include <restify/helpers.h>
+#include <restify/thread_placement.h>
+#include <json/json.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <cstdlib>
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+namespace restify {
+
+    struct LoopTaskQueue::PrivateData {
+        std::mutex mutex;
+        std::vector<LoopTask> tasks;
+        int wakeup;
+        bool closed;
+
+        PrivateData(int w)
+            :wakeup(w), closed(false)
+        {}
+    };
+
+    LoopTaskQueue::LoopTaskQueue(int wakeup)
+        :_data(new PrivateData(wakeup))
+    {}
+
+    LoopTaskQueue::~LoopTaskQueue()
+    {}
+
+    void LoopTaskQueue::post(int socket, uint64_t serial, const ConnectionTask &task) {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        if (_data->closed)
+            return;
+
+        const bool wasEmpty = _data->tasks.empty();
+        _data->tasks.emplace_back(socket, serial, task);
+        if (wasEmpty)
+            wake();
+    }
+
+    void LoopTaskQueue::take(std::vector<LoopTask> &dst) {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        dst.swap(_data->tasks);
+    }
+
+    void LoopTaskQueue::close() {
+        std::vector<LoopTask> dropped;
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        _data->closed = true;
+        dropped.swap(_data->tasks);
+    }
+
+    void LoopTaskQueue::wake() {
+        const uint64_t one = 1;
+        ssize_t ignored = ::write(_data->wakeup, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    PhaseDeadline::PhaseDeadline(HttpServerConnection *owner)
+        :timer(owner), phase(RequestPhase::None), requests(UINT64_MAX), sent(0)
+    {}
+
+    void PhaseDeadline::update(const HttpServerConnection &c, bool sending, TimerWheel &wheel, uint64_t now) {
+        const RequestPhase p = sending ? RequestPhase::WriteResponse : c.getPhase();
+        const uint64_t r = c.getRequestCount();
+        const uint64_t s = c.getBytesSent();
+        if (p == phase && r == requests && s == sent)
+            return;
+
+        phase = p;
+        requests = r;
+        sent = s;
+        const uint32_t timeout = c.getPhaseTimeout(p);
+        if (timeout > 0)
+            wheel.schedule(timer, now, timeout);
+        else
+            wheel.cancel(timer);
+    }
+
+    /** Parse [host:]port, [ipv6]:port, unix:path into a socket address. */
+    static bool parseListeningPort(const std::string &spec, sockaddr_storage &addr, socklen_t &addrLength) {
+        memset(&addr, 0, sizeof(addr));
+
+        if (spec.compare(0, 5, "unix:") == 0) {
+            sockaddr_un *un = reinterpret_cast<sockaddr_un*>(&addr);
+            const std::string path = spec.substr(5);
+            if (path.empty() || path.size() >= sizeof(un->sun_path))
+                return false;
+            un->sun_family = AF_UNIX;
+            memcpy(un->sun_path, path.data(), path.size());
+            addrLength = (socklen_t)(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+            return true;
+        }
+
+        std::string host;
+        std::string port = spec;
+
+        if (!spec.empty() && spec[0] == '[') {
+            const size_t close = spec.find(']');
+            if (close == std::string::npos || close + 1 >= spec.size() || spec[close + 1] != ':')
+                return false;
+            host = spec.substr(1, close - 1);
+            port = spec.substr(close + 2);
+        } else {
+            const size_t colon = spec.rfind(':');
+            if (colon != std::string::npos) {
+                host = spec.substr(0, colon);
+                port = spec.substr(colon + 1);
+            }
+        }
+
+        char *end = nullptr;
+        const long p = strtol(port.c_str(), &end, 10);
+        if (port.empty() || *end != '\0' || p < 0 || p > 65535)
+            return false;
+
+        sockaddr_in *in4 = reinterpret_cast<sockaddr_in*>(&addr);
+        sockaddr_in6 *in6 = reinterpret_cast<sockaddr_in6*>(&addr);
+
+        if (host.empty()) {
+            in4->sin_family = AF_INET;
+            in4->sin_addr.s_addr = htonl(INADDR_ANY);
+            in4->sin_port = htons((uint16_t)p);
+            addrLength = sizeof(sockaddr_in);
+        } else if (inet_pton(AF_INET, host.c_str(), &in4->sin_addr) == 1) {
+            in4->sin_family = AF_INET;
+            in4->sin_port = htons((uint16_t)p);
+            addrLength = sizeof(sockaddr_in);
+        } else if (inet_pton(AF_INET6, host.c_str(), &in6->sin6_addr) == 1) {
+            in6->sin6_family = AF_INET6;
+            in6->sin6_port = htons((uint16_t)p);
+            addrLength = sizeof(sockaddr_in6);
+        } else {
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+        Remove a socket file left behind by a process that exited without unlinking it. Paths
+        still accepted on and files other than sockets are kept, bind then fails.
+    */
+    static void removeStaleUnixSocket(const sockaddr_un &addr) {
+        struct stat st;
+        if (::lstat(addr.sun_path, &st) != 0 || !S_ISSOCK(st.st_mode))
+            return;
+
+        const int s = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (s < 0)
+            return;
+        if (::connect(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 && errno == ECONNREFUSED)
+            ::unlink(addr.sun_path);
+        ::close(s);
+    }
+
+    bool EventLoopSetup::openListeners(const Json::Value &config, bool reusePort, std::vector<int> &listeners) {
+        const std::vector<std::string> specs = splitString(json_cast<std::string>(config["listening_ports"]), ',', true, true);
+        const int backlog = json_cast<int>(config["listen_backlog"]);
+        const std::string mode = json_cast<std::string>(config["unix_socket_mode"]);
+
+        for (const std::string &spec : specs) {
+            if (spec.empty())
+                continue;
+
+            sockaddr_storage addr;
+            socklen_t addrLength = 0;
+            if (!parseListeningPort(spec, addr, addrLength))
+                return false;
+
+            const int fd = ::socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0)
+                return false;
+            listeners.push_back(fd);
+
+            if (addr.ss_family == AF_UNIX) {
+                const sockaddr_un &un = reinterpret_cast<const sockaddr_un&>(addr);
+                removeStaleUnixSocket(un);
+                if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), addrLength) != 0)
+                    return false;
+                if (!mode.empty() && ::chmod(un.sun_path, (mode_t)strtol(mode.c_str(), nullptr, 8)) != 0)
+                    return false;
+            } else {
+                int one = 1;
+                setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+                if (reusePort && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0)
+                    return false;
+
+                if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), addrLength) != 0)
+                    return false;
+            }
+            if (::listen(fd, backlog) != 0)
+                return false;
+        }
+
+        return !listeners.empty();
+    }
+
+    std::vector<int> EventLoopSetup::inheritListeners(const Json::Value &config) {
+        std::vector<int> inherited;
+        const Json::Value &sockets = config["listening_sockets"];
+        if (sockets.isArray()) {
+            for (const Json::Value &s : sockets) {
+                const int fd = json_cast<int>(s);
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+                inherited.push_back(fd);
+            }
+        }
+        return inherited;
+    }
+
+    bool EventLoopSetup::isUnixSocket(int fd) {
+        sockaddr_storage addr;
+        socklen_t length = sizeof(addr);
+        return ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &length) == 0 && addr.ss_family == AF_UNIX;
+    }
+
+    bool EventLoopSetup::placeLoops(const Json::Value &config, size_t numLoops, std::vector<int> &cpus) {
+        cpus.clear();
+
+        std::vector<int> allowed;
+        if (!ThreadPlacement::parseCpuList(json_cast<std::string>(config["cpu_affinity"]), allowed))
+            return false;
+
+        std::vector<std::vector<int>> nodes;
+        if (json_cast<bool>(config["numa"])) {
+            for (const std::vector<int> &node : ThreadPlacement::getNumaNodes()) {
+                std::vector<int> nodeCpus;
+                for (int c : node) {
+                    if (allowed.empty() || std::binary_search(allowed.begin(), allowed.end(), c))
+                        nodeCpus.push_back(c);
+                }
+                if (!nodeCpus.empty())
+                    nodes.push_back(nodeCpus);
+            }
+        } else if (!allowed.empty()) {
+            nodes.push_back(allowed);
+        }
+
+        if (nodes.empty())
+            return true;
+
+        for (size_t i = 0; i < numLoops; ++i) {
+            const std::vector<int> &node = nodes[i % nodes.size()];
+            cpus.push_back(node[(i / nodes.size()) % node.size()]);
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,282 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/event_stream.h>
+#include <restify/connection.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace restify {
+
+    static const std::shared_ptr<const std::string> HeartbeatBytes = std::make_shared<const std::string>(":\n\n");
+
+    struct EventStream::PrivateData {
+        std::mutex mutex;
+        /** Resumer of the current suspension, replaced by every write. */
+        ConnectionResumer resumer;
+        std::deque<std::shared_ptr<const std::string>> queue;
+        size_t maxQueued;
+        /** A write task is posted and not yet done. */
+        bool scheduled;
+        /** Response ends once the queue is written. */
+        bool closing;
+        /** Connection is gone or the response ended. */
+        bool closed;
+
+        PrivateData(const ConnectionResumer &r, size_t m)
+            :resumer(r), maxQueued(m), scheduled(false), closing(false), closed(false)
+        {}
+    };
+
+    EventStream::EventStream(const ConnectionResumer & resumer, size_t maxQueued)
+        :_data(new PrivateData(resumer, std::max<size_t>(maxQueued, 1)))
+    {}
+
+    EventStream::~EventStream()
+    {}
+
+    bool EventStream::send(const std::string & data, const std::string & event, const std::string & id) {
+        return send(std::make_shared<const std::string>(format(data, event, id)));
+    }
+
+    bool EventStream::send(const std::shared_ptr<const std::string> &bytes) {
+        PrivateData &d = *_data;
+        std::lock_guard<std::mutex> lock(d.mutex);
+        if (d.closing || d.closed)
+            return false;
+
+        if (d.queue.size() >= d.maxQueued) {
+            // Client does not keep up, end the stream rather than buffering without bound.
+            d.queue.clear();
+            d.closing = true;
+        } else {
+            d.queue.push_back(bytes);
+        }
+
+        if (!d.scheduled) {
+            d.scheduled = true;
+            std::shared_ptr<EventStream> self = shared_from_this();
+            d.resumer([self](Connection &c) { self->write(c); });
+        }
+        return !d.closing;
+    }
+
+    bool EventStream::heartbeat() {
+        {
+            std::lock_guard<std::mutex> lock(_data->mutex);
+            if (_data->closing || _data->closed)
+                return false;
+            // Events waiting to be written serve as well.
+            if (!_data->queue.empty())
+                return true;
+        }
+        return send(HeartbeatBytes);
+    }
+
+    void EventStream::close() {
+        PrivateData &d = *_data;
+        std::lock_guard<std::mutex> lock(d.mutex);
+        if (d.closing || d.closed)
+            return;
+
+        d.closing = true;
+        if (!d.scheduled) {
+            d.scheduled = true;
+            std::shared_ptr<EventStream> self = shared_from_this();
+            d.resumer([self](Connection &c) { self->write(c); });
+        }
+    }
+
+    bool EventStream::isOpen() const {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        return !_data->closing && !_data->closed;
+    }
+
+    void EventStream::detach() {
+        PrivateData &d = *_data;
+        std::lock_guard<std::mutex> lock(d.mutex);
+        d.closed = true;
+        d.scheduled = false;
+        d.queue.clear();
+        d.resumer = ConnectionResumer();
+    }
+
+    void EventStream::write(Connection & c) {
+        PrivateData &d = *_data;
+
+        std::deque<std::shared_ptr<const std::string>> pending;
+        bool closing;
+        {
+            std::lock_guard<std::mutex> lock(d.mutex);
+            if (d.closed)
+                return;
+            pending.swap(d.queue);
+            closing = d.closing;
+        }
+
+        bool ok = true;
+        for (const std::shared_ptr<const std::string> &bytes : pending) {
+            if (c.write(bytes->data(), bytes->size()) < 0) {
+                ok = false;
+                break;
+            }
+        }
+
+        if (ok && !closing) {
+            // Stay suspended for events sent in the meantime or later.
+            ConnectionResumer resumer = c.suspend();
+            if (resumer) {
+                std::lock_guard<std::mutex> lock(d.mutex);
+                d.resumer = resumer;
+                if (d.queue.empty() && !d.closing) {
+                    d.scheduled = false;
+                } else {
+                    std::shared_ptr<EventStream> self = shared_from_this();
+                    d.resumer([self](Connection &c) { self->write(c); });
+                }
+                return;
+            }
+        }
+
+        c.closeConnection();
+
+        std::lock_guard<std::mutex> lock(d.mutex);
+        d.closing = true;
+        d.closed = true;
+        d.scheduled = false;
+        d.queue.clear();
+        d.resumer = ConnectionResumer();
+    }
+
+    std::string EventStream::format(const std::string & data, const std::string & event, const std::string & id) {
+        std::string bytes;
+        bytes.reserve(data.size() + event.size() + id.size() + 24);
+
+        if (!event.empty())
+            bytes.append("event: ").append(event).push_back('\n');
+        if (!id.empty())
+            bytes.append("id: ").append(id).push_back('\n');
+
+        // Lines end with CRLF, LF or CR.
+        size_t begin = 0;
+        for (;;) {
+            const size_t end = data.find_first_of("\r\n", begin);
+            bytes.append("data: ").append(data, begin, end == std::string::npos ? std::string::npos : end - begin).push_back('\n');
+            if (end == std::string::npos)
+                break;
+            begin = end + ((data[end] == '\r' && end + 1 < data.size() && data[end + 1] == '\n') ? 2 : 1);
+        }
+
+        bytes.push_back('\n');
+        return bytes;
+    }
+
+    struct EventHub::PrivateData {
+        mutable std::mutex mutex;
+        std::vector<std::shared_ptr<EventStream>> streams;
+
+        std::mutex timerMutex;
+        std::condition_variable timer;
+        bool stopping;
+        std::thread heartbeats;
+
+        PrivateData()
+            :stopping(false)
+        {}
+
+        /** Apply send to all streams, dropping those it fails on. Returns the number of successes. */
+        template<class Send>
+        size_t each(const Send &send) {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t i = 0;
+            while (i < streams.size()) {
+                if (send(*streams[i])) {
+                    ++i;
+                } else {
+                    streams[i] = std::move(streams.back());
+                    streams.pop_back();
+                }
+            }
+            return streams.size();
+        }
+    };
+
+    EventHub::EventHub(int heartbeatInterval)
+        :_data(new PrivateData())
+    {
+        if (heartbeatInterval <= 0)
+            return;
+
+        _data->heartbeats = std::thread([this, heartbeatInterval]() {
+            PrivateData &d = *_data;
+            std::unique_lock<std::mutex> lock(d.timerMutex);
+            while (!d.timer.wait_for(lock, std::chrono::milliseconds(heartbeatInterval), [&d]() { return d.stopping; })) {
+                lock.unlock();
+                heartbeat();
+                lock.lock();
+            }
+        });
+    }
+
+    EventHub::~EventHub()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_data->timerMutex);
+            _data->stopping = true;
+        }
+        _data->timer.notify_one();
+        if (_data->heartbeats.joinable())
+            _data->heartbeats.join();
+    }
+
+    void EventHub::subscribe(const std::shared_ptr<EventStream>& stream) {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        _data->streams.push_back(stream);
+    }
+
+    void EventHub::unsubscribe(const std::shared_ptr<EventStream>& stream) {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        std::vector<std::shared_ptr<EventStream>> &streams = _data->streams;
+        streams.erase(std::remove(streams.begin(), streams.end(), stream), streams.end());
+    }
+
+    size_t EventHub::broadcast(const std::string & data, const std::string & event, const std::string & id) {
+        return broadcast(std::make_shared<const std::string>(EventStream::format(data, event, id)));
+    }
+
+    size_t EventHub::broadcast(const std::shared_ptr<const std::string>& bytes) {
+        return _data->each([&bytes](EventStream &s) { return s.send(bytes); });
+    }
+
+    size_t EventHub::heartbeat() {
+        return _data->each([](EventStream &s) { return s.heartbeat(); });
+    }
+
+    void EventHub::close() {
+        std::vector<std::shared_ptr<EventStream>> streams;
+        {
+            std::lock_guard<std::mutex> lock(_data->mutex);
+            streams.swap(_data->streams);
+        }
+        for (const std::shared_ptr<EventStream> &s : streams)
+            s->close();
+    }
+
+    size_t EventHub::getSubscriberCount() const {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        return _data->streams.size();
+    }
+
+}
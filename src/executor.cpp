@@ -0,0 +1,165 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/executor.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace restify {
+
+    Executor::~Executor()
+    {}
+
+    /** Executor and queue index of the calling pool thread. */
+    static thread_local const void *currentExecutor = nullptr;
+    static thread_local size_t currentIndex = 0;
+
+    struct WorkStealingExecutor::PrivateData {
+        struct Worker {
+            std::mutex mutex;
+            std::deque<ExecutorTask> tasks;
+            std::thread thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<size_t> nextWorker;
+        std::atomic<size_t> pending;
+
+        std::mutex idleMutex;
+        std::condition_variable idle;
+        std::atomic<size_t> sleeping;
+        bool stopping;
+
+        PrivateData()
+            :nextWorker(0), pending(0), sleeping(0), stopping(false)
+        {}
+    };
+
+    WorkStealingExecutor::WorkStealingExecutor(size_t numThreads)
+        :_data(new PrivateData())
+    {
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        for (size_t i = 0; i < numThreads; ++i)
+            _data->workers.emplace_back(new PrivateData::Worker());
+
+        for (size_t i = 0; i < numThreads; ++i)
+            _data->workers[i]->thread = std::thread(&WorkStealingExecutor::run, this, i);
+    }
+
+    WorkStealingExecutor::~WorkStealingExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_data->idleMutex);
+            _data->stopping = true;
+        }
+        _data->idle.notify_all();
+
+        for (auto &w : _data->workers)
+            w->thread.join();
+    }
+
+    size_t WorkStealingExecutor::getThreadCount() const {
+        return _data->workers.size();
+    }
+
+    void WorkStealingExecutor::submit(const ExecutorTask & task, int affinity) {
+        PrivateData &d = *_data;
+        const size_t n = d.workers.size();
+
+        size_t index;
+        if (affinity >= 0)
+            index = (size_t)affinity % n;
+        else if (currentExecutor == this)
+            index = currentIndex;
+        else
+            index = d.nextWorker.fetch_add(1, std::memory_order_relaxed) % n;
+
+        {
+            PrivateData::Worker &w = *d.workers[index];
+            std::lock_guard<std::mutex> lock(w.mutex);
+            w.tasks.push_back(task);
+        }
+        d.pending.fetch_add(1);
+
+        // Only take the idle lock when somebody might be sleeping. Sleepers register
+        // before checking pending, so either they see the task or we see them.
+        if (d.sleeping.load() > 0) {
+            { std::lock_guard<std::mutex> lock(d.idleMutex); }
+            d.idle.notify_one();
+        }
+    }
+
+    bool WorkStealingExecutor::tryRun(size_t index) {
+        PrivateData &d = *_data;
+        const size_t n = d.workers.size();
+
+        ExecutorTask task;
+
+        // Own queue first, newest task is most likely still in cache.
+        {
+            PrivateData::Worker &w = *d.workers[index];
+            std::lock_guard<std::mutex> lock(w.mutex);
+            if (!w.tasks.empty()) {
+                task = std::move(w.tasks.back());
+                w.tasks.pop_back();
+            }
+        }
+
+        // Steal oldest task from others.
+        for (size_t i = 1; !task && i < n; ++i) {
+            PrivateData::Worker &w = *d.workers[(index + i) % n];
+            std::unique_lock<std::mutex> lock(w.mutex, std::try_to_lock);
+            if (lock.owns_lock() && !w.tasks.empty()) {
+                task = std::move(w.tasks.front());
+                w.tasks.pop_front();
+            }
+        }
+
+        if (!task)
+            return false;
+
+        d.pending.fetch_sub(1);
+        try {
+            task();
+        } catch (...) {
+            // Tasks report their own errors.
+        }
+        return true;
+    }
+
+    void WorkStealingExecutor::run(size_t index) {
+        PrivateData &d = *_data;
+        currentExecutor = this;
+        currentIndex = index;
+
+        for (;;) {
+            if (tryRun(index))
+                continue;
+
+            std::unique_lock<std::mutex> lock(d.idleMutex);
+            if (d.pending.load() > 0)
+                continue;
+            if (d.stopping)
+                break;
+
+            ++d.sleeping;
+            d.idle.wait(lock, [&d]() { return d.stopping || d.pending.load() > 0; });
+            --d.sleeping;
+        }
+    }
+
+}
@@ -0,0 +1,136 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/frame_pool.h>
+#include <mutex>
+#include <vector>
+#include <new>
+#include <cstdint>
+
+namespace restify {
+
+    static const size_t Granularity = 64;
+    static const size_t NumSizeClasses = 64;
+
+    /** Precedes every block, keeps the owning pool alive. */
+    struct alignas(std::max_align_t) BlockHeader {
+        std::shared_ptr<FramePool> pool;
+        size_t sizeClass;
+    };
+
+    static const size_t HeaderSize = (sizeof(BlockHeader) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    static thread_local FramePool *currentPool = nullptr;
+
+    struct FramePool::PrivateData {
+        mutable std::mutex mutex;
+        std::vector<void*> free[NumSizeClasses];
+        size_t maxCachedBlocks;
+        uint64_t reused;
+
+        PrivateData(size_t maxCached)
+            :maxCachedBlocks(maxCached), reused(0)
+        {}
+    };
+
+    FramePool::Scope::Scope(const std::shared_ptr<FramePool> &pool)
+        :_pool(pool), _previous(currentPool)
+    {
+        currentPool = pool.get();
+    }
+
+    FramePool::Scope::~Scope() {
+        currentPool = _previous;
+    }
+
+    FramePool::FramePool(size_t maxCachedBlocks)
+        :_data(new PrivateData(maxCachedBlocks))
+    {}
+
+    FramePool::~FramePool() {
+        for (auto &list : _data->free) {
+            for (void *block : list)
+                ::operator delete(block);
+        }
+    }
+
+    FramePool * FramePool::current() {
+        return currentPool;
+    }
+
+    void * FramePool::allocate(size_t size) {
+        const size_t sizeClass = (size + HeaderSize + Granularity - 1) / Granularity;
+
+        FramePool *pool = currentPool;
+        void *block = nullptr;
+        if (pool && sizeClass < NumSizeClasses)
+            block = pool->take(sizeClass);
+        if (!block)
+            block = ::operator new(sizeClass * Granularity);
+
+        BlockHeader *h = new (block) BlockHeader();
+        h->sizeClass = sizeClass;
+        if (pool && sizeClass < NumSizeClasses)
+            h->pool = pool->shared_from_this();
+
+        return static_cast<char*>(block) + HeaderSize;
+    }
+
+    void FramePool::deallocate(void * p) {
+        if (!p)
+            return;
+
+        void *block = static_cast<char*>(p) - HeaderSize;
+        BlockHeader *h = static_cast<BlockHeader*>(block);
+
+        std::shared_ptr<FramePool> pool = std::move(h->pool);
+        const size_t sizeClass = h->sizeClass;
+        h->~BlockHeader();
+
+        if (!pool || !pool->give(block, sizeClass))
+            ::operator delete(block);
+    }
+
+    size_t FramePool::getCachedBlockCount() const {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        size_t count = 0;
+        for (auto &list : _data->free)
+            count += list.size();
+        return count;
+    }
+
+    uint64_t FramePool::getReusedBlockCount() const {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        return _data->reused;
+    }
+
+    void * FramePool::take(size_t sizeClass) {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        std::vector<void*> &list = _data->free[sizeClass];
+        if (list.empty())
+            return nullptr;
+
+        void *block = list.back();
+        list.pop_back();
+        ++_data->reused;
+        return block;
+    }
+
+    bool FramePool::give(void * block, size_t sizeClass) {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        std::vector<void*> &list = _data->free[sizeClass];
+        if (list.size() >= _data->maxCachedBlocks)
+            return false;
+
+        list.push_back(block);
+        return true;
+    }
+
+}
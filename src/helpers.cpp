@@ -16,9 +16,9 @@
 
 namespace restify {
 
-    inline void updateFieldIfNot(Json::Value & a, const Json::Value & b, const std::string &key, int condition) {
+    inline void updateFieldIfNot(Json::Value & a, const Json::Value & b, int condition) {
         if (condition == 0) {
-            a[key] = b[key];
+            a = b;
         }
     }
 
@@ -28,26 +28,33 @@ namespace restify {
             return false;
         }
             
-        // For each key in b
+        // For each key in b, refer to member names in place instead of copying them.
         bool ok = true;
-        for (const auto& key : b.getMemberNames()) {
+        for (auto i = b.begin(); i != b.end(); ++i) {
+            const char *end = nullptr;
+            const char *begin = i.memberName(&end);
 
-            if (a[key].isObject() && b[key].isObject()) {
+            // Look up existing members without building a key string.
+            const Json::Value *existing = a.find(begin, end);
+            Json::Value &av = existing ? const_cast<Json::Value&>(*existing) : a[std::string(begin, end)];
+            const Json::Value &bv = *i;
+
+            if (av.isObject() && bv.isObject()) {
                 // Both are objects, recurse.
-                ok &= jsonMerge(a[key], b[key], ignoreFlags);
+                ok &= jsonMerge(av, bv, ignoreFlags);
             } else {
                 // Either of both is not object.
-                if (a[key].type() == b[key].type()) {
+                if (av.type() == bv.type()) {
                     // Both have the same type
-                    updateFieldIfNot(a, b, key, ignoreFlags & JsonMergeFlags::IgnoreNewValues);
+                    updateFieldIfNot(av, bv, ignoreFlags & JsonMergeFlags::IgnoreNewValues);
                 } else {
                     // Type of both is different
-                    if (a[key].isNull()) {
+                    if (av.isNull()) {
                         // field is not present in a
-                        updateFieldIfNot(a, b, key, ignoreFlags & JsonMergeFlags::IgnoreNewFields);
+                        updateFieldIfNot(av, bv, ignoreFlags & JsonMergeFlags::IgnoreNewFields);
                     } else {
                         // field is already present in a (we also know from above that they cannot be of same type.
-                        updateFieldIfNot(a, b, key, ignoreFlags & JsonMergeFlags::IgnoreNewType);
+                        updateFieldIfNot(av, bv, ignoreFlags & JsonMergeFlags::IgnoreNewType);
                     }
                 }
             }
@@ -109,6 +116,32 @@ namespace restify {
         return result;
     }
 
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    std::string urlDecode(const char *str, size_t length, bool decodePlus) {
+        std::string result;
+        result.reserve(length);
+
+        for (size_t i = 0; i < length; ++i) {
+            const char c = str[i];
+            if (c == '%' && i + 2 < length && hexValue(str[i + 1]) >= 0 && hexValue(str[i + 2]) >= 0) {
+                result.push_back(static_cast<char>(hexValue(str[i + 1]) * 16 + hexValue(str[i + 2])));
+                i += 2;
+            } else if (c == '+' && decodePlus) {
+                result.push_back(' ');
+            } else {
+                result.push_back(c);
+            }
+        }
+
+        return result;
+    }
+
     JsonBuilder::JsonBuilder()
         :_root(new Json::Value(), JsonBuilder::defaultDelete)
     {}
@@ -0,0 +1,528 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/http/hpack.h>
+#include <deque>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace restify {
+
+    struct StaticEntry {
+        const char *name;
+        const char *value;
+    };
+
+    /** Static table of RFC 7541 Appendix A, index 1 is the first entry. */
+    static const StaticEntry StaticTable[] = {
+        { ":authority", "" }, { ":method", "GET" }, { ":method", "POST" }, { ":path", "/" },
+        { ":path", "/index.html" }, { ":scheme", "http" }, { ":scheme", "https" }, { ":status", "200" },
+        { ":status", "204" }, { ":status", "206" }, { ":status", "304" }, { ":status", "400" },
+        { ":status", "404" }, { ":status", "500" }, { "accept-charset", "" }, { "accept-encoding", "gzip, deflate" },
+        { "accept-language", "" }, { "accept-ranges", "" }, { "accept", "" }, { "access-control-allow-origin", "" },
+        { "age", "" }, { "allow", "" }, { "authorization", "" }, { "cache-control", "" },
+        { "content-disposition", "" }, { "content-encoding", "" }, { "content-language", "" }, { "content-length", "" },
+        { "content-location", "" }, { "content-range", "" }, { "content-type", "" }, { "cookie", "" },
+        { "date", "" }, { "etag", "" }, { "expect", "" }, { "expires", "" },
+        { "from", "" }, { "host", "" }, { "if-match", "" }, { "if-modified-since", "" },
+        { "if-none-match", "" }, { "if-range", "" }, { "if-unmodified-since", "" }, { "last-modified", "" },
+        { "link", "" }, { "location", "" }, { "max-forwards", "" }, { "proxy-authenticate", "" },
+        { "proxy-authorization", "" }, { "range", "" }, { "referer", "" }, { "refresh", "" },
+        { "retry-after", "" }, { "server", "" }, { "set-cookie", "" }, { "strict-transport-security", "" },
+        { "transfer-encoding", "" }, { "user-agent", "" }, { "vary", "" }, { "via", "" },
+        { "www-authenticate", "" },
+    };
+
+    static const size_t StaticTableSize = sizeof(StaticTable) / sizeof(StaticTable[0]);
+
+    struct HuffmanSymbol {
+        uint32_t code;
+        uint8_t length;
+    };
+
+    /** Huffman code of RFC 7541 Appendix B for each byte value. */
+    static const HuffmanSymbol HuffmanCodes[256] = {
+        { 0x1ff8, 13 }, { 0x7fffd8, 23 }, { 0xfffffe2, 28 }, { 0xfffffe3, 28 }, { 0xfffffe4, 28 }, { 0xfffffe5, 28 },
+        { 0xfffffe6, 28 }, { 0xfffffe7, 28 }, { 0xfffffe8, 28 }, { 0xffffea, 24 }, { 0x3ffffffc, 30 }, { 0xfffffe9, 28 },
+        { 0xfffffea, 28 }, { 0x3ffffffd, 30 }, { 0xfffffeb, 28 }, { 0xfffffec, 28 }, { 0xfffffed, 28 }, { 0xfffffee, 28 },
+        { 0xfffffef, 28 }, { 0xffffff0, 28 }, { 0xffffff1, 28 }, { 0xffffff2, 28 }, { 0x3ffffffe, 30 }, { 0xffffff3, 28 },
+        { 0xffffff4, 28 }, { 0xffffff5, 28 }, { 0xffffff6, 28 }, { 0xffffff7, 28 }, { 0xffffff8, 28 }, { 0xffffff9, 28 },
+        { 0xffffffa, 28 }, { 0xffffffb, 28 }, { 0x14, 6 }, { 0x3f8, 10 }, { 0x3f9, 10 }, { 0xffa, 12 },
+        { 0x1ff9, 13 }, { 0x15, 6 }, { 0xf8, 8 }, { 0x7fa, 11 }, { 0x3fa, 10 }, { 0x3fb, 10 },
+        { 0xf9, 8 }, { 0x7fb, 11 }, { 0xfa, 8 }, { 0x16, 6 }, { 0x17, 6 }, { 0x18, 6 },
+        { 0x0, 5 }, { 0x1, 5 }, { 0x2, 5 }, { 0x19, 6 }, { 0x1a, 6 }, { 0x1b, 6 },
+        { 0x1c, 6 }, { 0x1d, 6 }, { 0x1e, 6 }, { 0x1f, 6 }, { 0x5c, 7 }, { 0xfb, 8 },
+        { 0x7ffc, 15 }, { 0x20, 6 }, { 0xffb, 12 }, { 0x3fc, 10 }, { 0x1ffa, 13 }, { 0x21, 6 },
+        { 0x5d, 7 }, { 0x5e, 7 }, { 0x5f, 7 }, { 0x60, 7 }, { 0x61, 7 }, { 0x62, 7 },
+        { 0x63, 7 }, { 0x64, 7 }, { 0x65, 7 }, { 0x66, 7 }, { 0x67, 7 }, { 0x68, 7 },
+        { 0x69, 7 }, { 0x6a, 7 }, { 0x6b, 7 }, { 0x6c, 7 }, { 0x6d, 7 }, { 0x6e, 7 },
+        { 0x6f, 7 }, { 0x70, 7 }, { 0x71, 7 }, { 0x72, 7 }, { 0xfc, 8 }, { 0x73, 7 },
+        { 0xfd, 8 }, { 0x1ffb, 13 }, { 0x7fff0, 19 }, { 0x1ffc, 13 }, { 0x3ffc, 14 }, { 0x22, 6 },
+        { 0x7ffd, 15 }, { 0x3, 5 }, { 0x23, 6 }, { 0x4, 5 }, { 0x24, 6 }, { 0x5, 5 },
+        { 0x25, 6 }, { 0x26, 6 }, { 0x27, 6 }, { 0x6, 5 }, { 0x74, 7 }, { 0x75, 7 },
+        { 0x28, 6 }, { 0x29, 6 }, { 0x2a, 6 }, { 0x7, 5 }, { 0x2b, 6 }, { 0x76, 7 },
+        { 0x2c, 6 }, { 0x8, 5 }, { 0x9, 5 }, { 0x2d, 6 }, { 0x77, 7 }, { 0x78, 7 },
+        { 0x79, 7 }, { 0x7a, 7 }, { 0x7b, 7 }, { 0x7ffe, 15 }, { 0x7fc, 11 }, { 0x3ffd, 14 },
+        { 0x1ffd, 13 }, { 0xffffffc, 28 }, { 0xfffe6, 20 }, { 0x3fffd2, 22 }, { 0xfffe7, 20 }, { 0xfffe8, 20 },
+        { 0x3fffd3, 22 }, { 0x3fffd4, 22 }, { 0x3fffd5, 22 }, { 0x7fffd9, 23 }, { 0x3fffd6, 22 }, { 0x7fffda, 23 },
+        { 0x7fffdb, 23 }, { 0x7fffdc, 23 }, { 0x7fffdd, 23 }, { 0x7fffde, 23 }, { 0xffffeb, 24 }, { 0x7fffdf, 23 },
+        { 0xffffec, 24 }, { 0xffffed, 24 }, { 0x3fffd7, 22 }, { 0x7fffe0, 23 }, { 0xffffee, 24 }, { 0x7fffe1, 23 },
+        { 0x7fffe2, 23 }, { 0x7fffe3, 23 }, { 0x7fffe4, 23 }, { 0x1fffdc, 21 }, { 0x3fffd8, 22 }, { 0x7fffe5, 23 },
+        { 0x3fffd9, 22 }, { 0x7fffe6, 23 }, { 0x7fffe7, 23 }, { 0xffffef, 24 }, { 0x3fffda, 22 }, { 0x1fffdd, 21 },
+        { 0xfffe9, 20 }, { 0x3fffdb, 22 }, { 0x3fffdc, 22 }, { 0x7fffe8, 23 }, { 0x7fffe9, 23 }, { 0x1fffde, 21 },
+        { 0x7fffea, 23 }, { 0x3fffdd, 22 }, { 0x3fffde, 22 }, { 0xfffff0, 24 }, { 0x1fffdf, 21 }, { 0x3fffdf, 22 },
+        { 0x7fffeb, 23 }, { 0x7fffec, 23 }, { 0x1fffe0, 21 }, { 0x1fffe1, 21 }, { 0x3fffe0, 22 }, { 0x1fffe2, 21 },
+        { 0x7fffed, 23 }, { 0x3fffe1, 22 }, { 0x7fffee, 23 }, { 0x7fffef, 23 }, { 0xfffea, 20 }, { 0x3fffe2, 22 },
+        { 0x3fffe3, 22 }, { 0x3fffe4, 22 }, { 0x7ffff0, 23 }, { 0x3fffe5, 22 }, { 0x3fffe6, 22 }, { 0x7ffff1, 23 },
+        { 0x3ffffe0, 26 }, { 0x3ffffe1, 26 }, { 0xfffeb, 20 }, { 0x7fff1, 19 }, { 0x3fffe7, 22 }, { 0x7ffff2, 23 },
+        { 0x3fffe8, 22 }, { 0x1ffffec, 25 }, { 0x3ffffe2, 26 }, { 0x3ffffe3, 26 }, { 0x3ffffe4, 26 }, { 0x7ffffde, 27 },
+        { 0x7ffffdf, 27 }, { 0x3ffffe5, 26 }, { 0xfffff1, 24 }, { 0x1ffffed, 25 }, { 0x7fff2, 19 }, { 0x1fffe3, 21 },
+        { 0x3ffffe6, 26 }, { 0x7ffffe0, 27 }, { 0x7ffffe1, 27 }, { 0x3ffffe7, 26 }, { 0x7ffffe2, 27 }, { 0xfffff2, 24 },
+        { 0x1fffe4, 21 }, { 0x1fffe5, 21 }, { 0x3ffffe8, 26 }, { 0x3ffffe9, 26 }, { 0xffffffd, 28 }, { 0x7ffffe3, 27 },
+        { 0x7ffffe4, 27 }, { 0x7ffffe5, 27 }, { 0xfffec, 20 }, { 0xfffff3, 24 }, { 0xfffed, 20 }, { 0x1fffe6, 21 },
+        { 0x3fffe9, 22 }, { 0x1fffe7, 21 }, { 0x1fffe8, 21 }, { 0x7ffff3, 23 }, { 0x3fffea, 22 }, { 0x3fffeb, 22 },
+        { 0x1ffffee, 25 }, { 0x1ffffef, 25 }, { 0xfffff4, 24 }, { 0xfffff5, 24 }, { 0x3ffffea, 26 }, { 0x7ffff4, 23 },
+        { 0x3ffffeb, 26 }, { 0x7ffffe6, 27 }, { 0x3ffffec, 26 }, { 0x3ffffed, 26 }, { 0x7ffffe7, 27 }, { 0x7ffffe8, 27 },
+        { 0x7ffffe9, 27 }, { 0x7ffffea, 27 }, { 0x7ffffeb, 27 }, { 0xffffffe, 28 }, { 0x7ffffec, 27 }, { 0x7ffffed, 27 },
+        { 0x7ffffee, 27 }, { 0x7ffffef, 27 }, { 0x7fffff0, 27 }, { 0x3ffffee, 26 },
+    };
+
+    static const uint32_t EosCode = 0x3fffffff;
+    static const int EosLength = 30;
+
+    /** Codes of equal length are consecutive, decoding looks them up per length. */
+    struct HuffmanDecodeTable {
+        uint32_t first[EosLength + 1];
+        uint32_t count[EosLength + 1];
+        uint32_t offset[EosLength + 1];
+        /** Symbols ordered by length and code, 256 stands for EOS. */
+        uint16_t symbols[257];
+
+        HuffmanDecodeTable() {
+            memset(first, 0, sizeof(first));
+            memset(count, 0, sizeof(count));
+            memset(offset, 0, sizeof(offset));
+
+            uint32_t next = 0;
+            for (int length = 1; length <= EosLength; ++length) {
+                offset[length] = next;
+                for (int code = 0; code <= 256; ++code) {
+                    if (lengthOf(code) == length)
+                        ++count[length];
+                }
+
+                // Insertion by code keeps symbols of this length sorted.
+                for (int sym = 0; sym <= 256; ++sym) {
+                    if (lengthOf(sym) != length)
+                        continue;
+                    uint32_t i = next++;
+                    while (i > offset[length] && codeOf(symbols[i - 1]) > codeOf(sym)) {
+                        symbols[i] = symbols[i - 1];
+                        --i;
+                    }
+                    symbols[i] = (uint16_t)sym;
+                }
+                if (count[length] > 0)
+                    first[length] = codeOf(symbols[offset[length]]);
+            }
+        }
+
+        static int lengthOf(int sym) {
+            return sym == 256 ? EosLength : HuffmanCodes[sym].length;
+        }
+
+        static uint32_t codeOf(int sym) {
+            return sym == 256 ? EosCode : HuffmanCodes[sym].code;
+        }
+    };
+
+    static const HuffmanDecodeTable &huffmanDecodeTable() {
+        static const HuffmanDecodeTable table;
+        return table;
+    }
+
+    void huffmanEncode(const char * data, size_t length, std::string & out) {
+        uint64_t bits = 0;
+        int pending = 0;
+
+        for (size_t i = 0; i < length; ++i) {
+            const HuffmanSymbol &s = HuffmanCodes[(uint8_t)data[i]];
+            bits = (bits << s.length) | s.code;
+            pending += s.length;
+            while (pending >= 8) {
+                pending -= 8;
+                out.push_back((char)(bits >> pending));
+            }
+        }
+
+        // Pad with the most significant bits of EOS.
+        if (pending > 0)
+            out.push_back((char)((bits << (8 - pending)) | (0xff >> pending)));
+    }
+
+    size_t huffmanEncodedLength(const char * data, size_t length) {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < length; ++i)
+            bits += HuffmanCodes[(uint8_t)data[i]].length;
+        return (size_t)((bits + 7) / 8);
+    }
+
+    bool huffmanDecode(const char * data, size_t length, std::string & out) {
+        const HuffmanDecodeTable &t = huffmanDecodeTable();
+
+        uint32_t code = 0;
+        int bits = 0;
+        for (size_t i = 0; i < length; ++i) {
+            const uint8_t byte = (uint8_t)data[i];
+            for (int b = 7; b >= 0; --b) {
+                code = (code << 1) | ((byte >> b) & 1);
+                ++bits;
+
+                if (t.count[bits] > 0 && code >= t.first[bits] && code - t.first[bits] < t.count[bits]) {
+                    const uint16_t sym = t.symbols[t.offset[bits] + code - t.first[bits]];
+                    if (sym == 256)
+                        return false;
+                    out.push_back((char)sym);
+                    code = 0;
+                    bits = 0;
+                } else if (bits == EosLength) {
+                    return false;
+                }
+            }
+        }
+
+        // Padding is shorter than a byte and consists of the leading bits of EOS.
+        return bits < 8 && code == (1u << bits) - 1;
+    }
+
+    /** Dynamic table, the most recently added entry comes first. */
+    struct HpackTable {
+        std::deque<std::pair<std::string, std::string>> entries;
+        size_t size;
+        size_t maxSize;
+
+        HpackTable(size_t max)
+            :size(0), maxSize(max)
+        {}
+
+        static size_t entrySize(const std::string &name, const std::string &value) {
+            return name.size() + value.size() + 32;
+        }
+
+        void evict(size_t target) {
+            while (size > target && !entries.empty()) {
+                size -= entrySize(entries.back().first, entries.back().second);
+                entries.pop_back();
+            }
+        }
+
+        void setMaxSize(size_t max) {
+            maxSize = max;
+            evict(maxSize);
+        }
+
+        /** Add entry, an entry larger than the table empties it. */
+        void add(const std::string &name, const std::string &value) {
+            const size_t s = entrySize(name, value);
+            if (s > maxSize) {
+                evict(0);
+                return;
+            }
+            evict(maxSize - s);
+            entries.emplace_front(name, value);
+            size += s;
+        }
+    };
+
+    static bool decodeInteger(const uint8_t *&p, const uint8_t *end, int prefix, uint32_t &value) {
+        if (p == end)
+            return false;
+
+        const uint32_t mask = (1u << prefix) - 1;
+        value = *p++ & mask;
+        if (value < mask)
+            return true;
+
+        for (int shift = 0; shift <= 21; shift += 7) {
+            if (p == end)
+                return false;
+            const uint8_t b = *p++;
+            value += (uint32_t)(b & 0x7f) << shift;
+            if ((b & 0x80) == 0)
+                return true;
+        }
+
+        // Larger values exceed any sensible header or table size.
+        return false;
+    }
+
+    static bool decodeString(const uint8_t *&p, const uint8_t *end, std::string &out) {
+        if (p == end)
+            return false;
+
+        const bool huffman = (*p & 0x80) != 0;
+        uint32_t length = 0;
+        if (!decodeInteger(p, end, 7, length) || length > (size_t)(end - p))
+            return false;
+
+        out.clear();
+        const char *s = reinterpret_cast<const char*>(p);
+        p += length;
+        if (huffman)
+            return huffmanDecode(s, length, out);
+
+        out.assign(s, length);
+        return true;
+    }
+
+    static void encodeInteger(uint8_t first, int prefix, uint32_t value, std::string &out) {
+        const uint32_t mask = (1u << prefix) - 1;
+        if (value < mask) {
+            out.push_back((char)(first | value));
+            return;
+        }
+
+        out.push_back((char)(first | mask));
+        value -= mask;
+        while (value >= 0x80) {
+            out.push_back((char)((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back((char)value);
+    }
+
+    static void encodeString(const std::string &s, std::string &out) {
+        const size_t huffmanLength = huffmanEncodedLength(s.data(), s.size());
+        if (huffmanLength < s.size()) {
+            encodeInteger(0x80, 7, (uint32_t)huffmanLength, out);
+            huffmanEncode(s.data(), s.size(), out);
+        } else {
+            encodeInteger(0, 7, (uint32_t)s.size(), out);
+            out.append(s);
+        }
+    }
+
+    struct HpackDecoder::PrivateData {
+        HpackTable table;
+        /** Limit set through SETTINGS_HEADER_TABLE_SIZE. */
+        size_t maxTableSize;
+
+        PrivateData(size_t max)
+            :table(max), maxTableSize(max)
+        {}
+
+        bool lookup(uint32_t index, std::string *name, std::string *value) const {
+            if (index == 0)
+                return false;
+            if (index <= StaticTableSize) {
+                if (name)
+                    name->assign(StaticTable[index - 1].name);
+                if (value)
+                    value->assign(StaticTable[index - 1].value);
+                return true;
+            }
+
+            index -= (uint32_t)StaticTableSize + 1;
+            if (index >= table.entries.size())
+                return false;
+            if (name)
+                *name = table.entries[index].first;
+            if (value)
+                *value = table.entries[index].second;
+            return true;
+        }
+    };
+
+    HpackDecoder::HpackDecoder(size_t maxTableSize)
+        :_data(new PrivateData(maxTableSize))
+    {}
+
+    HpackDecoder::~HpackDecoder()
+    {}
+
+    bool HpackDecoder::decode(const char * data, size_t length, std::vector<Header> &headers) {
+        bool tooLarge = false;
+        return decode(data, length, headers, std::numeric_limits<size_t>::max(), tooLarge);
+    }
+
+    bool HpackDecoder::decode(const char * data, size_t length, std::vector<Header> &headers, size_t maxListSize, bool &tooLarge) {
+        PrivateData &d = *_data;
+        const uint8_t *p = reinterpret_cast<const uint8_t*>(data);
+        const uint8_t *end = p + length;
+
+        // Indexed fields expand a single byte into a whole table entry, the list size is bounded
+        // as fields are decoded rather than once all are.
+        const size_t first = headers.size();
+        size_t listSize = 0;
+        Header skipped;
+        tooLarge = false;
+
+        bool fieldSeen = false;
+        while (p < end) {
+            const uint8_t b = *p;
+            Header *h = nullptr;
+
+            if (b & 0x80) {
+                // Indexed field
+                uint32_t index = 0;
+                if (!decodeInteger(p, end, 7, index))
+                    return false;
+                if (tooLarge) {
+                    if (!d.lookup(index, nullptr, nullptr))
+                        return false;
+                } else {
+                    headers.emplace_back();
+                    h = &headers.back();
+                    if (!d.lookup(index, &h->first, &h->second))
+                        return false;
+                }
+            } else if ((b & 0xe0) == 0x20) {
+                // Table size updates precede the fields of a block.
+                uint32_t size = 0;
+                if (fieldSeen || !decodeInteger(p, end, 5, size) || size > d.maxTableSize)
+                    return false;
+                d.table.setMaxSize(size);
+                continue;
+            } else {
+                // Literal with incremental indexing, without indexing or never indexed.
+                const bool indexing = (b & 0xc0) == 0x40;
+                uint32_t index = 0;
+                if (!decodeInteger(p, end, indexing ? 6 : 4, index))
+                    return false;
+
+                // Literals are bounded by the block, decoding them keeps the table in sync.
+                Header *literal = &skipped;
+                if (!tooLarge) {
+                    headers.emplace_back();
+                    literal = h = &headers.back();
+                }
+                if (index == 0) {
+                    if (!decodeString(p, end, literal->first))
+                        return false;
+                } else if (!d.lookup(index, &literal->first, nullptr)) {
+                    return false;
+                }
+                if (!decodeString(p, end, literal->second))
+                    return false;
+
+                if (indexing)
+                    d.table.add(literal->first, literal->second);
+            }
+            fieldSeen = true;
+
+            if (h) {
+                listSize += h->first.size() + h->second.size() + 32;
+                if (listSize > maxListSize) {
+                    tooLarge = true;
+                    headers.erase(headers.begin() + first, headers.end());
+                }
+            }
+        }
+
+        return true;
+    }
+
+    size_t HpackDecoder::getTableSize() const {
+        return _data->table.size;
+    }
+
+    size_t HpackDecoder::getTableCount() const {
+        return _data->table.entries.size();
+    }
+
+    /** Fields whose values rarely repeat are not worth a table entry. */
+    static bool worthIndexing(const std::string &name) {
+        return name != "content-length" && name != "date" && name != "etag" && name != "set-cookie";
+    }
+
+    struct HpackEncoder::PrivateData {
+        HpackTable table;
+        size_t capacity;
+        bool sizeUpdate;
+
+        PrivateData(size_t max)
+            :table(max), capacity(max), sizeUpdate(false)
+        {}
+
+        /** Index of an exact match, or 0 and nameIndex set to a field with the same name if any. */
+        uint32_t find(const std::string &name, const std::string &value, uint32_t &nameIndex) const {
+            nameIndex = 0;
+            for (size_t i = 0; i < StaticTableSize; ++i) {
+                if (name != StaticTable[i].name)
+                    continue;
+                if (value == StaticTable[i].value)
+                    return (uint32_t)i + 1;
+                if (nameIndex == 0)
+                    nameIndex = (uint32_t)i + 1;
+            }
+
+            for (size_t i = 0; i < table.entries.size(); ++i) {
+                if (table.entries[i].first != name)
+                    continue;
+                if (table.entries[i].second == value)
+                    return (uint32_t)(StaticTableSize + 1 + i);
+                if (nameIndex == 0)
+                    nameIndex = (uint32_t)(StaticTableSize + 1 + i);
+            }
+            return 0;
+        }
+    };
+
+    HpackEncoder::HpackEncoder(size_t maxTableSize)
+        :_data(new PrivateData(maxTableSize))
+    {}
+
+    HpackEncoder::~HpackEncoder()
+    {}
+
+    void HpackEncoder::setMaxTableSize(size_t size) {
+        PrivateData &d = *_data;
+        d.table.setMaxSize(std::min(size, d.capacity));
+        d.sizeUpdate = true;
+    }
+
+    void HpackEncoder::encode(const std::vector<Header>& headers, std::string & block) {
+        PrivateData &d = *_data;
+
+        if (d.sizeUpdate) {
+            encodeInteger(0x20, 5, (uint32_t)d.table.maxSize, block);
+            d.sizeUpdate = false;
+        }
+
+        for (const Header &h : headers) {
+            uint32_t nameIndex = 0;
+            const uint32_t index = d.find(h.first, h.second, nameIndex);
+            if (index > 0) {
+                encodeInteger(0x80, 7, index, block);
+                continue;
+            }
+
+            const bool indexing = worthIndexing(h.first) && HpackTable::entrySize(h.first, h.second) <= d.table.maxSize / 2;
+            if (indexing)
+                encodeInteger(0x40, 6, nameIndex, block);
+            else
+                encodeInteger(0x00, 4, nameIndex, block);
+
+            if (nameIndex == 0)
+                encodeString(h.first, block);
+            encodeString(h.second, block);
+
+            if (indexing)
+                d.table.add(h.first, h.second);
+        }
+    }
+
+    size_t HpackEncoder::getTableSize() const {
+        return _data->table.size;
+    }
+
+}
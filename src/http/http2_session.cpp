@@ -0,0 +1,1272 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/http/http2_session.h>
+#include <restify/http/http_connection.h>
+#include <restify/http/http_parser.h>
+#include <restify/http/hpack.h>
+#include <restify/helpers.h>
+#include <restify/codes.h>
+#include <istream>
+#include <ostream>
+#include <map>
+#include <deque>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+namespace restify {
+
+    static const uint8_t FrameData = 0x0;
+    static const uint8_t FrameHeaders = 0x1;
+    static const uint8_t FramePriority = 0x2;
+    static const uint8_t FrameRstStream = 0x3;
+    static const uint8_t FrameSettings = 0x4;
+    static const uint8_t FramePushPromise = 0x5;
+    static const uint8_t FramePing = 0x6;
+    static const uint8_t FrameGoAway = 0x7;
+    static const uint8_t FrameWindowUpdate = 0x8;
+    static const uint8_t FrameContinuation = 0x9;
+
+    static const uint8_t FlagEndStream = 0x1;
+    static const uint8_t FlagAck = 0x1;
+    static const uint8_t FlagEndHeaders = 0x4;
+    static const uint8_t FlagPadded = 0x8;
+    static const uint8_t FlagPriority = 0x20;
+
+    static const uint32_t ErrorNone = 0x0;
+    static const uint32_t ErrorProtocol = 0x1;
+    static const uint32_t ErrorInternal = 0x2;
+    static const uint32_t ErrorFlowControl = 0x3;
+    static const uint32_t ErrorStreamClosed = 0x5;
+    static const uint32_t ErrorFrameSize = 0x6;
+    static const uint32_t ErrorRefusedStream = 0x7;
+    static const uint32_t ErrorCompression = 0x9;
+    static const uint32_t ErrorEnhanceYourCalm = 0xb;
+
+    static const uint16_t SettingHeaderTableSize = 0x1;
+    static const uint16_t SettingEnablePush = 0x2;
+    static const uint16_t SettingMaxConcurrentStreams = 0x3;
+    static const uint16_t SettingInitialWindowSize = 0x4;
+    static const uint16_t SettingMaxFrameSize = 0x5;
+    static const uint16_t SettingMaxHeaderListSize = 0x6;
+
+    static const size_t FrameHeaderLength = 9;
+    static const uint32_t DefaultWindow = 65535;
+    static const uint32_t MaxWindow = 0x7fffffff;
+    static const uint32_t MinFrameSize = 16384;
+    static const uint32_t MaxFrameSize = 16777215;
+
+    /** Receive window granted per stream and for the connection, replenished once half is used. */
+    static const uint32_t ReceiveWindow = 1 << 20;
+
+    const char Http2Session::Preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+    const size_t Http2Session::PrefaceLength = sizeof(Http2Session::Preface) - 1;
+
+    static uint32_t readUint32(const char *p) {
+        const uint8_t *u = reinterpret_cast<const uint8_t*>(p);
+        return ((uint32_t)u[0] << 24) | ((uint32_t)u[1] << 16) | ((uint32_t)u[2] << 8) | u[3];
+    }
+
+    static uint16_t readUint16(const char *p) {
+        const uint8_t *u = reinterpret_cast<const uint8_t*>(p);
+        return (uint16_t)((u[0] << 8) | u[1]);
+    }
+
+    static void appendUint32(std::string &out, uint32_t v) {
+        const char b[4] = { (char)(v >> 24), (char)(v >> 16), (char)(v >> 8), (char)v };
+        out.append(b, 4);
+    }
+
+    static void appendSetting(std::string &out, uint16_t id, uint32_t value) {
+        out.push_back((char)(id >> 8));
+        out.push_back((char)id);
+        appendUint32(out, value);
+    }
+
+    /** Decode unpadded base64url as used by HTTP2-Settings. */
+    static bool decodeBase64Url(const std::string &in, std::string &out) {
+        uint32_t bits = 0;
+        int count = 0;
+        for (char c : in) {
+            int v;
+            if (c >= 'A' && c <= 'Z') v = c - 'A';
+            else if (c >= 'a' && c <= 'z') v = c - 'a' + 26;
+            else if (c >= '0' && c <= '9') v = c - '0' + 52;
+            else if (c == '-') v = 62;
+            else if (c == '_') v = 63;
+            else if (c == '=') break;
+            else return false;
+
+            bits = (bits << 6) | (uint32_t)v;
+            count += 6;
+            if (count >= 8) {
+                count -= 8;
+                out.push_back((char)(bits >> count));
+            }
+        }
+        return count < 6;
+    }
+
+    /** Header name as a HTTP/1.x peer would send it, e.g. content-type becomes Content-Type. */
+    static std::string canonicalHeaderName(const std::string &name) {
+        std::string s(name);
+        bool upper = true;
+        for (char &c : s) {
+            if (upper && c >= 'a' && c <= 'z')
+                c = (char)(c - 'a' + 'A');
+            upper = c == '-';
+        }
+        return s;
+    }
+
+    /** Headers meaningful to a single HTTP/1.x connection only, not to be forwarded into HTTP/2. */
+    static bool isConnectionHeader(const std::string &lowerName) {
+        return lowerName == "connection" || lowerName == "keep-alive" || lowerName == "proxy-connection" ||
+            lowerName == "transfer-encoding" || lowerName == "upgrade" || lowerName == "http2-settings";
+    }
+
+    /** Task of a stream resumer, routed to its stream by Http2Session::resume. */
+    struct Http2Session::StreamTask {
+        uint32_t id;
+        ConnectionTask task;
+
+        void operator()(Connection &) const {}
+    };
+
+    /**
+        A stream seen by the backend handler as connection of its own. The HTTP/1.1 response written
+        by the response writer is translated into frames on the fly.
+    */
+    struct Http2Session::Stream : public HttpConnection {
+        enum {
+            ResponseHead,
+            ResponseLength,
+            ResponseChunkSize,
+            ResponseChunkData,
+            ResponseChunkEnd,
+            ResponseTrailer,
+            ResponseUntilEnd,
+            ResponseDone
+        };
+
+        PrivateData &session;
+        uint32_t id;
+
+        HttpRequestHead head;
+        std::string body;
+        bool headerListTooLarge;
+
+        /** Request is still being received. */
+        bool receiving;
+        bool deferred;
+        /** RST_STREAM sent or received, further output is dropped. */
+        bool reset;
+        /** END_STREAM sent. */
+        bool ended;
+        /** Reset with NO_ERROR after END_STREAM, the rest of the request is not wanted. */
+        bool resetAfterEnd;
+        bool queued;
+
+        int64_t sendWindow;
+        int64_t receiveWindow;
+        uint32_t receiveConsumed;
+
+        int response;
+        /** Response head, chunk size or trailer line being received. */
+        std::string line;
+        uint64_t remaining;
+        uint64_t written;
+
+        /** DATA payload waiting for flow control. */
+        std::string pending;
+        size_t pendingOffset;
+        bool endPending;
+
+        Stream(PrivateData &s, uint32_t i, int64_t window)
+            :session(s), id(i), headerListTooLarge(false), receiving(true), deferred(false), reset(false),
+            ended(false), resetAfterEnd(false), queued(false), sendWindow(window), receiveWindow(ReceiveWindow),
+            receiveConsumed(0), response(ResponseHead), remaining(0), written(0), pendingOffset(0), endPending(false)
+        {}
+
+        size_t getPendingSize() const {
+            return pending.size() - pendingOffset;
+        }
+
+        // Inherited via HttpConnection
+        virtual const HttpRequestHead &getRequestHead() const override {
+            return head;
+        }
+
+        virtual int64_t readStream(std::ostream &stream) override {
+            if (!body.empty()) {
+                stream.write(body.data(), body.size());
+                if (!stream.good())
+                    return -1;
+            }
+            return (int64_t)body.size();
+        }
+
+        virtual int64_t writeStream(std::istream &stream) override {
+            const int chunkSize = 2048;
+            char chunk[chunkSize];
+
+            int64_t total = 0;
+            while (stream.good()) {
+                stream.read(chunk, chunkSize);
+                const std::streamsize read = stream.gcount();
+                if (read > 0) {
+                    if (write(chunk, (size_t)read) < 0)
+                        return -1;
+                    total += read;
+                }
+            }
+
+            return stream.eof() ? total : -1;
+        }
+
+        virtual int64_t write(const char *data, size_t length) override;
+
+        /** Other streams go on, a response left incomplete is reset once the handler is done. */
+        virtual void closeConnection() override {}
+
+        virtual bool isKeepAlive() const override {
+            return true;
+        }
+
+        virtual std::string getVersion() const override {
+            return head.version;
+        }
+
+        virtual ConnectionData *getConnectionData() const override;
+        virtual void setConnectionData(std::unique_ptr<ConnectionData> data) override;
+        virtual ConnectionResumer suspend() override;
+    };
+
+    struct Http2Session::PrivateData {
+        HttpServerConnection &transport;
+        HttpServerConnection::Limits limits;
+
+        HpackDecoder decoder;
+        HpackEncoder encoder;
+
+        std::map<uint32_t, std::unique_ptr<Stream>> streams;
+        /** Streams whose request is complete, in order of arrival. */
+        std::deque<uint32_t> dispatchQueue;
+        /** Streams with DATA or END_STREAM to send, served round robin. */
+        std::deque<uint32_t> sendQueue;
+
+        /** Frames produced since the last commit. */
+        std::string out;
+
+        bool prefaceReceived;
+        bool settingsReceived;
+        bool draining;
+        bool peerGoAway;
+        bool closed;
+
+        uint32_t lastStreamId;
+        uint64_t requests;
+        size_t deferred;
+
+        uint32_t peerInitialWindow;
+        uint32_t peerMaxFrameSize;
+        int64_t sendWindow;
+        int64_t receiveWindow;
+        uint32_t receiveConsumed;
+
+        /** Header block of HEADERS being continued by CONTINUATION frames. */
+        std::string headerBlock;
+        uint32_t headerStream;
+        bool headerEndStream;
+        bool expectContinuation;
+        std::vector<HpackDecoder::Header> fields;
+        std::vector<HpackEncoder::Header> responseFields;
+
+        PrivateData(HttpServerConnection &t, const HttpServerConnection::Limits &l)
+            :transport(t), limits(l), prefaceReceived(false), settingsReceived(false), draining(false),
+            peerGoAway(false), closed(false), lastStreamId(0), requests(0), deferred(0),
+            peerInitialWindow(DefaultWindow), peerMaxFrameSize(MinFrameSize), sendWindow(DefaultWindow),
+            receiveWindow(DefaultWindow), receiveConsumed(0), headerStream(0), headerEndStream(false), expectContinuation(false)
+        {}
+
+        Stream *find(uint32_t id) {
+            auto i = streams.find(id);
+            return i == streams.end() ? nullptr : i->second.get();
+        }
+
+        void writeFrameHeader(size_t length, uint8_t type, uint8_t flags, uint32_t stream) {
+            const char h[FrameHeaderLength] = {
+                (char)(length >> 16), (char)(length >> 8), (char)length,
+                (char)type, (char)flags,
+                (char)((stream >> 24) & 0x7f), (char)(stream >> 16), (char)(stream >> 8), (char)stream
+            };
+            out.append(h, FrameHeaderLength);
+        }
+
+        void writeFrame(uint8_t type, uint8_t flags, uint32_t stream, const char *payload, size_t length) {
+            writeFrameHeader(length, type, flags, stream);
+            out.append(payload, length);
+        }
+
+        void writeRst(uint32_t stream, uint32_t code) {
+            writeFrameHeader(4, FrameRstStream, 0, stream);
+            appendUint32(out, code);
+        }
+
+        void writeWindowUpdate(uint32_t stream, uint32_t increment) {
+            writeFrameHeader(4, FrameWindowUpdate, 0, stream);
+            appendUint32(out, increment);
+        }
+
+        void writeGoAway(uint32_t code) {
+            writeFrameHeader(8, FrameGoAway, 0, 0);
+            appendUint32(out, lastStreamId);
+            appendUint32(out, code);
+        }
+
+        /** Header block split into HEADERS and CONTINUATION frames the peer accepts. */
+        void writeHeaders(uint32_t stream, const std::string &block, bool endStream) {
+            size_t offset = 0;
+            bool first = true;
+            do {
+                const size_t n = std::min<size_t>(block.size() - offset, peerMaxFrameSize);
+                const bool last = offset + n == block.size();
+                uint8_t flags = last ? FlagEndHeaders : 0;
+                if (first && endStream)
+                    flags |= FlagEndStream;
+                writeFrame(first ? FrameHeaders : FrameContinuation, flags, stream, block.data() + offset, n);
+                offset += n;
+                first = false;
+            } while (offset < block.size());
+        }
+
+        void commit() {
+            if (!out.empty()) {
+                transport.write(out.data(), out.size());
+                out.clear();
+            }
+        }
+
+        void connectionError(uint32_t code) {
+            if (closed)
+                return;
+            writeGoAway(code);
+            closed = true;
+        }
+
+        void schedule(Stream &s) {
+            if (!s.queued && !s.reset) {
+                s.queued = true;
+                sendQueue.push_back(s.id);
+            }
+        }
+
+        /** Forget stream once both sides are done with it and no resumer refers to it. */
+        void release(Stream &s) {
+            if (s.ended && !s.receiving && !s.deferred)
+                streams.erase(s.id);
+        }
+
+        void resetStream(Stream &s, uint32_t code) {
+            if (!s.reset)
+                writeRst(s.id, code);
+            s.reset = true;
+            s.receiving = false;
+            s.ended = true;
+            s.endPending = false;
+            s.pending.clear();
+            s.pendingOffset = 0;
+        }
+
+        void endStream(Stream &s) {
+            s.response = Stream::ResponseDone;
+            s.endPending = true;
+            schedule(s);
+        }
+
+        void queueData(Stream &s, const char *data, size_t length) {
+            if (length == 0)
+                return;
+            s.pending.append(data, length);
+            schedule(s);
+        }
+
+        /** Answer stream with an empty response of status code. */
+        void writeError(Stream &s, int code) {
+            size_t length = 0;
+            const char *line = statusLine(code, length);
+            if (!line)
+                line = statusLine((int)StatusCode::BadRequest, length);
+
+            std::string message(line, length);
+            message.append("Content-Length: 0\r\n\r\n");
+            s.write(message.data(), message.size());
+        }
+
+        /** Translate HTTP/1.1 response head into HEADERS. */
+        void sendResponseHead(Stream &s, const std::string &http) {
+            const char *begin = http.data();
+            const char *end = begin + http.size();
+
+            const char *lineEnd = static_cast<const char*>(memchr(begin, '\n', end - begin));
+            const char *sp = static_cast<const char*>(memchr(begin, ' ', lineEnd - begin));
+            const int status = sp ? atoi(sp + 1) : 0;
+            if (status < 100 || status > 999) {
+                resetStream(s, ErrorInternal);
+                return;
+            }
+
+            responseFields.clear();
+            responseFields.emplace_back(":status", std::to_string(status));
+
+            bool chunked = false;
+            bool hasLength = false;
+            uint64_t length = 0;
+
+            for (const char *p = lineEnd + 1; p < end; ) {
+                const char *e = static_cast<const char*>(memchr(p, '\n', end - p));
+                const char *le = (e > p && e[-1] == '\r') ? e - 1 : e;
+                const char *colon = static_cast<const char*>(memchr(p, ':', le - p));
+                if (colon) {
+                    std::string name = toLowerCase(std::string(p, colon));
+                    const char *v = colon + 1;
+                    while (v < le && (*v == ' ' || *v == '\t'))
+                        ++v;
+                    std::string value(v, le);
+
+                    if (name == "transfer-encoding") {
+                        chunked = toLowerCase(value).find("chunked") != std::string::npos;
+                    } else if (!isConnectionHeader(name)) {
+                        if (name == "content-length") {
+                            hasLength = true;
+                            length = strtoull(value.c_str(), nullptr, 10);
+                        }
+                        responseFields.emplace_back(std::move(name), std::move(value));
+                    }
+                }
+                p = e + 1;
+            }
+
+            // Interim responses precede the final one.
+            const bool interim = status < 200;
+            const bool noBody = !interim && (s.head.method == "HEAD" || status == 204 || status == 304 || (hasLength && length == 0 && !chunked));
+
+            std::string block;
+            encoder.encode(responseFields, block);
+            writeHeaders(s.id, block, noBody);
+
+            if (interim)
+                return;
+
+            if (noBody) {
+                s.response = Stream::ResponseDone;
+                s.ended = true;
+                if (s.resetAfterEnd)
+                    resetStream(s, ErrorNone);
+            } else if (chunked) {
+                s.response = Stream::ResponseChunkSize;
+            } else if (hasLength) {
+                s.response = Stream::ResponseLength;
+                s.remaining = length;
+            } else {
+                s.response = Stream::ResponseUntilEnd;
+            }
+        }
+
+        /** Feed bytes of the HTTP/1.1 response written to stream. */
+        void translate(Stream &s, const char *data, size_t length) {
+            while (length > 0 && !s.reset) {
+                switch (s.response) {
+                case Stream::ResponseHead:
+                {
+                    const size_t before = s.line.size();
+                    s.line.append(data, length);
+                    const size_t pos = s.line.find("\r\n\r\n", before >= 3 ? before - 3 : 0);
+                    if (pos == std::string::npos)
+                        return;
+
+                    const size_t used = pos + 4 - before;
+                    data += used;
+                    length -= used;
+                    s.line.resize(pos + 4);
+                    sendResponseHead(s, s.line);
+                    s.line.clear();
+                    break;
+                }
+                case Stream::ResponseLength:
+                {
+                    const size_t n = (size_t)std::min<uint64_t>(length, s.remaining);
+                    queueData(s, data, n);
+                    s.remaining -= n;
+                    data += n;
+                    length -= n;
+                    if (s.remaining == 0)
+                        endStream(s);
+                    break;
+                }
+                case Stream::ResponseChunkSize:
+                case Stream::ResponseTrailer:
+                {
+                    const char *nl = static_cast<const char*>(memchr(data, '\n', length));
+                    const size_t n = nl ? (size_t)(nl - data) + 1 : length;
+                    s.line.append(data, n);
+                    data += n;
+                    length -= n;
+                    if (!nl)
+                        break;
+
+                    if (s.response == Stream::ResponseChunkSize) {
+                        s.remaining = strtoull(s.line.c_str(), nullptr, 16);
+                        s.response = s.remaining > 0 ? Stream::ResponseChunkData : Stream::ResponseTrailer;
+                    } else if (s.line == "\r\n" || s.line == "\n") {
+                        endStream(s);
+                    }
+                    s.line.clear();
+                    break;
+                }
+                case Stream::ResponseChunkData:
+                {
+                    const size_t n = (size_t)std::min<uint64_t>(length, s.remaining);
+                    queueData(s, data, n);
+                    s.remaining -= n;
+                    data += n;
+                    length -= n;
+                    if (s.remaining == 0) {
+                        s.response = Stream::ResponseChunkEnd;
+                        s.remaining = 2;
+                    }
+                    break;
+                }
+                case Stream::ResponseChunkEnd:
+                {
+                    const size_t n = (size_t)std::min<uint64_t>(length, s.remaining);
+                    s.remaining -= n;
+                    data += n;
+                    length -= n;
+                    if (s.remaining == 0)
+                        s.response = Stream::ResponseChunkSize;
+                    break;
+                }
+                case Stream::ResponseUntilEnd:
+                    queueData(s, data, length);
+                    length = 0;
+                    break;
+                default:
+                    // Nothing follows a complete response.
+                    return;
+                }
+            }
+        }
+
+        /** Called once the handler of a stream is done, directly or through its resumer. */
+        void completeResponse(Stream &s, bool handled, bool hasHandler) {
+            if (s.reset)
+                return;
+
+            if (!handled && s.written == 0) {
+                writeError(s, hasHandler ? (int)StatusCode::InternalServerError : (int)StatusCode::NotFound);
+            } else if (!handled || s.response == Stream::ResponseHead) {
+                resetStream(s, ErrorInternal);
+            } else if (s.response == Stream::ResponseUntilEnd) {
+                endStream(s);
+            } else if (s.response != Stream::ResponseDone) {
+                // Body ended short, e.g. a streaming producer failed and closed the connection.
+                resetStream(s, ErrorInternal);
+            }
+        }
+
+        void dispatch(Stream &s, const BackendRequestHandler &handler, const BackendContext &ctx) {
+            ++requests;
+
+            bool handled = false;
+            try {
+                handled = handler && handler(ctx, s);
+            } catch (...) {
+                handled = false;
+            }
+
+            if (s.deferred)
+                return;
+            completeResponse(s, handled, (bool)handler);
+        }
+
+        /** Send pending DATA as the flow control windows permit, one frame per stream and turn. */
+        void flush() {
+            while (!sendQueue.empty()) {
+                const uint32_t id = sendQueue.front();
+                Stream *s = find(id);
+                if (!s || s->reset) {
+                    sendQueue.pop_front();
+                    continue;
+                }
+
+                const size_t available = s->getPendingSize();
+                size_t n = 0;
+                if (available > 0) {
+                    const int64_t window = std::min(s->sendWindow, sendWindow);
+                    n = (size_t)std::min<int64_t>(std::min<int64_t>((int64_t)available, window), peerMaxFrameSize);
+                    if (window <= 0) {
+                        if (sendWindow <= 0)
+                            break;
+                        // Stream window is exhausted, WINDOW_UPDATE schedules it again.
+                        sendQueue.pop_front();
+                        s->queued = false;
+                        continue;
+                    }
+                } else if (!s->endPending) {
+                    sendQueue.pop_front();
+                    s->queued = false;
+                    continue;
+                }
+
+                sendQueue.pop_front();
+                s->queued = false;
+
+                const bool last = n == available && s->endPending;
+                writeFrame(FrameData, last ? FlagEndStream : 0, id, s->pending.data() + s->pendingOffset, n);
+                s->pendingOffset += n;
+                s->sendWindow -= n;
+                sendWindow -= n;
+                if (s->pendingOffset == s->pending.size()) {
+                    s->pending.clear();
+                    s->pendingOffset = 0;
+                }
+
+                if (last) {
+                    s->endPending = false;
+                    s->ended = true;
+                    if (s->resetAfterEnd)
+                        resetStream(*s, ErrorNone);
+                    release(*s);
+                } else {
+                    schedule(*s);
+                }
+            }
+        }
+
+        /** Apply settings of peer. Returns error code of a connection error or ErrorNone. */
+        uint32_t applySettings(const char *p, size_t length) {
+            for (size_t i = 0; i + 6 <= length; i += 6) {
+                const uint16_t id = readUint16(p + i);
+                const uint32_t value = readUint32(p + i + 2);
+
+                switch (id) {
+                case SettingHeaderTableSize:
+                    encoder.setMaxTableSize(value);
+                    break;
+                case SettingEnablePush:
+                    if (value > 1)
+                        return ErrorProtocol;
+                    break;
+                case SettingInitialWindowSize:
+                {
+                    if (value > MaxWindow)
+                        return ErrorFlowControl;
+                    const int64_t delta = (int64_t)value - (int64_t)peerInitialWindow;
+                    peerInitialWindow = value;
+                    for (auto &e : streams) {
+                        Stream &s = *e.second;
+                        s.sendWindow += delta;
+                        if (s.sendWindow > MaxWindow)
+                            return ErrorFlowControl;
+                        if (delta > 0 && s.getPendingSize() > 0)
+                            schedule(s);
+                    }
+                    break;
+                }
+                case SettingMaxFrameSize:
+                    if (value < MinFrameSize || value > MaxFrameSize)
+                        return ErrorProtocol;
+                    peerMaxFrameSize = value;
+                    break;
+                default:
+                    // SETTINGS_MAX_CONCURRENT_STREAMS limits pushes only, unknown settings are ignored.
+                    break;
+                }
+            }
+            return ErrorNone;
+        }
+
+        /** Validate decoded request fields and fill the stream's request head. */
+        bool buildHead(Stream &s) {
+            HttpRequestHead &h = s.head;
+            h.clear();
+            h.version = "2.0";
+            h.keepAlive = true;
+
+            std::string path, scheme, authority, cookie;
+            bool regular = false;
+
+            for (HpackDecoder::Header &f : fields) {
+                if (f.first.empty())
+                    return false;
+
+                if (f.first[0] == ':') {
+                    std::string *target = nullptr;
+                    if (f.first == ":method") target = &h.method;
+                    else if (f.first == ":path") target = &path;
+                    else if (f.first == ":scheme") target = &scheme;
+                    else if (f.first == ":authority") target = &authority;
+
+                    if (regular || !target || !target->empty())
+                        return false;
+                    *target = std::move(f.second);
+                    continue;
+                }
+
+                regular = true;
+                for (char c : f.first) {
+                    if (c >= 'A' && c <= 'Z')
+                        return false;
+                }
+                if (isConnectionHeader(f.first) || (f.first == "te" && f.second != "trailers"))
+                    return false;
+
+                if (f.first == "cookie") {
+                    // Cookie crumbs are joined as in a HTTP/1.x request.
+                    if (!cookie.empty())
+                        cookie.append("; ");
+                    cookie.append(f.second);
+                    continue;
+                }
+                h.headers.emplace_back(canonicalHeaderName(f.first), std::move(f.second));
+            }
+
+            if (h.method.empty() || scheme.empty() || path.empty())
+                return false;
+            if (path[0] != '/' && !(path == "*" && h.method == "OPTIONS"))
+                return false;
+
+            if (!authority.empty() && !h.findHeader("Host"))
+                h.headers.emplace_back("Host", authority);
+            if (!cookie.empty())
+                h.headers.emplace_back("Cookie", cookie);
+
+            const size_t q = path.find('?');
+            h.path = urlDecode(path.data(), q == std::string::npos ? path.size() : q);
+            if (q != std::string::npos) {
+                h.hasQuery = true;
+                h.query.assign(path, q + 1, std::string::npos);
+            }
+
+            return true;
+        }
+
+        /** Request of stream is complete, check its length and queue it for dispatching. */
+        void requestComplete(Stream &s) {
+            s.receiving = false;
+
+            const std::string *cl = s.head.findHeader("Content-Length");
+            if (cl) {
+                if (strtoull(cl->c_str(), nullptr, 10) != s.body.size()) {
+                    resetStream(s, ErrorProtocol);
+                    release(s);
+                    return;
+                }
+            } else if (!s.body.empty()) {
+                s.head.headers.emplace_back("Content-Length", std::to_string(s.body.size()));
+            }
+            s.head.contentLength = (int64_t)s.body.size();
+            dispatchQueue.push_back(s.id);
+        }
+
+        /** Reject request of stream that is still being received. */
+        void rejectRequest(Stream &s, int code) {
+            if (s.receiving)
+                s.resetAfterEnd = true;
+            s.receiving = false;
+            writeError(s, code);
+            release(s);
+        }
+
+        void finishHeaderBlock() {
+            expectContinuation = false;
+
+            fields.clear();
+            bool tooLarge = false;
+            if (!decoder.decode(headerBlock.data(), headerBlock.size(), fields, limits.maxHeadSize, tooLarge)) {
+                connectionError(ErrorCompression);
+                return;
+            }
+
+            const uint32_t id = headerStream;
+            Stream *existing = find(id);
+            if (existing) {
+                // Trailers end the request, their fields are not passed on.
+                if (!existing->receiving || existing->resetAfterEnd)
+                    return;
+                if (!headerEndStream)
+                    resetStream(*existing, ErrorProtocol);
+                else
+                    requestComplete(*existing);
+                release(*existing);
+                return;
+            }
+
+            // Frames may still arrive for streams closed by either side.
+            if (id <= lastStreamId || draining)
+                return;
+            lastStreamId = id;
+
+            if (streams.size() >= limits.maxConcurrentStreams) {
+                writeRst(id, ErrorRefusedStream);
+                return;
+            }
+
+            Stream *s = new Stream(*this, id, peerInitialWindow);
+            streams[id].reset(s);
+            s->receiving = !headerEndStream;
+
+            s->headerListTooLarge = tooLarge;
+            if (!tooLarge && !buildHead(*s)) {
+                resetStream(*s, ErrorProtocol);
+                release(*s);
+                return;
+            }
+            if (s->headerListTooLarge) {
+                rejectRequest(*s, (int)StatusCode::RequestHeaderFieldsTooLarge);
+                return;
+            }
+            if (!s->receiving)
+                requestComplete(*s);
+        }
+
+        void handleHeaders(uint8_t flags, uint32_t id, const char *p, size_t length) {
+            if (id == 0 || (id & 1) == 0) {
+                connectionError(ErrorProtocol);
+                return;
+            }
+
+            if (flags & FlagPadded) {
+                const size_t pad = length > 0 ? (uint8_t)p[0] : 0;
+                if (length == 0 || pad >= length) {
+                    connectionError(ErrorProtocol);
+                    return;
+                }
+                ++p;
+                length -= 1 + pad;
+            }
+            if (flags & FlagPriority) {
+                if (length < 5) {
+                    connectionError(ErrorFrameSize);
+                    return;
+                }
+                p += 5;
+                length -= 5;
+            }
+
+            headerBlock.assign(p, length);
+            headerStream = id;
+            headerEndStream = (flags & FlagEndStream) != 0;
+
+            if (flags & FlagEndHeaders)
+                finishHeaderBlock();
+            else
+                expectContinuation = true;
+        }
+
+        void handleContinuation(uint8_t flags, const char *p, size_t length) {
+            headerBlock.append(p, length);
+            if (headerBlock.size() > limits.maxHeadSize + MinFrameSize) {
+                connectionError(ErrorEnhanceYourCalm);
+                return;
+            }
+            if (flags & FlagEndHeaders)
+                finishHeaderBlock();
+        }
+
+        void handleData(uint8_t flags, uint32_t id, const char *p, size_t length) {
+            if (id == 0) {
+                connectionError(ErrorProtocol);
+                return;
+            }
+
+            // The whole frame counts against the windows, padding included.
+            if ((int64_t)length > receiveWindow) {
+                connectionError(ErrorFlowControl);
+                return;
+            }
+            receiveWindow -= length;
+            receiveConsumed += (uint32_t)length;
+            const size_t frameLength = length;
+
+            if (flags & FlagPadded) {
+                const size_t pad = length > 0 ? (uint8_t)p[0] : 0;
+                if (length == 0 || pad >= length) {
+                    connectionError(ErrorProtocol);
+                    return;
+                }
+                ++p;
+                length -= 1 + pad;
+            }
+
+            Stream *s = find(id);
+            if (!s) {
+                if (id > lastStreamId)
+                    connectionError(ErrorProtocol);
+            } else if (s->resetAfterEnd || s->reset) {
+                // Rest of a rejected request.
+            } else if (!s->receiving) {
+                resetStream(*s, ErrorStreamClosed);
+                release(*s);
+            } else if ((int64_t)frameLength > s->receiveWindow) {
+                resetStream(*s, ErrorFlowControl);
+                release(*s);
+            } else {
+                s->receiveWindow -= frameLength;
+                if (s->body.size() + length > limits.maxBodySize) {
+                    rejectRequest(*s, (int)StatusCode::ContentTooLarge);
+                } else {
+                    s->body.append(p, length);
+                    if (flags & FlagEndStream) {
+                        requestComplete(*s);
+                    } else {
+                        s->receiveConsumed += (uint32_t)frameLength;
+                        if (s->receiveConsumed >= ReceiveWindow / 2) {
+                            writeWindowUpdate(id, s->receiveConsumed);
+                            s->receiveWindow += s->receiveConsumed;
+                            s->receiveConsumed = 0;
+                        }
+                    }
+                }
+            }
+
+            if (receiveConsumed >= ReceiveWindow / 2) {
+                writeWindowUpdate(0, receiveConsumed);
+                receiveWindow += receiveConsumed;
+                receiveConsumed = 0;
+            }
+        }
+
+        void handleWindowUpdate(uint32_t id, const char *p, size_t length) {
+            if (length != 4) {
+                connectionError(ErrorFrameSize);
+                return;
+            }
+            const uint32_t increment = readUint32(p) & 0x7fffffff;
+
+            if (id == 0) {
+                sendWindow += increment;
+                if (increment == 0)
+                    connectionError(ErrorProtocol);
+                else if (sendWindow > MaxWindow)
+                    connectionError(ErrorFlowControl);
+                return;
+            }
+
+            Stream *s = find(id);
+            if (!s) {
+                if (id > lastStreamId)
+                    connectionError(ErrorProtocol);
+                return;
+            }
+
+            s->sendWindow += increment;
+            if (increment == 0) {
+                resetStream(*s, ErrorProtocol);
+                release(*s);
+            } else if (s->sendWindow > MaxWindow) {
+                resetStream(*s, ErrorFlowControl);
+                release(*s);
+            } else if (s->getPendingSize() > 0) {
+                schedule(*s);
+            }
+        }
+
+        void handleFrame(uint8_t type, uint8_t flags, uint32_t id, const char *p, size_t length) {
+            if (expectContinuation && (type != FrameContinuation || id != headerStream)) {
+                connectionError(ErrorProtocol);
+                return;
+            }
+            if (!settingsReceived && type != FrameSettings) {
+                connectionError(ErrorProtocol);
+                return;
+            }
+
+            switch (type) {
+            case FrameData:
+                handleData(flags, id, p, length);
+                break;
+            case FrameHeaders:
+                handleHeaders(flags, id, p, length);
+                break;
+            case FramePriority:
+                if (id == 0)
+                    connectionError(ErrorProtocol);
+                else if (length != 5)
+                    connectionError(ErrorFrameSize);
+                break;
+            case FrameRstStream:
+            {
+                if (id == 0 || id > lastStreamId) {
+                    connectionError(ErrorProtocol);
+                    break;
+                }
+                if (length != 4) {
+                    connectionError(ErrorFrameSize);
+                    break;
+                }
+                Stream *s = find(id);
+                if (s) {
+                    s->reset = true;
+                    s->receiving = false;
+                    s->ended = true;
+                    s->pending.clear();
+                    s->pendingOffset = 0;
+                    release(*s);
+                }
+                break;
+            }
+            case FrameSettings:
+                if (id != 0) {
+                    connectionError(ErrorProtocol);
+                } else if (flags & FlagAck) {
+                    if (length != 0)
+                        connectionError(ErrorFrameSize);
+                } else if (length % 6 != 0) {
+                    connectionError(ErrorFrameSize);
+                } else {
+                    const uint32_t error = applySettings(p, length);
+                    if (error != ErrorNone) {
+                        connectionError(error);
+                    } else {
+                        writeFrame(FrameSettings, FlagAck, 0, nullptr, 0);
+                        settingsReceived = true;
+                    }
+                }
+                break;
+            case FramePushPromise:
+                connectionError(ErrorProtocol);
+                break;
+            case FramePing:
+                if (id != 0)
+                    connectionError(ErrorProtocol);
+                else if (length != 8)
+                    connectionError(ErrorFrameSize);
+                else if ((flags & FlagAck) == 0)
+                    writeFrame(FramePing, FlagAck, 0, p, length);
+                break;
+            case FrameGoAway:
+                if (id != 0)
+                    connectionError(ErrorProtocol);
+                else
+                    peerGoAway = true;
+                break;
+            case FrameWindowUpdate:
+                handleWindowUpdate(id, p, length);
+                break;
+            case FrameContinuation:
+                if (!expectContinuation)
+                    connectionError(ErrorProtocol);
+                else
+                    handleContinuation(flags, p, length);
+                break;
+            default:
+                // Unknown frame types are ignored.
+                break;
+            }
+        }
+    };
+
+    int64_t Http2Session::Stream::write(const char * data, size_t length) {
+        if (reset || session.closed)
+            return -1;
+
+        written += length;
+        session.translate(*this, data, length);
+        return (int64_t)length;
+    }
+
+    ConnectionData * Http2Session::Stream::getConnectionData() const {
+        return session.transport.getConnectionData();
+    }
+
+    void Http2Session::Stream::setConnectionData(std::unique_ptr<ConnectionData> data) {
+        session.transport.setConnectionData(std::move(data));
+    }
+
+    ConnectionResumer Http2Session::Stream::suspend() {
+        // In HTTP/2 mode the transport hands out resumers without suspending itself.
+        const ConnectionResumer resumer = session.transport.suspend();
+        if (!resumer)
+            return resumer;
+
+        if (!deferred) {
+            deferred = true;
+            ++session.deferred;
+        }
+        const uint32_t streamId = id;
+        return [resumer, streamId](const ConnectionTask &task) {
+            resumer(ConnectionTask(StreamTask{ streamId, task }));
+        };
+    }
+
+    Http2Session::Http2Session(HttpServerConnection & transport, const HttpServerConnection::Limits & limits)
+        :_data(new PrivateData(transport, limits))
+    {}
+
+    Http2Session::~Http2Session()
+    {}
+
+    bool Http2Session::upgrade(const HttpRequestHead & head, const char * body, size_t length, const std::string & settings) {
+        PrivateData &d = *_data;
+
+        std::string payload;
+        if (!decodeBase64Url(settings, payload) || payload.size() % 6 != 0 || d.applySettings(payload.data(), payload.size()) != ErrorNone)
+            return false;
+
+        // The upgraded request becomes stream 1, half-closed by the client.
+        Stream *s = new Stream(d, 1, d.peerInitialWindow);
+        d.streams[1].reset(s);
+        d.lastStreamId = 1;
+
+        s->head = head;
+        s->head.version = "2.0";
+        s->head.keepAlive = true;
+        s->head.expectContinue = false;
+        s->head.headers.clear();
+        for (const HttpRequestHead::Header &h : head.headers) {
+            if (!isConnectionHeader(toLowerCase(h.first)))
+                s->head.headers.push_back(h);
+        }
+        s->body.assign(body, length);
+        d.requestComplete(*s);
+        return true;
+    }
+
+    void Http2Session::start() {
+        PrivateData &d = *_data;
+
+        std::string settings;
+        appendSetting(settings, SettingMaxConcurrentStreams, (uint32_t)d.limits.maxConcurrentStreams);
+        appendSetting(settings, SettingInitialWindowSize, ReceiveWindow);
+        appendSetting(settings, SettingMaxHeaderListSize, (uint32_t)d.limits.maxHeadSize);
+        d.writeFrame(FrameSettings, 0, 0, settings.data(), settings.size());
+
+        // The connection window is raised right away, stream windows once SETTINGS are acknowledged.
+        d.writeWindowUpdate(0, ReceiveWindow - DefaultWindow);
+        d.receiveWindow = ReceiveWindow;
+        d.commit();
+    }
+
+    size_t Http2Session::process(const char * data, size_t length, const BackendRequestHandler & handler, const BackendContext & ctx) {
+        PrivateData &d = *_data;
+        size_t offset = 0;
+
+        if (!d.closed && !d.prefaceReceived) {
+            const size_t n = std::min(length, PrefaceLength);
+            if (memcmp(data, Preface, n) != 0) {
+                d.connectionError(ErrorProtocol);
+            } else if (n == PrefaceLength) {
+                d.prefaceReceived = true;
+                offset = PrefaceLength;
+            }
+        }
+
+        while (d.prefaceReceived && !d.closed && length - offset >= FrameHeaderLength) {
+            const char *h = data + offset;
+            const size_t frameLength = ((size_t)(uint8_t)h[0] << 16) | ((size_t)(uint8_t)h[1] << 8) | (uint8_t)h[2];
+            if (frameLength > MinFrameSize) {
+                // Larger frames than SETTINGS_MAX_FRAME_SIZE were never permitted.
+                d.connectionError(ErrorFrameSize);
+                break;
+            }
+            if (length - offset < FrameHeaderLength + frameLength)
+                break;
+
+            d.handleFrame((uint8_t)h[3], (uint8_t)h[4], readUint32(h + 5) & 0x7fffffff, h + FrameHeaderLength, frameLength);
+            offset += FrameHeaderLength + frameLength;
+        }
+
+        if (d.closed)
+            offset = length;
+
+        while (!d.dispatchQueue.empty() && !d.closed) {
+            Stream *s = d.find(d.dispatchQueue.front());
+            d.dispatchQueue.pop_front();
+            if (!s || s->reset)
+                continue;
+            d.dispatch(*s, handler, ctx);
+            d.release(*s);
+        }
+
+        if (!d.closed)
+            d.flush();
+        d.commit();
+        return offset;
+    }
+
+    void Http2Session::resume(const ConnectionTask & task) {
+        PrivateData &d = *_data;
+
+        const StreamTask *t = task.target<StreamTask>();
+        Stream *s = t ? d.find(t->id) : nullptr;
+        if (!s || !s->deferred)
+            return;
+
+        s->deferred = false;
+        --d.deferred;
+
+        if (!s->reset && !d.closed) {
+            try {
+                if (t->task)
+                    t->task(*s);
+            } catch (...) {
+            }
+
+            if (s->deferred && !d.draining) {
+                // Task suspended the stream again, its response continues with later tasks.
+                d.flush();
+                d.commit();
+                return;
+            }
+            d.completeResponse(*s, true, true);
+        }
+
+        if (s->deferred) {
+            s->deferred = false;
+            --d.deferred;
+        }
+        d.release(*s);
+        d.flush();
+        d.commit();
+    }
+
+    void Http2Session::drain() {
+        PrivateData &d = *_data;
+        if (d.draining || d.closed)
+            return;
+
+        d.draining = true;
+        d.writeGoAway(ErrorNone);
+        d.commit();
+    }
+
+    bool Http2Session::shouldClose() const {
+        const PrivateData &d = *_data;
+        return d.closed || ((d.draining || d.peerGoAway) && d.streams.empty());
+    }
+
+    uint64_t Http2Session::getRequestCount() const {
+        return _data->requests;
+    }
+
+    size_t Http2Session::getDeferredCount() const {
+        return _data->deferred;
+    }
+
+    size_t Http2Session::getOpenStreamCount() const {
+        return _data->streams.size();
+    }
+
+}
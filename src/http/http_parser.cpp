@@ -0,0 +1,260 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/http/http_parser.h>
+#include <restify/helpers.h>
+#include <restify/codes.h>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <cerrno>
+
+namespace restify {
+
+    static bool equalsIgnoreCase(const char *a, const char *b, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            if (::tolower((unsigned char)a[i]) != ::tolower((unsigned char)b[i]))
+                return false;
+        }
+        return true;
+    }
+
+    static bool equalsIgnoreCase(const std::string &a, const char *b) {
+        const size_t n = strlen(b);
+        return a.size() == n && equalsIgnoreCase(a.data(), b, n);
+    }
+
+    static bool containsTokenIgnoreCase(const std::string &value, const char *token) {
+        // Connection header is a comma separated list of tokens.
+        const size_t n = strlen(token);
+        size_t pos = 0;
+        while (pos < value.size()) {
+            size_t end = value.find(',', pos);
+            if (end == std::string::npos)
+                end = value.size();
+
+            size_t b = pos, e = end;
+            while (b < e && (value[b] == ' ' || value[b] == '\t')) ++b;
+            while (e > b && (value[e - 1] == ' ' || value[e - 1] == '\t')) --e;
+
+            if (e - b == n && equalsIgnoreCase(value.data() + b, token, n))
+                return true;
+
+            pos = end + 1;
+        }
+        return false;
+    }
+
+    static bool endsWithTokenIgnoreCase(const std::string &value, const char *token) {
+        // Transfer codings are applied in order, the last one listed frames the message.
+        size_t e = value.size();
+        while (e > 0 && (value[e - 1] == ' ' || value[e - 1] == '\t')) --e;
+        size_t b = value.rfind(',', e == 0 ? 0 : e - 1);
+        b = b == std::string::npos ? 0 : b + 1;
+        while (b < e && (value[b] == ' ' || value[b] == '\t')) ++b;
+
+        const size_t n = strlen(token);
+        return e - b == n && equalsIgnoreCase(value.data() + b, token, n);
+    }
+
+    HttpRequestHead::HttpRequestHead()
+        :hasQuery(false), contentLength(-1), chunked(false), keepAlive(false), expectContinue(false)
+    {}
+
+    void HttpRequestHead::clear() {
+        method.clear();
+        path.clear();
+        query.clear();
+        hasQuery = false;
+        version.clear();
+        headers.clear();
+        contentLength = -1;
+        chunked = false;
+        keepAlive = false;
+        expectContinue = false;
+    }
+
+    const std::string * HttpRequestHead::findHeader(const char * name) const {
+        for (const auto &h : headers) {
+            if (equalsIgnoreCase(h.first, name))
+                return &h.second;
+        }
+        return nullptr;
+    }
+
+    HttpRequestParser::HttpRequestParser(size_t maxHeadSize, size_t maxHeaders)
+        :_maxHeadSize(maxHeadSize), _maxHeaders(maxHeaders), _scanned(0), _headLength(0), _errorCode(0)
+    {}
+
+    size_t HttpRequestParser::getHeadLength() const {
+        return _headLength;
+    }
+
+    int HttpRequestParser::getErrorCode() const {
+        return _errorCode;
+    }
+
+    void HttpRequestParser::reset() {
+        _scanned = 0;
+        _headLength = 0;
+        _errorCode = 0;
+    }
+
+    HttpRequestParser::Result HttpRequestParser::fail(int code) {
+        _errorCode = code;
+        return Result::Invalid;
+    }
+
+    HttpRequestParser::Result HttpRequestParser::parse(const char * data, size_t length, HttpRequestHead & head) {
+        // Tolerate empty lines preceding the request line.
+        size_t start = 0;
+        while (start < length && (data[start] == '\r' || data[start] == '\n'))
+            ++start;
+
+        // Find end of head, an empty line. Continue where the last call stopped.
+        size_t i = _scanned > start ? _scanned : start;
+        size_t end = 0;
+        for (; i < length; ++i) {
+            if (data[i] != '\n')
+                continue;
+            if (i + 1 < length && data[i + 1] == '\n') {
+                end = i + 2;
+                break;
+            }
+            if (i + 2 < length && data[i + 1] == '\r' && data[i + 2] == '\n') {
+                end = i + 3;
+                break;
+            }
+        }
+
+        if (end == 0) {
+            // Keep the last two bytes for rescanning, they might be part of the terminator.
+            _scanned = length > 2 ? length - 2 : 0;
+            if (length - start > _maxHeadSize)
+                return fail((int)StatusCode::RequestHeaderFieldsTooLarge);
+            return Result::Incomplete;
+        }
+
+        if (end - start > _maxHeadSize)
+            return fail((int)StatusCode::RequestHeaderFieldsTooLarge);
+
+        _headLength = end;
+        head.clear();
+        return parseHead(data + start, end - start, head);
+    }
+
+    HttpRequestParser::Result HttpRequestParser::parseHead(const char * data, size_t length, HttpRequestHead & head) {
+        const char *p = data;
+        const char *last = data + length;
+
+        auto nextLine = [&p, last](const char *&lineBegin, const char *&lineEnd) {
+            lineBegin = p;
+            const char *nl = static_cast<const char*>(memchr(p, '\n', last - p));
+            lineEnd = nl ? nl : last;
+            p = nl ? nl + 1 : last;
+            if (lineEnd > lineBegin && lineEnd[-1] == '\r')
+                --lineEnd;
+        };
+
+        // Request line
+        const char *lb, *le;
+        nextLine(lb, le);
+
+        const char *sp1 = static_cast<const char*>(memchr(lb, ' ', le - lb));
+        if (!sp1 || sp1 == lb)
+            return fail((int)StatusCode::BadRequest);
+        const char *sp2 = static_cast<const char*>(memchr(sp1 + 1, ' ', le - sp1 - 1));
+        if (!sp2 || sp2 == sp1 + 1)
+            return fail((int)StatusCode::BadRequest);
+
+        head.method.assign(lb, sp1);
+
+        const char *target = sp1 + 1;
+        if (*target != '/' && !(sp2 - target == 1 && *target == '*'))
+            return fail((int)StatusCode::BadRequest);
+
+        const char *q = static_cast<const char*>(memchr(target, '?', sp2 - target));
+        head.path = urlDecode(target, (q ? q : sp2) - target);
+        if (q) {
+            head.hasQuery = true;
+            head.query.assign(q + 1, sp2);
+        }
+
+        const char *proto = sp2 + 1;
+        if (le - proto != 8 || strncmp(proto, "HTTP/1.", 7) != 0)
+            return fail((int)StatusCode::BadRequest);
+        if (proto[7] != '0' && proto[7] != '1')
+            return fail((int)StatusCode::HTTPVersionNotSupported);
+        head.version.assign(proto + 5, le);
+
+        // Header fields
+        while (p < last) {
+            nextLine(lb, le);
+            if (lb == le)
+                break;
+
+            if (*lb == ' ' || *lb == '\t') {
+                // Obsolete line folding is not supported.
+                return fail((int)StatusCode::BadRequest);
+            }
+
+            const char *colon = static_cast<const char*>(memchr(lb, ':', le - lb));
+            if (!colon || colon == lb)
+                return fail((int)StatusCode::BadRequest);
+
+            if (head.headers.size() >= _maxHeaders)
+                return fail((int)StatusCode::RequestHeaderFieldsTooLarge);
+
+            const char *vb = colon + 1;
+            const char *ve = le;
+            while (vb < ve && (*vb == ' ' || *vb == '\t')) ++vb;
+            while (ve > vb && (ve[-1] == ' ' || ve[-1] == '\t')) --ve;
+
+            head.headers.emplace_back(std::string(lb, colon), std::string(vb, ve));
+        }
+
+        // Interpret framing and connection headers
+        bool transferEncoded = false;
+        for (const auto &h : head.headers) {
+            if (equalsIgnoreCase(h.first, "Content-Length")) {
+                // Content-Length is 1*DIGIT, strtoll alone would accept signs and whitespace.
+                if (h.second.empty() || h.second.find_first_not_of("0123456789") != std::string::npos)
+                    return fail((int)StatusCode::BadRequest);
+                errno = 0;
+                const long long v = strtoll(h.second.c_str(), nullptr, 10);
+                if (errno == ERANGE)
+                    return fail((int)StatusCode::BadRequest);
+                if (head.contentLength >= 0 && head.contentLength != v)
+                    return fail((int)StatusCode::BadRequest);
+                head.contentLength = v;
+            } else if (equalsIgnoreCase(h.first, "Transfer-Encoding")) {
+                // Repeated headers continue the list of codings.
+                transferEncoded = true;
+                head.chunked = endsWithTokenIgnoreCase(h.second, "chunked");
+            } else if (equalsIgnoreCase(h.first, "Expect")) {
+                head.expectContinue = equalsIgnoreCase(h.second, "100-continue");
+            }
+        }
+
+        // Without chunked as the final coding the length of the body is unknown, see RFC 7230 3.3.3.
+        if (transferEncoded && !head.chunked)
+            return fail((int)StatusCode::BadRequest);
+
+        const std::string *connection = head.findHeader("Connection");
+        if (head.version == "1.1") {
+            head.keepAlive = !(connection && containsTokenIgnoreCase(*connection, "close"));
+        } else {
+            head.keepAlive = connection && containsTokenIgnoreCase(*connection, "keep-alive");
+        }
+
+        return Result::Complete;
+    }
+
+}
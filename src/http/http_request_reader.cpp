@@ -0,0 +1,93 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/http/http_request_reader.h>
+#include <restify/http/http_connection.h>
+#include <restify/http/http_parser.h>
+#include <restify/request.h>
+#include <restify/error.h>
+#include <restify/helpers.h>
+#include <json/json.h>
+
+namespace restify {
+
+    void HttpRequestHeaderReader::readRequestHeader(Connection &c, Request & request) const {
+        
+        try {
+            HttpConnection &hc = dynamic_cast<HttpConnection&>(c);
+            const HttpRequestHead &head = hc.getRequestHead();
+
+            Json::Value &root = request.toJson();
+            root[Request::Keys::method] = head.method;
+            root[Request::Keys::path] = head.path;
+
+            Json::Value &headers = root[Request::Keys::headers];
+            for (const auto &h : head.headers) {
+                headers[h.first] = h.second;
+            }
+
+            readQueryString(head, request);
+
+        } catch (std::bad_cast) {
+            CPPRESTIFY_FAIL(StatusCode::InternalServerError, "Expected HttpConnection.");
+        }
+    }
+
+    void HttpRequestHeaderReader::readQueryString(const HttpRequestHead &head, Request & request) const {
+        if (!head.hasQuery)
+            return;
+
+        Json::Value &root = request.toJson();
+        const std::string decodedQueryString = urlDecode(head.query.data(), head.query.size());
+
+        // Update request params.
+        Json::Value &getParams = root[Request::Keys::params];
+        std::vector<std::string> pairs = splitString(decodedQueryString, '&', false, false);
+        for (auto p : pairs) {
+            std::vector<std::string> keyval = splitString(p, '=', true, false);
+
+            if (keyval.size() != 2 || keyval.front().empty() || keyval.back().empty()) {
+                CPPRESTIFY_FAIL(StatusCode::BadRequest, "Query string is malformed.");
+            }
+
+            getParams[keyval[0]] = keyval[1];
+        }
+
+        // Set query string
+        root[Request::Keys::query] = decodedQueryString;
+    }
+
+    struct HttpBackendContext::PrivateData {
+        std::unique_ptr<RequestHeaderReader> _headerReader;
+        std::unique_ptr<RequestBodyReader> _bodyReader;
+
+        PrivateData()
+            :_headerReader(new HttpRequestHeaderReader())
+            , _bodyReader(new DefaultRequestBodyReader()) 
+        {
+        }        
+    };
+
+    HttpBackendContext::HttpBackendContext() 
+        :_data(new PrivateData())
+    {}
+
+    HttpBackendContext::~HttpBackendContext() {
+    }
+
+    const RequestHeaderReader & HttpBackendContext::getRequestHeaderReader() const {
+        return *_data->_headerReader;
+    }
+
+    const RequestBodyReader & HttpBackendContext::getRequestBodyReader() const {
+        return *_data->_bodyReader;
+    }
+
+}
@@ -0,0 +1,480 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/http/http_server_connection.h>
+#include <restify/http/http_parser.h>
+#include <restify/http/http2_session.h>
+#include <restify/helpers.h>
+#include <restify/codes.h>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+
+namespace restify {
+
+    HttpServerConnection::Limits::Limits()
+        :maxHeadSize(16384), maxBodySize(64 * 1024 * 1024), maxPendingOutput(1024 * 1024), maxConcurrentStreams(100)
+    {}
+
+    struct HttpServerConnection::PrivateData {
+        Limits limits;
+        HttpRequestParser parser;
+        HttpRequestHead head;
+
+        std::vector<char> in;
+        size_t inSize;
+
+        std::string out;
+        size_t outOffset;
+
+        bool headComplete;
+        bool continueSent;
+        bool close;
+        bool broken;
+        bool suspended;
+        bool draining;
+
+        size_t bodyOffset;
+        size_t bodyLength;
+        uint64_t bytesWritten;
+        uint64_t bytesSent;
+        uint64_t requests;
+
+        /** Bytes written when the request being processed was dispatched. */
+        uint64_t dispatchWritten;
+        /** Timeouts set for the request being processed, negative for those of limits. */
+        int handlerTimeout;
+        int writeTimeout;
+
+        std::unique_ptr<ConnectionData> userData;
+        std::unique_ptr<Http2Session> http2;
+
+        PrivateData(const Limits &l)
+            :limits(l), parser(l.maxHeadSize), inSize(0), outOffset(0), headComplete(false), continueSent(false),
+            close(false), broken(false), suspended(false), draining(false), bodyOffset(0), bodyLength(0), bytesWritten(0), bytesSent(0), requests(0),
+            dispatchWritten(0), handlerTimeout(-1), writeTimeout(-1)
+        {}
+    };
+
+    HttpServerConnection::HttpServerConnection(const Limits &limits)
+        :_data(new PrivateData(limits))
+    {}
+
+    HttpServerConnection::~HttpServerConnection()
+    {}
+
+    char * HttpServerConnection::prepareReceive(size_t length) {
+        if (_data->in.size() < _data->inSize + length)
+            _data->in.resize(_data->inSize + length);
+        return _data->in.data() + _data->inSize;
+    }
+
+    void HttpServerConnection::commitReceive(size_t length) {
+        _data->inSize += length;
+    }
+
+    void HttpServerConnection::receive(const char * data, size_t length) {
+        memcpy(prepareReceive(length), data, length);
+        commitReceive(length);
+    }
+
+    /** True when list, a comma separated header value, contains token. */
+    static bool hasToken(const std::string *list, const char *token) {
+        if (!list)
+            return false;
+        for (const std::string &t : splitString(*list, ',', true, false)) {
+            if (toLowerCase(t) == token)
+                return true;
+        }
+        return false;
+    }
+
+    void HttpServerConnection::process(const BackendRequestHandler & handler, const BackendContext & ctx) {
+        PrivateData &d = *_data;
+
+        if (d.http2) {
+            processHttp2(handler, ctx);
+            return;
+        }
+
+        while (!d.close && !d.suspended) {
+            if (getPendingOutputSize() > d.limits.maxPendingOutput)
+                break;
+
+            if (!d.headComplete) {
+                // Prior knowledge clients open with the HTTP/2 preface instead of a request.
+                const bool http2 = d.requests == 0 && d.limits.maxConcurrentStreams > 0 && !d.draining;
+                const size_t n = std::min(d.inSize, Http2Session::PrefaceLength);
+                if (http2 && n > 0 && memcmp(d.in.data(), Http2Session::Preface, n) == 0) {
+                    if (n < Http2Session::PrefaceLength)
+                        break;
+                    startHttp2(handler, ctx);
+                    return;
+                }
+
+                HttpRequestParser::Result r = d.parser.parse(d.in.data(), d.inSize, d.head);
+                if (r == HttpRequestParser::Result::Incomplete)
+                    break;
+                if (r == HttpRequestParser::Result::Invalid) {
+                    writeError(d.parser.getErrorCode());
+                    break;
+                }
+
+                d.headComplete = true;
+
+                if (d.head.chunked) {
+                    writeError((int)StatusCode::LengthRequired);
+                    break;
+                }
+                if (d.head.contentLength > (int64_t)d.limits.maxBodySize) {
+                    writeError((int)StatusCode::ContentTooLarge);
+                    break;
+                }
+            }
+
+            const size_t headLength = d.parser.getHeadLength();
+            const size_t bodyLength = d.head.contentLength > 0 ? (size_t)d.head.contentLength : 0;
+
+            if (d.inSize < headLength + bodyLength) {
+                if (d.head.expectContinue && !d.continueSent) {
+                    static const char Continue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+                    write(Continue, sizeof(Continue) - 1);
+                    d.continueSent = true;
+                }
+                break;
+            }
+
+            if (upgradeHttp2(handler, ctx))
+                return;
+
+            // Request is complete, dispatch.
+            d.bodyOffset = headLength;
+            d.bodyLength = bodyLength;
+
+            const uint64_t written = d.bytesWritten;
+            d.dispatchWritten = written;
+            d.handlerTimeout = -1;
+            d.writeTimeout = -1;
+            bool handled = false;
+            try {
+                handled = handler && handler(ctx, *this);
+            } catch (...) {
+                handled = false;
+            }
+            ++d.requests;
+
+            if (!handled && !d.suspended) {
+                if (d.bytesWritten == written)
+                    writeError(handler ? (int)StatusCode::InternalServerError : (int)StatusCode::NotFound);
+                else
+                    d.close = true;
+            }
+
+            if (!d.head.keepAlive || d.draining)
+                d.close = true;
+
+            // Drop request from input buffer.
+            const size_t consumed = headLength + bodyLength;
+            memmove(d.in.data(), d.in.data() + consumed, d.inSize - consumed);
+            d.inSize -= consumed;
+            d.parser.reset();
+            d.headComplete = false;
+            d.continueSent = false;
+            d.bodyLength = 0;
+        }
+    }
+
+    void HttpServerConnection::startHttp2(const BackendRequestHandler & handler, const BackendContext & ctx) {
+        PrivateData &d = *_data;
+        d.http2.reset(new Http2Session(*this, d.limits));
+        d.http2->start();
+        processHttp2(handler, ctx);
+    }
+
+    bool HttpServerConnection::upgradeHttp2(const BackendRequestHandler & handler, const BackendContext & ctx) {
+        PrivateData &d = *_data;
+        if (d.requests > 0 || d.limits.maxConcurrentStreams == 0 || d.draining)
+            return false;
+
+        const std::string *settings = d.head.findHeader("HTTP2-Settings");
+        if (!settings || !hasToken(d.head.findHeader("Upgrade"), "h2c") || !hasToken(d.head.findHeader("Connection"), "upgrade"))
+            return false;
+
+        // Malformed settings leave the request to HTTP/1.1.
+        const size_t headLength = d.parser.getHeadLength();
+        const size_t bodyLength = d.head.contentLength > 0 ? (size_t)d.head.contentLength : 0;
+        std::unique_ptr<Http2Session> session(new Http2Session(*this, d.limits));
+        if (!session->upgrade(d.head, d.in.data() + headLength, bodyLength, *settings))
+            return false;
+
+        static const char Switching[] = "HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n";
+        write(Switching, sizeof(Switching) - 1);
+
+        const size_t consumed = headLength + bodyLength;
+        memmove(d.in.data(), d.in.data() + consumed, d.inSize - consumed);
+        d.inSize -= consumed;
+        d.parser.reset();
+        d.headComplete = false;
+        d.continueSent = false;
+
+        // The response to the upgraded request goes out as stream 1.
+        d.http2 = std::move(session);
+        d.http2->start();
+        processHttp2(handler, ctx);
+        return true;
+    }
+
+    void HttpServerConnection::processHttp2(const BackendRequestHandler & handler, const BackendContext & ctx) {
+        PrivateData &d = *_data;
+        const size_t consumed = d.http2->process(d.in.data(), d.inSize, handler, ctx);
+        memmove(d.in.data(), d.in.data() + consumed, d.inSize - consumed);
+        d.inSize -= consumed;
+    }
+
+    const char * HttpServerConnection::getPendingOutput() const {
+        return _data->out.data() + _data->outOffset;
+    }
+
+    size_t HttpServerConnection::getPendingOutputSize() const {
+        return _data->out.size() - _data->outOffset;
+    }
+
+    void HttpServerConnection::consumeOutput(size_t length) {
+        PrivateData &d = *_data;
+        d.outOffset += length;
+        d.bytesSent += length;
+        if (d.outOffset >= d.out.size()) {
+            d.out.clear();
+            d.outOffset = 0;
+        } else if (d.outOffset > 64 * 1024 && d.outOffset * 2 > d.out.size()) {
+            d.out.erase(0, d.outOffset);
+            d.outOffset = 0;
+        }
+    }
+
+    bool HttpServerConnection::shouldClose() const {
+        return _data->close || (_data->http2 && _data->http2->shouldClose());
+    }
+
+    uint64_t HttpServerConnection::getRequestCount() const {
+        return _data->requests + (_data->http2 ? _data->http2->getRequestCount() : 0);
+    }
+
+    bool HttpServerConnection::isSuspended() const {
+        return _data->suspended;
+    }
+
+    size_t HttpServerConnection::getDeferredCount() const {
+        if (_data->http2)
+            return _data->http2->getDeferredCount();
+        return _data->suspended ? 1 : 0;
+    }
+
+    bool HttpServerConnection::isHttp2() const {
+        return (bool)_data->http2;
+    }
+
+    void HttpServerConnection::resume(const ConnectionTask & task) {
+        if (_data->http2) {
+            _data->http2->resume(task);
+            return;
+        }
+
+        // The task may suspend the connection again.
+        _data->suspended = false;
+        if (task)
+            task(*this);
+        if (_data->draining) {
+            _data->suspended = false;
+            _data->close = true;
+        }
+    }
+
+    void HttpServerConnection::drain() {
+        PrivateData &d = *_data;
+        d.draining = true;
+        if (d.http2) {
+            d.http2->drain();
+            return;
+        }
+        if (d.inSize == 0 && !d.suspended)
+            d.close = true;
+    }
+
+    RequestPhase HttpServerConnection::getPhase() const {
+        const PrivateData &d = *_data;
+        if (getPendingOutputSize() > 0)
+            return RequestPhase::WriteResponse;
+
+        if (d.http2)
+            return d.http2->getDeferredCount() > 0 ? RequestPhase::None : RequestPhase::ReadHeader;
+
+        // A suspended connection whose response began is streaming, e.g. events.
+        if (d.suspended)
+            return d.bytesWritten == d.dispatchWritten ? RequestPhase::Handler : RequestPhase::None;
+        if (d.close)
+            return RequestPhase::None;
+        return d.headComplete ? RequestPhase::ReadBody : RequestPhase::ReadHeader;
+    }
+
+    uint32_t HttpServerConnection::getPhaseTimeout(RequestPhase phase) const {
+        const PrivateData &d = *_data;
+        if (phase == RequestPhase::Handler && d.handlerTimeout >= 0)
+            return (uint32_t)d.handlerTimeout;
+        if (phase == RequestPhase::WriteResponse && d.writeTimeout >= 0)
+            return (uint32_t)d.writeTimeout;
+        return d.limits.timeouts.get(phase);
+    }
+
+    bool HttpServerConnection::expirePhase(RequestPhase phase) {
+        PrivateData &d = *_data;
+        if (d.http2 || d.close)
+            return false;
+
+        switch (phase) {
+        case RequestPhase::ReadHeader:
+        case RequestPhase::ReadBody:
+            // Idle connections are closed silently.
+            if (d.inSize == 0 || getPendingOutputSize() > 0)
+                return false;
+            writeError((int)StatusCode::RequestTimeout);
+            return true;
+        case RequestPhase::Handler:
+            // The deferred response is dropped when it arrives, the connection is no longer suspended.
+            if (!d.suspended || d.bytesWritten != d.dispatchWritten)
+                return false;
+            d.suspended = false;
+            writeError((int)StatusCode::ServiceUnavailable);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    uint64_t HttpServerConnection::getBytesSent() const {
+        return _data->bytesSent;
+    }
+
+    const HttpRequestHead & HttpServerConnection::getRequestHead() const {
+        return _data->head;
+    }
+
+    int64_t HttpServerConnection::readStream(std::ostream & stream) {
+        PrivateData &d = *_data;
+        if (d.bodyLength > 0) {
+            stream.write(d.in.data() + d.bodyOffset, d.bodyLength);
+            if (!stream.good())
+                return -1;
+        }
+        return (int64_t)d.bodyLength;
+    }
+
+    int64_t HttpServerConnection::writeStream(std::istream & stream) {
+        const int chunkSize = 2048;
+        char chunk[chunkSize];
+
+        int64_t total = 0;
+        while (stream.good()) {
+            stream.read(chunk, chunkSize);
+            const std::streamsize read = stream.gcount();
+            if (read > 0) {
+                if (write(chunk, (size_t)read) < 0)
+                    return -1;
+                total += read;
+            }
+        }
+
+        return stream.eof() ? total : -1;
+    }
+
+    int64_t HttpServerConnection::write(const char * data, size_t length) {
+        PrivateData &d = *_data;
+        if (d.broken)
+            return -1;
+
+        const size_t total = length;
+
+        if (getPendingOutputSize() == 0) {
+            const int64_t sent = trySend(data, length);
+            if (sent < 0) {
+                d.broken = true;
+                d.close = true;
+                return -1;
+            }
+            data += sent;
+            length -= (size_t)sent;
+            d.bytesSent += (uint64_t)sent;
+        }
+
+        d.out.append(data, length);
+        d.bytesWritten += total;
+        return (int64_t)total;
+    }
+
+    void HttpServerConnection::closeConnection() {
+        _data->close = true;
+    }
+
+    bool HttpServerConnection::isKeepAlive() const {
+        return !_data->close && !_data->draining && _data->head.keepAlive;
+    }
+
+    std::string HttpServerConnection::getVersion() const {
+        return _data->head.version;
+    }
+
+    ConnectionData * HttpServerConnection::getConnectionData() const {
+        return _data->userData.get();
+    }
+
+    void HttpServerConnection::setConnectionData(std::unique_ptr<ConnectionData> data) {
+        _data->userData = std::move(data);
+    }
+
+    ConnectionResumer HttpServerConnection::suspend() {
+        if (_data->http2)
+            return createResumer();
+
+        ConnectionResumer resumer = createResumer();
+        if (resumer)
+            _data->suspended = true;
+        return resumer;
+    }
+
+    bool HttpServerConnection::setTimeouts(int handler, int write) {
+        _data->handlerTimeout = handler;
+        _data->writeTimeout = write;
+        return true;
+    }
+
+    int64_t HttpServerConnection::trySend(const char * data, size_t length) {
+        return 0;
+    }
+
+    ConnectionResumer HttpServerConnection::createResumer() {
+        return ConnectionResumer();
+    }
+
+    void HttpServerConnection::writeError(int code) {
+        size_t length = 0;
+        const char *line = statusLine(code, length);
+        if (!line)
+            line = statusLine((int)StatusCode::BadRequest, length);
+
+        std::string message(line, length);
+        message.append("Content-Length: 0\r\nConnection: close\r\n\r\n");
+        write(message.data(), message.size());
+        _data->close = true;
+    }
+
+}
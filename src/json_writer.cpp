@@ -0,0 +1,293 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/json_writer.h>
+#include <restify/error.h>
+#include <json/json.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace restify {
+
+    static const char DigitPairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    static const char HexDigits[] = "0123456789ABCDEF";
+
+    /** True if any of the eight bytes in word is a control character, a quote or a backslash. */
+    static inline bool wordNeedsEscape(uint64_t word) {
+        const uint64_t ones = 0x0101010101010101ULL;
+        const uint64_t highs = 0x8080808080808080ULL;
+
+        const uint64_t control = (word - ones * 0x20) & ~word & highs;
+        const uint64_t q = word ^ (ones * '"');
+        const uint64_t quote = (q - ones) & ~q & highs;
+        const uint64_t b = word ^ (ones * '\\');
+        const uint64_t backslash = (b - ones) & ~b & highs;
+
+        return (control | quote | backslash) != 0;
+    }
+
+    static inline bool byteNeedsEscape(unsigned char c) {
+        return c < 0x20 || c == '"' || c == '\\';
+    }
+
+    JsonStreamWriter::JsonStreamWriter(const FlushHandler &flush, size_t bufferSize)
+        :_flush(flush), _capacity(std::max<size_t>(bufferSize, 64)), _size(0), _flushed(0)
+    {
+        _ownedBuffer.reset(new char[_capacity]);
+        _buffer = _ownedBuffer.get();
+    }
+
+    JsonStreamWriter::JsonStreamWriter(const FlushHandler & flush, char * buffer, size_t bufferSize)
+        :_flush(flush), _buffer(buffer), _capacity(bufferSize), _size(0), _flushed(0)
+    {
+        if (bufferSize < 64)
+            CPPRESTIFY_FAIL(StatusCode::InternalServerError, "Json buffer needs to hold at least 64 chars.");
+    }
+
+    JsonStreamWriter::~JsonStreamWriter()
+    {}
+
+    JsonStreamWriter & JsonStreamWriter::write(const Json::Value & value) {
+        writeValue(value);
+        return *this;
+    }
+
+    void JsonStreamWriter::flush() {
+        if (_size == 0)
+            return;
+
+        _flush(_buffer, _size);
+        _flushed += _size;
+        _size = 0;
+    }
+
+    const char * JsonStreamWriter::data() const {
+        return _buffer;
+    }
+
+    size_t JsonStreamWriter::size() const {
+        return _size;
+    }
+
+    uint64_t JsonStreamWriter::getFlushedBytes() const {
+        return _flushed;
+    }
+
+    void JsonStreamWriter::reserve(size_t length) {
+        if (_capacity - _size < length)
+            flush();
+    }
+
+    void JsonStreamWriter::append(const char * data, size_t length) {
+        while (length > 0) {
+            if (_size == _capacity)
+                flush();
+
+            const size_t n = std::min(length, _capacity - _size);
+            memcpy(_buffer + _size, data, n);
+            _size += n;
+            data += n;
+            length -= n;
+        }
+    }
+
+    void JsonStreamWriter::writeValue(const Json::Value & value) {
+        switch (value.type()) {
+            case Json::nullValue:
+                append("null", 4);
+                break;
+            case Json::intValue:
+                reserve(20);
+                _size += formatInt(value.asLargestInt(), _buffer + _size);
+                break;
+            case Json::uintValue:
+                reserve(20);
+                _size += formatUInt(value.asLargestUInt(), _buffer + _size);
+                break;
+            case Json::realValue:
+                reserve(32);
+                _size += formatDouble(value.asDouble(), _buffer + _size);
+                break;
+            case Json::booleanValue:
+                if (value.asBool())
+                    append("true", 4);
+                else
+                    append("false", 5);
+                break;
+            case Json::stringValue:
+            {
+                const char *begin = nullptr;
+                const char *end = nullptr;
+                if (value.getString(&begin, &end))
+                    writeString(begin, end);
+                else
+                    append("\"\"", 2);
+                break;
+            }
+            case Json::arrayValue:
+            {
+                append("[", 1);
+                const Json::ArrayIndex count = value.size();
+                for (Json::ArrayIndex i = 0; i < count; ++i) {
+                    if (i > 0)
+                        append(",", 1);
+                    writeValue(value[i]);
+                }
+                append("]", 1);
+                break;
+            }
+            case Json::objectValue:
+            {
+                append("{", 1);
+                bool first = true;
+                for (auto i = value.begin(); i != value.end(); ++i) {
+                    if (!first)
+                        append(",", 1);
+                    first = false;
+
+                    const char *end = nullptr;
+                    const char *begin = i.memberName(&end);
+                    writeString(begin, end);
+                    append(":", 1);
+                    writeValue(*i);
+                }
+                append("}", 1);
+                break;
+            }
+        }
+    }
+
+    void JsonStreamWriter::writeString(const char * begin, const char * end) {
+        append("\"", 1);
+
+        const char *run = begin;
+        const char *p = begin;
+
+        while (p < end) {
+            // Skip eight clean bytes at a time.
+            if (end - p >= 8) {
+                uint64_t word;
+                memcpy(&word, p, 8);
+                if (!wordNeedsEscape(word)) {
+                    p += 8;
+                    continue;
+                }
+            }
+
+            const unsigned char c = static_cast<unsigned char>(*p);
+            if (!byteNeedsEscape(c)) {
+                ++p;
+                continue;
+            }
+
+            append(run, p - run);
+
+            char escaped[6] = { '\\', 0, 0, 0, 0, 0 };
+            size_t n = 2;
+            switch (c) {
+                case '"': escaped[1] = '"'; break;
+                case '\\': escaped[1] = '\\'; break;
+                case '\b': escaped[1] = 'b'; break;
+                case '\f': escaped[1] = 'f'; break;
+                case '\n': escaped[1] = 'n'; break;
+                case '\r': escaped[1] = 'r'; break;
+                case '\t': escaped[1] = 't'; break;
+                default:
+                    escaped[1] = 'u';
+                    escaped[2] = '0';
+                    escaped[3] = '0';
+                    escaped[4] = HexDigits[c >> 4];
+                    escaped[5] = HexDigits[c & 0xF];
+                    n = 6;
+                    break;
+            }
+            append(escaped, n);
+
+            ++p;
+            run = p;
+        }
+
+        append(run, p - run);
+        append("\"", 1);
+    }
+
+    size_t JsonStreamWriter::formatUInt(uint64_t value, char * dst) {
+        char tmp[20];
+        char *p = tmp + sizeof(tmp);
+
+        while (value >= 100) {
+            const unsigned idx = static_cast<unsigned>(value % 100) * 2;
+            value /= 100;
+            *--p = DigitPairs[idx + 1];
+            *--p = DigitPairs[idx];
+        }
+
+        if (value >= 10) {
+            const unsigned idx = static_cast<unsigned>(value) * 2;
+            *--p = DigitPairs[idx + 1];
+            *--p = DigitPairs[idx];
+        } else {
+            *--p = static_cast<char>('0' + value);
+        }
+
+        const size_t length = tmp + sizeof(tmp) - p;
+        memcpy(dst, p, length);
+        return length;
+    }
+
+    size_t JsonStreamWriter::formatInt(int64_t value, char * dst) {
+        if (value < 0) {
+            *dst = '-';
+            // Negate in unsigned arithmetic to handle the smallest value.
+            return 1 + formatUInt(0 - static_cast<uint64_t>(value), dst + 1);
+        }
+        return formatUInt(static_cast<uint64_t>(value), dst);
+    }
+
+    size_t JsonStreamWriter::formatDouble(double value, char * dst) {
+        if (!std::isfinite(value)) {
+            // Json has no representation for these.
+            memcpy(dst, "null", 4);
+            return 4;
+        }
+
+        // Integral values that are exactly representable.
+        if (value == std::floor(value) && std::fabs(value) < 9007199254740992.0) {
+            return formatInt(static_cast<int64_t>(value), dst);
+        }
+
+        // Shortest of 15, 16 or 17 significant digits that parses back to the same value.
+        int length = 0;
+        for (int precision = 15; precision <= 17; ++precision) {
+            length = snprintf(dst, 32, "%.*g", precision, value);
+            if (precision == 17 || strtod(dst, nullptr) == value)
+                break;
+        }
+
+        // Undo locale specific decimal separators.
+        std::replace(dst, dst + length, ',', '.');
+        return static_cast<size_t>(length);
+    }
+
+}
@@ -0,0 +1,199 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/listener_handoff.h>
+#include <json/json.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace restify {
+
+#ifndef _WIN32
+
+    static const char Ack = 'A';
+
+    static bool unixAddress(const std::string &path, sockaddr_un &addr) {
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path))
+            return false;
+        memcpy(addr.sun_path, path.data(), path.size());
+        return true;
+    }
+
+    /** Wait until s is readable, at most timeout milliseconds, negative waits forever. */
+    static bool waitReadable(int s, int timeout) {
+        pollfd pfd;
+        pfd.fd = s;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        for (;;) {
+            const int r = ::poll(&pfd, 1, timeout);
+            if (r > 0)
+                return true;
+            if (r == 0 || errno != EINTR)
+                return false;
+        }
+    }
+
+    bool ListenerHandoff::offer(const std::string & path, const std::vector<int> & sockets, int timeout) {
+        sockaddr_un addr;
+        if (sockets.empty() || sockets.size() > MaxSockets || !unixAddress(path, addr))
+            return false;
+
+        const int l = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (l < 0)
+            return false;
+
+        // A stale path left by a crashed process would fail bind.
+        ::unlink(path.c_str());
+        bool ok = ::bind(l, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+            ::listen(l, 1) == 0 &&
+            waitReadable(l, timeout);
+
+        const int c = ok ? ::accept(l, nullptr, nullptr) : -1;
+        ::close(l);
+        ::unlink(path.c_str());
+        if (c < 0)
+            return false;
+
+        // The count travels as payload, at least one byte is required to carry ancillary data.
+        const uint32_t count = (uint32_t)sockets.size();
+        iovec iov;
+        iov.iov_base = const_cast<uint32_t*>(&count);
+        iov.iov_len = sizeof(count);
+
+        char control[CMSG_SPACE(sizeof(int) * MaxSockets)];
+        memset(control, 0, sizeof(control));
+
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * sockets.size());
+
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * sockets.size());
+        memcpy(CMSG_DATA(cmsg), sockets.data(), sizeof(int) * sockets.size());
+
+        ok = ::sendmsg(c, &msg, MSG_NOSIGNAL) == (ssize_t)sizeof(count);
+
+        // Sockets are in use by the claimant once it acknowledged.
+        char ack = 0;
+        ok = ok && waitReadable(c, timeout) && ::recv(c, &ack, 1, 0) == 1 && ack == Ack;
+        ::close(c);
+        return ok;
+    }
+
+    bool ListenerHandoff::claim(const std::string & path, std::vector<int> & sockets, int timeout) {
+        sockaddr_un addr;
+        if (!unixAddress(path, addr))
+            return false;
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, timeout));
+
+        int c = -1;
+        for (;;) {
+            c = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (c < 0)
+                return false;
+            if (::connect(c, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+                break;
+
+            const int error = errno;
+            ::close(c);
+            c = -1;
+            if ((error != ENOENT && error != ECONNREFUSED) || std::chrono::steady_clock::now() >= deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (!waitReadable(c, std::max(0, (int)left.count()))) {
+            ::close(c);
+            return false;
+        }
+
+        uint32_t count = 0;
+        iovec iov;
+        iov.iov_base = &count;
+        iov.iov_len = sizeof(count);
+
+        char control[CMSG_SPACE(sizeof(int) * MaxSockets)];
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        const ssize_t n = ::recvmsg(c, &msg, MSG_CMSG_CLOEXEC);
+
+        std::vector<int> received;
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); n > 0 && cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+                continue;
+
+            const size_t num = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const size_t offset = received.size();
+            received.resize(offset + num);
+            memcpy(received.data() + offset, CMSG_DATA(cmsg), num * sizeof(int));
+        }
+
+        const bool ok = n == (ssize_t)sizeof(count) && !(msg.msg_flags & MSG_CTRUNC) &&
+            count == received.size() && ::send(c, &Ack, 1, MSG_NOSIGNAL) == 1;
+        ::close(c);
+
+        if (!ok) {
+            for (int s : received)
+                ::close(s);
+            return false;
+        }
+
+        sockets.insert(sockets.end(), received.begin(), received.end());
+        return true;
+    }
+
+#else
+
+    bool ListenerHandoff::offer(const std::string & path, const std::vector<int> & sockets, int timeout) {
+        return false;
+    }
+
+    bool ListenerHandoff::claim(const std::string & path, std::vector<int> & sockets, int timeout) {
+        return false;
+    }
+
+#endif
+
+    Json::Value ListenerHandoff::toJson(const std::vector<int> & sockets) {
+        Json::Value v(Json::arrayValue);
+        for (int s : sockets)
+            v.append(s);
+        return v;
+    }
+
+}
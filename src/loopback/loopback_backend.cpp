@@ -0,0 +1,107 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/loopback/loopback_backend.h>
+#include <restify/http/http_request_reader.h>
+#include <restify/helpers.h>
+#include <json/json.h>
+#include <algorithm>
+
+namespace restify {
+
+    struct LoopbackBackend::PrivateData {
+        Json::Value config;
+        BackendRequestHandler handler;
+        HttpBackendContext context;
+        HttpServerConnection::Limits limits;
+        bool isRunning;
+
+        PrivateData()
+            :isRunning(false)
+        {}
+    };
+
+    LoopbackBackend::LoopbackBackend()
+        :_data(new PrivateData)
+    {
+        json(_data->config)
+            ("max_request_size", 16384)
+            ("max_body_size", 64 * 1024 * 1024)
+            ("max_concurrent_streams", 100);
+    }
+
+    LoopbackBackend::~LoopbackBackend()
+    {
+        stop();
+    }
+
+    bool LoopbackBackend::setConfig(const Json::Value & options) {
+        return jsonMerge(_data->config, options);
+    }
+
+    bool LoopbackBackend::start() {
+        if (_data->isRunning)
+            return false;
+
+        _data->limits.maxHeadSize = (size_t)json_cast<int>(_data->config["max_request_size"]);
+        _data->limits.maxBodySize = (size_t)json_cast<int>(_data->config["max_body_size"]);
+        _data->limits.maxConcurrentStreams = (size_t)std::max(0, json_cast<int>(_data->config["max_concurrent_streams"]));
+        _data->isRunning = true;
+        return true;
+    }
+
+    bool LoopbackBackend::stop() {
+        _data->isRunning = false;
+        return true;
+    }
+
+    bool LoopbackBackend::setRequestCallback(const BackendRequestHandler & handler) {
+        if (_data->isRunning)
+            return false;
+
+        _data->handler = handler;
+        return true;
+    }
+
+    std::unique_ptr<LoopbackConnection> LoopbackBackend::connect() const {
+        return std::unique_ptr<LoopbackConnection>(new LoopbackConnection(_data->limits));
+    }
+
+    bool LoopbackBackend::exchange(LoopbackConnection & c, const char * data, size_t length, std::string & response) const {
+        if (!_data->isRunning || c.shouldClose())
+            return false;
+
+        c.receive(data, length);
+
+        // Dispatch until no further pipelined requests are released, resuming deferred ones.
+        for (;;) {
+            const uint64_t dispatched = c.getRequestCount();
+            c.process(_data->handler, _data->context);
+
+            response.append(c.getPendingOutput(), c.getPendingOutputSize());
+            c.consumeOutput(c.getPendingOutputSize());
+
+            if (c.getDeferredCount() > 0)
+                c.resumeNext();
+            else if (c.getRequestCount() == dispatched)
+                break;
+        }
+
+        return true;
+    }
+
+    std::string LoopbackBackend::exchange(const std::string & request) const {
+        std::unique_ptr<LoopbackConnection> c = connect();
+        std::string response;
+        exchange(*c, request.data(), request.size(), response);
+        return response;
+    }
+
+}
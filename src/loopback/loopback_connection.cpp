@@ -0,0 +1,75 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/loopback/loopback_connection.h>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace restify {
+
+    /** Tasks posted by resumers, shared with them since they may outlive the connection. */
+    struct LoopbackConnection::Mailbox {
+        std::mutex mutex;
+        std::condition_variable posted;
+        std::deque<ConnectionTask> tasks;
+        bool closed;
+
+        Mailbox()
+            :closed(false)
+        {}
+
+        void post(const ConnectionTask &task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (closed)
+                    return;
+                tasks.push_back(task);
+            }
+            posted.notify_one();
+        }
+
+        ConnectionTask take() {
+            std::unique_lock<std::mutex> lock(mutex);
+            posted.wait(lock, [this]() { return !tasks.empty(); });
+            ConnectionTask task = std::move(tasks.front());
+            tasks.pop_front();
+            return task;
+        }
+
+        void close() {
+            std::deque<ConnectionTask> dropped;
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            dropped.swap(tasks);
+        }
+    };
+
+    LoopbackConnection::LoopbackConnection(const Limits &limits)
+        :HttpServerConnection(limits), _mailbox(std::make_shared<Mailbox>())
+    {}
+
+    LoopbackConnection::~LoopbackConnection()
+    {
+        _mailbox->close();
+    }
+
+    void LoopbackConnection::resumeNext() {
+        resume(_mailbox->take());
+    }
+
+    ConnectionResumer LoopbackConnection::createResumer() {
+        std::shared_ptr<Mailbox> mailbox = _mailbox;
+        return [mailbox](const ConnectionTask &task) {
+            mailbox->post(task);
+        };
+    }
+
+}
@@ -11,16 +11,32 @@
 #include <restify/mongoose/mongoose_backend.h>
 #include <restify/mongoose/mongoose_connection.h>
 #include <restify/mongoose/mongoose_request_reader.h>
+#include <restify/mongoose/mongoose_websocket.h>
+#include <restify/mongoose/mongoose_watchdog.h>
 #include <restify/connection.h>
 #include <restify/request_reader.h>
 #include <restify/response_writer.h>
 #include <restify/helpers.h>
+#include <restify/admission_control.h>
+#include <restify/thread_placement.h>
 #include <json/json.h>
 #include <regex>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #include "mongoose.h"
 
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/socket.h>
+#endif
+
 namespace restify {
 
     struct MongooseBackendContext::PrivateData {
@@ -52,15 +68,37 @@ namespace restify {
 
 
     struct MongooseBackend::PrivateData {
-        struct mg_context *ctx;
+        /** One context per shard. */
+        std::vector<struct mg_context*> contexts;
         struct mg_callbacks callbacks;
         Json::Value config;
         BackendRequestHandler handler;
+        BackendWebSocketHandler webSocketHandler;
         MongooseBackendContext context;
+        AdmissionControl admission;
+        /** Times the phases of requests on all workers. */
+        MongooseWatchdog watchdog;
         bool isRunning;
+
+        /** Connections whose workers wait for deferred responses. */
+        std::mutex suspendedMutex;
+        std::set<MongooseConnection*> suspended;
+        bool stopping;
+        std::atomic<bool> draining;
+
+        /** WebSockets past their handshake. */
+        std::mutex socketsMutex;
+        std::set<std::shared_ptr<MongooseWebSocket>> sockets;
+
+        /** Start closing handshake of all WebSockets. */
+        void closeWebSockets(int code) {
+            std::lock_guard<std::mutex> lock(socketsMutex);
+            for (const std::shared_ptr<MongooseWebSocket> &ws : sockets)
+                ws->close(code);
+        }
         
         PrivateData()
-            :ctx(nullptr), isRunning(false)
+            :isRunning(false), stopping(false), draining(false)
         {
             memset(&callbacks, 0, sizeof(callbacks));
         }
@@ -75,10 +113,19 @@ namespace restify {
     {
         _data->callbacks.begin_request = &MongooseBackend::onBeginRequestCallback;
         _data->callbacks.log_message = onLogMessage;
+        _data->callbacks.accept_socket = &MongooseBackend::onAcceptSocketCallback;
+        _data->callbacks.dequeue_socket = &MongooseBackend::onDequeueSocketCallback;
+        _data->callbacks.read_head = &MongooseBackend::onReadHeadCallback;
         
         json(_data->config)
             ("listening_ports", "127.0.0.1:8080")
-            ("num_threads", 50);
+            ("num_threads", 50)
+            ("num_shards", 1)
+            ("numa", false)
+            ("enable_keep_alive", "yes")
+            ("websocket_max_message_size", 1024 * 1024);
+        AdmissionControl::addDefaultOptions(_data->config);
+        RequestTimeouts::addDefaultOptions(_data->config);
     }
 
     MongooseBackend::~MongooseBackend()
@@ -101,26 +148,132 @@ namespace restify {
 
     bool MongooseBackend::start()
     {
-        std::vector<std::string> strings;
-        createMongooseOptionStrings(_data->config, strings);
-        
-        std::vector<const char*> cstrings;
-        for (auto &s : strings) {
-            cstrings.push_back(s.c_str());
+        if (_data->isRunning)
+            return false;
+
+        int numShards = json_cast<int>(_data->config["num_shards"]);
+        if (numShards <= 0)
+            numShards = (int)std::max(1u, std::thread::hardware_concurrency());
+
+        // In NUMA mode every node with CPUs of cpu_affinity gets a shard running on them.
+        std::vector<std::string> shardCpus;
+        if (json_cast<bool>(_data->config["numa"])) {
+            std::vector<int> allowed;
+            if (!ThreadPlacement::parseCpuList(json_cast<std::string>(_data->config.get("cpu_affinity", "")), allowed))
+                return false;
+
+            for (const std::vector<int> &node : ThreadPlacement::getNumaNodes()) {
+                std::vector<int> cpus;
+                for (int c : node) {
+                    if (allowed.empty() || std::binary_search(allowed.begin(), allowed.end(), c))
+                        cpus.push_back(c);
+                }
+                if (!cpus.empty())
+                    shardCpus.push_back(ThreadPlacement::formatCpuList(cpus));
+            }
+            if (shardCpus.empty())
+                return false;
+            numShards = (int)shardCpus.size();
         }
-        cstrings.push_back(nullptr);
+
+        // num_shards, numa, listening_sockets, websocket, admission limits and timeouts are ours, everything else is passed on to mongoose.
+        Json::Value options = _data->config;
+        options.removeMember("num_shards");
+        options.removeMember("numa");
+        options.removeMember("listening_sockets");
+        options.removeMember("websocket_max_message_size");
+        if (!shardCpus.empty()) {
+            options.removeMember("cpu_affinity");
+            options["local_memory"] = "yes";
+        }
+        AdmissionControl::removeOptions(options);
+        RequestTimeouts::removeOptions(options);
+        _data->admission.setLimits(AdmissionControl::Limits::fromConfig(_data->config));
+
+        {
+            std::lock_guard<std::mutex> lock(_data->suspendedMutex);
+            _data->stopping = false;
+        }
+        _data->draining = false;
+
+        if (numShards > 1) {
+            // Every shard binds the same ports and gets its share of the worker threads.
+            const int numThreads = json_cast<int>(options["num_threads"]);
+            options["num_threads"] = std::max(1, (numThreads + numShards - 1) / numShards);
+            if (options.isMember("min_threads")) {
+                const int minThreads = json_cast<int>(options["min_threads"]);
+                options["min_threads"] = (minThreads + numShards - 1) / numShards;
+            }
+            options["reuse_port"] = "yes";
+        }
+
+        // Inherited sockets are split evenly between shards.
+        const Json::Value &sockets = _data->config["listening_sockets"];
+        const int numSockets = sockets.isArray() ? (int)sockets.size() : 0;
+        if (numSockets > 0 && numSockets % numShards != 0)
+            return false;
+
+        std::vector<std::string> common;
+        createMongooseOptionStrings(options, common);
+        _data->watchdog.start(RequestTimeouts::fromConfig(_data->config));
     
-        _data->ctx = mg_start(&_data->callbacks, this, &cstrings.at(0));
-        _data->isRunning = _data->ctx != 0;
+        for (int i = 0; i < numShards; ++i) {
+            std::vector<std::string> strings = common;
+            if (numSockets > 0) {
+                const int perShard = numSockets / numShards;
+                std::string list;
+                for (int j = i * perShard; j < (i + 1) * perShard; ++j) {
+                    if (!list.empty())
+                        list.push_back(',');
+                    list.append(std::to_string(json_cast<int>(sockets[j])));
+                }
+                strings.push_back("listening_sockets");
+                strings.push_back(list);
+            }
+            if (!shardCpus.empty()) {
+                strings.push_back("cpu_affinity");
+                strings.push_back(shardCpus[i]);
+            }
+
+            std::vector<const char*> cstrings;
+            for (auto &s : strings) {
+                cstrings.push_back(s.c_str());
+            }
+            cstrings.push_back(nullptr);
+
+            struct mg_context *ctx = mg_start(&_data->callbacks, this, &cstrings.at(0));
+            if (!ctx) {
+                stop();
+                return false;
+            }
+            _data->contexts.push_back(ctx);
+        }
+
+        _data->isRunning = true;
         return _data->isRunning;
     }
 
     bool MongooseBackend::stop()
     {
-        if (_data->ctx) {
-            mg_stop(_data->ctx);
-            _data->ctx = 0;
+        {
+            // Workers blocked on deferred responses would keep mg_stop from returning.
+            std::lock_guard<std::mutex> lock(_data->suspendedMutex);
+            _data->stopping = true;
+            for (MongooseConnection *c : _data->suspended)
+                c->abandon();
         }
+
+        // So would workers waiting for frames of WebSockets or follow-up requests.
+        _data->closeWebSockets(1001);
+        for (struct mg_context *ctx : _data->contexts) {
+            mg_drain(ctx);
+        }
+
+        for (struct mg_context *ctx : _data->contexts) {
+            mg_stop(ctx);
+        }
+        _data->contexts.clear();
+        _data->watchdog.stop();
         _data->isRunning = false;
         return true;
     }
@@ -137,6 +290,139 @@ namespace restify {
         return true;
     }
 
+    bool MongooseBackend::setWebSocketCallback(const BackendWebSocketHandler & handler) {
+        if (_data->isRunning)
+            return false;
+
+        // Without handler upgrade requests reach the request callback, which answers them.
+        const bool enabled = static_cast<bool>(handler);
+        _data->webSocketHandler = handler;
+        _data->callbacks.websocket_connect = enabled ? &MongooseBackend::onWebSocketConnectCallback : nullptr;
+        _data->callbacks.websocket_ready = enabled ? &MongooseBackend::onWebSocketReadyCallback : nullptr;
+        _data->callbacks.websocket_data = enabled ? &MongooseBackend::onWebSocketDataCallback : nullptr;
+        _data->callbacks.end_request = enabled ? &MongooseBackend::onEndRequestCallback : nullptr;
+        return true;
+    }
+
+    Json::Value MongooseBackend::getStatistics() const {
+        Json::Value stats(Json::objectValue);
+        stats["admission"] = _data->admission.getStatistics();
+
+        // Worker pools of all shards summed up.
+        struct mg_worker_stats total;
+        memset(&total, 0, sizeof(total));
+        for (struct mg_context *ctx : _data->contexts) {
+            struct mg_worker_stats w;
+            mg_get_worker_stats(ctx, &w);
+            total.threads += w.threads;
+            total.idle_threads += w.idle_threads;
+            total.min_threads += w.min_threads;
+            total.max_threads += w.max_threads;
+            total.spawned += w.spawned;
+            total.retired += w.retired;
+        }
+
+        Json::Value &workers = stats["workers"];
+        workers["threads"] = total.threads;
+        workers["idle"] = total.idle_threads;
+        workers["min"] = total.min_threads;
+        workers["max"] = total.max_threads;
+        workers["spawned"] = Json::Int64(total.spawned);
+        workers["retired"] = Json::Int64(total.retired);
+
+        std::lock_guard<std::mutex> lock(_data->socketsMutex);
+        stats["websockets"] = (Json::UInt64)_data->sockets.size();
+        return stats;
+    }
+
+    bool MongooseBackend::beginDrain() {
+        if (!_data->isRunning)
+            return false;
+
+        _data->draining = true;
+        _data->closeWebSockets(1001);
+        for (struct mg_context *ctx : _data->contexts) {
+            mg_drain(ctx);
+        }
+        return true;
+    }
+
+    size_t MongooseBackend::getOpenConnectionCount() const {
+        size_t count = 0;
+        for (struct mg_context *ctx : _data->contexts) {
+            count += (size_t)std::max(0, mg_get_open_connections(ctx));
+        }
+        return count;
+    }
+
+    std::vector<int> MongooseBackend::getListeningSockets() const {
+        std::vector<int> sockets;
+        for (struct mg_context *ctx : _data->contexts) {
+            const int n = mg_get_listening_sockets(ctx, nullptr, 0);
+            const size_t offset = sockets.size();
+            sockets.resize(offset + (size_t)n);
+            mg_get_listening_sockets(ctx, sockets.data() + offset, n);
+        }
+        return sockets;
+    }
+
+    /** Send pre-rendered rejection on a socket not yet served by mongoose. */
+    static void sendRejection(const AdmissionControl &admission, int sock, int isSsl) {
+        if (isSsl)
+            return;
+
+        const std::string &r = admission.getRejection();
+        int ignored = (int)::send(sock, r.data(), (int)r.size(), 0);
+        (void)ignored;
+    }
+
+    int MongooseBackend::onAcceptSocketCallback(void * userData, int sock, int isSsl) {
+        MongooseBackend *backend = static_cast<MongooseBackend*>(userData);
+        if (backend->_data->admission.enterQueue())
+            return 0;
+
+        sendRejection(backend->_data->admission, sock, isSsl);
+        return 1;
+    }
+
+    int MongooseBackend::onDequeueSocketCallback(void * userData, int sock, int isSsl, double waited) {
+        MongooseBackend *backend = static_cast<MongooseBackend*>(userData);
+        if (backend->_data->admission.leaveQueue(waited))
+            return 0;
+
+        sendRejection(backend->_data->admission, sock, isSsl);
+        return 1;
+    }
+
+    void MongooseBackend::onReadHeadCallback(void * userData, int sock, int isSsl, int state) {
+        MongooseWatchdog &watchdog = static_cast<MongooseBackend*>(userData)->_data->watchdog;
+        if (state == 0)
+            watchdog.beginHead(sock, isSsl != 0);
+        else if (state == 1)
+            watchdog.receivedHead();
+        else
+            watchdog.enter(RequestPhase::None);
+    }
+
+    /** Socket of a connection upgrading to WebSocket. */
+    struct WebSocketConnectionData : public ConnectionData {
+        std::shared_ptr<MongooseWebSocket> socket;
+    };
+
+    static std::shared_ptr<MongooseWebSocket> webSocketOf(const mg_connection *conn) {
+        WebSocketConnectionData *data = dynamic_cast<WebSocketConnectionData*>(static_cast<ConnectionData*>(mg_get_conn_data(conn)));
+        return data ? data->socket : std::shared_ptr<MongooseWebSocket>();
+    }
+
+    /** Mirrors the test mongoose uses to hand requests to its WebSocket handshake. */
+    static bool isWebSocketRequest(const mg_connection *conn) {
+        const char *upgrade = mg_get_header(conn, "Upgrade");
+        const char *connection = mg_get_header(conn, "Connection");
+        return mg_get_header(conn, "Host") && mg_get_header(conn, "Sec-WebSocket-Key") && mg_get_header(conn, "Sec-WebSocket-Version") &&
+            upgrade && toLowerCase(upgrade).find("websocket") != std::string::npos &&
+            connection && toLowerCase(connection).find("upgrade") != std::string::npos;
+    }
+
     int MongooseBackend::onBeginRequestCallback(mg_connection * conn) {
         const struct mg_request_info *info = mg_get_request_info(conn);
         
@@ -146,19 +432,154 @@ namespace restify {
 
         MongooseBackend *backend = static_cast<MongooseBackend*>(info->user_data);
         try {
+            if (backend->_data->webSocketHandler && isWebSocketRequest(conn))
+                return backend->handleWebSocketRequest(conn) ? 1 : 0;
             return backend->handleRequest(conn, info) ? 1 : 0;
         } catch (...) {
             return 0;
         }
     }
 
+    /** Request of the calling worker timed by watchdog, its phases end with it. */
+    struct WatchedRequest {
+        MongooseWatchdog &watchdog;
+
+        WatchedRequest(MongooseWatchdog &w, MongooseConnection &conn)
+            :watchdog(w)
+        {
+            watchdog.enter(RequestPhase::Handler);
+            watchdog.attach(&conn);
+        }
+
+        ~WatchedRequest() {
+            watchdog.attach(nullptr);
+            watchdog.enter(RequestPhase::None);
+        }
+    };
+
+    /** Ends an admitted request when the worker is done with it. */
+    struct AdmittedRequest {
+        AdmissionControl &admission;
+
+        AdmittedRequest(AdmissionControl &a)
+            :admission(a)
+        {}
+
+        ~AdmittedRequest() {
+            admission.endRequest();
+        }
+    };
+
     bool MongooseBackend::handleRequest(mg_connection * conn, const mg_request_info * info) {
         if (_data->handler) {
-            MongooseConnection mconn(conn);
-            return _data->handler(_data->context, mconn);
+            if (!_data->admission.beginRequest()) {
+                const std::string &r = _data->admission.getRejection();
+                mg_write(conn, r.data(), r.size());
+                mg_set_must_close(conn);
+                return true;
+            }
+            AdmittedRequest admitted(_data->admission);
+
+            MongooseConnection mconn(conn, &_data->watchdog);
+            WatchedRequest watched(_data->watchdog, mconn);
+            const bool handled = _data->handler(_data->context, mconn);
+            if (!mconn.isSuspended())
+                return handled;
+
+            // Tasks suspending the connection again, such as those of event streams, keep the worker.
+            // Requests past their deadline are abandoned by the watchdog, unless they expired before
+            // they were suspended.
+            for (;;) {
+                {
+                    std::lock_guard<std::mutex> lock(_data->suspendedMutex);
+                    if (_data->stopping || _data->watchdog.isExpired())
+                        mconn.abandon();
+                    _data->suspended.insert(&mconn);
+                }
+
+                if (!mconn.waitForResume()) {
+                    mconn.closeConnection();
+                    break;
+                }
+                if (!mconn.isSuspended())
+                    break;
+                if (_data->draining) {
+                    mconn.abandon();
+                    mconn.closeConnection();
+                    break;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(_data->suspendedMutex);
+            _data->suspended.erase(&mconn);
+            return true;
         } else {
             return false;
         }
     }
 
+
+    bool MongooseBackend::handleWebSocketRequest(mg_connection * conn) {
+        if (!_data->admission.beginRequest()) {
+            const std::string &r = _data->admission.getRejection();
+            mg_write(conn, r.data(), r.size());
+            mg_set_must_close(conn);
+            return true;
+        }
+        AdmittedRequest admitted(_data->admission);
+
+        const size_t maxMessageSize = (size_t)std::max(0, json_cast<int>(_data->config["websocket_max_message_size"]));
+        std::shared_ptr<MongooseWebSocket> ws = std::make_shared<MongooseWebSocket>(conn, maxMessageSize);
+
+        MongooseConnection mconn(conn);
+        WebSocketHandlers handlers;
+        if (!_data->webSocketHandler(_data->context, mconn, ws->getRequest(), handlers))
+            return true;
+
+        // Mongoose performs the handshake, the socket waits attached to the connection.
+        ws->setHandlers(handlers);
+        std::unique_ptr<WebSocketConnectionData> data(new WebSocketConnectionData());
+        data->socket = ws;
+        mconn.setConnectionData(std::move(data));
+        return false;
+    }
+
+    int MongooseBackend::onWebSocketConnectCallback(const mg_connection * conn) {
+        // Refuse handshakes of requests not accepted in onBeginRequestCallback.
+        return webSocketOf(conn) ? 0 : 1;
+    }
+
+    void MongooseBackend::onWebSocketReadyCallback(mg_connection * conn) {
+        std::shared_ptr<MongooseWebSocket> ws = webSocketOf(conn);
+        MongooseBackend *backend = static_cast<MongooseBackend*>(mg_get_request_info(conn)->user_data);
+        {
+            std::lock_guard<std::mutex> lock(backend->_data->socketsMutex);
+            backend->_data->sockets.insert(ws);
+        }
+        ws->open();
+    }
+
+    int MongooseBackend::onWebSocketDataCallback(mg_connection * conn, int bits, char * data, size_t length) {
+        std::shared_ptr<MongooseWebSocket> ws = webSocketOf(conn);
+        return ws && ws->receive(bits, data, length) ? 1 : 0;
+    }
+
+    void MongooseBackend::onEndRequestCallback(const mg_connection * conn, int status) {
+        std::shared_ptr<MongooseWebSocket> ws = webSocketOf(conn);
+        if (!ws)
+            return;
+
+        mg_connection *c = const_cast<mg_connection*>(conn);
+        MongooseBackend *backend = static_cast<MongooseBackend*>(mg_get_request_info(c)->user_data);
+        {
+            std::lock_guard<std::mutex> lock(backend->_data->socketsMutex);
+            backend->_data->sockets.erase(ws);
+        }
+        ws->detach();
+
+        // The connection does not return to HTTP.
+        mg_set_must_close(c);
+        mg_set_conn_data(c, nullptr, nullptr);
+    }
+
 }
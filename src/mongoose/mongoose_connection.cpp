@@ -9,15 +9,33 @@
 */
 
 #include <restify/mongoose/mongoose_connection.h>
+#include <restify/mongoose/mongoose_watchdog.h>
+#include <algorithm>
 #include <ostream>
 #include <istream>
+#include <mutex>
+#include <condition_variable>
 #include "mongoose.h"
 
 namespace restify {
 
+    struct MongooseConnection::Suspension {
+        std::mutex mutex;
+        std::condition_variable cv;
+        ConnectionTask task;
+        bool resumed;
+        bool abandoned;
 
-    MongooseConnection::MongooseConnection(mg_connection * conn)
-        :_conn(conn)
+        Suspension()
+            :resumed(false), abandoned(false)
+        {}
+    };
+
+    /** Writes are split into chunks of this size, each restarting the write deadline. */
+    static const size_t WriteChunkSize = 16384;
+
+    MongooseConnection::MongooseConnection(mg_connection * conn, MongooseWatchdog *watchdog)
+        :_conn(conn), _watchdog(watchdog)
     {
     }
 
@@ -30,6 +48,9 @@ namespace restify {
         const int chunkSize = 2048;
         char chunk[chunkSize];
 
+        if (_watchdog && !_watchdog->enter(RequestPhase::ReadBody))
+            return -1;
+
         int64_t total = 0;
         int read = 0;
         do {
@@ -40,6 +61,10 @@ namespace restify {
             }
         } while (read > 0 && stream.good());
 
+        // A body cut short by its deadline fails.
+        if (_watchdog && !_watchdog->enter(RequestPhase::Handler))
+            return -1;
+
         if (read == -1 || !stream.good()) {
             return -1;
         } else {
@@ -61,6 +86,8 @@ namespace restify {
             std::streamsize read = stream.gcount();
 
 			if (read > 0) {
+				if (_watchdog && !_watchdog->enter(RequestPhase::WriteResponse))
+					return -1;
 				wrote = mg_write(_conn, chunk, read);
 				if (wrote < 0) {
 					return -1;
@@ -76,10 +103,118 @@ namespace restify {
 			}
         }
         
+        if (_watchdog && !_watchdog->enter(RequestPhase::None))
+            return -1;
         return total;
     }
     
+    int64_t MongooseConnection::write(const char *data, size_t length) {
+        if (length == 0)
+            return 0;
+
+        if (!_watchdog) {
+            int wrote = mg_write(_conn, data, length);
+            return wrote < 0 ? -1 : (int64_t)wrote;
+        }
+
+        size_t total = 0;
+        while (total < length) {
+            const size_t n = std::min(length - total, WriteChunkSize);
+            if (!_watchdog->enter(RequestPhase::WriteResponse) || mg_write(_conn, data + total, n) < 0)
+                return -1;
+            total += n;
+        }
+        return _watchdog->enter(RequestPhase::None) ? (int64_t)total : -1;
+    }
+    
     void MongooseConnection::closeConnection() {
-        mg_close_connection(_conn);
+        mg_set_must_close(_conn);
+    }
+
+    bool MongooseConnection::isKeepAlive() const {
+        return mg_should_keep_alive(_conn) != 0;
+    }
+
+    std::string MongooseConnection::getVersion() const {
+        const char *version = mg_get_request_info(_conn)->http_version;
+        return version ? version : "1.1";
+    }
+
+    ConnectionData * MongooseConnection::getConnectionData() const {
+        return static_cast<ConnectionData*>(mg_get_conn_data(_conn));
+    }
+
+    static void deleteConnectionData(void *data) {
+        delete static_cast<ConnectionData*>(data);
+    }
+
+    void MongooseConnection::setConnectionData(std::unique_ptr<ConnectionData> data) {
+        mg_set_conn_data(_conn, data.release(), &deleteConnectionData);
+    }
+
+    ConnectionResumer MongooseConnection::suspend() {
+        std::shared_ptr<Suspension> s = std::make_shared<Suspension>();
+        {
+            std::lock_guard<std::mutex> lock(_suspensionMutex);
+            _suspension = s;
+        }
+        return [s](const ConnectionTask &task) {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            if (s->resumed || s->abandoned)
+                return;
+            s->task = task;
+            s->resumed = true;
+            s->cv.notify_one();
+        };
+    }
+
+    bool MongooseConnection::isSuspended() const {
+        return static_cast<bool>(_suspension);
+    }
+
+    bool MongooseConnection::setTimeouts(int handler, int write) {
+        if (!_watchdog)
+            return false;
+        _watchdog->setTimeouts(handler, write);
+        return true;
+    }
+
+    bool MongooseConnection::waitForResume() {
+        std::shared_ptr<Suspension> s = _suspension;
+        if (!s)
+            return true;
+
+        ConnectionTask task;
+        {
+            std::unique_lock<std::mutex> lock(s->mutex);
+            s->cv.wait(lock, [&s]() { return s->resumed || s->abandoned; });
+            if (!s->resumed)
+                return false;
+            task = std::move(s->task);
+        }
+
+        // The task may suspend the connection again.
+        {
+            std::lock_guard<std::mutex> lock(_suspensionMutex);
+            _suspension.reset();
+        }
+        if (task)
+            task(*this);
+        return true;
+    }
+
+    void MongooseConnection::abandon() {
+        std::shared_ptr<Suspension> s;
+        {
+            std::lock_guard<std::mutex> lock(_suspensionMutex);
+            s = _suspension;
+        }
+        if (!s)
+            return;
+
+        std::lock_guard<std::mutex> lock(s->mutex);
+        if (!s->resumed)
+            s->abandoned = true;
+        s->cv.notify_one();
     }
 }
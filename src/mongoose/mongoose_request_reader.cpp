@@ -15,6 +15,7 @@
 #include <restify/helpers.h>
 #include <json/json.h>
 #include <regex>
+#include <cstring>
 
 #include "mongoose.h"
 
@@ -0,0 +1,276 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/mongoose/mongoose_watchdog.h>
+#include <restify/mongoose/mongoose_connection.h>
+#include <restify/timer_wheel.h>
+#include <restify/codes.h>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#define SHUT_RDWR SD_BOTH
+#else
+#include <sys/socket.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#ifndef MSG_DONTWAIT
+#define MSG_DONTWAIT 0
+#endif
+
+namespace restify {
+
+    struct MongooseWatchdog::PrivateData {
+        std::mutex mutex;
+        std::condition_variable cv;
+        TimerWheel wheel;
+        /**
+            Deadlines of workers by thread id, declared after the wheel to be destroyed first. Workers
+            are detached and may still be exiting once stopped, nothing of theirs refers back here.
+            Ids of exited workers are reused by threads spawned later, which keeps the map small.
+        */
+        std::unordered_map<std::thread::id, std::unique_ptr<Worker>> workers;
+        RequestTimeouts timeouts;
+        std::thread thread;
+        bool running;
+        bool stopping;
+        /** Time the thread wakes up next, earlier deadlines wake it. */
+        uint64_t wakeAt;
+
+        std::string requestTimeout;
+        std::string serviceUnavailable;
+
+        PrivateData()
+            :running(false), stopping(false), wakeAt(UINT64_MAX)
+        {}
+
+        /** Arm the timer of w for the phase it is in, the lock is held. */
+        void arm(Worker &w);
+
+        /** Deadline of the calling worker, the lock is held. */
+        Worker &current();
+    };
+
+    /** Deadline of the request a worker serves. */
+    struct MongooseWatchdog::Worker {
+        TimerWheel::Timer timer;
+        int socket;
+        bool ssl;
+        bool received;
+        bool expired;
+        RequestPhase phase;
+        int handlerTimeout;
+        int writeTimeout;
+        MongooseConnection *connection;
+
+        Worker()
+            :timer(this), socket(-1), ssl(false), received(false), expired(false),
+            phase(RequestPhase::None), handlerTimeout(-1), writeTimeout(-1), connection(nullptr)
+        {}
+    };
+
+    /** Response sent to clients of requests expiring before their response began. */
+    static std::string renderTimeoutResponse(StatusCode code) {
+        size_t length = 0;
+        const char *line = statusLine((int)code, length);
+        std::string r(line, length);
+        r.append("Content-Length: 0\r\nConnection: close\r\n\r\n");
+        return r;
+    }
+
+    void MongooseWatchdog::PrivateData::arm(Worker &w) {
+        uint32_t timeout = timeouts.get(w.phase);
+        if (w.phase == RequestPhase::Handler && w.handlerTimeout >= 0)
+            timeout = (uint32_t)w.handlerTimeout;
+        else if (w.phase == RequestPhase::WriteResponse && w.writeTimeout >= 0)
+            timeout = (uint32_t)w.writeTimeout;
+
+        if (timeout == 0) {
+            wheel.cancel(w.timer);
+            return;
+        }
+
+        const uint64_t now = TimerWheel::now();
+        wheel.schedule(w.timer, now, timeout);
+        if (now + timeout < wakeAt) {
+            wakeAt = now + timeout;
+            cv.notify_one();
+        }
+    }
+
+    MongooseWatchdog::Worker & MongooseWatchdog::PrivateData::current() {
+        std::unique_ptr<Worker> &w = workers[std::this_thread::get_id()];
+        if (!w)
+            w.reset(new Worker());
+        return *w;
+    }
+
+    MongooseWatchdog::MongooseWatchdog()
+        :_data(new PrivateData())
+    {}
+
+    MongooseWatchdog::~MongooseWatchdog() {
+        stop();
+    }
+
+    void MongooseWatchdog::start(const RequestTimeouts & timeouts) {
+        PrivateData &d = *_data;
+        if (d.running)
+            return;
+
+        d.timeouts = timeouts;
+        d.requestTimeout = renderTimeoutResponse(StatusCode::RequestTimeout);
+        d.serviceUnavailable = renderTimeoutResponse(StatusCode::ServiceUnavailable);
+        d.stopping = false;
+        d.running = true;
+
+        d.thread = std::thread([&d]() {
+            auto expire = [&d](TimerWheel::Timer &timer) {
+                Worker &w = *static_cast<Worker*>(timer.getOwner());
+                w.expired = true;
+
+                const std::string *response = nullptr;
+                if ((w.phase == RequestPhase::ReadHeader && w.received) || w.phase == RequestPhase::ReadBody)
+                    response = &d.requestTimeout;
+                else if (w.phase == RequestPhase::Handler)
+                    response = &d.serviceUnavailable;
+
+                // The socket buffer is empty before a response began, sending does not block.
+                if (response && !w.ssl) {
+                    int ignored = (int)::send(w.socket, response->data(), (int)response->size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+                    (void)ignored;
+                }
+                ::shutdown(w.socket, SHUT_RDWR);
+
+                if (w.phase == RequestPhase::Handler && w.connection)
+                    w.connection->abandon();
+            };
+
+            std::unique_lock<std::mutex> lock(d.mutex);
+            while (!d.stopping) {
+                const uint64_t now = TimerWheel::now();
+                d.wheel.advance(now, expire);
+
+                const int wait = d.wheel.getWaitTime(now);
+                if (wait < 0) {
+                    d.wakeAt = UINT64_MAX;
+                    d.cv.wait(lock);
+                } else {
+                    d.wakeAt = now + (uint64_t)wait;
+                    d.cv.wait_for(lock, std::chrono::milliseconds(wait));
+                }
+            }
+        });
+    }
+
+    void MongooseWatchdog::stop() {
+        PrivateData &d = *_data;
+        if (!d.running)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(d.mutex);
+            d.stopping = true;
+            d.cv.notify_one();
+        }
+        d.thread.join();
+
+        std::lock_guard<std::mutex> lock(d.mutex);
+        d.workers.clear();
+        d.running = false;
+    }
+
+    void MongooseWatchdog::beginHead(int sock, bool ssl) {
+        PrivateData &d = *_data;
+        if (!d.running)
+            return;
+
+        std::lock_guard<std::mutex> lock(d.mutex);
+        Worker &w = d.current();
+        w.socket = sock;
+        w.ssl = ssl;
+        w.received = false;
+        w.expired = false;
+        w.phase = RequestPhase::ReadHeader;
+        w.handlerTimeout = -1;
+        w.writeTimeout = -1;
+        w.connection = nullptr;
+        d.arm(w);
+    }
+
+    void MongooseWatchdog::receivedHead() {
+        PrivateData &d = *_data;
+        if (!d.running)
+            return;
+
+        std::lock_guard<std::mutex> lock(d.mutex);
+        Worker &w = d.current();
+        w.received = true;
+    }
+
+    bool MongooseWatchdog::enter(RequestPhase phase) {
+        PrivateData &d = *_data;
+        if (!d.running)
+            return true;
+
+        std::lock_guard<std::mutex> lock(d.mutex);
+        Worker &w = d.current();
+        if (w.expired)
+            return false;
+        w.phase = phase;
+        d.arm(w);
+        return true;
+    }
+
+    bool MongooseWatchdog::isExpired() {
+        PrivateData &d = *_data;
+        if (!d.running)
+            return false;
+
+        std::lock_guard<std::mutex> lock(d.mutex);
+        Worker &w = d.current();
+        return w.expired;
+    }
+
+    void MongooseWatchdog::setTimeouts(int handler, int write) {
+        PrivateData &d = *_data;
+        if (!d.running)
+            return;
+
+        std::lock_guard<std::mutex> lock(d.mutex);
+        Worker &w = d.current();
+        w.handlerTimeout = handler;
+        w.writeTimeout = write;
+        if (!w.expired && (w.phase == RequestPhase::Handler || w.phase == RequestPhase::WriteResponse))
+            d.arm(w);
+    }
+
+    void MongooseWatchdog::attach(MongooseConnection * conn) {
+        PrivateData &d = *_data;
+        if (!d.running)
+            return;
+
+        std::lock_guard<std::mutex> lock(d.mutex);
+        Worker &w = d.current();
+        w.connection = conn;
+    }
+
+}
@@ -0,0 +1,193 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/mongoose/mongoose_websocket.h>
+#include <restify/request.h>
+#include <mutex>
+#include <string>
+
+#include "mongoose.h"
+
+namespace restify {
+
+    static const int OpcodeContinuation = 0x0;
+    static const int OpcodeText = 0x1;
+    static const int OpcodeBinary = 0x2;
+    static const int OpcodeClose = 0x8;
+    static const int OpcodePing = 0x9;
+    static const int OpcodePong = 0xa;
+
+    static const int CloseProtocolError = 1002;
+    static const int CloseMessageTooBig = 1009;
+    static const int CloseInternalError = 1011;
+
+    struct MongooseWebSocket::PrivateData {
+        /** Guards conn and state against concurrent senders. */
+        mutable std::mutex mutex;
+        struct mg_connection *conn;
+        bool opened;
+        bool closing;
+
+        Request request;
+        WebSocketHandlers handlers;
+        size_t maxMessageSize;
+
+        /** Message being received, accessed by the worker only. */
+        std::string message;
+        int messageOpcode;
+
+        PrivateData()
+            :conn(nullptr), opened(false), closing(false), maxMessageSize(0), messageOpcode(OpcodeContinuation)
+        {}
+    };
+
+    MongooseWebSocket::MongooseWebSocket(mg_connection * conn, size_t maxMessageSize)
+        :_data(new PrivateData())
+    {
+        _data->conn = conn;
+        _data->maxMessageSize = maxMessageSize;
+    }
+
+    MongooseWebSocket::~MongooseWebSocket()
+    {}
+
+    bool MongooseWebSocket::writeFrame(int opcode, const char * data, size_t length) {
+        return _data->conn && mg_websocket_write(_data->conn, opcode, data, length) > 0;
+    }
+
+    bool MongooseWebSocket::send(const char * data, size_t length, bool binary) {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        if (!_data->opened || _data->closing)
+            return false;
+        return writeFrame(binary ? OpcodeBinary : OpcodeText, data, length);
+    }
+
+    bool MongooseWebSocket::close(int code) {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        if (!_data->opened || _data->closing || !_data->conn)
+            return false;
+
+        // The worker keeps reading until the peer answers with a close frame.
+        const char payload[2] = { (char)((code >> 8) & 0xff), (char)(code & 0xff) };
+        writeFrame(OpcodeClose, payload, sizeof(payload));
+        _data->closing = true;
+        mg_set_must_close(_data->conn);
+        return true;
+    }
+
+    bool MongooseWebSocket::isOpen() const {
+        std::lock_guard<std::mutex> lock(_data->mutex);
+        return _data->opened && !_data->closing && _data->conn != nullptr;
+    }
+
+    const Request & MongooseWebSocket::getRequest() const {
+        return _data->request;
+    }
+
+    Request & MongooseWebSocket::getRequest() {
+        return _data->request;
+    }
+
+    void MongooseWebSocket::setHandlers(const WebSocketHandlers & handlers) {
+        _data->handlers = handlers;
+    }
+
+    void MongooseWebSocket::open() {
+        {
+            std::lock_guard<std::mutex> lock(_data->mutex);
+            _data->opened = true;
+        }
+
+        if (_data->handlers.onOpen) {
+            try {
+                _data->handlers.onOpen(shared_from_this());
+            } catch (...) {
+                close(CloseInternalError);
+            }
+        }
+    }
+
+    bool MongooseWebSocket::fail(int code) {
+        close(code);
+        return false;
+    }
+
+    bool MongooseWebSocket::receive(int bits, const char * data, size_t length) {
+        PrivateData &d = *_data;
+        const int opcode = bits & 0x0f;
+        const bool fin = (bits & 0x80) != 0;
+
+        // No extensions are negotiated, reserved bits must be clear.
+        if (bits & 0x70)
+            return fail(CloseProtocolError);
+
+        if (opcode & 0x8) {
+            // Control frames are never fragmented and carry at most 125 bytes.
+            if (!fin || length > 125 || opcode > OpcodePong)
+                return fail(CloseProtocolError);
+
+            std::lock_guard<std::mutex> lock(d.mutex);
+            if (opcode == OpcodeClose) {
+                // Echo status code unless we started the closing handshake.
+                if (!d.closing)
+                    writeFrame(OpcodeClose, data, length >= 2 ? 2 : 0);
+                d.closing = true;
+                return false;
+            }
+            if (opcode == OpcodePing && !d.closing)
+                writeFrame(OpcodePong, data, length);
+            return true;
+        }
+
+        if (opcode == OpcodeText || opcode == OpcodeBinary) {
+            if (d.messageOpcode != OpcodeContinuation)
+                return fail(CloseProtocolError);
+            d.messageOpcode = opcode;
+            d.message.clear();
+        } else if (opcode != OpcodeContinuation || d.messageOpcode == OpcodeContinuation) {
+            return fail(CloseProtocolError);
+        }
+
+        if (d.message.size() + length > d.maxMessageSize)
+            return fail(CloseMessageTooBig);
+        d.message.append(data, length);
+
+        if (!fin)
+            return true;
+
+        const bool binary = d.messageOpcode == OpcodeBinary;
+        d.messageOpcode = OpcodeContinuation;
+        if (d.handlers.onMessage) {
+            try {
+                d.handlers.onMessage(shared_from_this(), d.message, binary);
+            } catch (...) {
+                return fail(CloseInternalError);
+            }
+        }
+        return true;
+    }
+
+    void MongooseWebSocket::detach() {
+        bool opened;
+        {
+            std::lock_guard<std::mutex> lock(_data->mutex);
+            opened = _data->opened;
+            _data->conn = nullptr;
+            _data->closing = true;
+        }
+
+        if (opened && _data->handlers.onClose) {
+            try {
+                _data->handlers.onClose(shared_from_this());
+            } catch (...) {
+            }
+        }
+    }
+}
@@ -33,6 +33,23 @@ namespace restify {
 
     Request::~Request()        
     {}
+
+    void Request::clear() {
+        _root.removeMember(Keys::method);
+        _root.removeMember(Keys::path);
+        _root.removeMember(Keys::query);
+        _root.removeMember(Keys::body);
+
+        // Reuse existing containers.
+        _root[Keys::params].clear();
+        _root[Keys::headers].clear();
+
+        if (_root.size() != 2) {
+            _root = Json::Value(Json::objectValue);
+            _root[Keys::params] = Json::Value(Json::objectValue);
+            _root[Keys::headers] = Json::Value(Json::objectValue);
+        }
+    }
   
     std::string Request::getMethod() const
     {
@@ -0,0 +1,126 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/request_arena.h>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+namespace restify {
+
+    static thread_local RequestArena *currentArena = nullptr;
+
+    struct RequestArena::PrivateData {
+        struct Chunk {
+            char *data;
+            size_t size;
+        };
+
+        std::vector<Chunk> chunks;
+        size_t chunk;
+        size_t offset;
+        size_t used;
+        size_t highWaterMark;
+        size_t initialSize;
+        size_t maxRetainedSize;
+
+        PrivateData(size_t initial, size_t maxRetained)
+            :chunk(0), offset(0), used(0), highWaterMark(0), initialSize(std::max<size_t>(initial, 64)), maxRetainedSize(maxRetained)
+        {}
+    };
+
+    RequestArena::Scope::Scope(RequestArena * arena)
+        :_previous(currentArena)
+    {
+        currentArena = arena;
+    }
+
+    RequestArena::Scope::~Scope() {
+        currentArena = _previous;
+    }
+
+    RequestArena::RequestArena(size_t initialSize, size_t maxRetainedSize)
+        :_data(new PrivateData(initialSize, maxRetainedSize))
+    {}
+
+    RequestArena::~RequestArena() {
+        for (auto &c : _data->chunks)
+            ::operator delete(c.data);
+    }
+
+    RequestArena * RequestArena::current() {
+        return currentArena;
+    }
+
+    void * RequestArena::allocate(size_t size, size_t alignment) {
+        PrivateData &d = *_data;
+
+        // Continue in the current chunk, then in chunks retained from earlier requests.
+        while (d.chunk < d.chunks.size()) {
+            PrivateData::Chunk &c = d.chunks[d.chunk];
+            const uintptr_t base = reinterpret_cast<uintptr_t>(c.data);
+            const uintptr_t aligned = (base + d.offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            const size_t begin = aligned - base;
+            if (begin + size <= c.size) {
+                d.used += begin + size - d.offset;
+                d.offset = begin + size;
+                d.highWaterMark = std::max(d.highWaterMark, d.used);
+                return c.data + begin;
+            }
+            d.used += c.size - d.offset;
+            ++d.chunk;
+            d.offset = 0;
+        }
+
+        // Chunks double in size, ::operator new aligns to max_align_t.
+        const size_t last = d.chunks.empty() ? d.initialSize / 2 : d.chunks.back().size;
+        const size_t chunkSize = std::max(last * 2, size + alignment);
+        PrivateData::Chunk c = { static_cast<char*>(::operator new(chunkSize)), chunkSize };
+        d.chunks.push_back(c);
+        d.chunk = d.chunks.size() - 1;
+        d.offset = 0;
+        return allocate(size, alignment);
+    }
+
+    void RequestArena::reset() {
+        PrivateData &d = *_data;
+
+        // Keep the leading chunks up to the retained size.
+        size_t retained = 0;
+        size_t keep = 0;
+        while (keep < d.chunks.size() && (keep == 0 || retained + d.chunks[keep].size <= d.maxRetainedSize)) {
+            retained += d.chunks[keep].size;
+            ++keep;
+        }
+        for (size_t i = keep; i < d.chunks.size(); ++i)
+            ::operator delete(d.chunks[i].data);
+        d.chunks.resize(keep);
+
+        d.chunk = 0;
+        d.offset = 0;
+        d.used = 0;
+    }
+
+    size_t RequestArena::getUsed() const {
+        return _data->used;
+    }
+
+    size_t RequestArena::getCapacity() const {
+        size_t total = 0;
+        for (auto &c : _data->chunks)
+            total += c.size;
+        return total;
+    }
+
+    size_t RequestArena::getHighWaterMark() const {
+        return _data->highWaterMark;
+    }
+
+}
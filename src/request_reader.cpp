@@ -13,13 +13,29 @@
 #include <restify/connection.h>
 #include <restify/error.h>
 #include <restify/helpers.h>
+#include <restify/request_arena.h>
+#include <restify/object_pool.h>
 #include <json/json.h>
 #include <regex>
+#include <sstream>
 
 #include "mongoose.h"
 
 namespace restify {
 
+    /** Readers are stateless between parses, each thread keeps a few configured ones. */
+    template<>
+    struct ObjectPoolTraits<Json::CharReader> {
+        enum { Capacity = 4 };
+
+        static Json::CharReader *create() {
+            Json::CharReaderBuilder b;
+            return b.newCharReader();
+        }
+
+        static void recycle(Json::CharReader &) {}
+    };
+
     void DefaultRequestBodyReader::readRequestBody(Connection & c, Request & request) const {
         Json::Value &root = request.toJson();
 
@@ -29,10 +45,12 @@ namespace restify {
             return;
         }
 
-        std::ostringstream oss;
+        // Raw body is only needed until it is converted, keep it in the request arena.
+        std::basic_ostringstream<char, std::char_traits<char>, ArenaAllocator<char>> oss;
         if (c.readStream(oss) < 0) {
             throw Error(StatusCode::BadRequest, "Message transfer not complete.");
         }
+        const ArenaString raw = oss.str();
 
         const static std::regex isContentJsonRegex(R"(/json)", std::regex::icase);
 
@@ -40,19 +58,17 @@ namespace restify {
 
         if (std::regex_search(contentType.begin(), contentType.end(), isContentJsonRegex)) {
 
-            std::istringstream iss(oss.str());
-
-            Json::CharReaderBuilder b;
+            ObjectPool<Json::CharReader>::Ptr reader = ObjectPool<Json::CharReader>::acquire();
             std::string errs;
 
             root[Request::Keys::body] = Json::Value(Json::objectValue);
 
-            if (!Json::parseFromStream(b, iss, &root[Request::Keys::body], &errs)) {
+            if (!reader->parse(raw.data(), raw.data() + raw.size(), &root[Request::Keys::body], &errs)) {
                 throw Error(StatusCode::BadRequest, errs.c_str());
             }
 
         } else {
-            root[Request::Keys::body] = oss.str();
+            root[Request::Keys::body] = Json::Value(raw.data(), raw.data() + raw.size());
         }
     }
 
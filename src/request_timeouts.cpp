@@ -0,0 +1,61 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/request_timeouts.h>
+#include <restify/helpers.h>
+#include <json/json.h>
+#include <algorithm>
+
+namespace restify {
+
+    RequestTimeouts::RequestTimeouts()
+        :header(30000), body(60000), handler(0), write(60000)
+    {}
+
+    uint32_t RequestTimeouts::get(RequestPhase phase) const {
+        switch (phase) {
+        case RequestPhase::ReadHeader:
+            return header;
+        case RequestPhase::ReadBody:
+            return body;
+        case RequestPhase::Handler:
+            return handler;
+        case RequestPhase::WriteResponse:
+            return write;
+        default:
+            return 0;
+        }
+    }
+
+    RequestTimeouts RequestTimeouts::fromConfig(const Json::Value & config) {
+        RequestTimeouts t;
+        t.header = (uint32_t)std::max(0, json_cast<int>(config.get("header_timeout_ms", 30000)));
+        t.body = (uint32_t)std::max(0, json_cast<int>(config.get("body_timeout_ms", 60000)));
+        t.handler = (uint32_t)std::max(0, json_cast<int>(config.get("handler_timeout_ms", 0)));
+        t.write = (uint32_t)std::max(0, json_cast<int>(config.get("write_timeout_ms", 60000)));
+        return t;
+    }
+
+    void RequestTimeouts::addDefaultOptions(Json::Value & config) {
+        json(config)
+            ("header_timeout_ms", 30000)
+            ("body_timeout_ms", 60000)
+            ("handler_timeout_ms", 0)
+            ("write_timeout_ms", 60000);
+    }
+
+    void RequestTimeouts::removeOptions(Json::Value & config) {
+        config.removeMember("header_timeout_ms");
+        config.removeMember("body_timeout_ms");
+        config.removeMember("handler_timeout_ms");
+        config.removeMember("write_timeout_ms");
+    }
+
+}
@@ -20,13 +20,13 @@ namespace restify {
         
 
     Response::Response()
-        :_root(Json::objectValue)
+        :_root(Json::objectValue), _bodyStreamChunkSize(0)
     {
         _root[Keys::headers] = Json::Value(Json::objectValue);
     }
 
     Response::Response(const Json::Value & opts) 
-        : _root(opts)
+        : _root(opts), _bodyStreamChunkSize(0)
     {
         if (_root[Keys::headers].isNull())
             _root[Keys::headers] = Json::Value(Json::objectValue);
@@ -35,6 +35,21 @@ namespace restify {
     Response::~Response()
     {
     }
+
+    void Response::clear() {
+        clearBody();
+        _bodyStreamChunkSize = 0;
+        _rawBodyContentType.clear();
+
+        _root.removeMember(Keys::statusCode);
+        _root.removeMember(Keys::version);
+        _root[Keys::headers].clear();
+
+        if (_root.size() != 1) {
+            _root = Json::Value(Json::objectValue);
+            _root[Keys::headers] = Json::Value(Json::objectValue);
+        }
+    }
     
     Response &Response::setCode(int setCode) {
         _root[Keys::statusCode] = setCode;
@@ -43,9 +58,39 @@ namespace restify {
 
     
     Response &Response::setBody(const Json::Value &value) {
+        clearBody();
         _root[Keys::body] = value;
         return *this;
     }
+
+    Response &Response::setBodyStream(const ResponseBodyProducer &producer, size_t chunkSize) {
+        clearBody();
+        _bodyStream = producer;
+        _bodyStreamChunkSize = chunkSize;
+        return *this;
+    }
+
+    Response &Response::setRawBody(std::shared_ptr<const std::string> bytes, const std::string &contentType) {
+        clearBody();
+        _rawBody = std::move(bytes);
+        _rawBodyContentType = contentType;
+        return *this;
+    }
+
+    Response &Response::setBinaryBody(std::string bytes, const std::string &contentType) {
+        return setRawBody(std::make_shared<const std::string>(std::move(bytes)), contentType);
+    }
+
+    Response &Response::setBinaryBody(const void *data, size_t length, const std::string &contentType) {
+        const char *begin = static_cast<const char*>(data);
+        return setRawBody(std::make_shared<const std::string>(begin, begin + length), contentType);
+    }
+
+    void Response::clearBody() {
+        _root.removeMember(Keys::body);
+        _bodyStream = ResponseBodyProducer();
+        _rawBody.reset();
+    }
     
     Response &Response::setHeader(const std::string &key, const Json::Value &value) {
         _root[Keys::headers][key] = value;
@@ -74,20 +119,14 @@ namespace restify {
             throw Error(StatusCode::Forbidden, "Cannot open file.");
         }
 
-        file.seekg(0, file.end);
-        std::streampos fsize = file.tellg();
-        file.seekg(0, file.beg);        
-
         std::stringstream buffer;
         buffer << file.rdbuf();
         file.close();
 
         const std::string mime = MimeTypes::resolveFromFileExtension(Path::extension(path));
 
-        setBody(buffer.str());
-        setHeader("Content-Length", (int)fsize);
-        setHeader("Content-Type", mime);
-        setHeader("Content - Disposition", "attachment; filename = " + Path::filename(path));
+        setBinaryBody(buffer.str(), mime);
+        setHeader("Content-Disposition", "attachment; filename=" + Path::filename(path));
 
         return *this;
     }
@@ -104,9 +143,27 @@ namespace restify {
         return _root;
     }
 
+    const ResponseBodyProducer & Response::getBodyStream() const {
+        return _bodyStream;
+    }
+
+    size_t Response::getBodyStreamChunkSize() const {
+        return _bodyStreamChunkSize;
+    }
+
+    const std::shared_ptr<const std::string> & Response::getRawBody() const {
+        return _rawBody;
+    }
+
+    const std::string & Response::getRawBodyContentType() const {
+        return _rawBodyContentType;
+    }
+
     Response::JsonBodyBuilder::JsonBodyBuilder(Response & response)
         :_response(response), _builder(response.toJson()[Keys::body])
     {
+        _response._bodyStream = ResponseBodyProducer();
+        _response._rawBody.reset();
     }
 
     Response::JsonBodyBuilder & Response::JsonBodyBuilder::set(const std::string & key, const Json::Value & value) {
@@ -0,0 +1,61 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/response_completion.h>
+#include <restify/error.h>
+#include <atomic>
+
+namespace restify {
+
+    struct ResponseCompletion::State {
+        std::atomic<bool> done;
+        Callback callback;
+
+        State(const Callback &cb)
+            :done(false), callback(cb)
+        {}
+
+        bool finish(std::exception_ptr error) {
+            if (done.exchange(true))
+                return false;
+            if (callback)
+                callback(error);
+            return true;
+        }
+
+        ~State() {
+            try {
+                finish(std::make_exception_ptr(Error(StatusCode::InternalServerError, "Handler did not complete response.")));
+            } catch (...) {
+            }
+        }
+    };
+
+    ResponseCompletion::ResponseCompletion(const Callback & callback)
+        :_state(std::make_shared<State>(callback))
+    {}
+
+    bool ResponseCompletion::complete() const {
+        return _state->finish(nullptr);
+    }
+
+    bool ResponseCompletion::fail(std::exception_ptr error) const {
+        return _state->finish(error);
+    }
+
+    bool ResponseCompletion::fail(const Error & error) const {
+        return _state->finish(std::make_exception_ptr(error));
+    }
+
+    bool ResponseCompletion::isDone() const {
+        return _state->done.load();
+    }
+
+}
@@ -13,83 +13,310 @@
 #include <restify/response.h>
 #include <restify/error.h>
 #include <restify/helpers.h>
+#include <restify/json_writer.h>
+#include <restify/object_pool.h>
 #include <json/json.h>
 #include <iostream>
+#include <algorithm>
+#include <cstdio>
 
 #define EOL "\r\n"
 
 namespace restify {
     
     
+    static void writeAll(Connection &c, const char *data, size_t length) {
+        if (c.write(data, length) != (int64_t)length) {
+            throw Error(StatusCode::BadRequest, "Message transfer not complete.");
+        }
+    }
+    
+    static void writeChunk(Connection &c, std::string &frame, const char *data, size_t length) {
+        char sizeLine[24];
+        int n = snprintf(sizeLine, sizeof(sizeLine), "%zx" EOL, length);
+
+        frame.assign(sizeLine, n);
+        frame.append(data, length);
+        frame.append(EOL);
+        writeAll(c, frame.data(), frame.length());
+    }
+
+    /** HTTP/1.0 clients do not know chunked transfer coding, see RFC 7230 3.3.1. */
+    static bool acceptsChunked(const Connection &c) {
+        return c.getVersion() != "1.0";
+    }
+
+    /** Json bodies are serialized into buffers of this size. */
+    static const size_t JsonBufferSize = 8192;
+
+    /** Buffers larger than this are released instead of being kept for the next response. */
+    static const size_t MaxRetainedBufferSize = 64 * 1024;
+
+    /** Scratch memory of writing a response, pooled per thread to retain capacity. */
+    struct WriterBuffers {
+        std::string message;
+        std::string frame;
+        char json[JsonBufferSize];
+    };
+
+    static void recycleBuffer(std::string &s) {
+        if (s.capacity() > MaxRetainedBufferSize)
+            std::string().swap(s);
+        else
+            s.clear();
+    }
+
+    template<>
+    struct ObjectPoolTraits<WriterBuffers> {
+        enum { Capacity = 4 };
+
+        static WriterBuffers *create() {
+            WriterBuffers *b = new WriterBuffers();
+            b->message.reserve(1024);
+            return b;
+        }
+
+        static void recycle(WriterBuffers &b) {
+            recycleBuffer(b.message);
+            recycleBuffer(b.frame);
+        }
+    };
+    
     void DefaultResponseWriter::writeResponse(restify::Connection &c, restify::Response &r) const
     {
-        const std::string message = renderMessage(r.toJson());
-        
-        std::istringstream iss(message);
+        if (r.getBodyStream()) {
+            writeStreamedResponse(c, r);
+            return;
+        }
 
-        if (c.writeStream(iss) != message.length()) {
-            throw Error(StatusCode::BadRequest, "Message transfer not complete.");
+        if (r.getRawBody()) {
+            writeRawResponse(c, r);
+            return;
+        }
+
+        const Json::Value &jroot = r.toJson();
+        switch (jroot[Response::Keys::body].type()) {
+            case Json::objectValue:
+            case Json::arrayValue:
+            case Json::intValue:
+            case Json::uintValue:
+            case Json::realValue:
+            case Json::booleanValue:
+                writeJsonResponse(c, r);
+                return;
+            default:
+                break;
+        }
+
+        ObjectPool<WriterBuffers>::Ptr buffers = ObjectPool<WriterBuffers>::acquire();
+        renderMessage(c, r.toJson(), buffers->message, buffers->frame);
+        writeAll(c, buffers->message.data(), buffers->message.length());
+    }
+
+    void DefaultResponseWriter::writeStreamedResponse(Connection &c, Response &r) const
+    {
+        Json::Value headers(Json::objectValue);
+        headers["Content-Type"] = "application/octet-stream";
+
+        // Without chunked coding the end of the body is told by closing the connection.
+        const bool chunked = acceptsChunked(c);
+        if (chunked)
+            headers["Transfer-Encoding"] = "chunked";
+        else
+            c.closeConnection();
+
+        ObjectPool<WriterBuffers>::Ptr buffers = ObjectPool<WriterBuffers>::acquire();
+
+        // Head goes out before the first chunk is produced.
+        renderHead(c, r.toJson(), headers, buffers->message);
+        writeAll(c, buffers->message.data(), buffers->message.length());
+
+        const size_t chunkSize = std::max<size_t>(r.getBodyStreamChunkSize(), 1);
+        const ResponseBodyProducer &producer = r.getBodyStream();
+
+        // Chunks are produced into the message buffer, the head is already sent.
+        std::string &chunk = buffers->message;
+        std::string &frame = buffers->frame;
+        chunk.reserve(chunkSize);
+        frame.reserve(chunkSize + 16);
+
+        bool more = true;
+        while (more) {
+            chunk.clear();
+            try {
+                more = producer(chunk);
+            } catch (...) {
+                // Head is already on the wire, so no error response can follow. Leave the
+                // stream unterminated and drop the connection so the client notices.
+                c.closeConnection();
+                return;
+            }
+
+            if (chunk.empty())
+                continue;
+            if (chunked)
+                writeChunk(c, frame, chunk.data(), chunk.size());
+            else
+                writeAll(c, chunk.data(), chunk.size());
         }
+
+        if (chunked)
+            writeAll(c, "0" EOL EOL, 5);
     }
     
-    std::string DefaultResponseWriter::renderMessage(const Json::Value &jroot) const
+    void DefaultResponseWriter::writeRawResponse(Connection &c, Response &r) const
+    {
+        // Hold a reference, the buffer might be shared with other connections.
+        std::shared_ptr<const std::string> body = r.getRawBody();
+
+        Json::Value headers(Json::objectValue);
+        headers["Content-Type"] = r.getRawBodyContentType();
+        headers["Content-Length"] = (Json::UInt64)body->length();
+
+        ObjectPool<WriterBuffers>::Ptr buffers = ObjectPool<WriterBuffers>::acquire();
+        renderHead(c, r.toJson(), headers, buffers->message);
+        writeAll(c, buffers->message.data(), buffers->message.length());
+        writeAll(c, body->data(), body->length());
+    }
+    
+    void DefaultResponseWriter::writeJsonResponse(Connection &c, Response &r) const
+    {
+        const Json::Value &jroot = r.toJson();
+
+        Json::Value headers(Json::objectValue);
+        headers["Content-Type"] = "application/json; charset=utf-8";
+
+        ObjectPool<WriterBuffers>::Ptr buffers = ObjectPool<WriterBuffers>::acquire();
+        std::string &message = buffers->message;
+        bool chunked = false;
+
+        // Documents not fitting into a single buffer are collected for clients not accepting chunks.
+        std::string &body = buffers->frame;
+        const bool collect = !acceptsChunked(c);
+
+        JsonStreamWriter json([&](const char *data, size_t length) {
+            if (collect) {
+                body.append(data, length);
+                return;
+            }
+            if (!chunked) {
+                // Document does not fit into a single buffer, stream it chunked.
+                headers["Transfer-Encoding"] = "chunked";
+                renderHead(c, jroot, headers, message);
+                writeAll(c, message.data(), message.length());
+                chunked = true;
+            }
+            writeChunk(c, buffers->frame, data, length);
+        }, buffers->json, JsonBufferSize);
+
+        json.write(jroot[Response::Keys::body]);
+
+        if (chunked) {
+            json.flush();
+            writeAll(c, "0" EOL EOL, 5);
+        } else if (!body.empty()) {
+            json.flush();
+            headers["Content-Length"] = (Json::UInt64)body.size();
+            renderHead(c, jroot, headers, message);
+            writeAll(c, message.data(), message.length());
+            writeAll(c, body.data(), body.size());
+        } else {
+            headers["Content-Length"] = (Json::UInt64)json.size();
+            renderHead(c, jroot, headers, message);
+            message.append(json.data(), json.size());
+            writeAll(c, message.data(), message.length());
+        }
+    }
+    
+    void DefaultResponseWriter::renderMessage(Connection &c, const Json::Value &jroot, std::string &message, std::string &scratch) const
     {
-        std::ostringstream http;
-        
         Json::Value headers(Json::objectValue);
         
-        const std::string body = renderBody(jroot, headers);
+        renderBody(jroot, headers, scratch);
+        renderHead(c, jroot, headers, message);
+        message.append(scratch);
+    }
+
+    void DefaultResponseWriter::renderHead(Connection &c, const Json::Value &jroot, Json::Value &headers, std::string &http) const
+    {
+        // A handler asking for Connection: close ends the persistent connection.
+        const Json::Value &connection = jroot["headers"]["Connection"];
+        if (connection.isString() && toLowerCase(connection.asString()) == "close")
+            c.closeConnection();
+
+        const bool keepAlive = c.isKeepAlive();
+        headers["Connection"] = keepAlive ? "keep-alive" : "close";
         
         // Replace generated headers by headers set in response.
         jsonMerge(headers, jroot["headers"]);
+
+        // Never announce keep-alive on a connection that is about to close.
+        if (!keepAlive)
+            headers["Connection"] = "close";
         
         // Status line
         int setCode = json_cast<int>(jroot.get("statusCode", 200));
-        http << "HTTP/" << jroot.get("version", "1.1").asString() << " "
-        << setCode << " "
-        << reasonPhraseFromStatusCode(setCode) << EOL;
+        const Json::Value &version = jroot["version"];
+
+        size_t lineLength = 0;
+        const char *line = nullptr;
+        if (version.isNull() || version.asString() == "1.1")
+            line = statusLine(setCode, lineLength);
+
+        if (line) {
+            http.append(line, lineLength);
+        } else {
+            char code[16];
+            snprintf(code, sizeof(code), " %d ", setCode);
+            http.append("HTTP/").append(version.isNull() ? "1.1" : version.asString())
+                .append(code)
+                .append(reasonPhraseFromStatusCode(setCode))
+                .append(EOL);
+        }
         
         // Headers
-        for (const auto& key : headers.getMemberNames()) {
-            http << key << ": " << headers[key].asString() << EOL;
+        for (auto i = headers.begin(); i != headers.end(); ++i) {
+            const char *end = nullptr;
+            const char *begin = i.memberName(&end);
+            http.append(begin, end).append(": ");
+
+            // Refer to string values in place, others need converting.
+            const char *vbegin = nullptr, *vend = nullptr;
+            if ((*i).getString(&vbegin, &vend))
+                http.append(vbegin, vend);
+            else
+                http.append((*i).asString());
+            http.append(EOL);
         }
-        http << EOL;
-        
-        // Body
-        http << body;
-        
-        return http.str();
+        http.append(EOL);
     }
     
-    std::string DefaultResponseWriter::renderBody(const Json::Value &jroot, Json::Value & generatedHeaders)  const {
-        const Json::Value jbody = jroot.get("body", "");
-        
-        std::string body;
+    void DefaultResponseWriter::renderBody(const Json::Value &jroot, Json::Value & generatedHeaders, std::string &body)  const {
+        const Json::Value &jbody = jroot[Response::Keys::body];
         
         switch (jbody.type()) {
-            case Json::stringValue:
-                body = jbody.asString();
-                generatedHeaders["Content-Type"] = "text/plain; charset=utf-8";
-                generatedHeaders["Content-Length"] = (int)body.length();
+            case Json::nullValue:
+                generatedHeaders["Content-Length"] = 0;
                 break;
-            case Json::objectValue:
+            case Json::stringValue:
             {
-                Json::FastWriter w;
-                w.omitEndingLineFeed();
-                body = w.write(jbody);
-                generatedHeaders["Content-Type"] = "application/json; charset=utf-8";
-                generatedHeaders["Content-Length"] = (int)body.length();
+                const char *begin = nullptr, *end = nullptr;
+                jbody.getString(&begin, &end);
+                body.append(begin, end);
+                generatedHeaders["Content-Type"] = "text/plain; charset=utf-8";
+                generatedHeaders["Content-Length"] = (Json::UInt64)(end - begin);
                 break;
             }
             default:
                 CPPRESTIFY_FAIL(StatusCode::InternalServerError, "Failed to render body.");
         }
-
-        return body;
-        
     }
     
-    std::string DefaultResponseWriter::reasonPhraseFromStatusCode(int setCode) const {
+    const char *DefaultResponseWriter::reasonPhraseFromStatusCode(int setCode) const {
+        
+        const char *phrase = reasonPhrase(setCode);
+        if (phrase)
+            return phrase;
         
         if (setCode >= 100 && setCode < 200)
             return "Informational";
@@ -12,26 +12,80 @@
 #include <restify/request.h>
 #include <restify/response.h>
 #include <restify/error.h>
+#include <restify/response_completion.h>
+#include <restify/request_arena.h>
 #include <regex>
+#include <algorithm>
 #include <string>
+#include <future>
 
 namespace restify {
     RequestHandlerRoute::RequestHandlerRoute(const RequestHandler & handler) 
         :_handler(handler)
     {}
 
+    RequestHandlerRoute::RequestHandlerRoute(const AsyncRequestHandler & handler)
+        :_asyncHandler(handler)
+    {}
+
     void RequestHandlerRoute::call(Request & request, Response & rep) const 
     {
         if (_handler) {
             _handler(request, rep);
+        } else if (_asyncHandler) {
+            std::shared_ptr<std::promise<void>> p = std::make_shared<std::promise<void>>();
+            std::future<void> f = p->get_future();
+            _asyncHandler(request, rep, ResponseCompletion([p](std::exception_ptr error) {
+                if (error)
+                    p->set_exception(error);
+                else
+                    p->set_value();
+            }));
+            f.get();
         }
     }
 
+    void RequestHandlerRoute::call(Request & request, Response & rep, const ResponseCompletion & done) const {
+        try {
+            if (_asyncHandler) {
+                _asyncHandler(request, rep, done);
+                return;
+            }
+            if (_handler) {
+                _handler(request, rep);
+            }
+        } catch (...) {
+            done.fail(std::current_exception());
+            return;
+        }
+        done.complete();
+    }
+
+    bool RequestHandlerRoute::isAsync() const {
+        return static_cast<bool>(_asyncHandler);
+    }
+
+    int RequestHandlerRoute::getAffinity() const {
+        return -1;
+    }
+
+    int RequestHandlerRoute::getHandlerTimeout() const {
+        return -1;
+    }
+
+    int RequestHandlerRoute::getWriteTimeout() const {
+        return -1;
+    }
+
 
     AnyRoute::AnyRoute(const RequestHandler & handler)
         :RequestHandlerRoute(handler)
     {}
 
+    AnyRoute::AnyRoute(const AsyncRequestHandler & handler)
+        :RequestHandlerRoute(handler)
+    {}
+
     bool AnyRoute::match(const Request & request, Json::Value & extractedParams) const {
         return true;
     }
@@ -48,16 +102,36 @@ namespace restify {
         Json::Value cfg;
         std::regex matchRegex;
         std::vector<std::string> keys;
+        int affinity;
+        int handlerTimeout;
+        int writeTimeout;
     };
 
     ParameterRoute::ParameterRoute(const Json::Value & config, const RequestHandler & handler) 
         :RequestHandlerRoute(handler), _data(new PrivateData())
     {
+        setup(config);
+    }
+
+    ParameterRoute::ParameterRoute(const Json::Value & config, const AsyncRequestHandler & handler)
+        :RequestHandlerRoute(handler), _data(new PrivateData())
+    {
+        setup(config);
+    }
+
+    void ParameterRoute::setup(const Json::Value & config) {
         json(_data->cfg)
             ("ignoreTrailingSlashes", true)
-            ("methods", "GET");
+            ("methods", "GET")
+            ("affinity", -1);
         jsonMerge(_data->cfg, config);
 
+        _data->affinity = json_cast<int>(_data->cfg["affinity"]);
+
+        const Json::Value &timeouts = _data->cfg["timeouts"];
+        _data->handlerTimeout = timeouts.isObject() ? json_cast<int>(timeouts.get("handler", -1)) : -1;
+        _data->writeTimeout = timeouts.isObject() ? json_cast<int>(timeouts.get("write", -1)) : -1;
+
         const bool ignoreTrailingSlashes = json_cast<bool>(_data->cfg["ignoreTrailingSlashes"]);
 
         std::string path = _data->cfg.get("path", "").asString();
@@ -89,30 +163,37 @@ namespace restify {
 
         extractedParams = Json::Value(Json::objectValue);
 
-        const std::string path = request.getPath();
-        const std::string method = request.getMethod();
+        // Refer to path and method in place instead of copying them.
+        const char *path = "", *pathEnd = path;
+        const char *method = "", *methodEnd = method;
+        request.toJson()[Request::Keys::path].getString(&path, &pathEnd);
+        request.toJson()[Request::Keys::method].getString(&method, &methodEnd);
 
+        auto isMethod = [method, methodEnd](const Json::Value &v) {
+            const char *b = nullptr, *e = nullptr;
+            return v.getString(&b, &e) && (size_t)(e - b) == (size_t)(methodEnd - method) && std::equal(b, e, method);
+        };
 
-        const Json::Value &methods = _data->cfg.get("methods", "GET");
+        const Json::Value &cfg = _data->cfg;
+        const Json::Value &methods = cfg["methods"];
 
         if (methods.isArray()) {
-            auto i = std::find_if(methods.begin(), methods.end(), [&method](const Json::Value &v) {
-                return method == json_cast<std::string>(v);
-            });
+            auto i = std::find_if(methods.begin(), methods.end(), isMethod);
 
             if (i == methods.end())
                 return false;
         } else if (methods.isString()) {
             // Method is string.
-            if (method != methods.asString())
+            if (!isMethod(methods))
                 return false;
         } else {
             throw Error(StatusCode::InternalServerError, "Field methods needs to be string or array of strings.");
         }
 
-
-        std::smatch values;
-        if (!std::regex_match(path, values, _data->matchRegex)) {
+        // Match state is scratch memory of the request.
+        typedef std::sub_match<const char*> SubMatch;
+        std::match_results<const char*, ArenaAllocator<SubMatch>> values;
+        if (!std::regex_match(path, pathEnd, values, _data->matchRegex)) {
             return false;
         }
 
@@ -121,16 +202,64 @@ namespace restify {
             return true;
 
         for (auto i = 0; i < values.size() - 1; i++) {
-            extractedParams[_data->keys[i]] = std::string(values[i + 1]);
+            extractedParams[_data->keys[i]] = Json::Value(values[i + 1].first, values[i + 1].second);
         }
 
         return true;
     }
 
+    int ParameterRoute::getAffinity() const {
+        return _data->affinity;
+    }
+
+    int ParameterRoute::getHandlerTimeout() const {
+        return _data->handlerTimeout;
+    }
+
+    int ParameterRoute::getWriteTimeout() const {
+        return _data->writeTimeout;
+    }
+
     void ParameterRoute::updateRequest(Request & request, const Json::Value & extractedParams) const {
         Json::Value &params = request.toJson()[Request::Keys::params];
         jsonMerge(params, extractedParams);
     }
 
+    static bool requireUpgrade(const Request &request, Response &rep) {
+        rep.setCode((int)StatusCode::UpgradeRequired)
+            .setHeader("Upgrade", "websocket")
+            .setBody(json()("statusCode", (int)StatusCode::UpgradeRequired)("message", "WebSocket endpoint, upgrade required."));
+        return true;
+    }
+
+    WebSocketRoute::WebSocketRoute(const Json::Value & config, const WebSocketHandlers & handlers)
+        :ParameterRoute(config, RequestHandler(&requireUpgrade)), _handlers(handlers)
+    {}
+
+    const WebSocketHandlers & WebSocketRoute::getHandlers() const {
+        return _handlers;
+    }
+
+    static bool requireEventStream(const Request &request, Response &rep) {
+        throw Error(StatusCode::InternalServerError, "Event stream endpoint called without a connection.");
+    }
+
+    EventStreamRoute::EventStreamRoute(const Json::Value & config, const EventStreamHandler & handler)
+        :ParameterRoute(config, RequestHandler(&requireEventStream)), _handler(handler), 
+        _maxQueuedEvents((size_t)std::max(1, config.get("maxQueuedEvents", 1024).asInt()))
+    {}
+
+    bool EventStreamRoute::isAsync() const {
+        return true;
+    }
+
+    const EventStreamHandler & EventStreamRoute::getHandler() const {
+        return _handler;
+    }
+
+    size_t EventStreamRoute::getMaxQueuedEvents() const {
+        return _maxQueuedEvents;
+    }
+
 }
 
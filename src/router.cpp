@@ -40,9 +40,19 @@ namespace restify {
     }
 
     bool Router::route(Request & req, Response & rep) const {
-        // Loop over routes until the first one handles the request
+        RouteConstPtr r = match(req);
+        if (!r)
+            return false;
 
-        auto i = std::find_if(_data->routes.begin(), _data->routes.end(), [&req, &rep](const RouteConstPtr &r) {
+        // Invoke handler
+        r->call(req, rep);
+        return true;
+    }
+
+    std::shared_ptr<const Route> Router::match(Request & req) const {
+        // Loop over routes until the first one matches the request
+
+        auto i = std::find_if(_data->routes.begin(), _data->routes.end(), [&req](const RouteConstPtr &r) {
 
             Json::Value extractedParams(Json::objectValue);
 
@@ -52,14 +62,11 @@ namespace restify {
 
             // Merge in extracted parameters into request.
             r->updateRequest(req, extractedParams);
-            
-            // Invoke handler
-            r->call(req, rep);
 
             return true;
         });
 
-        return i != _data->routes.end();
+        return i != _data->routes.end() ? *i : RouteConstPtr();
     }
 
 }
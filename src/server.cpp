@@ -19,25 +19,285 @@
 #include <restify/connection.h>
 #include <restify/request_reader.h>
 #include <restify/response_writer.h>
+#include <restify/executor.h>
+#include <restify/response_completion.h>
+#include <restify/websocket.h>
+#include <restify/event_stream.h>
+#include <restify/frame_pool.h>
+#include <restify/request_arena.h>
+#include <restify/object_pool.h>
 #include <json/json.h>
 #include <iostream>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <limits>
 
+#include "restify_build_config.h"
 #include <restify/mongoose/mongoose_backend.h>
+#ifdef CPPRESTIFY_WITH_EPOLL
+#include <restify/epoll/epoll_backend.h>
+#endif
+#ifdef CPPRESTIFY_WITH_URING
+#include <restify/uring/uring_backend.h>
+#endif
 
 namespace restify {
 
+    /** Request and response of a dispatch, shared with deferred completions. */
+    struct Exchange {
+        Request request;
+        Response response;
+    };
+
+    /** Exchanges of closed connections and deferred completions are kept per thread with their Json containers. */
+    template<>
+    struct ObjectPoolTraits<Exchange> {
+        enum { Capacity = 16 };
+
+        static Exchange *create() {
+            return new Exchange();
+        }
+
+        static void recycle(Exchange &x) {
+            x.request.clear();
+            x.response.clear();
+        }
+    };
+
+    /** Objects reused across the requests of a persistent connection. */
+    struct ServerConnectionData : public ConnectionData {
+        ServerConnectionData(size_t arenaInitialSize = 4096, size_t arenaMaxRetainedSize = 64 * 1024)
+            :arena(arenaInitialSize, arenaMaxRetainedSize)
+        {}
+
+        std::shared_ptr<Exchange> exchange;
+        /** Scratch memory of the request currently read, reset once it is dispatched. */
+        RequestArena arena;
+        DefaultResponseWriter writer;
+        /** Created on the first asynchronous handler, recycles its coroutine frames. */
+        std::shared_ptr<FramePool> framePool;
+        /** Event streams served by this connection, HTTP/2 may carry several. */
+        std::vector<std::weak_ptr<EventStream>> eventStreams;
+
+        ~ServerConnectionData() {
+            for (const std::weak_ptr<EventStream> &w : eventStreams) {
+                std::shared_ptr<EventStream> s = w.lock();
+                if (s)
+                    s->detach();
+            }
+        }
+    };
+
+    /** Signals completion of a deferred response to a waiting backend thread. */
+    struct HandlerCompletion {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done;
+        std::exception_ptr error;
+
+        HandlerCompletion()
+            :done(false)
+        {}
+    };
+
+    /** Write response or the error the request failed with. */
+    static void writeResult(const ResponseWriter &writer, Connection &conn, Response &response, std::exception_ptr error) {
+        try {
+            if (error)
+                std::rethrow_exception(error);
+
+            // Enable cors for now.
+            static const std::string AllowOrigin("Access-Control-Allow-Origin");
+            static const Json::Value AllowAny("*");
+            response.setHeader(AllowOrigin, AllowAny);
+            writer.writeResponse(conn, response);
+        } catch (const Error &error) {
+            Response rep(error.toJson());
+            writer.writeResponse(conn, rep);
+        } catch (const std::exception &error) {
+            Error myError(StatusCode::InternalServerError, error.what());
+            Response rep(myError.toJson());
+            writer.writeResponse(conn, rep);
+        } catch (...) {
+            Error myError(StatusCode::InternalServerError, "Unknown error occurred. That's all we know.");
+            Response rep(myError.toJson());
+            writer.writeResponse(conn, rep);
+        }
+    }
+
     struct Server::PrivateData {
         std::shared_ptr<Backend> backend;
+        std::shared_ptr<Executor> executor;
         Router router;
         Json::Value config;
+
+        size_t arenaInitialSize;
+        size_t arenaMaxRetainedSize;
+        bool arenaStatistics;
+        std::atomic<uint64_t> arenaRequests;
+        std::atomic<uint64_t> arenaBytes;
+        std::atomic<uint64_t> arenaMaxBytes;
+
+        /** Activates the arena of a connection for one request and resets it afterwards. */
+        class ArenaGuard : NonCopyable {
+        public:
+            ArenaGuard(PrivateData &d, RequestArena &arena)
+                :_d(d), _arena(arena), _scope(&arena)
+            {}
+
+            ~ArenaGuard() {
+                if (_d.arenaStatistics)
+                    _d.recordArenaUsage(_arena.getUsed());
+                _arena.reset();
+            }
+
+        private:
+            PrivateData &_d;
+            RequestArena &_arena;
+            RequestArena::Scope _scope;
+        };
+
+        void recordArenaUsage(uint64_t used) {
+            arenaRequests.fetch_add(1, std::memory_order_relaxed);
+            arenaBytes.fetch_add(used, std::memory_order_relaxed);
+
+            uint64_t max = arenaMaxBytes.load(std::memory_order_relaxed);
+            while (used > max && !arenaMaxBytes.compare_exchange_weak(max, used, std::memory_order_relaxed)) {
+            }
+        }
+
+        /** Invoke handler of route with the connection's frame pool active, on the executor if one is set. */
+        void run(const std::shared_ptr<const Route> &route, const std::shared_ptr<Exchange> &x, const ResponseCompletion &done, const std::shared_ptr<FramePool> &pool) {
+            if (!executor) {
+                FramePool::Scope scope(pool);
+                route->call(x->request, x->response, done);
+                return;
+            }
+
+            executor->submit([route, x, done, pool]() {
+                FramePool::Scope scope(pool);
+                route->call(x->request, x->response, done);
+            }, route->getAffinity());
+        }
+
+        /** 
+            Suspend connection and write the response once the handler completes it. The backend 
+            thread is free to serve other connections in the meantime.
+        */
+        void dispatchDeferred(Connection &conn, const std::shared_ptr<Exchange> &x, const std::shared_ptr<const Route> &route, const std::shared_ptr<FramePool> &pool) {
+            ConnectionResumer resumer = conn.suspend();
+
+            if (!resumer) {
+                // Backend cannot suspend, block until the response is complete.
+                std::shared_ptr<HandlerCompletion> c = std::make_shared<HandlerCompletion>();
+                ResponseCompletion done([c](std::exception_ptr error) {
+                    std::lock_guard<std::mutex> lock(c->mutex);
+                    c->error = error;
+                    c->done = true;
+                    c->cv.notify_one();
+                });
+
+                run(route, x, done, pool);
+
+                std::unique_lock<std::mutex> lock(c->mutex);
+                c->cv.wait(lock, [&c]() { return c->done; });
+
+                DefaultResponseWriter writer;
+                writeResult(writer, conn, x->response, c->error);
+                return;
+            }
+
+            ResponseCompletion done([resumer, x](std::exception_ptr error) {
+                resumer([x, error](Connection &c) {
+                    DefaultResponseWriter writer;
+                    writeResult(writer, c, x->response, error);
+                });
+            });
+
+            try {
+                run(route, x, done, pool);
+            } catch (...) {
+                // Connection is suspended, answer through the resumer only.
+                done.fail(std::current_exception());
+            }
+        }
         
+        /** 
+            Answer with the head of a text/event-stream response and keep the connection suspended
+            for the events of the stream passed to the handler.
+        */
+        void openEventStream(Connection &conn, ServerConnectionData *data, const Request &request, const EventStreamRoute &route) {
+            ConnectionResumer resumer = conn.suspend();
+            if (!resumer)
+                throw Error(StatusCode::NotImplemented, "Backend does not support event streams.");
+
+            static const std::string Head(
+                "HTTP/1.1 200 OK\r\n"
+                "Content-Type: text/event-stream\r\n"
+                "Cache-Control: no-cache\r\n"
+                "Access-Control-Allow-Origin: *\r\n"
+                "Connection: close\r\n"
+                "\r\n");
+            conn.write(Head.data(), Head.size());
+            conn.closeConnection();
+
+            std::shared_ptr<EventStream> stream = std::make_shared<EventStream>(resumer, route.getMaxQueuedEvents());
+            if (data) {
+                std::vector<std::weak_ptr<EventStream>> &streams = data->eventStreams;
+                streams.erase(std::remove_if(streams.begin(), streams.end(), [](const std::weak_ptr<EventStream> &w) { return w.expired(); }), streams.end());
+                streams.push_back(stream);
+            }
+
+            try {
+                if (route.getHandler())
+                    route.getHandler()(request, stream);
+            } catch (...) {
+                // Head is out, all that is left is ending the response.
+                stream->close();
+                return;
+            }
+
+            // Writing right away ends the request for the backend, e.g. releasing its admission slot.
+            stream->heartbeat();
+        }
+
         PrivateData()
+            :arenaInitialSize(4096), arenaMaxRetainedSize(64 * 1024), arenaStatistics(false), 
+            arenaRequests(0), arenaBytes(0), arenaMaxBytes(0)
         {}
     };
     
+    /** Backend named by option backend.type. */
+    static std::shared_ptr<Backend> createBackend(const std::string &type) {
+        if (type == "mongoose")
+            return std::make_shared<MongooseBackend>();
+#ifdef CPPRESTIFY_WITH_EPOLL
+        if (type == "epoll")
+            return std::make_shared<EpollBackend>();
+#endif
+#ifdef CPPRESTIFY_WITH_URING
+        if (type == "io_uring") {
+            if (!UringBackend::isSupported())
+                throw Error(StatusCode::InternalServerError, "Kernel does not support the io_uring backend.");
+            return std::make_shared<UringBackend>();
+        }
+#endif
+        throw Error(StatusCode::InternalServerError, ("Backend type not available: " + type).c_str());
+    }
+
     Server::Server()
     :_data(new PrivateData)
     {
+        json(_data->config)
+            ("arena.initialSize", (int)_data->arenaInitialSize)
+            ("arena.maxRetainedSize", (int)_data->arenaMaxRetainedSize)
+            ("arena.statistics", _data->arenaStatistics);
+
         // Currently we only support Mongoose.
         setBackend(std::make_shared<MongooseBackend>());
     }
@@ -53,23 +313,58 @@ namespace restify {
         if (_data->backend) {
             _data->backend->stop();
             _data->backend->setRequestCallback(BackendRequestHandler());
+            _data->backend->setWebSocketCallback(BackendWebSocketHandler());
         }
         _data->backend = backend;
         _data->backend->setRequestCallback(std::bind(&Server::onBackendRequest, this, std::placeholders::_1, std::placeholders::_2));
+        _data->backend->setWebSocketCallback(std::bind(&Server::onBackendWebSocket, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4));
+        return *this;
+    }
+
+    Server & Server::setExecutor(std::shared_ptr<Executor> executor) {
+        _data->executor = executor;
         return *this;
     }
 
     Server &Server::setConfig(const Json::Value &options) {
-        if (_data->backend) {
-            const Json::Value &backendCfg = options["backend"];
-            if (!backendCfg.isNull()) {
-                _data->backend->setConfig(backendCfg);
-            }
+        const Json::Value &backendCfg = options["backend"];
+        if (backendCfg.isObject() && backendCfg.isMember("type")) {
+            // New backend, configured by all backend options seen so far.
+            std::shared_ptr<Backend> backend = createBackend(json_cast<std::string>(backendCfg["type"]));
+            Json::Value cfg = _data->config.get("backend", Json::Value(Json::objectValue));
+            jsonMerge(cfg, backendCfg);
+            cfg.removeMember("type");
+            backend->setConfig(cfg);
+            setBackend(backend);
+        } else if (_data->backend && !backendCfg.isNull()) {
+            _data->backend->setConfig(backendCfg);
         }
         jsonMerge(_data->config, options);
+
+        const Json::Value &arena = _data->config["arena"];
+        _data->arenaInitialSize = (size_t)json_cast<int>(arena["initialSize"]);
+        _data->arenaMaxRetainedSize = (size_t)json_cast<int>(arena["maxRetainedSize"]);
+        _data->arenaStatistics = json_cast<bool>(arena["statistics"]);
         return *this;
     }
 
+    Json::Value Server::getStatistics() const {
+        const uint64_t requests = _data->arenaRequests.load(std::memory_order_relaxed);
+        const uint64_t bytes = _data->arenaBytes.load(std::memory_order_relaxed);
+
+        Json::Value stats(Json::objectValue);
+        stats["arena"]["requests"] = Json::UInt64(requests);
+        stats["arena"]["meanHighWaterMark"] = Json::UInt64(requests > 0 ? bytes / requests : 0);
+        stats["arena"]["maxHighWaterMark"] = Json::UInt64(_data->arenaMaxBytes.load(std::memory_order_relaxed));
+
+        if (_data->backend) {
+            Json::Value backend = _data->backend->getStatistics();
+            if (!backend.isNull())
+                stats["backend"] = backend;
+        }
+        return stats;
+    }
+
     Server::~Server()
     {
         if (_data->backend)
@@ -86,6 +381,26 @@ namespace restify {
         return *this;
     }
 
+    Server & Server::routeAsync(const Json::Value & opts, const AsyncRequestHandler & handler) {
+        _data->router.addRoute(std::make_shared<ParameterRoute>(opts, handler));
+        return *this;
+    }
+
+    Server & Server::otherwiseAsync(const AsyncRequestHandler & handler) {
+        _data->router.addRoute(std::make_shared<AnyRoute>(handler));
+        return *this;
+    }
+
+    Server & Server::websocket(const Json::Value & opts, const WebSocketHandlers & handlers) {
+        _data->router.addRoute(std::make_shared<WebSocketRoute>(opts, handlers));
+        return *this;
+    }
+
+    Server & Server::events(const Json::Value & opts, const EventStreamHandler & handler) {
+        _data->router.addRoute(std::make_shared<EventStreamRoute>(opts, handler));
+        return *this;
+    }
+
     Server & Server::start()
     {
         if (_data->backend)
@@ -100,48 +415,136 @@ namespace restify {
         return *this;
     }
 
+    bool Server::drain(int timeout, const DrainProgress & progress)
+    {
+        if (!_data->backend)
+            return true;
+
+        bool drained = true;
+        if (_data->backend->beginDrain()) {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+            size_t reported = std::numeric_limits<size_t>::max();
+            for (;;) {
+                const size_t open = _data->backend->getOpenConnectionCount();
+                if (progress && open != reported)
+                    progress(open);
+                reported = open;
+
+                if (open == 0)
+                    break;
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    drained = false;
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+
+        _data->backend->stop();
+        return drained;
+    }
+
+    std::vector<int> Server::getListeningSockets() const {
+        return _data->backend ? _data->backend->getListeningSockets() : std::vector<int>();
+    }
+
     bool Server::onBackendRequest(const BackendContext & ctx, Connection & conn) const {
-        
-        DefaultResponseWriter writer;
 
-        try {
-            // Setup request object
-            Request request;
+        ServerConnectionData *data = dynamic_cast<ServerConnectionData*>(conn.getConnectionData());
+        if (!data) {
+            conn.setConnectionData(std::unique_ptr<ConnectionData>(new ServerConnectionData(_data->arenaInitialSize, _data->arenaMaxRetainedSize)));
+            data = dynamic_cast<ServerConnectionData*>(conn.getConnectionData());
+        }
 
+        // Backends not keeping connection data get objects for this request only.
+        std::unique_ptr<ServerConnectionData> local;
+        if (!data) {
+            local.reset(new ServerConnectionData(_data->arenaInitialSize, _data->arenaMaxRetainedSize));
+            data = local.get();
+        }
+
+        // Reuse request and response unless a deferred completion still refers to them.
+        if (data->exchange && data->exchange.use_count() == 1) {
+            data->exchange->request.clear();
+            data->exchange->response.clear();
+        } else {
+            data->exchange = ObjectPool<Exchange>::acquireShared();
+        }
+
+        const DefaultResponseWriter &writer = data->writer;
+        Request &request = data->exchange->request;
+        Response &response = data->exchange->response;
+        PrivateData::ArenaGuard arenaGuard(*_data, data->arena);
+
+        try {
             // Read request.
             ctx.getRequestHeaderReader().readRequestHeader(conn, request);
             ctx.getRequestBodyReader().readRequestBody(conn, request);
 
             // Route request
-            Response response;
-            if (!_data->router.route(request, response)) {
+            std::shared_ptr<const Route> route = _data->router.match(request);
+            if (!route) {
                 std::ostringstream oss;
                 oss << "Route not found " << request.getPath();
                 throw Error(StatusCode::NotFound, oss.str().c_str());
             }
 
-			// Enable cors for now.
-			response.setHeader("Access-Control-Allow-Origin", "*");
-            writer.writeResponse(conn, response);
+            const int handlerTimeout = route->getHandlerTimeout();
+            const int writeTimeout = route->getWriteTimeout();
+            if (handlerTimeout >= 0 || writeTimeout >= 0)
+                conn.setTimeouts(handlerTimeout, writeTimeout);
 
-            return true;
+            // Handlers completing later or running on the executor must not block backend threads.
+            if (route->isAsync() || _data->executor) {
+                // Deferred handlers outlive the request arena.
+                RequestArena::Scope noArena(nullptr);
 
-        } catch (const Error &error) {
-            Response rep(error.toJson());
-            writer.writeResponse(conn, rep);
-            return true;
-        } catch (const std::exception &error) {
-            Error myError(StatusCode::InternalServerError, error.what());
-            Response rep(myError.toJson());
-            writer.writeResponse(conn, rep);
-            return true;
+                const EventStreamRoute *events = dynamic_cast<const EventStreamRoute*>(route.get());
+                if (events) {
+                    // Streams outlive the connection data of backends not keeping it.
+                    _data->openEventStream(conn, local ? nullptr : data, request, *events);
+                    return true;
+                }
+
+                if (route->isAsync() && !data->framePool)
+                    data->framePool = std::make_shared<FramePool>();
+                _data->dispatchDeferred(conn, data->exchange, route, data->framePool);
+                return true;
+            }
+
+            route->call(request, response);
         } catch (...) {
-            Error myError(StatusCode::InternalServerError, "Unknown error occurred. That's all we know.");
-            Response rep(myError.toJson());
-            writer.writeResponse(conn, rep);
+            writeResult(writer, conn, response, std::current_exception());
             return true;
         }
 
-        return false;
+        writeResult(writer, conn, response, nullptr);
+        return true;
+    }
+
+    bool Server::onBackendWebSocket(const BackendContext & ctx, Connection & conn, Request & request, WebSocketHandlers & handlers) const {
+        std::shared_ptr<const Route> matched;
+        const WebSocketRoute *route = nullptr;
+        try {
+            ctx.getRequestHeaderReader().readRequestHeader(conn, request);
+            matched = _data->router.match(request);
+            route = dynamic_cast<const WebSocketRoute*>(matched.get());
+            if (route && route->getHandlers().onAccept && !route->getHandlers().onAccept(request))
+                throw Error(StatusCode::Forbidden, "WebSocket upgrade rejected.");
+        } catch (...) {
+            DefaultResponseWriter writer;
+            Response response;
+            writeResult(writer, conn, response, std::current_exception());
+            return false;
+        }
+
+        if (!route) {
+            // Upgrade to a plain route is ignored, the request is answered as usual.
+            onBackendRequest(ctx, conn);
+            return false;
+        }
+
+        handlers = route->getHandlers();
+        return true;
     }
 }
@@ -0,0 +1,155 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/thread_placement.h>
+#include <algorithm>
+#include <fstream>
+#include <thread>
+#include <cstdlib>
+#include <cstdio>
+
+#ifdef __linux__
+#include <sched.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace restify {
+
+    bool ThreadPlacement::parseCpuList(const std::string & list, std::vector<int> & cpus) {
+        cpus.clear();
+
+        if (list.empty())
+            return true;
+
+        size_t pos = 0;
+        while (pos != std::string::npos) {
+            const size_t end = list.find(',', pos);
+            const std::string range = list.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+            pos = end == std::string::npos ? end : end + 1;
+
+            char *rest = nullptr;
+            const long first = strtol(range.c_str(), &rest, 10);
+            if (rest == range.c_str() || first < 0)
+                return false;
+
+            long last = first;
+            if (*rest == '-') {
+                const char *begin = rest + 1;
+                last = strtol(begin, &rest, 10);
+                if (rest == begin || last < first)
+                    return false;
+            }
+            if (*rest != '\0')
+                return false;
+
+            for (long c = first; c <= last; ++c)
+                cpus.push_back((int)c);
+        }
+
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        return true;
+    }
+
+    std::string ThreadPlacement::formatCpuList(const std::vector<int> & cpus) {
+        std::string list;
+        for (size_t i = 0; i < cpus.size(); ) {
+            size_t j = i;
+            while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+                ++j;
+
+            if (!list.empty())
+                list.push_back(',');
+            list.append(std::to_string(cpus[i]));
+            if (j > i)
+                list.append("-").append(std::to_string(cpus[j]));
+            i = j + 1;
+        }
+        return list;
+    }
+
+    std::vector<std::vector<int>> ThreadPlacement::getNumaNodes() {
+        std::vector<std::vector<int>> nodes;
+
+#ifdef __linux__
+        std::vector<int> ids;
+        if (DIR *dir = opendir("/sys/devices/system/node")) {
+            while (dirent *e = readdir(dir)) {
+                int id = 0;
+                if (sscanf(e->d_name, "node%d", &id) == 1)
+                    ids.push_back(id);
+            }
+            closedir(dir);
+        }
+        std::sort(ids.begin(), ids.end());
+
+        for (int id : ids) {
+            std::ifstream f("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+            std::string line;
+            std::vector<int> cpus;
+            if (std::getline(f, line) && parseCpuList(line, cpus) && !cpus.empty())
+                nodes.push_back(cpus);
+        }
+#endif
+
+        if (nodes.empty()) {
+            std::vector<int> cpus;
+            const unsigned n = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned c = 0; c < n; ++c)
+                cpus.push_back((int)c);
+            nodes.push_back(cpus);
+        }
+        return nodes;
+    }
+
+    bool ThreadPlacement::pinCurrentThread(const std::vector<int> & cpus) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : cpus) {
+            if (c < 0 || c >= CPU_SETSIZE)
+                return false;
+            CPU_SET(c, &set);
+        }
+        return !cpus.empty() && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+
+    std::vector<int> ThreadPlacement::getCurrentThreadCpus() {
+        std::vector<int> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+            for (int c = 0; c < CPU_SETSIZE; ++c) {
+                if (CPU_ISSET(c, &set))
+                    cpus.push_back(c);
+            }
+        }
+#endif
+        return cpus;
+    }
+
+    bool ThreadPlacement::useLocalMemory() {
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+        // MPOL_LOCAL from linux/mempolicy.h, avoids depending on libnuma.
+        const int MpolLocal = 4;
+        return syscall(SYS_set_mempolicy, MpolLocal, nullptr, 0) == 0;
+#else
+        return false;
+#endif
+    }
+
+}
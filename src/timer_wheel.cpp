@@ -0,0 +1,137 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/timer_wheel.h>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace restify {
+
+    TimerWheel::Timer::Timer(void *owner)
+        :_prev(this), _next(this), _wheel(nullptr), _tick(0), _owner(owner)
+    {}
+
+    TimerWheel::Timer::~Timer() {
+        if (_wheel)
+            _wheel->cancel(*this);
+    }
+
+    bool TimerWheel::Timer::isScheduled() const {
+        return _wheel != nullptr;
+    }
+
+    void * TimerWheel::Timer::getOwner() const {
+        return _owner;
+    }
+
+    void TimerWheel::Timer::unlink() {
+        _prev->_next = _next;
+        _next->_prev = _prev;
+        _prev = this;
+        _next = this;
+        _wheel = nullptr;
+    }
+
+    TimerWheel::TimerWheel(uint32_t resolution, size_t slots, uint64_t start)
+        :_slots(std::max<size_t>(1, slots)), _resolution(std::max<uint32_t>(1, resolution)), _tick(start / _resolution), _size(0)
+    {}
+
+    TimerWheel::~TimerWheel() {
+        // Timers outliving the wheel must not reach back into it.
+        for (Timer &slot : _slots) {
+            while (slot._next != &slot)
+                slot._next->unlink();
+        }
+    }
+
+    void TimerWheel::schedule(Timer & timer, uint64_t now, uint32_t delay) {
+        if (timer._wheel)
+            timer._wheel->cancel(timer);
+
+        // Round up, timers never expire early. Ticks passed already are visited no more.
+        const uint64_t tick = std::max((now + delay + _resolution - 1) / _resolution, _tick + 1);
+        Timer &slot = _slots[tick % _slots.size()];
+        timer._tick = tick;
+        timer._wheel = this;
+        timer._prev = slot._prev;
+        timer._next = &slot;
+        slot._prev->_next = &timer;
+        slot._prev = &timer;
+        ++_size;
+    }
+
+    void TimerWheel::cancel(Timer & timer) {
+        if (timer._wheel != this)
+            return;
+        timer.unlink();
+        --_size;
+    }
+
+    size_t TimerWheel::advance(uint64_t now, const ExpiryCallback & callback) {
+        const uint64_t tick = now / _resolution;
+        if (tick <= _tick)
+            return 0;
+
+        // Collect due timers first, callbacks may cancel or destroy timers of visited slots.
+        Timer expired;
+        const uint64_t visits = std::min<uint64_t>(tick - _tick, _slots.size());
+        for (uint64_t t = tick - visits + 1; t <= tick; ++t) {
+            Timer &slot = _slots[t % _slots.size()];
+            for (Timer *i = slot._next; i != &slot;) {
+                Timer *next = i->_next;
+                if (i->_tick <= tick) {
+                    // Stays scheduled until passed to the callback.
+                    i->_prev->_next = i->_next;
+                    i->_next->_prev = i->_prev;
+                    i->_prev = expired._prev;
+                    i->_next = &expired;
+                    expired._prev->_next = i;
+                    expired._prev = i;
+                }
+                i = next;
+            }
+        }
+        _tick = tick;
+
+        size_t count = 0;
+        while (expired._next != &expired) {
+            Timer &timer = *expired._next;
+            cancel(timer);
+            ++count;
+            if (callback)
+                callback(timer);
+        }
+        return count;
+    }
+
+    int TimerWheel::getWaitTime(uint64_t now) const {
+        if (_size == 0)
+            return -1;
+
+        for (uint64_t t = _tick + 1; t <= _tick + _slots.size(); ++t) {
+            const Timer &slot = _slots[t % _slots.size()];
+            if (slot._next == &slot)
+                continue;
+            const uint64_t at = t * _resolution;
+            return at <= now ? 0 : (int)std::min<uint64_t>(at - now, (uint64_t)std::numeric_limits<int>::max());
+        }
+        return 0;
+    }
+
+    size_t TimerWheel::size() const {
+        return _size;
+    }
+
+    uint64_t TimerWheel::now() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+}
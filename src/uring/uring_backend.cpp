@@ -0,0 +1,1161 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/uring/uring_backend.h>
+#include <restify/uring/uring_connection.h>
+#include <restify/http/http_request_reader.h>
+#include <restify/helpers.h>
+#include <restify/admission_control.h>
+#include <restify/thread_placement.h>
+#include <restify/event_loop.h>
+#include <json/json.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <cerrno>
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace restify {
+
+    /** Operation a completion belongs to, kept in the low bits of its user data. */
+    static const uint64_t TagAccept = 1;
+    static const uint64_t TagWakeup = 2;
+    static const uint64_t TagReceive = 3;
+    static const uint64_t TagSend = 4;
+    static const uint64_t TagClose = 5;
+    static const uint64_t TagIgnored = 6;
+    static const uint64_t TagMask = 7;
+
+    /**
+        Send buffer of a zero copy send, plus one, kept in the top bits of its user data. Its
+        notification arrives after the connection may have started further sends. User space
+        addresses fit into the remaining 48 bits.
+    */
+    static const int SendBufferShift = 48;
+    static const uint64_t AddressMask = (uint64_t(1) << SendBufferShift) - 1;
+
+    static const uint16_t ReceiveBufferGroup = 0;
+
+    /** Time stop waits for cancelled operations to complete. */
+    static const int CancelTimeout = 1000;
+
+    /** Milliseconds accepts rest when they ran out of file descriptors. */
+    static const uint32_t AcceptRetryDelay = 100;
+
+    static uint64_t userData(UringConnection *c, uint64_t tag) {
+        return uint64_t(reinterpret_cast<uintptr_t>(c)) | tag;
+    }
+
+    static UringConnection *connectionOf(uint64_t userData) {
+        return reinterpret_cast<UringConnection*>(uintptr_t(userData & AddressMask & ~TagMask));
+    }
+
+    static int sendBufferOf(uint64_t userData) {
+        return int(userData >> SendBufferShift) - 1;
+    }
+
+    /** True for the last completion reporting a result of its operation, not counting zero copy notifications. */
+    static bool isResult(const io_uring_cqe &cqe) {
+        switch (cqe.user_data & TagMask) {
+        case TagAccept:
+        case TagReceive:
+            return (cqe.flags & IORING_CQE_F_MORE) == 0;
+        case TagSend:
+            return (cqe.flags & IORING_CQE_F_NOTIF) == 0;
+        case TagIgnored:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    /** Submission and completion queues of an io_uring, used by a single thread through raw system calls. */
+    struct Ring {
+        int fd;
+        void *rings;
+        size_t ringsSize;
+        io_uring_sqe *sqes;
+        size_t sqesSize;
+
+        unsigned *sqHead;
+        unsigned *sqTail;
+        unsigned sqMask;
+        unsigned sqEntries;
+        /** Tail including entries not yet published to the kernel. */
+        unsigned sqLocalTail;
+        unsigned toSubmit;
+
+        unsigned *cqHead;
+        unsigned *cqTail;
+        unsigned cqMask;
+        io_uring_cqe *cqes;
+
+        uint64_t enters;
+
+        Ring()
+            :fd(-1), rings(MAP_FAILED), ringsSize(0), sqes(static_cast<io_uring_sqe*>(MAP_FAILED)), sqesSize(0),
+            sqHead(nullptr), sqTail(nullptr), sqMask(0), sqEntries(0), sqLocalTail(0), toSubmit(0),
+            cqHead(nullptr), cqTail(nullptr), cqMask(0), cqes(nullptr), enters(0)
+        {}
+
+        ~Ring() {
+            close();
+        }
+
+        bool open(unsigned entries) {
+            io_uring_params p;
+            memset(&p, 0, sizeof(p));
+            p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+            p.cq_entries = entries * 2;
+            fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+            if (fd < 0 && errno == EINVAL) {
+                // Kernels before 5.19 lack cooperative task running.
+                memset(&p, 0, sizeof(p));
+                p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL;
+                p.cq_entries = entries * 2;
+                fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+            }
+            if (fd < 0 || !(p.features & IORING_FEAT_SINGLE_MMAP))
+                return false;
+
+            ringsSize = std::max<size_t>(p.sq_off.array + p.sq_entries * sizeof(unsigned), p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe));
+            rings = mmap(nullptr, ringsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            if (rings == MAP_FAILED)
+                return false;
+            sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+            sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+            if (sqes == MAP_FAILED)
+                return false;
+
+            char *base = static_cast<char*>(rings);
+            sqHead = reinterpret_cast<unsigned*>(base + p.sq_off.head);
+            sqTail = reinterpret_cast<unsigned*>(base + p.sq_off.tail);
+            sqMask = *reinterpret_cast<unsigned*>(base + p.sq_off.ring_mask);
+            sqEntries = p.sq_entries;
+            sqLocalTail = *sqTail;
+            cqHead = reinterpret_cast<unsigned*>(base + p.cq_off.head);
+            cqTail = reinterpret_cast<unsigned*>(base + p.cq_off.tail);
+            cqMask = *reinterpret_cast<unsigned*>(base + p.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(base + p.cq_off.cqes);
+
+            // Submission entries are used in ring order.
+            unsigned *array = reinterpret_cast<unsigned*>(base + p.sq_off.array);
+            for (unsigned i = 0; i < sqEntries; ++i)
+                array[i] = i;
+            return true;
+        }
+
+        void close() {
+            if (sqes != MAP_FAILED)
+                munmap(sqes, sqesSize);
+            if (rings != MAP_FAILED)
+                munmap(rings, ringsSize);
+            if (fd >= 0)
+                ::close(fd);
+            sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+            rings = MAP_FAILED;
+            fd = -1;
+        }
+
+        /** Next free submission entry, cleared. Null when the queue stays full after submitting. */
+        io_uring_sqe *acquire() {
+            if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+                submit(0);
+                if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+                    return nullptr;
+            }
+            io_uring_sqe *sqe = &sqes[sqLocalTail & sqMask];
+            ++sqLocalTail;
+            ++toSubmit;
+            memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+
+        /** Submit acquired entries and wait for at least wait completions. False on fatal errors. */
+        bool submit(unsigned wait) {
+            __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+            if (toSubmit == 0 && wait == 0)
+                return true;
+
+            ++enters;
+            const long r = syscall(__NR_io_uring_enter, fd, toSubmit, wait, wait > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (r < 0)
+                return errno == EINTR || errno == EAGAIN || errno == EBUSY;
+            toSubmit -= std::min<unsigned>((unsigned)r, toSubmit);
+            return true;
+        }
+
+        /** Submit acquired entries and wait for a completion for at most timeout milliseconds. */
+        void submitAndWait(int timeout) {
+            __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+
+            __kernel_timespec ts;
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000) * 1000000;
+            io_uring_getevents_arg arg;
+            memset(&arg, 0, sizeof(arg));
+            arg.ts = reinterpret_cast<uintptr_t>(&ts);
+
+            ++enters;
+            const long r = syscall(__NR_io_uring_enter, fd, toSubmit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+            if (r > 0)
+                toSubmit -= std::min<unsigned>((unsigned)r, toSubmit);
+        }
+
+        /** Pass completions to f. Each is released before f sees it, f may submit. Returns their number. */
+        template<class F>
+        size_t reap(const F &f) {
+            size_t n = 0;
+            unsigned head = *cqHead;
+            while (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                const io_uring_cqe cqe = cqes[head & cqMask];
+                __atomic_store_n(cqHead, ++head, __ATOMIC_RELEASE);
+                f(cqe);
+                ++n;
+            }
+            return n;
+        }
+    };
+
+    /** Buffers the kernel picks from for multishot receives, returned once their bytes are copied. */
+    struct ReceiveBuffers {
+        void *ring;
+        size_t ringSize;
+        char *memory;
+        size_t memorySize;
+        size_t size;
+        unsigned mask;
+        uint16_t tail;
+
+        ReceiveBuffers()
+            :ring(MAP_FAILED), ringSize(0), memory(static_cast<char*>(MAP_FAILED)), memorySize(0), size(0), mask(0), tail(0)
+        {}
+
+        ~ReceiveBuffers() {
+            if (ring != MAP_FAILED)
+                munmap(ring, ringSize);
+            if (memory != MAP_FAILED)
+                munmap(memory, memorySize);
+        }
+
+        bool open(int ringFd, unsigned count, size_t bufferSize) {
+            unsigned entries = 1;
+            while (entries < count && entries < 32768)
+                entries <<= 1;
+
+            size = bufferSize;
+            mask = entries - 1;
+            ringSize = entries * sizeof(io_uring_buf);
+            ring = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+            memorySize = entries * bufferSize;
+            memory = static_cast<char*>(mmap(nullptr, memorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (ring == MAP_FAILED || memory == MAP_FAILED)
+                return false;
+
+            for (unsigned i = 0; i < entries; ++i)
+                recycle((uint16_t)i);
+
+            io_uring_buf_reg reg;
+            memset(&reg, 0, sizeof(reg));
+            reg.ring_addr = reinterpret_cast<uintptr_t>(ring);
+            reg.ring_entries = entries;
+            reg.bgid = ReceiveBufferGroup;
+            return syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) == 0;
+        }
+
+        const char *get(uint16_t id) const {
+            return memory + id * size;
+        }
+
+        void recycle(uint16_t id) {
+            // Entries are addressed by hand, the flexible array of io_uring_buf_ring is misplaced when compiled as C++.
+            io_uring_buf *entries = static_cast<io_uring_buf*>(ring);
+            io_uring_buf &e = entries[tail & mask];
+            e.addr = reinterpret_cast<uintptr_t>(memory + id * size);
+            e.len = (uint32_t)size;
+            e.bid = id;
+            // The ring tail overlays the reserved field of the first entry.
+            __atomic_store_n(&entries[0].resv, ++tail, __ATOMIC_RELEASE);
+        }
+    };
+
+    /** Buffers sends are copied into, registered with the kernel as one region when possible. */
+    struct SendBuffers {
+        char *memory;
+        size_t memorySize;
+        size_t size;
+        std::vector<int> free;
+        bool registered;
+
+        SendBuffers()
+            :memory(static_cast<char*>(MAP_FAILED)), memorySize(0), size(0), registered(false)
+        {}
+
+        ~SendBuffers() {
+            if (memory != MAP_FAILED)
+                munmap(memory, memorySize);
+        }
+
+        bool open(int ringFd, unsigned count, size_t bufferSize) {
+            size = bufferSize;
+            if (count == 0 || bufferSize == 0)
+                return true;
+
+            memorySize = count * bufferSize;
+            memory = static_cast<char*>(mmap(nullptr, memorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0));
+            if (memory == MAP_FAILED)
+                return false;
+            for (int i = (int)count - 1; i >= 0; --i)
+                free.push_back(i);
+
+            iovec region;
+            region.iov_base = memory;
+            region.iov_len = memorySize;
+            registered = syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS, &region, 1) == 0;
+            return true;
+        }
+
+        char *get(int id) {
+            return memory + (size_t)id * size;
+        }
+    };
+
+    struct UringBackend::EventLoop {
+        Ring ring;
+        int wakeup;
+        uint64_t wakeupValue;
+        bool wakeupArmed;
+        /** Shared with resumers of suspended connections, which may outlive the loop. */
+        std::shared_ptr<LoopTaskQueue> tasks;
+        std::thread thread;
+        /** Listeners this loop accepts on. */
+        std::vector<int> listeners;
+        /** Multishot accept is armed on the listener of the same index. */
+        std::vector<bool> accepting;
+        /** True when listeners are private to this loop. */
+        bool ownsListeners;
+        /** Deadlines of connections, declared first to outlive them. */
+        TimerWheel wheel;
+        /** Scheduled while accepts rest after descriptors ran out. */
+        TimerWheel::Timer acceptRetry;
+        /** Connections indexed by socket. */
+        std::vector<std::unique_ptr<UringConnection>> connections;
+        /** Connections whose close is submitted, freed once their last completion arrived. */
+        std::unordered_map<UringConnection*, std::unique_ptr<UringConnection>> closing;
+        /** Operations whose result is still to come. */
+        size_t inFlight;
+        ReceiveBuffers receiveBuffers;
+        SendBuffers sendBuffers;
+        bool zeroCopySends;
+        /** CPUs to pin the loop thread to, empty leaves it unpinned. */
+        std::vector<int> cpus;
+        bool localMemory;
+
+        std::atomic<uint64_t> enters;
+        std::atomic<uint64_t> completions;
+        std::atomic<uint64_t> sends;
+        std::atomic<uint64_t> zeroCopySendCount;
+
+        EventLoop()
+            :wakeup(-1), wakeupValue(0), wakeupArmed(false), ownsListeners(false), acceptRetry(this), inFlight(0), zeroCopySends(false),
+            localMemory(false), enters(0), completions(0), sends(0), zeroCopySendCount(0)
+        {}
+
+        ~EventLoop() {
+            if (tasks)
+                tasks->close();
+            connections.clear();
+            // Closes not confirmed might have freed the descriptor for others already.
+            for (auto &c : closing)
+                c.second->releaseSocket();
+            closing.clear();
+            if (ownsListeners) {
+                for (int l : listeners)
+                    ::close(l);
+            }
+            ring.close();
+            if (wakeup >= 0) ::close(wakeup);
+        }
+    };
+
+    struct UringBackend::PrivateData {
+        Json::Value config;
+        BackendRequestHandler handler;
+        HttpBackendContext context;
+        HttpServerConnection::Limits limits;
+        AdmissionControl admission;
+        std::vector<int> listeners;
+        /** Guards listeners of the backend and of its loops, which loops give up while draining. */
+        mutable std::mutex listenersMutex;
+        std::vector<std::unique_ptr<EventLoop>> loops;
+        std::atomic<bool> stopping;
+        std::atomic<bool> draining;
+        /** Loops that stopped accepting since draining began. */
+        std::atomic<size_t> drainedLoops;
+        std::atomic<size_t> openConnections;
+        /** Times a loop stopped accepting because file descriptors ran out. */
+        std::atomic<uint64_t> acceptPauses;
+        bool isRunning;
+
+        PrivateData()
+            :stopping(false), draining(false), drainedLoops(0), openConnections(0), acceptPauses(0), isRunning(false)
+        {}
+
+        void closeListeners() {
+            std::lock_guard<std::mutex> lock(listenersMutex);
+            for (int l : listeners)
+                ::close(l);
+            listeners.clear();
+        }
+    };
+
+    UringBackend::UringBackend()
+        :_data(new PrivateData)
+    {
+        json(_data->config)
+            ("listening_ports", "127.0.0.1:8080")
+            ("num_threads", (int)std::max(1u, std::thread::hardware_concurrency()))
+            ("max_request_size", 16384)
+            ("max_body_size", 64 * 1024 * 1024)
+            ("listen_backlog", SOMAXCONN)
+            ("reuse_port", false)
+            ("unix_socket_mode", "")
+            ("cpu_affinity", "")
+            ("numa", false)
+            ("max_concurrent_streams", 100)
+            ("queue_depth", 4096)
+            ("receive_buffers", 512)
+            ("receive_buffer_size", 8192)
+            ("send_buffers", 256)
+            ("send_buffer_size", 16384)
+            ("zero_copy_sends", true);
+        AdmissionControl::addDefaultOptions(_data->config);
+        RequestTimeouts::addDefaultOptions(_data->config);
+    }
+
+    UringBackend::~UringBackend()
+    {
+        stop();
+    }
+
+    bool UringBackend::isSupported() {
+        // Probe from a thread of its own, see start.
+        bool supported = false;
+        std::thread([&supported]() {
+            Ring ring;
+            if (!ring.open(2))
+                return;
+
+            // Zero copy sends came last, with Linux 6.0.
+            std::vector<char> buffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+            io_uring_probe *probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+            if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PROBE, probe, 256) != 0)
+                return;
+            supported = probe->ops_len > IORING_OP_SEND_ZC && (probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED) != 0;
+        }).join();
+        return supported;
+    }
+
+    bool UringBackend::setConfig(const Json::Value & options) {
+        return jsonMerge(_data->config, options);
+    }
+
+    bool UringBackend::setRequestCallback(const BackendRequestHandler & handler) {
+        if (_data->isRunning)
+            return false;
+
+        _data->handler = handler;
+        return true;
+    }
+
+    bool UringBackend::start()
+    {
+        if (_data->isRunning || !isSupported())
+            return false;
+
+        _data->limits.maxHeadSize = (size_t)json_cast<int>(_data->config["max_request_size"]);
+        _data->limits.maxBodySize = (size_t)json_cast<int>(_data->config["max_body_size"]);
+        _data->limits.maxConcurrentStreams = (size_t)std::max(0, json_cast<int>(_data->config["max_concurrent_streams"]));
+        _data->limits.timeouts = RequestTimeouts::fromConfig(_data->config);
+        const int numThreads = std::max(1, json_cast<int>(_data->config["num_threads"]));
+        const bool reusePort = json_cast<bool>(_data->config["reuse_port"]);
+        const bool numa = json_cast<bool>(_data->config["numa"]);
+        const unsigned queueDepth = (unsigned)std::max(8, json_cast<int>(_data->config["queue_depth"]));
+        const unsigned receiveBuffers = (unsigned)std::max(1, json_cast<int>(_data->config["receive_buffers"]));
+        const size_t receiveBufferSize = (size_t)std::max(512, json_cast<int>(_data->config["receive_buffer_size"]));
+        const unsigned sendBuffers = (unsigned)std::max(0, json_cast<int>(_data->config["send_buffers"]));
+        const size_t sendBufferSize = (size_t)std::max(512, json_cast<int>(_data->config["send_buffer_size"]));
+        const bool zeroCopySends = json_cast<bool>(_data->config["zero_copy_sends"]);
+        _data->admission.setLimits(AdmissionControl::Limits::fromConfig(_data->config));
+
+        // Inherited sockets replace binding, loops with private listeners take equal shares.
+        const std::vector<int> inherited = EventLoopSetup::inheritListeners(_data->config);
+        if (reusePort && inherited.size() % (size_t)numThreads != 0)
+            return false;
+
+        if (!reusePort && !inherited.empty()) {
+            _data->listeners = inherited;
+        } else if (!reusePort && !EventLoopSetup::openListeners(_data->config, false, _data->listeners)) {
+            _data->closeListeners();
+            return false;
+        }
+
+        std::vector<int> cpus;
+        if (!EventLoopSetup::placeLoops(_data->config, (size_t)numThreads, cpus)) {
+            _data->closeListeners();
+            return false;
+        }
+
+        _data->stopping = false;
+        _data->draining = false;
+        _data->drainedLoops = 0;
+        _data->openConnections = 0;
+
+        bool ok = true;
+        for (int i = 0; i < numThreads && ok; ++i) {
+            std::unique_ptr<EventLoop> loop(new EventLoop());
+            // Blocking, the ring reads it.
+            loop->wakeup = eventfd(0, EFD_CLOEXEC);
+            ok = loop->wakeup >= 0;
+            loop->tasks = std::make_shared<LoopTaskQueue>(loop->wakeup);
+
+            if (!cpus.empty()) {
+                loop->cpus.push_back(cpus[i]);
+                loop->localMemory = numa;
+            }
+
+            if (reusePort) {
+                // Private listeners, the kernel picks the loop when the connection arrives.
+                loop->ownsListeners = true;
+                if (!inherited.empty()) {
+                    const size_t share = inherited.size() / (size_t)numThreads;
+                    loop->listeners.assign(inherited.begin() + i * share, inherited.begin() + (i + 1) * share);
+                } else {
+                    ok = ok && EventLoopSetup::openListeners(_data->config, true, loop->listeners);
+                }
+            } else {
+                // Every loop accepts on every listener, the kernel hands each connection to one of them.
+                loop->listeners = _data->listeners;
+            }
+            loop->accepting.assign(loop->listeners.size(), false);
+
+            _data->loops.push_back(std::move(loop));
+        }
+
+        if (!ok) {
+            _data->loops.clear();
+            _data->closeListeners();
+            return false;
+        }
+
+        std::vector<std::future<bool>> ready;
+        for (auto &loop : _data->loops) {
+            EventLoop *l = loop.get();
+            std::promise<bool> setUp;
+            ready.push_back(setUp.get_future());
+            l->thread = std::thread([this, l, queueDepth, receiveBuffers, receiveBufferSize, sendBuffers, sendBufferSize,
+                zeroCopySends, &d = *_data, setUp = std::move(setUp)]() mutable {
+                if (!l->cpus.empty())
+                    ThreadPlacement::pinCurrentThread(l->cpus);
+                if (l->localMemory)
+                    ThreadPlacement::useLocalMemory();
+
+                // Threads setting up a ring keep io_uring state for their lifetime, which interrupts
+                // their blocking socket calls. Rings are set up here rather than on the caller, buffers
+                // land on the node of the loop.
+                bool ok = l->ring.open(queueDepth);
+                ok = ok && l->receiveBuffers.open(l->ring.fd, receiveBuffers, receiveBufferSize);
+                ok = ok && l->sendBuffers.open(l->ring.fd, sendBuffers, sendBufferSize);
+                l->zeroCopySends = zeroCopySends && l->sendBuffers.registered;
+                setUp.set_value(ok);
+                if (ok && !d.stopping.load())
+                    runLoop(*l);
+            });
+        }
+
+        for (auto &r : ready)
+            ok = r.get() && ok;
+        _data->isRunning = true;
+        if (!ok) {
+            stop();
+            return false;
+        }
+        return true;
+    }
+
+    bool UringBackend::stop()
+    {
+        if (!_data->isRunning)
+            return true;
+
+        _data->stopping = true;
+        for (auto &loop : _data->loops)
+            loop->tasks->wake();
+        for (auto &loop : _data->loops) {
+            if (loop->thread.joinable())
+                loop->thread.join();
+        }
+
+        _data->loops.clear();
+        _data->closeListeners();
+        _data->isRunning = false;
+        return true;
+    }
+
+    Json::Value UringBackend::getStatistics() const {
+        Json::Value stats(Json::objectValue);
+        stats["admission"] = _data->admission.getStatistics();
+        stats["accept"]["pauses"] = (Json::UInt64)_data->acceptPauses.load();
+
+        uint64_t enters = 0, completions = 0, sends = 0, zeroCopySends = 0;
+        bool registered = !_data->loops.empty();
+        for (auto &loop : _data->loops) {
+            enters += loop->enters.load(std::memory_order_relaxed);
+            completions += loop->completions.load(std::memory_order_relaxed);
+            sends += loop->sends.load(std::memory_order_relaxed);
+            zeroCopySends += loop->zeroCopySendCount.load(std::memory_order_relaxed);
+            registered = registered && loop->sendBuffers.registered;
+        }
+        Json::Value &uring = stats["io_uring"];
+        uring["enters"] = Json::UInt64(enters);
+        uring["completions"] = Json::UInt64(completions);
+        uring["sends"] = Json::UInt64(sends);
+        uring["zeroCopySends"] = Json::UInt64(zeroCopySends);
+        uring["registeredSendBuffers"] = registered;
+        return stats;
+    }
+
+    bool UringBackend::beginDrain() {
+        if (!_data->isRunning)
+            return false;
+
+        _data->draining = true;
+        for (auto &loop : _data->loops)
+            loop->tasks->wake();
+        return true;
+    }
+
+    size_t UringBackend::getOpenConnectionCount() const {
+        return _data->openConnections.load();
+    }
+
+    std::vector<int> UringBackend::getListeningSockets() const {
+        std::lock_guard<std::mutex> lock(_data->listenersMutex);
+        std::vector<int> sockets = _data->listeners;
+        for (auto &loop : _data->loops) {
+            if (loop->ownsListeners)
+                sockets.insert(sockets.end(), loop->listeners.begin(), loop->listeners.end());
+        }
+        return sockets;
+    }
+
+    void UringBackend::runLoop(EventLoop & loop) {
+        PrivateData &d = *_data;
+        Ring &ring = loop.ring;
+
+        std::shared_ptr<LoopTaskQueue> queue = loop.tasks;
+        const UringConnection::TaskPoster poster = [queue](int socket, uint64_t serial, const ConnectionTask &task) {
+            queue->post(socket, serial, task);
+        };
+        std::vector<LoopTask> tasks;
+        bool drained = false;
+        uint64_t now = TimerWheel::now();
+
+        // Requests hold their admission slot until answered, deferred ones until resumed. Handlers
+        // receive HTTP/2 streams rather than the connection, which counts their deferrals. Tasks
+        // suspending a connection again, such as those of event streams, take no slot.
+        UringConnection *current = nullptr;
+        BackendRequestHandler handler;
+        if (d.handler) {
+            handler = [&d, &current](const BackendContext &ctx, Connection &conn) {
+                if (!d.admission.beginRequest()) {
+                    const std::string &r = d.admission.getRejection();
+                    conn.write(r.data(), r.size());
+                    conn.closeConnection();
+                    return true;
+                }
+
+                const size_t deferred = current->getDeferredCount();
+                bool handled = false;
+                try {
+                    handled = d.handler(ctx, conn);
+                } catch (...) {
+                    if (current->getDeferredCount() == deferred)
+                        d.admission.endRequest();
+                    else
+                        current->setAdmittedCount(current->getAdmittedCount() + 1);
+                    throw;
+                }
+                if (current->getDeferredCount() == deferred)
+                    d.admission.endRequest();
+                else
+                    current->setAdmittedCount(current->getAdmittedCount() + 1);
+                return handled;
+            };
+        }
+
+        auto armAccept = [&loop, &ring](size_t i) {
+            io_uring_sqe *sqe = ring.acquire();
+            if (!sqe)
+                return;
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->fd = loop.listeners[i];
+            sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+            sqe->accept_flags = SOCK_CLOEXEC;
+            sqe->user_data = (uint64_t(i) << 3) | TagAccept;
+            loop.accepting[i] = true;
+            ++loop.inFlight;
+        };
+
+        auto armWakeup = [&loop, &ring]() {
+            io_uring_sqe *sqe = ring.acquire();
+            if (!sqe)
+                return;
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = loop.wakeup;
+            sqe->addr = reinterpret_cast<uintptr_t>(&loop.wakeupValue);
+            sqe->len = sizeof(loop.wakeupValue);
+            sqe->user_data = TagWakeup;
+            loop.wakeupArmed = true;
+            ++loop.inFlight;
+        };
+
+        auto submitted = [&loop](UringConnection &c) {
+            ++c.getOperations().inFlight;
+            ++loop.inFlight;
+        };
+
+        auto cancel = [&ring](uint64_t target) {
+            io_uring_sqe *sqe = ring.acquire();
+            if (!sqe)
+                return false;
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = target;
+            sqe->user_data = TagIgnored;
+            return true;
+        };
+
+        auto cancelReceive = [&cancel](UringConnection &c) {
+            UringConnection::Operations &ops = c.getOperations();
+            if (ops.receiving && !ops.receiveCanceled)
+                ops.receiveCanceled = cancel(userData(&c, TagReceive));
+        };
+
+        // Stop serving the connection, resumers of it find it gone and drop their task. The
+        // close is submitted unless a send linked to it was.
+        auto closeConnection = [&loop, &d, &ring, &submitted, &cancelReceive](UringConnection &c, bool closeSubmitted) {
+            UringConnection::Operations &ops = c.getOperations();
+            const int fd = c.getSocket();
+            cancelReceive(c);
+            if (!closeSubmitted) {
+                io_uring_sqe *sqe = ring.acquire();
+                if (sqe) {
+                    sqe->opcode = IORING_OP_CLOSE;
+                    sqe->fd = fd;
+                    sqe->user_data = userData(&c, TagClose);
+                    submitted(c);
+                } else {
+                    ::close(fd);
+                    c.releaseSocket();
+                }
+            }
+            ops.closing = true;
+            loop.wheel.cancel(c.getDeadline().timer);
+
+            for (size_t i = c.getAdmittedCount(); i > 0; --i)
+                d.admission.endRequest();
+            c.setAdmittedCount(0);
+            loop.closing[&c] = std::move(loop.connections[fd]);
+            d.openConnections.fetch_sub(1);
+        };
+
+        auto release = [&loop](UringConnection &c) {
+            if (c.getOperations().closing && c.getOperations().inFlight == 0)
+                loop.closing.erase(&c);
+        };
+
+        // Copy output into a send buffer and submit it. The last send of a connection to close
+        // takes the close along.
+        auto startSend = [&loop, &d, &ring, &submitted, &cancelReceive, &closeConnection](UringConnection &c) {
+            UringConnection::Operations &ops = c.getOperations();
+            SendBuffers &buffers = loop.sendBuffers;
+
+            const size_t pending = c.getPendingOutputSize();
+            const bool buffered = !buffers.free.empty();
+            const size_t length = buffered ? std::min(pending, buffers.size) : pending;
+            const bool last = length == pending && c.shouldClose() && !c.isSuspended();
+
+            const char *data;
+            if (buffered) {
+                ops.sendBuffer = buffers.free.back();
+                buffers.free.pop_back();
+                memcpy(buffers.get(ops.sendBuffer), c.getPendingOutput(), length);
+                data = buffers.get(ops.sendBuffer);
+            } else {
+                ops.sendBuffer = -1;
+                ops.sendCopy.assign(c.getPendingOutput(), length);
+                data = ops.sendCopy.data();
+            }
+            c.consumeOutput(length);
+            ops.sendLength = length;
+
+            if (last)
+                cancelReceive(c);
+
+            io_uring_sqe *sqe = ring.acquire();
+            io_uring_sqe *close = (sqe && last) ? ring.acquire() : nullptr;
+            if (!sqe || (last && !close)) {
+                if (ops.sendBuffer >= 0)
+                    buffers.free.push_back(ops.sendBuffer);
+                ops.sendBuffer = -1;
+                if (sqe) {
+                    sqe->opcode = IORING_OP_NOP;
+                    sqe->user_data = TagIgnored;
+                }
+                closeConnection(c, false);
+                return;
+            }
+
+            // Only full buffers are worth pinning pages for.
+            const bool zeroCopy = buffered && loop.zeroCopySends && length == buffers.size;
+            sqe->opcode = zeroCopy ? IORING_OP_SEND_ZC : IORING_OP_SEND;
+            sqe->fd = c.getSocket();
+            sqe->addr = reinterpret_cast<uintptr_t>(data);
+            sqe->len = (uint32_t)length;
+            sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+            sqe->user_data = userData(&c, TagSend);
+            if (zeroCopy) {
+                sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+                sqe->buf_index = 0;
+                sqe->user_data |= uint64_t(ops.sendBuffer + 1) << SendBufferShift;
+                loop.zeroCopySendCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            loop.sends.fetch_add(1, std::memory_order_relaxed);
+            ops.sending = true;
+            submitted(c);
+
+            if (last) {
+                sqe->flags |= IOSQE_IO_LINK;
+                close->opcode = IORING_OP_CLOSE;
+                close->fd = c.getSocket();
+                close->user_data = userData(&c, TagClose);
+                submitted(c);
+                closeConnection(c, true);
+            }
+        };
+
+        auto armReceive = [&loop, &ring, &submitted](UringConnection &c) {
+            io_uring_sqe *sqe = ring.acquire();
+            if (!sqe)
+                return false;
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = c.getSocket();
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = ReceiveBufferGroup;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->user_data = userData(&c, TagReceive);
+            c.getOperations().receiving = true;
+            c.getOperations().receiveCanceled = false;
+            submitted(c);
+            return true;
+        };
+
+        auto serviceConnection = [&loop, &d, &handler, &current, &now, &closeConnection, &startSend, &armReceive, &cancelReceive](UringConnection &c, bool peerClosed) {
+            UringConnection::Operations &ops = c.getOperations();
+            current = &c;
+
+            c.process(handler, d.context);
+            if (peerClosed)
+                c.closeConnection();
+
+            // Response is deferred, requests are no longer read once the head size limit is
+            // buffered. Output of tasks suspending the connection again is still sent, peers not
+            // keeping up with it are cut off.
+            if (c.isSuspended() && c.getPendingOutputSize() > d.limits.maxPendingOutput) {
+                closeConnection(c, false);
+                return;
+            }
+
+            if (!ops.sending && c.getPendingOutputSize() > 0) {
+                startSend(c);
+                if (ops.closing)
+                    return;
+            }
+
+            if (!ops.sending && !c.isSuspended() && c.shouldClose()) {
+                closeConnection(c, false);
+                return;
+            }
+
+            if (!c.isSuspended())
+                ops.receivedWhileSuspended = 0;
+
+            const bool wanted = !c.shouldClose() && c.getPendingOutputSize() <= d.limits.maxPendingOutput &&
+                ops.receivedWhileSuspended <= d.limits.maxHeadSize;
+            if (wanted && !ops.receiving) {
+                if (!armReceive(c)) {
+                    closeConnection(c, false);
+                    return;
+                }
+            } else if (!wanted) {
+                cancelReceive(c);
+            }
+
+            c.getDeadline().update(c, ops.sending, loop.wheel, now);
+        };
+
+        // Requests past their deadline are answered if they can be, their connections closed. Shutting
+        // the socket down fails a send stuck in flight.
+        const TimerWheel::ExpiryCallback expire = [&loop, &serviceConnection, &closeConnection](TimerWheel::Timer &timer) {
+            // Accepts are armed again by the loop once the retry is no longer scheduled.
+            if (&timer == &loop.acceptRetry)
+                return;
+
+            UringConnection &c = *static_cast<UringConnection*>(timer.getOwner());
+            if (!c.getOperations().sending && c.expirePhase(c.getDeadline().phase)) {
+                serviceConnection(c, false);
+            } else {
+                ::shutdown(c.getSocket(), SHUT_RDWR);
+                closeConnection(c, false);
+            }
+        };
+
+        auto runTasks = [&loop, &d, &queue, &tasks, &drained, &serviceConnection, &cancel]() {
+            // Resume connections whose deferred responses completed.
+            tasks.clear();
+            queue->take(tasks);
+            for (auto &t : tasks) {
+                const int s = t.socket;
+                if ((size_t)s >= loop.connections.size() || !loop.connections[s])
+                    continue;
+                UringConnection &c = *loop.connections[s];
+                if (c.getSerial() != t.serial || c.getDeferredCount() == 0)
+                    continue;
+                if (c.getAdmittedCount() > 0) {
+                    c.setAdmittedCount(c.getAdmittedCount() - 1);
+                    d.admission.endRequest();
+                }
+                c.resume(t.task);
+                t.task = nullptr;
+                serviceConnection(c, false);
+            }
+
+            if (d.draining.load() && !drained) {
+                // Stop accepting, the last loop doing so closes shared listeners.
+                drained = true;
+                {
+                    std::lock_guard<std::mutex> lock(d.listenersMutex);
+                    for (size_t i = 0; i < loop.listeners.size(); ++i) {
+                        if (loop.accepting[i])
+                            cancel((uint64_t(i) << 3) | TagAccept);
+                        if (loop.ownsListeners)
+                            ::close(loop.listeners[i]);
+                    }
+                    loop.listeners.clear();
+                }
+                if (d.drainedLoops.fetch_add(1) + 1 == d.loops.size())
+                    d.closeListeners();
+
+                for (size_t s = 0; s < loop.connections.size(); ++s) {
+                    if (!loop.connections[s])
+                        continue;
+                    loop.connections[s]->drain();
+                    serviceConnection(*loop.connections[s], false);
+                }
+            }
+        };
+
+        auto complete = [&](const io_uring_cqe &cqe) {
+            const uint64_t tag = cqe.user_data & TagMask;
+            if (isResult(cqe))
+                --loop.inFlight;
+
+            if (tag == TagWakeup) {
+                loop.wakeupArmed = false;
+                runTasks();
+                return;
+            }
+
+            if (tag == TagAccept) {
+                const size_t i = (size_t)(cqe.user_data >> 3);
+                if (!(cqe.flags & IORING_CQE_F_MORE))
+                    loop.accepting[i] = false;
+                if ((cqe.res == -EMFILE || cqe.res == -ENFILE) && !loop.acceptRetry.isScheduled()) {
+                    // Accepts armed again at once would fail right away, rest them for a while.
+                    for (size_t l = 0; l < loop.listeners.size(); ++l) {
+                        if (loop.accepting[l])
+                            cancel((uint64_t(l) << 3) | TagAccept);
+                    }
+                    loop.wheel.schedule(loop.acceptRetry, now, AcceptRetryDelay);
+                    d.acceptPauses.fetch_add(1);
+                }
+                if (cqe.res < 0)
+                    return;
+
+                const int s = cqe.res;
+                if (!EventLoopSetup::isUnixSocket(s)) {
+                    int one = 1;
+                    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                }
+
+                if ((size_t)s >= loop.connections.size())
+                    loop.connections.resize(s + 1);
+                loop.connections[s].reset(new UringConnection(s, d.limits, poster));
+                d.openConnections.fetch_add(1);
+                UringConnection &c = *loop.connections[s];
+                if (drained)
+                    c.drain();
+                serviceConnection(c, false);
+                return;
+            }
+
+            if (tag == TagIgnored)
+                return;
+
+            UringConnection &c = *connectionOf(cqe.user_data);
+            UringConnection::Operations &ops = c.getOperations();
+
+            if (tag == TagClose) {
+                --ops.inFlight;
+                if (cqe.res == 0) {
+                    c.releaseSocket();
+                } else if (c.getSocket() >= 0) {
+                    // Linked send failed and took the close along.
+                    ::close(c.getSocket());
+                    c.releaseSocket();
+                }
+                release(c);
+                return;
+            }
+
+            if (tag == TagSend) {
+                const int buffer = sendBufferOf(cqe.user_data);
+                if (cqe.flags & IORING_CQE_F_NOTIF) {
+                    // Kernel is done with the pages of a zero copy send.
+                    loop.sendBuffers.free.push_back(buffer);
+                    --ops.inFlight;
+                    release(c);
+                    return;
+                }
+
+                if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                    --ops.inFlight;
+                    if (ops.sendBuffer >= 0)
+                        loop.sendBuffers.free.push_back(ops.sendBuffer);
+                }
+                ops.sending = false;
+                ops.sendBuffer = -1;
+                ops.sendCopy.clear();
+
+                if (ops.closing) {
+                    release(c);
+                } else if (cqe.res < 0 || (size_t)cqe.res < ops.sendLength) {
+                    closeConnection(c, false);
+                } else {
+                    serviceConnection(c, false);
+                }
+                return;
+            }
+
+            // Receive.
+            if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                --ops.inFlight;
+                ops.receiving = false;
+                ops.receiveCanceled = false;
+            }
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                const uint16_t id = (uint16_t)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                if (cqe.res > 0 && !ops.closing) {
+                    c.receive(loop.receiveBuffers.get(id), (size_t)cqe.res);
+                    if (c.isSuspended())
+                        ops.receivedWhileSuspended += (size_t)cqe.res;
+                }
+                loop.receiveBuffers.recycle(id);
+            }
+
+            if (ops.closing) {
+                release(c);
+            } else if (cqe.res == 0) {
+                serviceConnection(c, true);
+            } else if (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+                closeConnection(c, false);
+            } else {
+                serviceConnection(c, false);
+            }
+        };
+
+        while (!d.stopping.load(std::memory_order_relaxed)) {
+            if (!loop.wakeupArmed)
+                armWakeup();
+            for (size_t i = 0; i < loop.listeners.size() && !drained && !loop.acceptRetry.isScheduled(); ++i) {
+                if (!loop.accepting[i])
+                    armAccept(i);
+            }
+
+            now = TimerWheel::now();
+            loop.wheel.advance(now, expire);
+            const int wait = loop.wheel.getWaitTime(now);
+            if (wait < 0) {
+                if (!ring.submit(1))
+                    break;
+            } else {
+                ring.submitAndWait(wait);
+            }
+            now = TimerWheel::now();
+            loop.completions.fetch_add(ring.reap(complete), std::memory_order_relaxed);
+            loop.enters.store(ring.enters, std::memory_order_relaxed);
+        }
+
+        // Cancel what is in flight and wait for it, the kernel must be done with buffers and
+        // connections before they are freed. Zero copy notifications are not waited for.
+        io_uring_sqe *sqe = ring.acquire();
+        if (sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+            sqe->user_data = TagIgnored;
+        }
+
+        auto settle = [&loop](const io_uring_cqe &cqe) {
+            if (isResult(cqe))
+                --loop.inFlight;
+            if ((cqe.user_data & TagMask) == TagClose) {
+                UringConnection &c = *connectionOf(cqe.user_data);
+                if (cqe.res != 0 && c.getSocket() >= 0)
+                    ::close(c.getSocket());
+                c.releaseSocket();
+            }
+        };
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CancelTimeout);
+        while (loop.inFlight > 0 && std::chrono::steady_clock::now() < deadline) {
+            ring.submitAndWait(100);
+            ring.reap(settle);
+        }
+    }
+
+}
@@ -0,0 +1,75 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/uring/uring_connection.h>
+#include <unistd.h>
+#include <atomic>
+
+namespace restify {
+
+    static std::atomic<uint64_t> nextSerial(1);
+
+    UringConnection::Operations::Operations()
+        :inFlight(0), receiving(false), receiveCanceled(false), receivedWhileSuspended(0), sending(false),
+        sendBuffer(-1), sendLength(0), closing(false)
+    {}
+
+    UringConnection::UringConnection(int socket, const Limits &limits, const TaskPoster &poster)
+        :HttpServerConnection(limits), _socket(socket), _serial(nextSerial.fetch_add(1, std::memory_order_relaxed)),
+        _admitted(0), _deadline(this), _poster(poster)
+    {}
+
+    UringConnection::~UringConnection()
+    {
+        if (_socket >= 0)
+            ::close(_socket);
+    }
+
+    int UringConnection::getSocket() const {
+        return _socket;
+    }
+
+    void UringConnection::releaseSocket() {
+        _socket = -1;
+    }
+
+    uint64_t UringConnection::getSerial() const {
+        return _serial;
+    }
+
+    size_t UringConnection::getAdmittedCount() const {
+        return _admitted;
+    }
+
+    void UringConnection::setAdmittedCount(size_t count) {
+        _admitted = count;
+    }
+
+    UringConnection::Operations & UringConnection::getOperations() {
+        return _operations;
+    }
+
+    PhaseDeadline & UringConnection::getDeadline() {
+        return _deadline;
+    }
+
+    ConnectionResumer UringConnection::createResumer() {
+        if (!_poster)
+            return ConnectionResumer();
+
+        const TaskPoster poster = _poster;
+        const int socket = _socket;
+        const uint64_t serial = _serial;
+        return [poster, socket, serial](const ConnectionTask &task) {
+            poster(socket, serial, task);
+        };
+    }
+
+}
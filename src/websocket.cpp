@@ -0,0 +1,22 @@
+/**
+    This file is part of cpp-restify.
+
+    Copyright(C) 2016 Christoph Heindl
+    All rights reserved.
+
+    This software may be modified and distributed under the terms
+    of MIT license. See the LICENSE file for details.
+*/
+
+#include <restify/websocket.h>
+
+namespace restify {
+
+    WebSocket::~WebSocket()
+    {}
+
+    bool WebSocket::send(const std::string & message, bool binary) {
+        return send(message.data(), message.size(), binary);
+    }
+
+}
@@ -0,0 +1,92 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/admission_control.h>
+#include <restify/helpers.h>
+#include <json/json.h>
+
+TEST_CASE("admission-control")
+{
+    using restify::AdmissionControl;
+
+    AdmissionControl::Limits l = AdmissionControl::Limits::fromConfig(
+        restify::json()
+        ("max_in_flight", 2)
+        ("max_queued", 1)
+        ("max_queue_wait_ms", 50)
+        ("retry_after", 3)
+    );
+    REQUIRE(l.maxInFlight == 2);
+    REQUIRE(l.maxQueued == 1);
+    REQUIRE(l.maxQueueWait == 50);
+    REQUIRE(l.retryAfter == 3);
+
+    AdmissionControl ac(l);
+
+    SECTION("in-flight") {
+        REQUIRE(ac.beginRequest());
+        REQUIRE(ac.beginRequest());
+        REQUIRE(!ac.beginRequest());
+        ac.endRequest();
+        REQUIRE(ac.beginRequest());
+
+        Json::Value s = ac.getStatistics();
+        REQUIRE(s["inFlight"].asInt() == 2);
+        REQUIRE(s["admitted"].asInt() == 3);
+        REQUIRE(s["shed"]["inFlight"].asInt() == 1);
+    }
+
+    SECTION("queue") {
+        REQUIRE(ac.enterQueue());
+        REQUIRE(!ac.enterQueue());
+        REQUIRE(ac.getStatistics()["queued"].asInt() == 1);
+        REQUIRE(ac.leaveQueue(10));
+        REQUIRE(ac.enterQueue());
+        REQUIRE(!ac.leaveQueue(100));
+
+        Json::Value s = ac.getStatistics();
+        REQUIRE(s["queued"].asInt() == 0);
+        REQUIRE(s["shed"]["queueFull"].asInt() == 1);
+        REQUIRE(s["shed"]["queueWait"].asInt() == 1);
+    }
+
+    SECTION("unlimited") {
+        ac.setLimits(AdmissionControl::Limits());
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(ac.enterQueue());
+            REQUIRE(ac.leaveQueue(1000));
+            REQUIRE(ac.beginRequest());
+        }
+        REQUIRE(ac.getStatistics()["inFlight"].asInt() == 100);
+    }
+
+    SECTION("rejection") {
+        const std::string &r = ac.getRejection();
+        REQUIRE(r.find("HTTP/1.1 503 ") == 0);
+        REQUIRE(r.find("Retry-After: 3\r\n") != std::string::npos);
+        REQUIRE(r.find("Connection: close\r\n") != std::string::npos);
+
+        const size_t body = r.find("\r\n\r\n") + 4;
+        Json::Value v;
+        REQUIRE(Json::Reader().parse(r.substr(body), v));
+        REQUIRE(v["statusCode"].asInt() == 503);
+    }
+
+    SECTION("options") {
+        Json::Value config(Json::objectValue);
+        AdmissionControl::addDefaultOptions(config);
+        REQUIRE(config.isMember("max_in_flight"));
+        REQUIRE(config["retry_after"].asInt() == 1);
+        AdmissionControl::removeOptions(config);
+        REQUIRE(config.empty());
+    }
+}
@@ -0,0 +1,38 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/codes.h>
+#include <string>
+
+TEST_CASE("codes-reason-phrases")
+{
+    REQUIRE(std::string(restify::reasonPhrase(200)) == "OK");
+    REQUIRE(std::string(restify::reasonPhrase((int)restify::StatusCode::NotFound)) == "Not Found");
+    REQUIRE(std::string(restify::reasonPhrase((int)restify::StatusCode::TooManyRequests)) == "Too Many Requests");
+    REQUIRE(restify::reasonPhrase(299) == nullptr);
+    REQUIRE(restify::reasonPhrase(42) == nullptr);
+    REQUIRE(restify::reasonPhrase(1000) == nullptr);
+}
+
+TEST_CASE("codes-status-lines")
+{
+    size_t length = 0;
+    const char *line = restify::statusLine(503, length);
+    REQUIRE(line != nullptr);
+    REQUIRE(std::string(line, length) == "HTTP/1.1 503 Service Unavailable\r\n");
+
+    line = restify::statusLine(301, length);
+    REQUIRE(std::string(line, length) == "HTTP/1.1 301 Moved Permanently\r\n");
+
+    REQUIRE(restify::statusLine(599, length) == nullptr);
+    REQUIRE(length == 0);
+}
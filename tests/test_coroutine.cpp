@@ -0,0 +1,90 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/coroutine.h>
+#include <restify/executor.h>
+#include <restify/response_completion.h>
+#include <restify/request.h>
+#include <restify/response.h>
+#include <restify/error.h>
+#include <future>
+#include <thread>
+
+namespace {
+
+    restify::Task<int> answer() {
+        co_await restify::sleepFor(std::chrono::milliseconds(5));
+        co_return 42;
+    }
+
+    restify::Task<int> failing() {
+        co_await restify::sleepFor(std::chrono::milliseconds(1));
+        throw restify::Error(restify::StatusCode::Conflict);
+    }
+
+    /** Run handler like the server does and wait for the completion. */
+    std::exception_ptr invoke(const restify::AsyncRequestHandler &handler, restify::Request &req, restify::Response &rep) {
+        std::promise<std::exception_ptr> result;
+        handler(req, rep, restify::ResponseCompletion([&result](std::exception_ptr error) {
+            result.set_value(error);
+        }));
+        return result.get_future().get();
+    }
+}
+
+TEST_CASE("coroutine-handler")
+{
+    restify::WorkStealingExecutor executor(2);
+
+    restify::AsyncRequestHandler handler = restify::coroutineHandler(
+        [&executor](const restify::Request &req, restify::Response &rep) -> restify::Task<void> {
+        const int a = co_await answer();
+        const std::thread::id io = std::this_thread::get_id();
+        const bool offloaded = co_await restify::runOn(executor, [io]() {
+            return std::this_thread::get_id() != io;
+        });
+        rep.setCode(200).setBody(Json::Value(offloaded ? a : 0));
+    });
+
+    restify::Request req;
+    restify::Response rep;
+    REQUIRE(invoke(handler, req, rep) == nullptr);
+    REQUIRE(rep.toJson()[restify::Response::Keys::body] == 42);
+
+    restify::AsyncRequestHandler fails = restify::coroutineHandler(
+        [](const restify::Request &req, restify::Response &rep) -> restify::Task<void> {
+        co_await failing();
+    });
+    REQUIRE(invoke(fails, req, rep) != nullptr);
+}
+
+TEST_CASE("coroutine-frames-from-pool")
+{
+    std::shared_ptr<restify::FramePool> pool = std::make_shared<restify::FramePool>();
+
+    restify::AsyncRequestHandler handler = restify::coroutineHandler(
+        [](const restify::Request &req, restify::Response &rep) -> restify::Task<void> {
+        co_await answer();
+    });
+
+    restify::Request req;
+    restify::Response rep;
+    for (int i = 0; i < 3; ++i) {
+        restify::FramePool::Scope scope(pool);
+        REQUIRE(invoke(handler, req, rep) == nullptr);
+        // Frames are released on the timer thread just after completion.
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    // Frames of the handler, the nested task and the driver are recycled.
+    REQUIRE(pool->getReusedBlockCount() >= 6);
+}
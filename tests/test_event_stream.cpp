@@ -0,0 +1,342 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/server.h>
+#include <restify/request.h>
+#include <restify/response.h>
+#include <restify/helpers.h>
+#include <restify/event_stream.h>
+#include <restify/loopback/loopback_backend.h>
+#include "restify_build_config.h"
+#ifdef CPPRESTIFY_WITH_EPOLL
+#include <restify/epoll/epoll_backend.h>
+#endif
+#ifdef CPPRESTIFY_WITH_URING
+#include <restify/uring/uring_backend.h>
+#endif
+#include <json/json.h>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    std::string bodyOf(const std::string &response) {
+        const size_t head = response.find("\r\n\r\n");
+        return head == std::string::npos ? std::string() : response.substr(head + 4);
+    }
+
+    size_t count(const std::string &s, const std::string &what) {
+        size_t n = 0;
+        for (size_t pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + what.size()))
+            ++n;
+        return n;
+    }
+
+    bool waitFor(const std::function<bool()> &condition, int timeout = 5000) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+        while (!condition()) {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+
+#ifndef _WIN32
+    /** Event stream client on a blocking socket. */
+    struct EventClient {
+        int s;
+        std::string input;
+
+        EventClient(int port, const std::string &path)
+            :s(::socket(AF_INET, SOCK_STREAM, 0))
+        {
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons((uint16_t)port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            timeval tv = { 5, 0 };
+            setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            REQUIRE(::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+
+            const std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nAccept: text/event-stream\r\n\r\n";
+            REQUIRE(::send(s, request.data(), request.size(), 0) == (ssize_t)request.size());
+        }
+
+        ~EventClient() {
+            close();
+        }
+
+        void close() {
+            if (s >= 0)
+                ::close(s);
+            s = -1;
+        }
+
+        bool fill() {
+            char buffer[4096];
+            const ssize_t n = ::recv(s, buffer, sizeof(buffer), 0);
+            if (n <= 0)
+                return false;
+            input.append(buffer, (size_t)n);
+            return true;
+        }
+
+        /** Read until what was received, false when the connection closed before. */
+        bool readUntil(const std::string &what) {
+            while (input.find(what) == std::string::npos) {
+                if (!fill())
+                    return false;
+            }
+            return true;
+        }
+
+        /** Read until the peer closes the connection. */
+        bool readToEnd() {
+            while (fill()) {
+            }
+            return true;
+        }
+    };
+#endif
+}
+
+TEST_CASE("event-stream-format")
+{
+    REQUIRE(restify::EventStream::format("hello") == "data: hello\n\n");
+    REQUIRE(restify::EventStream::format("") == "data: \n\n");
+    REQUIRE(restify::EventStream::format("a\nb\r\nc\rd", "update", "7") == "event: update\nid: 7\ndata: a\ndata: b\ndata: c\ndata: d\n\n");
+    REQUIRE(restify::EventStream::format("{\"x\":1}\n") == "data: {\"x\":1}\ndata: \n\n");
+}
+
+TEST_CASE("event-stream-loopback")
+{
+    restify::Server server;
+    std::shared_ptr<restify::LoopbackBackend> backend = std::make_shared<restify::LoopbackBackend>();
+    server.setBackend(backend);
+
+    restify::EventHub hub(0);
+    server.events(restify::json()("path", "/feed"), [&hub](const restify::Request &req, const std::shared_ptr<restify::EventStream> &stream) {
+        hub.subscribe(stream);
+    });
+    server.events(restify::json()("path", "/once/:name"), [](const restify::Request &req, const std::shared_ptr<restify::EventStream> &stream) {
+        stream->send("hello " + req.getParam("name").asString(), "greeting");
+        stream->send("bye");
+        stream->close();
+        REQUIRE(!stream->isOpen());
+        REQUIRE(!stream->send("too late"));
+    });
+    server.events(restify::json()("path", "/flood")("maxQueuedEvents", 3), [](const restify::Request &req, const std::shared_ptr<restify::EventStream> &stream) {
+        REQUIRE(stream->send("1"));
+        REQUIRE(stream->send("2"));
+        REQUIRE(stream->send("3"));
+        REQUIRE(!stream->send("4"));
+        REQUIRE(!stream->isOpen());
+    });
+    server.events(restify::json()("path", "/broken"), [](const restify::Request &req, const std::shared_ptr<restify::EventStream> &stream) {
+        stream->send("partial");
+        throw std::runtime_error("handler failed");
+    });
+    server.start();
+
+    SECTION("events written by the handler")
+    {
+        const std::string response = backend->exchange("GET /once/world HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+        REQUIRE(response.find("Content-Type: text/event-stream\r\n") != std::string::npos);
+        REQUIRE(response.find("Cache-Control: no-cache\r\n") != std::string::npos);
+        REQUIRE(response.find("Content-Length") == std::string::npos);
+        REQUIRE(bodyOf(response) == "event: greeting\ndata: hello world\n\ndata: bye\n\n");
+    }
+
+    SECTION("streams not keeping up are closed")
+    {
+        const std::string response = backend->exchange("GET /flood HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+        REQUIRE(bodyOf(response).empty());
+    }
+
+    SECTION("failing handlers end the stream")
+    {
+        const std::string response = backend->exchange("GET /broken HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+        REQUIRE(bodyOf(response) == "data: partial\n\n");
+    }
+
+    SECTION("broadcast to all subscribers")
+    {
+        std::string responses[2];
+        std::vector<std::thread> clients;
+        for (int i = 0; i < 2; ++i) {
+            clients.emplace_back([&backend, &responses, i]() {
+                responses[i] = backend->exchange("GET /feed HTTP/1.1\r\nHost: localhost\r\n\r\n");
+            });
+        }
+
+        REQUIRE(waitFor([&hub]() { return hub.getSubscriberCount() == 2; }));
+        REQUIRE(hub.broadcast("first") == 2);
+        REQUIRE(hub.broadcast("second", "", "2") == 2);
+        REQUIRE(hub.heartbeat() == 2);
+        hub.close();
+        REQUIRE(hub.getSubscriberCount() == 0);
+
+        for (std::thread &t : clients)
+            t.join();
+
+        for (const std::string &r : responses) {
+            const std::string body = bodyOf(r);
+            REQUIRE(body.find("data: first\n\nid: 2\ndata: second\n\n") != std::string::npos);
+        }
+    }
+}
+
+TEST_CASE("event-stream-heartbeat")
+{
+    restify::Server server;
+    std::shared_ptr<restify::LoopbackBackend> backend = std::make_shared<restify::LoopbackBackend>();
+    server.setBackend(backend);
+
+    restify::EventHub hub(10);
+    server.events(restify::json()("path", "/feed"), [&hub](const restify::Request &req, const std::shared_ptr<restify::EventStream> &stream) {
+        hub.subscribe(stream);
+    });
+    server.start();
+
+    std::string response;
+    std::thread client([&backend, &response]() {
+        response = backend->exchange("GET /feed HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    });
+
+    REQUIRE(waitFor([&hub]() { return hub.getSubscriberCount() == 1; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    hub.close();
+    client.join();
+
+    REQUIRE(count(bodyOf(response), ":\n\n") >= 3);
+}
+
+#ifndef _WIN32
+
+TEST_CASE("event-stream-mongoose")
+{
+    restify::EventHub hub(0);
+    restify::Server server;
+    server.setConfig(restify::json()("backend.listening_ports", "127.0.0.1:8097"));
+    server.events(restify::json()("path", "/feed"), [&hub](const restify::Request &req, const std::shared_ptr<restify::EventStream> &stream) {
+        hub.subscribe(stream);
+    });
+    server.start();
+
+    std::vector<std::unique_ptr<EventClient>> clients;
+    for (int i = 0; i < 3; ++i)
+        clients.emplace_back(new EventClient(8097, "/feed"));
+    REQUIRE(waitFor([&hub]() { return hub.getSubscriberCount() == 3; }));
+
+    REQUIRE(hub.broadcast("tick", "clock") == 3);
+    for (auto &c : clients) {
+        REQUIRE(c->readUntil("event: clock\ndata: tick\n\n"));
+        REQUIRE(c->input.find("HTTP/1.1 200 OK\r\n") == 0);
+    }
+
+    // Closed streams end their response.
+    hub.close();
+    clients[0]->readToEnd();
+    REQUIRE(clients[0]->input.find("data: tick\n\n") != std::string::npos);
+
+    // Stopping does not wait for open streams.
+    EventClient open(8097, "/feed");
+    REQUIRE(waitFor([&hub]() { return hub.getSubscriberCount() == 1; }));
+    const auto start = std::chrono::steady_clock::now();
+    server.stop();
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(3));
+}
+
+#if defined(CPPRESTIFY_WITH_EPOLL) || defined(CPPRESTIFY_WITH_URING)
+
+/** Serve many streams from a single event loop of backend. */
+static void requireLoopStreams(const std::shared_ptr<restify::Backend> &backend)
+{
+    restify::EventHub hub(0);
+    restify::Server server;
+    server.setBackend(backend);
+    server.setConfig(restify::json()
+        ("backend.listening_ports", "127.0.0.1:8098")
+        ("backend.num_threads", 1)
+        ("backend.max_in_flight", 1000));
+    server.route(restify::json()("path", "/hello"), [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    server.events(restify::json()("path", "/feed"), [&hub](const restify::Request &req, const std::shared_ptr<restify::EventStream> &stream) {
+        hub.subscribe(stream);
+    });
+    server.start();
+
+    // Open streams take no admission slot and leave the loop free for other requests.
+    const size_t numClients = 200;
+    std::vector<std::unique_ptr<EventClient>> clients;
+    for (size_t i = 0; i < numClients; ++i)
+        clients.emplace_back(new EventClient(8098, "/feed"));
+    REQUIRE(waitFor([&hub, numClients]() { return hub.getSubscriberCount() == numClients; }));
+    REQUIRE(waitFor([&server]() { return server.getStatistics()["backend"]["admission"]["inFlight"].asInt() == 0; }));
+
+    REQUIRE(hub.broadcast("tick", "", "1") == numClients);
+    for (auto &c : clients)
+        REQUIRE(c->readUntil("id: 1\ndata: tick\n\n"));
+
+    {
+        EventClient plain(8098, "/hello");
+        REQUIRE(plain.readUntil("hello world"));
+        REQUIRE(plain.input.find("HTTP/1.1 200 OK\r\n") == 0);
+    }
+
+    // Streams of clients gone are dropped once writing to them fails.
+    for (size_t i = 0; i < numClients / 2; ++i)
+        clients[i]->close();
+    REQUIRE(waitFor([&hub, numClients]() {
+        hub.heartbeat();
+        return hub.getSubscriberCount() == numClients / 2;
+    }));
+
+    hub.close();
+    for (size_t i = numClients / 2; i < numClients; ++i)
+        REQUIRE(clients[i]->readToEnd());
+    REQUIRE(waitFor([&server]() { return server.getStatistics()["backend"]["admission"]["inFlight"].asInt() == 0; }));
+
+    server.stop();
+}
+
+#endif
+
+#ifdef CPPRESTIFY_WITH_EPOLL
+TEST_CASE("event-stream-epoll")
+{
+    requireLoopStreams(std::make_shared<restify::EpollBackend>());
+}
+#endif
+
+#ifdef CPPRESTIFY_WITH_URING
+TEST_CASE("event-stream-uring")
+{
+    if (restify::UringBackend::isSupported())
+        requireLoopStreams(std::make_shared<restify::UringBackend>());
+}
+#endif
+#endif
@@ -0,0 +1,64 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/executor.h>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <chrono>
+
+TEST_CASE("executor-runs-all-tasks")
+{
+    std::atomic<int> count(0);
+    {
+        restify::WorkStealingExecutor e(3);
+        REQUIRE(e.getThreadCount() == 3);
+
+        for (int i = 0; i < 1000; ++i)
+            e.submit([&count]() { ++count; }, i % 5 - 1);
+    }
+    REQUIRE(count == 1000);
+}
+
+TEST_CASE("executor-tasks-submit-tasks")
+{
+    std::atomic<int> count(0);
+    {
+        restify::WorkStealingExecutor e(2);
+        for (int i = 0; i < 10; ++i) {
+            e.submit([&e, &count]() {
+                for (int j = 0; j < 10; ++j)
+                    e.submit([&count]() { ++count; });
+            });
+        }
+    }
+    REQUIRE(count == 100);
+}
+
+TEST_CASE("executor-steals-work")
+{
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    {
+        restify::WorkStealingExecutor e(2);
+        // All tasks prefer the same thread, the idle thread has to steal.
+        for (int i = 0; i < 20; ++i) {
+            e.submit([&mutex, &threads]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }, 0);
+        }
+    }
+    REQUIRE(threads.size() == 2);
+}
@@ -0,0 +1,55 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/frame_pool.h>
+#include <thread>
+#include <cstring>
+
+TEST_CASE("frame-pool")
+{
+    using restify::FramePool;
+
+    REQUIRE(FramePool::current() == nullptr);
+
+    // Without active pool blocks come from the global heap.
+    void *p = FramePool::allocate(100);
+    memset(p, 1, 100);
+    FramePool::deallocate(p);
+
+    std::shared_ptr<FramePool> pool = std::make_shared<FramePool>(2);
+    void *d = nullptr;
+    {
+        FramePool::Scope scope(pool);
+        REQUIRE(FramePool::current() == pool.get());
+
+        void *a = FramePool::allocate(100);
+        void *b = FramePool::allocate(100);
+        void *c = FramePool::allocate(100);
+        FramePool::deallocate(a);
+        FramePool::deallocate(b);
+        FramePool::deallocate(c);
+        REQUIRE(pool->getCachedBlockCount() == 2);
+
+        d = FramePool::allocate(120);
+        REQUIRE(pool->getReusedBlockCount() == 1);
+        REQUIRE(pool->getCachedBlockCount() == 1);
+        memset(d, 2, 120);
+    }
+    REQUIRE(FramePool::current() == nullptr);
+
+    // Release from another thread after the last reference to the pool is gone.
+    std::weak_ptr<FramePool> weak = pool;
+    pool.reset();
+    REQUIRE_FALSE(weak.expired());
+    std::thread([d]() { FramePool::deallocate(d); }).join();
+    REQUIRE(weak.expired());
+}
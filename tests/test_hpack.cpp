@@ -0,0 +1,184 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/http/hpack.h>
+#include <string>
+#include <vector>
+
+namespace {
+    typedef std::vector<restify::HpackDecoder::Header> Headers;
+
+    std::string fromHex(const std::string &hex) {
+        std::string out;
+        for (size_t i = 0; i + 1 < hex.size(); i += 2)
+            out.push_back((char)std::stoi(hex.substr(i, 2), nullptr, 16));
+        return out;
+    }
+
+    Headers decode(restify::HpackDecoder &decoder, const std::string &hex) {
+        const std::string block = fromHex(hex);
+        Headers headers;
+        REQUIRE(decoder.decode(block.data(), block.size(), headers));
+        return headers;
+    }
+}
+
+TEST_CASE("hpack-huffman")
+{
+    // Every byte value survives a round trip.
+    std::string all;
+    for (int i = 0; i < 256; ++i)
+        all.push_back((char)i);
+
+    std::string encoded;
+    restify::huffmanEncode(all.data(), all.size(), encoded);
+    REQUIRE(encoded.size() == restify::huffmanEncodedLength(all.data(), all.size()));
+
+    std::string decoded;
+    REQUIRE(restify::huffmanDecode(encoded.data(), encoded.size(), decoded));
+    REQUIRE(decoded == all);
+
+    // RFC 7541 C.4.1
+    encoded.clear();
+    restify::huffmanEncode("www.example.com", 15, encoded);
+    REQUIRE(encoded == fromHex("f1e3c2e5f23a6ba0ab90f4ff"));
+
+    // Padding longer than 7 bits or not made of ones is invalid.
+    decoded.clear();
+    REQUIRE(!restify::huffmanDecode("\xff\xff\xff\xff", 4, decoded));
+    decoded.clear();
+    REQUIRE(restify::huffmanDecode("\x07", 1, decoded));
+    REQUIRE(decoded == "0");
+    decoded.clear();
+    REQUIRE(!restify::huffmanDecode("\x00", 1, decoded));
+    decoded.clear();
+    REQUIRE(!restify::huffmanDecode("\x1e", 1, decoded));
+}
+
+TEST_CASE("hpack-decoder")
+{
+    // RFC 7541 C.3, requests without Huffman coding sharing a dynamic table.
+    restify::HpackDecoder plain;
+    Headers h = decode(plain, "828684410f7777772e6578616d706c652e636f6d");
+    REQUIRE(h.size() == 4);
+    REQUIRE(h[0] == restify::HpackDecoder::Header(":method", "GET"));
+    REQUIRE(h[1] == restify::HpackDecoder::Header(":scheme", "http"));
+    REQUIRE(h[2] == restify::HpackDecoder::Header(":path", "/"));
+    REQUIRE(h[3] == restify::HpackDecoder::Header(":authority", "www.example.com"));
+    REQUIRE(plain.getTableSize() == 57);
+
+    // RFC 7541 C.4, the same requests with Huffman coding.
+    restify::HpackDecoder huffman;
+    h = decode(huffman, "828684418cf1e3c2e5f23a6ba0ab90f4ff");
+    REQUIRE(h[3] == restify::HpackDecoder::Header(":authority", "www.example.com"));
+    REQUIRE(huffman.getTableSize() == 57);
+
+    h = decode(huffman, "828684be5886a8eb10649cbf");
+    REQUIRE(h.size() == 5);
+    REQUIRE(h[3] == restify::HpackDecoder::Header(":authority", "www.example.com"));
+    REQUIRE(h[4] == restify::HpackDecoder::Header("cache-control", "no-cache"));
+    REQUIRE(huffman.getTableSize() == 110);
+
+    h = decode(huffman, "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf");
+    REQUIRE(h.size() == 5);
+    REQUIRE(h[1] == restify::HpackDecoder::Header(":scheme", "https"));
+    REQUIRE(h[2] == restify::HpackDecoder::Header(":path", "/index.html"));
+    REQUIRE(h[4] == restify::HpackDecoder::Header("custom-key", "custom-value"));
+    REQUIRE(huffman.getTableSize() == 164);
+    REQUIRE(huffman.getTableCount() == 3);
+
+    // Table size update to zero empties the table, it may only start a block.
+    h = decode(huffman, "2082");
+    REQUIRE(huffman.getTableCount() == 0);
+
+    Headers ignored;
+    const std::string late = fromHex("8220");
+    REQUIRE(!restify::HpackDecoder().decode(late.data(), late.size(), ignored));
+
+    // Updates beyond the announced maximum, index 0 and unknown indices are invalid.
+    const std::string tooLarge = fromHex("3fe21f");
+    REQUIRE(!restify::HpackDecoder(4096).decode(tooLarge.data(), tooLarge.size(), ignored));
+    REQUIRE(!restify::HpackDecoder().decode("\x80", 1, ignored));
+    REQUIRE(!restify::HpackDecoder().decode("\xbe", 1, ignored));
+
+    // Truncated string
+    REQUIRE(!restify::HpackDecoder().decode("\x40\x05""ab", 4, ignored));
+}
+
+TEST_CASE("hpack-decoder-list-size")
+{
+    // One ~4 KB table entry referenced by single bytes expands a block many times over.
+    std::string block("\x40\x06x-bomb\x7f\xa1\x1e", 11);
+    block.append(4000, 'a');
+    block.append(32768 - block.size(), '\xbe');
+    REQUIRE(block.size() == 32768);
+
+    // Fields beyond the limit still enter the table.
+    block.append("\x40\x07x-after\x01" "1", 11);
+
+    restify::HpackDecoder decoder;
+    Headers decoded;
+    decoded.emplace_back("x-kept", "1");
+    bool tooLarge = false;
+    REQUIRE(decoder.decode(block.data(), block.size(), decoded, 16384, tooLarge));
+    REQUIRE(tooLarge);
+    REQUIRE(decoded.size() == 1);
+    REQUIRE(decoded[0].first == "x-kept");
+    REQUIRE(decoder.getTableCount() == 2);
+
+    // The table stays in sync with the encoder.
+    decoded.clear();
+    REQUIRE(decoder.decode("\xbe\xbf", 2, decoded, 16384, tooLarge));
+    REQUIRE(!tooLarge);
+    REQUIRE(decoded.size() == 2);
+    REQUIRE(decoded[0] == restify::HpackDecoder::Header("x-after", "1"));
+    REQUIRE(decoded[1] == restify::HpackDecoder::Header("x-bomb", std::string(4000, 'a')));
+}
+
+TEST_CASE("hpack-encoder")
+{
+    restify::HpackEncoder encoder;
+    restify::HpackDecoder decoder;
+
+    Headers response;
+    response.emplace_back(":status", "200");
+    response.emplace_back("content-type", "application/json; charset=utf-8");
+    response.emplace_back("content-length", "42");
+    response.emplace_back("x-custom", "value");
+
+    std::string first;
+    encoder.encode(response, first);
+    Headers decoded;
+    REQUIRE(decoder.decode(first.data(), first.size(), decoded));
+    REQUIRE(decoded == response);
+
+    // Repeated fields are served from the dynamic table, content-length is never indexed.
+    std::string second;
+    encoder.encode(response, second);
+    REQUIRE(second.size() < first.size());
+    REQUIRE(second.size() <= 8);
+    decoded.clear();
+    REQUIRE(decoder.decode(second.data(), second.size(), decoded));
+    REQUIRE(decoded == response);
+    REQUIRE(encoder.getTableSize() == decoder.getTableSize());
+
+    // A smaller table announced by the decoder is signalled in the next block.
+    encoder.setMaxTableSize(0);
+    std::string third;
+    encoder.encode(response, third);
+    REQUIRE((third[0] & 0xe0) == 0x20);
+    decoded.clear();
+    REQUIRE(decoder.decode(third.data(), third.size(), decoded));
+    REQUIRE(decoded == response);
+    REQUIRE(encoder.getTableSize() == 0);
+    REQUIRE(decoder.getTableSize() == 0);
+}
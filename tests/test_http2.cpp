@@ -0,0 +1,596 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/server.h>
+#include <restify/request.h>
+#include <restify/response.h>
+#include <restify/helpers.h>
+#include <restify/response_completion.h>
+#include <restify/event_stream.h>
+#include <restify/http/hpack.h>
+#include <restify/http/http2_session.h>
+#include <restify/loopback/loopback_backend.h>
+#include "restify_build_config.h"
+#ifdef CPPRESTIFY_WITH_EPOLL
+#include <restify/epoll/epoll_backend.h>
+#endif
+#ifdef CPPRESTIFY_WITH_URING
+#include <restify/uring/uring_backend.h>
+#endif
+#if defined(CPPRESTIFY_WITH_EPOLL) || defined(CPPRESTIFY_WITH_URING)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#endif
+#include <json/json.h>
+#include <thread>
+#include <chrono>
+#include <map>
+
+namespace {
+    const uint8_t Data = 0x0;
+    const uint8_t Headers = 0x1;
+    const uint8_t RstStream = 0x3;
+    const uint8_t Settings = 0x4;
+    const uint8_t PushPromise = 0x5;
+    const uint8_t Ping = 0x6;
+    const uint8_t GoAway = 0x7;
+    const uint8_t WindowUpdate = 0x8;
+
+    const uint8_t EndStream = 0x1;
+    const uint8_t Ack = 0x1;
+    const uint8_t EndHeaders = 0x4;
+
+    std::string uint32Bytes(uint32_t v) {
+        const char b[4] = { (char)(v >> 24), (char)(v >> 16), (char)(v >> 8), (char)v };
+        return std::string(b, 4);
+    }
+
+    uint32_t uint32At(const std::string &s, size_t offset) {
+        const uint8_t *u = reinterpret_cast<const uint8_t*>(s.data() + offset);
+        return ((uint32_t)u[0] << 24) | ((uint32_t)u[1] << 16) | ((uint32_t)u[2] << 8) | u[3];
+    }
+
+    std::string frame(uint8_t type, uint8_t flags, uint32_t stream, const std::string &payload = std::string()) {
+        std::string f;
+        f.push_back((char)(payload.size() >> 16));
+        f.push_back((char)(payload.size() >> 8));
+        f.push_back((char)payload.size());
+        f.push_back((char)type);
+        f.push_back((char)flags);
+        f.append(uint32Bytes(stream));
+        return f + payload;
+    }
+
+    std::string setting(uint16_t id, uint32_t value) {
+        return std::string(1, (char)(id >> 8)) + std::string(1, (char)id) + uint32Bytes(value);
+    }
+
+    struct Frame {
+        uint8_t type;
+        uint8_t flags;
+        uint32_t stream;
+        std::string payload;
+    };
+
+    struct StreamResponse {
+        std::vector<restify::HpackDecoder::Header> headers;
+        std::string body;
+        bool ended;
+        bool reset;
+        uint32_t error;
+
+        StreamResponse()
+            :ended(false), reset(false), error(0)
+        {}
+
+        std::string status() const {
+            for (const auto &h : headers) {
+                if (h.first == ":status")
+                    return h.second;
+            }
+            return std::string();
+        }
+
+        std::string header(const std::string &name) const {
+            for (const auto &h : headers) {
+                if (h.first == name)
+                    return h.second;
+            }
+            return std::string();
+        }
+    };
+
+    /** Client side of a HTTP/2 connection, frames are produced and consumed as bytes. */
+    struct Http2Client {
+        restify::HpackEncoder encoder;
+        restify::HpackDecoder decoder;
+        std::string input;
+        std::vector<Frame> frames;
+        std::map<uint32_t, StreamResponse> responses;
+        /** Order in which streams completed. */
+        std::vector<uint32_t> completed;
+        bool goAway;
+        uint32_t goAwayError;
+
+        Http2Client()
+            :goAway(false), goAwayError(0)
+        {}
+
+        std::string preface(const std::string &settings = std::string()) const {
+            return std::string(restify::Http2Session::Preface, restify::Http2Session::PrefaceLength) + frame(Settings, 0, 0, settings);
+        }
+
+        std::string request(uint32_t stream, const std::string &method, const std::string &path, const std::string &body = std::string()) {
+            std::vector<restify::HpackEncoder::Header> fields;
+            fields.emplace_back(":method", method);
+            fields.emplace_back(":scheme", "http");
+            fields.emplace_back(":authority", "localhost");
+            fields.emplace_back(":path", path);
+            if (!body.empty())
+                fields.emplace_back("content-type", "application/json");
+
+            std::string block;
+            encoder.encode(fields, block);
+            if (body.empty())
+                return frame(Headers, EndHeaders | EndStream, stream, block);
+            return frame(Headers, EndHeaders, stream, block) + frame(Data, EndStream, stream, body);
+        }
+
+        /** Consume received bytes, an incomplete frame is kept for the next call. */
+        void receive(const std::string &bytes) {
+            input.append(bytes);
+            while (input.size() >= 9) {
+                const size_t length = ((size_t)(uint8_t)input[0] << 16) | ((size_t)(uint8_t)input[1] << 8) | (uint8_t)input[2];
+                if (input.size() < 9 + length)
+                    break;
+
+                Frame f;
+                f.type = (uint8_t)input[3];
+                f.flags = (uint8_t)input[4];
+                f.stream = uint32At(input, 5) & 0x7fffffff;
+                f.payload = input.substr(9, length);
+                input.erase(0, 9 + length);
+                onFrame(f);
+                frames.push_back(f);
+            }
+        }
+
+        void onFrame(const Frame &f) {
+            StreamResponse &r = responses[f.stream];
+            if (f.type == Headers) {
+                REQUIRE((f.flags & EndHeaders) != 0);
+                REQUIRE(decoder.decode(f.payload.data(), f.payload.size(), r.headers));
+            } else if (f.type == Data) {
+                r.body.append(f.payload);
+            } else if (f.type == RstStream) {
+                r.reset = true;
+                r.error = uint32At(f.payload, 0);
+            } else if (f.type == GoAway) {
+                goAway = true;
+                goAwayError = uint32At(f.payload, 4);
+            }
+            if (f.stream != 0 && (f.type == Headers || f.type == Data) && (f.flags & EndStream)) {
+                r.ended = true;
+                completed.push_back(f.stream);
+            }
+            if (f.stream == 0)
+                responses.erase(0);
+        }
+
+        size_t count(uint8_t type, uint8_t flags = 0) const {
+            size_t n = 0;
+            for (const Frame &f : frames) {
+                if (f.type == type && (f.flags & flags) == flags)
+                    ++n;
+            }
+            return n;
+        }
+    };
+
+    /** Server on a loopback backend with a few routes. */
+    struct Http2Fixture {
+        restify::Server server;
+        std::shared_ptr<restify::LoopbackBackend> backend;
+
+        Http2Fixture(const Json::Value &options = Json::Value())
+            :backend(std::make_shared<restify::LoopbackBackend>())
+        {
+            server.setBackend(backend);
+            if (!options.isNull())
+                server.setConfig(options);
+            server.route(restify::json()("path", "/hello"), [](const restify::Request &req, restify::Response &rep) {
+                rep.setCode(200).setBody("hello world");
+                return true;
+            });
+            server.route(restify::json()("path", "/items/:id")("methods", "POST"), [](const restify::Request &req, restify::Response &rep) {
+                rep.setCode(201).setBody(restify::json()("id", req.getParam("id"))("value", req.getBody()["value"])("host", req.getHeader("Host")));
+                return true;
+            });
+            server.route(restify::json()("path", "/large"), [](const restify::Request &req, restify::Response &rep) {
+                // Too large for a single Json buffer, the writer switches to chunked encoding.
+                Json::Value items(Json::arrayValue);
+                for (int i = 0; i < 20000; ++i)
+                    items.append(i);
+                rep.setCode(200).setBody(items);
+                return true;
+            });
+            server.routeAsync(restify::json()("path", "/later"), [](const restify::Request &req, restify::Response &rep, const restify::ResponseCompletion &done) {
+                std::thread([&rep, done]() {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    rep.setCode(200).setBody("later");
+                    done.complete();
+                }).detach();
+            });
+            server.start();
+        }
+    };
+}
+
+TEST_CASE_METHOD(Http2Fixture, "http2-prior-knowledge")
+{
+    std::unique_ptr<restify::LoopbackConnection> c = backend->connect();
+    Http2Client client;
+
+    std::string out;
+    // Requests are encoded in order, they share the dynamic table.
+    std::string request = client.preface(setting(0x4, 1 << 20));
+    request += client.request(1, "GET", "/hello");
+    request += client.request(3, "POST", "/items/42", "{\"value\": 3}");
+    REQUIRE(backend->exchange(*c, request.data(), request.size(), out));
+    REQUIRE(c->isHttp2());
+    client.receive(out);
+
+    // Server preface and acknowledgement of the client settings come first.
+    REQUIRE(client.frames.size() >= 2);
+    REQUIRE(client.frames[0].type == Settings);
+    REQUIRE(client.frames[0].flags == 0);
+    REQUIRE(client.count(Settings, Ack) == 1);
+
+    REQUIRE(client.responses[1].ended);
+    REQUIRE(client.responses[1].status() == "200");
+    REQUIRE(client.responses[1].header("content-type") == "text/plain; charset=utf-8");
+    REQUIRE(client.responses[1].header("connection").empty());
+    REQUIRE(client.responses[1].body == "hello world");
+
+    REQUIRE(client.responses[3].ended);
+    REQUIRE(client.responses[3].status() == "201");
+    Json::Value body;
+    REQUIRE(Json::Reader().parse(client.responses[3].body, body));
+    REQUIRE(body["id"] == "42");
+    REQUIRE(body["value"] == 3);
+    REQUIRE(body["host"] == "localhost");
+
+    // Chunked bodies are unwrapped into DATA frames, the connection window is raised to fit.
+    out.clear();
+    std::string more = frame(WindowUpdate, 0, 0, uint32Bytes(1 << 20));
+    more += client.request(5, "GET", "/large");
+    more += client.request(7, "GET", "/missing");
+    more += frame(Ping, 0, 0, "12345678");
+    REQUIRE(backend->exchange(*c, more.data(), more.size(), out));
+    client.receive(out);
+
+    REQUIRE(client.responses[5].ended);
+    REQUIRE(client.responses[5].header("transfer-encoding").empty());
+    REQUIRE(Json::Reader().parse(client.responses[5].body, body));
+    REQUIRE(body.size() == 20000);
+    REQUIRE(body[19999] == 19999);
+
+    REQUIRE(client.responses[7].status() == "404");
+    REQUIRE(client.count(Ping, Ack) == 1);
+    for (const Frame &f : client.frames) {
+        if (f.type == Ping)
+            REQUIRE(f.payload == "12345678");
+    }
+    REQUIRE(c->getRequestCount() == 4);
+    REQUIRE(!c->shouldClose());
+
+    // Draining announces GOAWAY and closes once no stream is left.
+    out.clear();
+    c->drain();
+    REQUIRE(c->shouldClose());
+    client.receive(std::string(c->getPendingOutput(), c->getPendingOutputSize()));
+    REQUIRE(client.goAway);
+    REQUIRE(client.goAwayError == 0);
+}
+
+TEST_CASE_METHOD(Http2Fixture, "http2-upgrade")
+{
+    std::unique_ptr<restify::LoopbackConnection> c = backend->connect();
+    Http2Client client;
+
+    // HTTP2-Settings carries SETTINGS_MAX_CONCURRENT_STREAMS 100 and SETTINGS_INITIAL_WINDOW_SIZE 4.
+    std::string out;
+    const std::string upgrade =
+        "GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: Upgrade, HTTP2-Settings\r\n"
+        "Upgrade: h2c\r\nHTTP2-Settings: AAMAAABkAAQAAAAE\r\n\r\n";
+    REQUIRE(backend->exchange(*c, upgrade.data(), upgrade.size(), out));
+
+    const std::string switching = "HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n";
+    REQUIRE(out.find(switching) == 0);
+    client.receive(out.substr(switching.size()));
+
+    // The response of stream 1 is bound by the initial window announced in HTTP2-Settings.
+    REQUIRE(client.frames[0].type == Settings);
+    REQUIRE(client.responses[1].status() == "200");
+    REQUIRE(client.responses[1].body == "hell");
+    REQUIRE(!client.responses[1].ended);
+
+    out.clear();
+    const std::string next = client.preface() + frame(WindowUpdate, 0, 1, uint32Bytes(100)) + client.request(3, "GET", "/hello");
+    REQUIRE(backend->exchange(*c, next.data(), next.size(), out));
+    client.receive(out);
+    REQUIRE(client.responses[1].body == "hello world");
+    REQUIRE(client.responses[1].ended);
+    REQUIRE(client.responses[3].body == "hell");
+
+    // Disabled HTTP/2 leaves the request to HTTP/1.1.
+    restify::LoopbackBackend plain;
+    plain.setConfig(restify::json()("max_concurrent_streams", 0));
+    plain.setRequestCallback([](const restify::BackendContext &, restify::Connection &conn) {
+        const std::string r = "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n";
+        conn.write(r.data(), r.size());
+        return true;
+    });
+    plain.start();
+    REQUIRE(plain.exchange(upgrade).find("HTTP/1.1 204 ") == 0);
+}
+
+TEST_CASE_METHOD(Http2Fixture, "http2-flow-control")
+{
+    std::unique_ptr<restify::LoopbackConnection> c = backend->connect();
+    Http2Client client;
+
+    // Peer allows a single frame of 16384 bytes per stream at first.
+    std::string out;
+    std::string request = client.preface(setting(0x4, 16384));
+    request += client.request(1, "GET", "/large");
+    request += client.request(3, "GET", "/large");
+    REQUIRE(backend->exchange(*c, request.data(), request.size(), out));
+    client.receive(out);
+
+    REQUIRE(client.responses[1].body.size() == 16384);
+    REQUIRE(client.responses[3].body.size() == 16384);
+    REQUIRE(!client.responses[1].ended);
+
+    // The connection window of 65535 bytes is shared, 32767 bytes are left for both streams.
+    out.clear();
+    const std::string update = frame(WindowUpdate, 0, 1, uint32Bytes(1 << 20)) + frame(WindowUpdate, 0, 3, uint32Bytes(1 << 20));
+    REQUIRE(backend->exchange(*c, update.data(), update.size(), out));
+    client.receive(out);
+    REQUIRE(client.responses[1].body.size() + client.responses[3].body.size() == 65535);
+    REQUIRE(!client.responses[1].ended);
+
+    out.clear();
+    const std::string connection = frame(WindowUpdate, 0, 0, uint32Bytes(1 << 20));
+    REQUIRE(backend->exchange(*c, connection.data(), connection.size(), out));
+    client.receive(out);
+    REQUIRE(client.responses[1].ended);
+    REQUIRE(client.responses[3].ended);
+    REQUIRE(client.responses[1].body == client.responses[3].body);
+
+    // Frames never exceed the default maximum frame size.
+    for (const Frame &f : client.frames)
+        REQUIRE(f.payload.size() <= 16384);
+
+    // Overflowing the connection window is a connection error.
+    out.clear();
+    const std::string overflow = frame(WindowUpdate, 0, 0, uint32Bytes(0x7fffffff));
+    REQUIRE(backend->exchange(*c, overflow.data(), overflow.size(), out));
+    client.receive(out);
+    REQUIRE(client.goAway);
+    REQUIRE(client.goAwayError == 0x3);
+    REQUIRE(c->shouldClose());
+}
+
+TEST_CASE_METHOD(Http2Fixture, "http2-multiplexing")
+{
+    std::unique_ptr<restify::LoopbackConnection> c = backend->connect();
+    Http2Client client;
+
+    // Deferred streams do not hold up others on the same connection.
+    std::string request = client.preface() + client.request(1, "GET", "/later");
+    for (uint32_t id = 3; id < 200; id += 2)
+        request += client.request(id, "GET", id % 4 == 1 ? "/later" : "/hello");
+
+    std::string out;
+    REQUIRE(backend->exchange(*c, request.data(), request.size(), out));
+    client.receive(out);
+
+    REQUIRE(client.completed.size() == 100);
+    REQUIRE(client.completed.front() == 3);
+    REQUIRE(client.completed.back() % 4 == 1);
+    for (uint32_t id = 1; id < 200; id += 2) {
+        REQUIRE(client.responses[id].status() == "200");
+        REQUIRE(client.responses[id].body == (id % 4 == 1 ? "later" : "hello world"));
+    }
+    REQUIRE(c->getDeferredCount() == 0);
+    REQUIRE(c->getRequestCount() == 100);
+}
+
+TEST_CASE_METHOD(Http2Fixture, "http2-event-stream")
+{
+    server.events(restify::json()("path", "/events/:n"), [](const restify::Request &req, const std::shared_ptr<restify::EventStream> &stream) {
+        const int n = std::stoi(req.getParam("n").asString());
+        std::thread([stream, n]() {
+            for (int i = 0; i < n; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                stream->send(std::to_string(i));
+            }
+            stream->close();
+        }).detach();
+    });
+
+    std::unique_ptr<restify::LoopbackConnection> c = backend->connect();
+    Http2Client client;
+
+    // Streams stay open across events while other streams complete.
+    std::string request = client.preface();
+    request += client.request(1, "GET", "/events/3");
+    request += client.request(3, "GET", "/events/2");
+    request += client.request(5, "GET", "/hello");
+
+    std::string out;
+    REQUIRE(backend->exchange(*c, request.data(), request.size(), out));
+    client.receive(out);
+
+    REQUIRE(client.completed.size() == 3);
+    REQUIRE(client.completed.front() == 5);
+    REQUIRE(client.responses[1].status() == "200");
+    REQUIRE(client.responses[1].header("content-type") == "text/event-stream");
+    REQUIRE(client.responses[1].header("connection").empty());
+    REQUIRE(client.responses[1].body == ":\n\ndata: 0\n\ndata: 1\n\ndata: 2\n\n");
+    REQUIRE(client.responses[3].body == ":\n\ndata: 0\n\ndata: 1\n\n");
+    REQUIRE(!client.goAway);
+    REQUIRE(c->getDeferredCount() == 0);
+}
+
+TEST_CASE("http2-limits")
+{
+    Http2Fixture f(restify::json()("backend.max_concurrent_streams", 1)("backend.max_body_size", 16));
+    std::unique_ptr<restify::LoopbackConnection> c = f.backend->connect();
+    Http2Client client;
+
+    // A second stream beyond the announced limit is refused.
+    std::string out;
+    std::string request = client.preface();
+    request += client.request(1, "GET", "/later");
+    request += client.request(3, "GET", "/hello");
+    REQUIRE(f.backend->exchange(*c, request.data(), request.size(), out));
+    client.receive(out);
+
+    REQUIRE(client.frames[0].payload.find(setting(0x3, 1)) != std::string::npos);
+    REQUIRE(client.responses[1].body == "later");
+    REQUIRE(client.responses[3].reset);
+    REQUIRE(client.responses[3].error == 0x7);
+
+    // Bodies beyond max_body_size are answered with 413 and the stream is reset.
+    out.clear();
+    request = client.request(5, "POST", "/items/1", "{\"value\": \"more than sixteen bytes\"}");
+    REQUIRE(f.backend->exchange(*c, request.data(), request.size(), out));
+    client.receive(out);
+    REQUIRE(client.responses[5].status() == "413");
+    REQUIRE(client.responses[5].reset);
+    REQUIRE(client.responses[5].error == 0);
+
+    // Protocol violations end the connection with GOAWAY.
+    out.clear();
+    request = frame(PushPromise, EndHeaders, 7, uint32Bytes(8));
+    REQUIRE(f.backend->exchange(*c, request.data(), request.size(), out));
+    client.receive(out);
+    REQUIRE(client.goAway);
+    REQUIRE(client.goAwayError == 0x1);
+    REQUIRE(c->shouldClose());
+
+    // So do header blocks that fail to decode.
+    std::unique_ptr<restify::LoopbackConnection> c2 = f.backend->connect();
+    Http2Client client2;
+    out.clear();
+    request = client2.preface() + frame(Headers, EndHeaders | EndStream, 1, "\x80");
+    REQUIRE(f.backend->exchange(*c2, request.data(), request.size(), out));
+    client2.receive(out);
+    REQUIRE(client2.goAwayError == 0x9);
+
+    // Header lists expanding past max_request_size from a table entry are answered with 431
+    // while the table stays in sync.
+    std::unique_ptr<restify::LoopbackConnection> c3 = f.backend->connect();
+    Http2Client client3;
+    std::string bomb("\x82\x86\x84\x40\x06x-bomb\x7f\xa1\x1e", 14);
+    bomb.append(4000, 'a');
+    bomb.append(20, '\xbe');
+    out.clear();
+    request = client3.preface() + frame(Headers, EndHeaders | EndStream, 1, bomb);
+    request += frame(Headers, EndHeaders | EndStream, 3, std::string("\x82\x86\x04\x06/hello\xbe", 11));
+    REQUIRE(f.backend->exchange(*c3, request.data(), request.size(), out));
+    client3.receive(out);
+    REQUIRE(client3.responses[1].status() == "431");
+    REQUIRE(client3.responses[3].status() == "200");
+    REQUIRE(client3.responses[3].body == "hello world");
+    REQUIRE(!client3.goAway);
+}
+
+#if defined(CPPRESTIFY_WITH_EPOLL) || defined(CPPRESTIFY_WITH_URING)
+
+/** Multiplex deferred calls over one connection to an event loop of backend. */
+static void requireLoopStreams(const std::shared_ptr<restify::Backend> &backend)
+{
+    restify::Server server;
+    server.setBackend(backend);
+    server.setConfig(restify::json()
+        ("backend.listening_ports", "127.0.0.1:8093")
+        ("backend.num_threads", 1)
+        ("backend.max_in_flight", 1000));
+    server.route(restify::json()("path", "/hello"), [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    server.routeAsync(restify::json()("path", "/later"), [](const restify::Request &req, restify::Response &rep, const restify::ResponseCompletion &done) {
+        std::thread([&rep, done]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            rep.setCode(200).setBody("later");
+            done.complete();
+        }).detach();
+    });
+    server.start();
+
+    const int s = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(8093);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    timeval tv = { 5, 0 };
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    REQUIRE(::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+
+    // Deferred calls up to the stream limit share one connection and complete together.
+    Http2Client client;
+    std::string request = client.preface();
+    for (uint32_t id = 1; id < 199; id += 2)
+        request += client.request(id, "GET", "/later");
+    request += client.request(199, "GET", "/hello");
+    REQUIRE(::send(s, request.data(), request.size(), 0) == (ssize_t)request.size());
+
+    const auto start = std::chrono::steady_clock::now();
+    char buffer[16384];
+    while (client.completed.size() < 100) {
+        const ssize_t n = ::recv(s, buffer, sizeof(buffer), 0);
+        REQUIRE(n > 0);
+        client.receive(std::string(buffer, (size_t)n));
+    }
+    const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    REQUIRE(client.completed.front() == 199);
+    for (uint32_t id = 1; id < 199; id += 2)
+        REQUIRE(client.responses[id].body == "later");
+    REQUIRE(elapsed < 2000);
+    REQUIRE(server.getStatistics()["backend"]["admission"]["inFlight"].asInt() == 0);
+
+    ::close(s);
+    server.stop();
+}
+
+#endif
+
+#ifdef CPPRESTIFY_WITH_EPOLL
+TEST_CASE("http2-epoll")
+{
+    requireLoopStreams(std::make_shared<restify::EpollBackend>());
+}
+#endif
+
+#ifdef CPPRESTIFY_WITH_URING
+TEST_CASE("http2-uring")
+{
+    if (restify::UringBackend::isSupported())
+        requireLoopStreams(std::make_shared<restify::UringBackend>());
+}
+#endif
@@ -0,0 +1,339 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/http/http_parser.h>
+#include <restify/http/http_server_connection.h>
+#include <restify/http/http_request_reader.h>
+#include <restify/request.h>
+#include <restify/backend.h>
+#include <string>
+#include <sstream>
+
+TEST_CASE("http-parser-complete-request")
+{
+    restify::HttpRequestParser parser;
+    restify::HttpRequestHead head;
+
+    const std::string req = "GET /items/a%20b?x=1&y=2 HTTP/1.1\r\nHost: localhost\r\nContent-Length: 3\r\n\r\nabc";
+    REQUIRE(parser.parse(req.data(), req.size(), head) == restify::HttpRequestParser::Result::Complete);
+    REQUIRE(parser.getHeadLength() == req.size() - 3);
+    REQUIRE(head.method == "GET");
+    REQUIRE(head.path == "/items/a b");
+    REQUIRE(head.hasQuery);
+    REQUIRE(head.query == "x=1&y=2");
+    REQUIRE(head.version == "1.1");
+    REQUIRE(head.contentLength == 3);
+    REQUIRE(head.keepAlive);
+    REQUIRE(*head.findHeader("host") == "localhost");
+    REQUIRE(head.findHeader("Accept") == nullptr);
+}
+
+TEST_CASE("http-parser-incremental")
+{
+    restify::HttpRequestParser parser;
+    restify::HttpRequestHead head;
+
+    const std::string req = "POST /a HTTP/1.0\r\nConnection: keep-alive\r\n\r\n";
+    for (size_t i = 1; i < req.size(); ++i) {
+        REQUIRE(parser.parse(req.data(), i, head) == restify::HttpRequestParser::Result::Incomplete);
+    }
+    REQUIRE(parser.parse(req.data(), req.size(), head) == restify::HttpRequestParser::Result::Complete);
+    REQUIRE(head.method == "POST");
+    REQUIRE(head.version == "1.0");
+    REQUIRE(head.keepAlive);
+    REQUIRE(head.contentLength == -1);
+}
+
+TEST_CASE("http-parser-invalid")
+{
+    restify::HttpRequestHead head;
+
+    {
+        restify::HttpRequestParser parser;
+        const std::string req = "GARBAGE\r\n\r\n";
+        REQUIRE(parser.parse(req.data(), req.size(), head) == restify::HttpRequestParser::Result::Invalid);
+        REQUIRE(parser.getErrorCode() == 400);
+    }
+    {
+        restify::HttpRequestParser parser;
+        const std::string req = "GET / HTTP/1.2\r\n\r\n";
+        REQUIRE(parser.parse(req.data(), req.size(), head) == restify::HttpRequestParser::Result::Invalid);
+        REQUIRE(parser.getErrorCode() == 505);
+    }
+    {
+        restify::HttpRequestParser parser;
+        const std::string req = "GET / HTTP/1.1\r\nContent-Length: abc\r\n\r\n";
+        REQUIRE(parser.parse(req.data(), req.size(), head) == restify::HttpRequestParser::Result::Invalid);
+        REQUIRE(parser.getErrorCode() == 400);
+    }
+    {
+        restify::HttpRequestParser parser;
+        const std::string req = "POST / HTTP/1.1\r\nContent-Length: +5\r\n\r\nhello";
+        REQUIRE(parser.parse(req.data(), req.size(), head) == restify::HttpRequestParser::Result::Invalid);
+        REQUIRE(parser.getErrorCode() == 400);
+    }
+    {
+        restify::HttpRequestParser parser;
+        const std::string req = "POST / HTTP/1.1\r\nContent-Length: 99999999999999999999\r\n\r\n";
+        REQUIRE(parser.parse(req.data(), req.size(), head) == restify::HttpRequestParser::Result::Invalid);
+        REQUIRE(parser.getErrorCode() == 400);
+    }
+    {
+        restify::HttpRequestParser parser;
+        const std::string req = "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\nContent-Length: 4\r\n\r\n";
+        REQUIRE(parser.parse(req.data(), req.size(), head) == restify::HttpRequestParser::Result::Invalid);
+        REQUIRE(parser.getErrorCode() == 400);
+    }
+    {
+        restify::HttpRequestParser parser;
+        const std::string req = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked, gzip\r\n\r\n";
+        REQUIRE(parser.parse(req.data(), req.size(), head) == restify::HttpRequestParser::Result::Invalid);
+        REQUIRE(parser.getErrorCode() == 400);
+    }
+    {
+        restify::HttpRequestParser parser;
+        const std::string req = "POST / HTTP/1.1\r\nTransfer-Encoding: gzip, chunked \r\n\r\n";
+        REQUIRE(parser.parse(req.data(), req.size(), head) == restify::HttpRequestParser::Result::Complete);
+        REQUIRE(head.chunked);
+    }
+    {
+        restify::HttpRequestParser parser(64);
+        const std::string req = "GET / HTTP/1.1\r\nX-Long: " + std::string(100, 'a');
+        REQUIRE(parser.parse(req.data(), req.size(), head) == restify::HttpRequestParser::Result::Invalid);
+        REQUIRE(parser.getErrorCode() == 431);
+    }
+}
+
+TEST_CASE("http-server-connection-pipelining")
+{
+    restify::HttpServerConnection conn;
+    restify::HttpBackendContext ctx;
+
+    std::vector<std::string> bodies;
+    restify::BackendRequestHandler handler = [&bodies](const restify::BackendContext &c, restify::Connection &con) {
+        restify::Request r;
+        c.getRequestHeaderReader().readRequestHeader(con, r);
+
+        std::ostringstream oss;
+        con.readStream(oss);
+        bodies.push_back(r.getPath() + ":" + oss.str());
+
+        const std::string reply = "HTTP/1.1 204 No Content\r\n\r\n";
+        con.write(reply.data(), reply.size());
+        return true;
+    };
+
+    const std::string reqs =
+        "POST /a HTTP/1.1\r\nContent-Length: 2\r\n\r\nxy"
+        "GET /b HTTP/1.1\r\n\r\n"
+        "GET /c HTTP/1.1\r\nConnection: close\r\n\r\n";
+
+    // Feed in two parts, splitting the second request.
+    conn.receive(reqs.data(), 50);
+    conn.process(handler, ctx);
+    REQUIRE(bodies.size() == 1);
+    REQUIRE_FALSE(conn.shouldClose());
+
+    conn.receive(reqs.data() + 50, reqs.size() - 50);
+    conn.process(handler, ctx);
+    REQUIRE(bodies.size() == 3);
+    REQUIRE(bodies[0] == "/a:xy");
+    REQUIRE(bodies[1] == "/b:");
+    REQUIRE(bodies[2] == "/c:");
+    REQUIRE(conn.getRequestCount() == 3);
+    REQUIRE(conn.shouldClose());
+    REQUIRE(conn.getPendingOutputSize() == 3 * 27);
+}
+
+TEST_CASE("http-server-connection-errors")
+{
+    restify::HttpBackendContext ctx;
+    restify::BackendRequestHandler handler = [](const restify::BackendContext &c, restify::Connection &con) {
+        return true;
+    };
+
+    {
+        restify::HttpServerConnection conn;
+        const std::string req = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+        conn.receive(req.data(), req.size());
+        conn.process(handler, ctx);
+        REQUIRE(conn.shouldClose());
+        REQUIRE(std::string(conn.getPendingOutput(), conn.getPendingOutputSize()).find("HTTP/1.1 411 ") == 0);
+    }
+    {
+        restify::HttpServerConnection::Limits limits;
+        limits.maxBodySize = 10;
+        restify::HttpServerConnection conn(limits);
+        const std::string req = "POST / HTTP/1.1\r\nContent-Length: 11\r\n\r\n";
+        conn.receive(req.data(), req.size());
+        conn.process(handler, ctx);
+        REQUIRE(conn.shouldClose());
+        REQUIRE(std::string(conn.getPendingOutput(), conn.getPendingOutputSize()).find("HTTP/1.1 413 ") == 0);
+    }
+    {
+        restify::HttpServerConnection conn;
+        const std::string req = "POST / HTTP/1.1\r\nContent-Length: 4\r\nExpect: 100-continue\r\n\r\n";
+        conn.receive(req.data(), req.size());
+        conn.process(handler, ctx);
+        REQUIRE_FALSE(conn.shouldClose());
+        REQUIRE(std::string(conn.getPendingOutput(), conn.getPendingOutputSize()) == "HTTP/1.1 100 Continue\r\n\r\n");
+    }
+}
+
+/** Connection handing resumed tasks to the test instead of an event loop. */
+class SuspendableConnection : public restify::HttpServerConnection {
+public:
+    std::vector<restify::ConnectionTask> tasks;
+
+protected:
+    virtual restify::ConnectionResumer createResumer() override {
+        return [this](const restify::ConnectionTask &task) {
+            tasks.push_back(task);
+        };
+    }
+};
+
+TEST_CASE("http-server-connection-suspend")
+{
+    SuspendableConnection conn;
+    restify::HttpBackendContext ctx;
+
+    restify::ConnectionResumer resumer;
+    int dispatched = 0;
+    restify::BackendRequestHandler handler = [&resumer, &dispatched](const restify::BackendContext &c, restify::Connection &con) {
+        ++dispatched;
+        resumer = con.suspend();
+        return true;
+    };
+
+    const std::string reqs =
+        "GET /a HTTP/1.1\r\n\r\n"
+        "GET /b HTTP/1.1\r\n\r\n";
+
+    // Pipelined request waits while the first one is suspended.
+    conn.receive(reqs.data(), reqs.size());
+    conn.process(handler, ctx);
+    REQUIRE(dispatched == 1);
+    REQUIRE(conn.isSuspended());
+    REQUIRE(conn.getPendingOutputSize() == 0);
+
+    resumer([](restify::Connection &c) {
+        const std::string reply = "HTTP/1.1 204 No Content\r\n\r\n";
+        c.write(reply.data(), reply.size());
+    });
+    REQUIRE(conn.tasks.size() == 1);
+
+    conn.resume(conn.tasks[0]);
+    REQUIRE_FALSE(conn.isSuspended());
+    REQUIRE(conn.getPendingOutputSize() == 27);
+
+    conn.process(handler, ctx);
+    REQUIRE(dispatched == 2);
+    REQUIRE(conn.isSuspended());
+
+    // Plain connections cannot be suspended.
+    restify::HttpServerConnection plain;
+    REQUIRE_FALSE(plain.suspend());
+    REQUIRE_FALSE(plain.isSuspended());
+}
+
+TEST_CASE("http-server-connection-phases")
+{
+    using restify::RequestPhase;
+    restify::HttpBackendContext ctx;
+
+    restify::ConnectionResumer resumer;
+    restify::BackendRequestHandler handler = [&resumer](const restify::BackendContext &c, restify::Connection &con) {
+        restify::Request r;
+        c.getRequestHeaderReader().readRequestHeader(con, r);
+        if (r.getPath() == "/deferred") {
+            con.setTimeouts(50, -1);
+            resumer = con.suspend();
+            return true;
+        }
+        const std::string reply = "HTTP/1.1 204 No Content\r\n\r\n";
+        con.write(reply.data(), reply.size());
+        return true;
+    };
+
+    SECTION("header-and-body") {
+        restify::HttpServerConnection conn;
+        REQUIRE(conn.getPhase() == RequestPhase::ReadHeader);
+        REQUIRE(conn.getPhaseTimeout(RequestPhase::ReadHeader) == 30000);
+
+        const std::string head = "POST /a HTTP/1.1\r\nContent-Length: 4\r\n\r\nxy";
+        conn.receive(head.data(), head.size());
+        conn.process(handler, ctx);
+        REQUIRE(conn.getPhase() == RequestPhase::ReadBody);
+
+        REQUIRE(conn.expirePhase(RequestPhase::ReadBody));
+        REQUIRE(conn.shouldClose());
+        REQUIRE(std::string(conn.getPendingOutput(), conn.getPendingOutputSize()).find("HTTP/1.1 408 ") == 0);
+        REQUIRE(conn.getPhase() == RequestPhase::WriteResponse);
+        REQUIRE_FALSE(conn.expirePhase(RequestPhase::WriteResponse));
+    }
+
+    SECTION("idle") {
+        // Idle connections are closed without response.
+        restify::HttpServerConnection conn;
+        REQUIRE_FALSE(conn.expirePhase(RequestPhase::ReadHeader));
+        REQUIRE(conn.getPendingOutputSize() == 0);
+    }
+
+    SECTION("write-progress") {
+        restify::HttpServerConnection conn;
+        const std::string req = "GET /a HTTP/1.1\r\n\r\n";
+        conn.receive(req.data(), req.size());
+        conn.process(handler, ctx);
+        REQUIRE(conn.getPhase() == RequestPhase::WriteResponse);
+        REQUIRE(conn.getBytesSent() == 0);
+
+        conn.consumeOutput(10);
+        REQUIRE(conn.getBytesSent() == 10);
+        conn.consumeOutput(conn.getPendingOutputSize());
+        REQUIRE(conn.getPhase() == RequestPhase::ReadHeader);
+    }
+
+    SECTION("handler") {
+        SuspendableConnection conn;
+        const std::string req = "GET /deferred HTTP/1.1\r\n\r\n";
+        conn.receive(req.data(), req.size());
+        conn.process(handler, ctx);
+        REQUIRE(conn.isSuspended());
+        REQUIRE(conn.getPhase() == RequestPhase::Handler);
+        REQUIRE(conn.getPhaseTimeout(RequestPhase::Handler) == 50);
+        REQUIRE(conn.getPhaseTimeout(RequestPhase::WriteResponse) == 60000);
+
+        REQUIRE(conn.expirePhase(RequestPhase::Handler));
+        REQUIRE_FALSE(conn.isSuspended());
+        REQUIRE(conn.getDeferredCount() == 0);
+        REQUIRE(conn.shouldClose());
+        REQUIRE(std::string(conn.getPendingOutput(), conn.getPendingOutputSize()).find("HTTP/1.1 503 ") == 0);
+    }
+
+    SECTION("streaming") {
+        // Suspended after the response began, e.g. an event stream.
+        SuspendableConnection conn;
+        const std::string req = "GET /deferred HTTP/1.1\r\n\r\n";
+        conn.receive(req.data(), req.size());
+        conn.process(handler, ctx);
+        resumer([](restify::Connection &c) {
+            c.write("HTTP/1.1 200 OK\r\n\r\n", 19);
+            c.suspend();
+        });
+        conn.resume(conn.tasks[0]);
+        REQUIRE(conn.isSuspended());
+        REQUIRE(conn.getPhase() == RequestPhase::WriteResponse);
+        conn.consumeOutput(conn.getPendingOutputSize());
+        REQUIRE(conn.getPhase() == RequestPhase::None);
+    }
+}
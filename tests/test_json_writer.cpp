@@ -0,0 +1,87 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/json_writer.h>
+#include <restify/helpers.h>
+#include <json/json.h>
+#include <string>
+#include <limits>
+
+static std::string writeJson(const Json::Value &v, size_t bufferSize, int *flushes = nullptr) {
+    std::string out;
+    int count = 0;
+    restify::JsonStreamWriter w([&](const char *data, size_t length) {
+        out.append(data, length);
+        ++count;
+    }, bufferSize);
+    w.write(v).flush();
+    if (flushes)
+        *flushes = count;
+    return out;
+}
+
+TEST_CASE("json-writer-matches-fastwriter")
+{
+    Json::Value doc = restify::json()
+        ("name", "restify")
+        ("count", 42)
+        ("negative", -17)
+        ("big", Json::UInt64(18446744073709551615ULL))
+        ("flag", true)
+        ("nothing", Json::Value())
+        ("nested.list", restify::json("[1, \"two\", [3], {\"four\": false}]"))
+        ("escaped", std::string("quote\" back\\ tab\t nl\n ctrl\x01 utf8 \xc3\xa4 long string without escapes"));
+
+    Json::FastWriter fw;
+    fw.omitEndingLineFeed();
+
+    REQUIRE(writeJson(doc, 8192) == fw.write(doc));
+    REQUIRE(writeJson(Json::Value(Json::arrayValue), 8192) == "[]");
+    REQUIRE(writeJson(Json::Value(Json::objectValue), 8192) == "{}");
+}
+
+TEST_CASE("json-writer-flushes-when-full")
+{
+    Json::Value doc(Json::arrayValue);
+    for (int i = 0; i < 1000; ++i)
+        doc.append(restify::json()("index", i)("text", "some text that needs \"escaping\""));
+
+    Json::FastWriter fw;
+    fw.omitEndingLineFeed();
+
+    int flushes = 0;
+    REQUIRE(writeJson(doc, 64, &flushes) == fw.write(doc));
+    REQUIRE(flushes > 100);
+}
+
+TEST_CASE("json-writer-numbers")
+{
+    using restify::JsonStreamWriter;
+    char buf[32];
+
+    REQUIRE(std::string(buf, JsonStreamWriter::formatInt(0, buf)) == "0");
+    REQUIRE(std::string(buf, JsonStreamWriter::formatInt(-7, buf)) == "-7");
+    REQUIRE(std::string(buf, JsonStreamWriter::formatInt(std::numeric_limits<int64_t>::min(), buf)) == "-9223372036854775808");
+    REQUIRE(std::string(buf, JsonStreamWriter::formatUInt(std::numeric_limits<uint64_t>::max(), buf)) == "18446744073709551615");
+
+    REQUIRE(std::string(buf, JsonStreamWriter::formatDouble(1.0, buf)) == "1");
+    REQUIRE(std::string(buf, JsonStreamWriter::formatDouble(0.1, buf)) == "0.1");
+    REQUIRE(std::string(buf, JsonStreamWriter::formatDouble(-2.5, buf)) == "-2.5");
+    REQUIRE(std::string(buf, JsonStreamWriter::formatDouble(1e300, buf)) == "1e+300");
+    REQUIRE(std::string(buf, JsonStreamWriter::formatDouble(std::numeric_limits<double>::infinity(), buf)) == "null");
+
+    const double values[] = { 3.141592653589793, 1.0 / 3.0, 2.2250738585072014e-308, 123456.789 };
+    for (double v : values) {
+        size_t n = JsonStreamWriter::formatDouble(v, buf);
+        REQUIRE(std::strtod(std::string(buf, n).c_str(), nullptr) == v);
+    }
+}
@@ -0,0 +1,182 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/server.h>
+#include <restify/request.h>
+#include <restify/response.h>
+#include <restify/helpers.h>
+#include <restify/executor.h>
+#include <restify/response_completion.h>
+#include <restify/loopback/loopback_backend.h>
+#include <json/json.h>
+#include <thread>
+#include <chrono>
+
+namespace {
+    /** Server on a loopback backend with a few routes. */
+    struct LoopbackFixture {
+        restify::Server server;
+        std::shared_ptr<restify::LoopbackBackend> backend;
+
+        LoopbackFixture()
+            :backend(std::make_shared<restify::LoopbackBackend>())
+        {
+            server.setBackend(backend);
+            server.route(restify::json()("path", "/hello"), [](const restify::Request &req, restify::Response &rep) {
+                rep.setCode(200).setBody("hello world");
+                return true;
+            });
+            server.route(restify::json()("path", "/items/:id")("methods", "POST"), [](const restify::Request &req, restify::Response &rep) {
+                rep.setCode(201).setBody(restify::json()("id", req.getParam("id"))("value", req.getBody()["value"]));
+                return true;
+            });
+            server.routeAsync(restify::json()("path", "/later"), [](const restify::Request &req, restify::Response &rep, const restify::ResponseCompletion &done) {
+                std::thread([&rep, done]() {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    rep.setCode(200).setBody("later");
+                    done.complete();
+                }).detach();
+            });
+            server.start();
+        }
+    };
+
+    std::string bodyOf(const std::string &response) {
+        const size_t head = response.find("\r\n\r\n");
+        return head == std::string::npos ? std::string() : response.substr(head + 4);
+    }
+}
+
+TEST_CASE_METHOD(LoopbackFixture, "loopback-backend")
+{
+    std::string response = backend->exchange("GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+    REQUIRE(response.find("Content-Length: 11\r\n") != std::string::npos);
+    REQUIRE(bodyOf(response) == "hello world");
+
+    response = backend->exchange(
+        "POST /items/42 HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\nContent-Length: 12\r\n\r\n"
+        "{\"value\": 3}");
+    REQUIRE(response.find("HTTP/1.1 201 ") == 0);
+
+    Json::Value body;
+    REQUIRE(Json::Reader().parse(bodyOf(response), body));
+    REQUIRE(body["id"] == "42");
+    REQUIRE(body["value"] == 3);
+
+    response = backend->exchange("GET /missing HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    REQUIRE(response.find("HTTP/1.1 404 ") == 0);
+
+    response = backend->exchange("GET /later HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+    REQUIRE(bodyOf(response) == "later");
+}
+
+TEST_CASE_METHOD(LoopbackFixture, "loopback-connection")
+{
+    std::unique_ptr<restify::LoopbackConnection> c = backend->connect();
+
+    // Incomplete requests wait for the remaining bytes.
+    const std::string request = "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    std::string response;
+    REQUIRE(backend->exchange(*c, request.data(), 10, response));
+    REQUIRE(response.empty());
+    REQUIRE(backend->exchange(*c, request.data() + 10, request.size() - 10, response));
+    REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+    REQUIRE(response.find("Connection: keep-alive\r\n") != std::string::npos);
+
+    // Pipelined requests are answered in order, deferred ones included.
+    const std::string pipelined =
+        "GET /later HTTP/1.1\r\nHost: localhost\r\n\r\n"
+        "GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    response.clear();
+    REQUIRE(backend->exchange(*c, pipelined.data(), pipelined.size(), response));
+
+    const size_t second = response.find("HTTP/1.1 200 OK\r\n", 1);
+    REQUIRE(second != std::string::npos);
+    REQUIRE(response.substr(0, second).find("later") != std::string::npos);
+    REQUIRE(response.find("Connection: close\r\n", second) != std::string::npos);
+    REQUIRE(bodyOf(response.substr(second)) == "hello world");
+    REQUIRE(c->getRequestCount() == 3);
+
+    // Closed connections take no further requests.
+    response.clear();
+    REQUIRE(!backend->exchange(*c, request.data(), request.size(), response));
+    REQUIRE(response.empty());
+}
+
+TEST_CASE_METHOD(LoopbackFixture, "loopback-executor")
+{
+    server.setExecutor(std::make_shared<restify::WorkStealingExecutor>(2));
+
+    std::unique_ptr<restify::LoopbackConnection> c = backend->connect();
+    const std::string request = "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    for (int i = 0; i < 10; ++i) {
+        std::string response;
+        REQUIRE(backend->exchange(*c, request.data(), request.size(), response));
+        REQUIRE(bodyOf(response) == "hello world");
+    }
+}
+
+TEST_CASE("loopback-http10-framing")
+{
+    restify::Server server;
+    std::shared_ptr<restify::LoopbackBackend> backend = std::make_shared<restify::LoopbackBackend>();
+    server.setBackend(backend);
+
+    Json::Value items(Json::arrayValue);
+    for (int i = 0; i < 2000; ++i)
+        items.append(restify::json()("id", i)("name", "item"));
+
+    server.route(restify::json()("path", "/items"), [items](const restify::Request &req, restify::Response &rep) {
+        rep.setBody(restify::json()("items", items));
+        return true;
+    });
+    server.route(restify::json()("path", "/export"), [](const restify::Request &req, restify::Response &rep) {
+        auto count = std::make_shared<int>(0);
+        rep.setBodyStream([count](std::string &chunk) {
+            chunk.append("row").append(std::to_string(*count)).append("\n");
+            return ++(*count) < 100;
+        }, 64);
+        return true;
+    });
+    server.start();
+
+    std::string expected;
+    for (int i = 0; i < 100; ++i)
+        expected.append("row").append(std::to_string(i)).append("\n");
+
+    // Large documents go out chunked to HTTP/1.1 clients only, HTTP/1.0 clients get a length.
+    std::string response = backend->exchange("GET /items HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    REQUIRE(response.find("Transfer-Encoding: chunked\r\n") != std::string::npos);
+
+    response = backend->exchange("GET /items HTTP/1.0\r\nHost: localhost\r\n\r\n");
+    REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+    REQUIRE(response.find("Transfer-Encoding") == std::string::npos);
+    REQUIRE(response.find("Content-Length: " + std::to_string(bodyOf(response).size()) + "\r\n") != std::string::npos);
+
+    Json::Value body;
+    REQUIRE(Json::Reader().parse(bodyOf(response), body));
+    REQUIRE(body["items"] == items);
+
+    // Streamed bodies to HTTP/1.0 clients end with the connection.
+    std::unique_ptr<restify::LoopbackConnection> c = backend->connect();
+    const std::string request = "GET /export HTTP/1.0\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n";
+    response.clear();
+    REQUIRE(backend->exchange(*c, request.data(), request.size(), response));
+    REQUIRE(response.find("Transfer-Encoding") == std::string::npos);
+    REQUIRE(response.find("Connection: close\r\n") != std::string::npos);
+    REQUIRE(bodyOf(response) == expected);
+
+    response.clear();
+    REQUIRE(!backend->exchange(*c, request.data(), request.size(), response));
+}
@@ -0,0 +1,83 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/object_pool.h>
+#include <string>
+#include <thread>
+
+namespace {
+    struct Buffer {
+        std::string data;
+    };
+}
+
+namespace restify {
+    template<>
+    struct ObjectPoolTraits<Buffer> {
+        enum { Capacity = 2 };
+
+        static Buffer *create() {
+            return new Buffer();
+        }
+
+        static void recycle(Buffer &b) {
+            b.data.clear();
+        }
+    };
+}
+
+TEST_CASE("object-pool")
+{
+    using restify::ObjectPool;
+
+    REQUIRE(ObjectPool<Buffer>::getCachedCount() == 0);
+
+    const char *storage = nullptr;
+    {
+        ObjectPool<Buffer>::Ptr b = ObjectPool<Buffer>::acquire();
+        b->data.assign(1000, 'x');
+        storage = b->data.data();
+    }
+    REQUIRE(ObjectPool<Buffer>::getCachedCount() == 1);
+
+    // Recycled object keeps its capacity.
+    {
+        ObjectPool<Buffer>::Ptr b = ObjectPool<Buffer>::acquire();
+        REQUIRE(ObjectPool<Buffer>::getCachedCount() == 0);
+        REQUIRE(b->data.empty());
+        REQUIRE(b->data.capacity() >= 1000);
+        REQUIRE(b->data.data() == storage);
+    }
+
+    // Objects beyond capacity are deleted.
+    {
+        ObjectPool<Buffer>::Ptr a = ObjectPool<Buffer>::acquire();
+        ObjectPool<Buffer>::Ptr b = ObjectPool<Buffer>::acquire();
+        std::shared_ptr<Buffer> c = ObjectPool<Buffer>::acquireShared();
+    }
+    REQUIRE(ObjectPool<Buffer>::getCachedCount() == 2);
+
+    // Each thread has its own cache, objects return to the releasing thread.
+    std::shared_ptr<Buffer> shared = ObjectPool<Buffer>::acquireShared();
+    REQUIRE(ObjectPool<Buffer>::getCachedCount() == 1);
+
+    size_t cachedInThread = 0;
+    std::thread t([&]() {
+        REQUIRE(ObjectPool<Buffer>::getCachedCount() == 0);
+        shared.reset();
+        cachedInThread = ObjectPool<Buffer>::getCachedCount();
+    });
+    t.join();
+
+    REQUIRE(cachedInThread == 1);
+    REQUIRE(ObjectPool<Buffer>::getCachedCount() == 1);
+}
@@ -80,4 +80,25 @@ TEST_CASE("request-query-string")
     REQUIRE(json_cast<std::string>(r.getParam("b")) == "hugo");
     REQUIRE(json_cast<bool>(r.getParam("c")) == true);
     */
-}
\ No newline at end of file
+}
+TEST_CASE("request-clear")
+{
+    using restify::Request;
+
+    Request r(restify::json()
+        (Request::Keys::method, "POST")
+        (Request::Keys::path, "/a")
+        ("params.a", 3)
+        ("headers.Content-Type", "text/plain")
+        ("body.value", 1));
+
+    r.clear();
+    REQUIRE(r.getMethod() == "GET");
+    REQUIRE(r.getPath() == "/");
+    REQUIRE(r.getParams().isObject());
+    REQUIRE(r.getParams().size() == 0);
+    REQUIRE(r.getHeaders().isObject());
+    REQUIRE(r.getHeaders().size() == 0);
+    REQUIRE(r.getBody() == "");
+    REQUIRE(r.toJson() == Request().toJson());
+}
@@ -0,0 +1,80 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/request_arena.h>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+TEST_CASE("request-arena")
+{
+    using restify::RequestArena;
+
+    RequestArena arena(256, 1024);
+    REQUIRE(arena.getUsed() == 0);
+    // Chunks are allocated on first use.
+    REQUIRE(arena.getCapacity() == 0);
+
+    void *a = arena.allocate(10, 1);
+    void *b = arena.allocate(8, 16);
+    REQUIRE(a != nullptr);
+    REQUIRE((reinterpret_cast<uintptr_t>(b) % 16) == 0);
+    memset(a, 1, 10);
+    memset(b, 2, 8);
+
+    // Larger than the first chunk.
+    void *c = arena.allocate(1000);
+    memset(c, 3, 1000);
+    REQUIRE(arena.getUsed() >= 1018);
+    const size_t capacity = arena.getCapacity();
+    REQUIRE(capacity >= 1256);
+
+    arena.reset();
+    REQUIRE(arena.getUsed() == 0);
+    REQUIRE(arena.getHighWaterMark() >= 1018);
+    REQUIRE(arena.getCapacity() <= capacity);
+    REQUIRE(arena.getCapacity() >= 256);
+
+    // Chunks are reused after reset.
+    void *d = arena.allocate(10, 1);
+    REQUIRE(d == a);
+}
+
+TEST_CASE("request-arena-allocator")
+{
+    using namespace restify;
+
+    RequestArena arena;
+    {
+        RequestArena::Scope scope(&arena);
+        REQUIRE(RequestArena::current() == &arena);
+
+        ArenaString s("a string that does not fit into the small string buffer");
+        const size_t length = s.size();
+        s.append(100, 'x');
+        REQUIRE(s.size() == length + 100);
+        REQUIRE(s.get_allocator().getArena() == &arena);
+
+        std::vector<int, ArenaAllocator<int>> v;
+        for (int i = 0; i < 100; ++i)
+            v.push_back(i);
+        REQUIRE(v[99] == 99);
+        REQUIRE(arena.getUsed() >= 100 * sizeof(int));
+    }
+    REQUIRE(RequestArena::current() == nullptr);
+
+    // Without active arena allocations fall back to the heap.
+    const size_t used = arena.getUsed();
+    ArenaString s("another string that does not fit into the small string buffer");
+    REQUIRE(s.get_allocator().getArena() == nullptr);
+    REQUIRE(arena.getUsed() == used);
+}
@@ -29,3 +29,69 @@ TEST_CASE("response")
     REQUIRE(c["body"]["message"].asString() == "Not found.");
     REQUIRE(c["statusCode"].asInt() == 404);
 }
+
+TEST_CASE("response-body-stream")
+{
+    restify::Response r;
+    r.setBody("hello");
+
+    int calls = 0;
+    r.setBodyStream([&calls](std::string &chunk) {
+        chunk.append("x");
+        return ++calls < 3;
+    }, 16);
+
+    REQUIRE(r.getBodyStream());
+    REQUIRE(r.getBodyStreamChunkSize() == 16);
+    REQUIRE(!r.toJson().isMember("body"));
+
+    r.setBody("hello");
+    REQUIRE(!r.getBodyStream());
+    REQUIRE(r.toJson()["body"] == "hello");
+}
+
+TEST_CASE("response-raw-body")
+{
+    auto payload = std::make_shared<const std::string>(R"({"cached":true})");
+
+    restify::Response a, b;
+    a.setRawBody(payload);
+    b.setRawBody(payload, "application/vnd.api+json");
+
+    REQUIRE(a.getRawBody().get() == payload.get());
+    REQUIRE(b.getRawBody().get() == payload.get());
+    REQUIRE(a.getRawBodyContentType() == "application/json; charset=utf-8");
+    REQUIRE(b.getRawBodyContentType() == "application/vnd.api+json");
+
+    a.setBody("text");
+    REQUIRE(!a.getRawBody());
+}
+
+TEST_CASE("response-binary-body")
+{
+    const char bytes[] = { 'P', 'N', 'G', 0, 1, 2 };
+
+    restify::Response r;
+    r.setBinaryBody(bytes, sizeof(bytes), "image/png");
+
+    REQUIRE(r.getRawBody()->size() == sizeof(bytes));
+    REQUIRE(r.getRawBodyContentType() == "image/png");
+    REQUIRE(!r.toJson().isMember("body"));
+
+    r.setBinaryBody(std::string("abc"));
+    REQUIRE(*r.getRawBody() == "abc");
+    REQUIRE(r.getRawBodyContentType() == "application/octet-stream");
+}
+
+TEST_CASE("response-clear")
+{
+    restify::Response r;
+    r.setCode(404).setHeader("X-A", "b").setBody(restify::json()("a", 1));
+    r.clear();
+    REQUIRE(r.toJson() == restify::Response().toJson());
+
+    r.setRawBody(std::make_shared<const std::string>("x"), "text/plain");
+    r.clear();
+    REQUIRE(!r.getRawBody());
+    REQUIRE(r.toJson() == restify::Response().toJson());
+}
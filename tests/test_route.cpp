@@ -14,7 +14,11 @@ of MIT license. See the LICENSE file for details.
 #include <restify/request.h>
 #include <restify/response.h>
 #include <restify/helpers.h>
+#include <restify/response_completion.h>
+#include <restify/error.h>
 #include <json/json.h>
+#include <thread>
+#include <memory>
 
 TEST_CASE("route-param")
 {
@@ -89,4 +93,60 @@ TEST_CASE("route-param")
     REQUIRE(json_cast<int>(extracted["number"]) == 45663);
 
 
-}
\ No newline at end of file
+}
+
+TEST_CASE("route-async")
+{
+    using namespace restify;
+
+    // Only the first completion counts, dropping all copies fails the response.
+    std::vector<bool> results;
+    {
+        ResponseCompletion done([&results](std::exception_ptr error) {
+            results.push_back(error == nullptr);
+        });
+        ResponseCompletion copy = done;
+        REQUIRE_FALSE(copy.isDone());
+        REQUIRE(copy.complete());
+        REQUIRE(done.isDone());
+        REQUIRE_FALSE(done.fail(Error(StatusCode::BadRequest)));
+    }
+    {
+        ResponseCompletion done([&results](std::exception_ptr error) {
+            results.push_back(error == nullptr);
+        });
+    }
+    REQUIRE(results.size() == 2);
+    REQUIRE(results[0]);
+    REQUIRE_FALSE(results[1]);
+
+    // Synchronous call waits for completion from another thread.
+    ParameterRoute r(
+        json()("path", "/users"),
+        AsyncRequestHandler([](const Request &req, Response &rep, const ResponseCompletion &done) {
+            std::thread([&rep, done]() {
+                rep.setCode(200).setBody("later");
+                done.complete();
+            }).detach();
+        }));
+    REQUIRE(r.isAsync());
+
+    Request req;
+    Response rep;
+    r.call(req, rep);
+    REQUIRE(rep.toJson()[Response::Keys::statusCode] == 200);
+
+    // Synchronous handlers complete immediately.
+    ParameterRoute s(
+        json()("path", "/users"),
+        RequestHandler([](const Request &req, Response &rep) -> bool {
+            throw Error(StatusCode::Conflict);
+        }));
+    REQUIRE_FALSE(s.isAsync());
+
+    std::exception_ptr failure;
+    s.call(req, rep, ResponseCompletion([&failure](std::exception_ptr error) {
+        failure = error;
+    }));
+    REQUIRE(failure != nullptr);
+}
@@ -18,12 +18,41 @@ of MIT license. See the LICENSE file for details.
 #include <restify/helpers.h>
 #include <restify/error.h>
 #include <restify/handler.h>
+#include <restify/executor.h>
+#include <restify/response_completion.h>
+#include <restify/listener_handoff.h>
+#include <restify/thread_placement.h>
 #include <json/json.h>
+#include "restify_build_config.h"
+#ifdef CPPRESTIFY_WITH_EPOLL
+#include <restify/epoll/epoll_backend.h>
+#endif
+#ifdef CPPRESTIFY_WITH_URING
+#include <restify/uring/uring_backend.h>
+#endif
+#ifdef CPPRESTIFY_WITH_COROUTINES
+#include <restify/coroutine.h>
+#endif
 
 #include <future>
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <vector>
 #include <iostream>
 
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
 #define CPPRESTIFY_REQUIRE_RESPOND(future, timeout) \
     REQUIRE((future).wait_for(std::chrono::milliseconds(timeout)) == std::future_status::ready);
 
@@ -234,6 +263,1355 @@ TEST_CASE_METHOD(ServerFixture, "server-routes-with-otherwise") {
     REQUIRE(response["body"] == "Welcome!");
 }
 
+TEST_CASE_METHOD(ServerFixture, "server-stream-body") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+    );
+    _server.route(
+        restify::json()("path", "/export"),
+        [](const restify::Request &req, restify::Response &rep) {
+
+        auto count = std::make_shared<int>(0);
+        rep.setHeader("Content-Type", "text/csv");
+        rep.setBodyStream([count](std::string &chunk) {
+            chunk.append("row").append(std::to_string(*count)).append("\n");
+            return ++(*count) < 100;
+        }, 64);
+
+        return true;
+    });
+    _server.start();
+
+    Json::Value response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/export"));
+
+    std::string expected;
+    for (int i = 0; i < 100; ++i)
+        expected.append("row").append(std::to_string(i)).append("\n");
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["statusCode"] == 200);
+    REQUIRE(response["headers"]["Transfer-Encoding"] == "chunked");
+    REQUIRE(response["headers"]["Content-Type"] == "text/csv");
+    REQUIRE(response["body"] == expected);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-raw-body") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+    );
+
+    auto cached = std::make_shared<const std::string>(R"({"id":1,"name":"Bar"})");
+    _server.route(
+        restify::json()("path", "/cached"),
+        [cached](const restify::Request &req, restify::Response &rep) {
+        rep.setRawBody(cached);
+        return true;
+    });
+    _server.start();
+
+    for (int i = 0; i < 2; ++i) {
+        Json::Value response = restify::Client::invoke(
+            restify::json()
+            ("url", "http://127.0.0.1:8080/cached"));
+
+        REQUIRE(response["success"] == true);
+        REQUIRE(response["statusCode"] == 200);
+        REQUIRE(response["headers"]["Content-Type"] == "application/json; charset=utf-8");
+        REQUIRE(response["body"] == restify::json()("id", 1)("name", "Bar"));
+    }
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-large-json") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+    );
+
+    Json::Value items(Json::arrayValue);
+    for (int i = 0; i < 2000; ++i)
+        items.append(restify::json()("id", i)("name", "item"));
+
+    _server.route(
+        restify::json()("path", "/items"),
+        [items](const restify::Request &req, restify::Response &rep) {
+        rep.setBody(restify::json()("items", items));
+        return true;
+    });
+    _server.route(
+        restify::json()("path", "/small"),
+        [](const restify::Request &req, restify::Response &rep) {
+        rep.setBody(restify::json()("id", 1));
+        return true;
+    });
+    _server.start();
+
+    Json::Value response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/items"));
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["statusCode"] == 200);
+    REQUIRE(response["headers"]["Transfer-Encoding"] == "chunked");
+    REQUIRE(response["body"]["items"] == items);
+
+    response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/small"));
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["headers"]["Content-Length"] == "8");
+    REQUIRE(response["body"] == restify::json()("id", 1));
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-array-and-binary-body") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+    );
+    _server.route(
+        restify::json()("path", "/list"),
+        [](const restify::Request &req, restify::Response &rep) {
+        rep.setBody(restify::json("[1, 2, {\"id\": 3}]"));
+        return true;
+    });
+    _server.route(
+        restify::json()("path", "/count"),
+        [](const restify::Request &req, restify::Response &rep) {
+        rep.setBody(42);
+        return true;
+    });
+    _server.route(
+        restify::json()("path", "/blob"),
+        [](const restify::Request &req, restify::Response &rep) {
+        rep.setBinaryBody(std::string("\x00\x01" "binary\xff", 9));
+        return true;
+    });
+    _server.start();
+
+    Json::Value response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/list"));
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["statusCode"] == 200);
+    REQUIRE(response["headers"]["Content-Type"] == "application/json; charset=utf-8");
+    REQUIRE(response["body"] == restify::json("[1, 2, {\"id\": 3}]").toJson());
+
+    response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/count"));
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["body"] == 42);
+
+    response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/blob"));
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["headers"]["Content-Type"] == "application/octet-stream");
+    REQUIRE(response["headers"]["Content-Length"] == "9");
+    REQUIRE(response["body"].asString() == std::string("\x00\x01" "binary\xff", 9));
+}
+
+#ifndef _WIN32
+/** Plain socket client to observe connection reuse, which restify::Client hides. */
+class RawClient {
+public:
+    RawClient(int port) {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        connect(reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    }
+
+    /** Connect to unix domain socket at path. */
+    RawClient(const std::string &path) {
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        connect(reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    }
+
+    ~RawClient() {
+        ::close(_socket);
+    }
+
+    bool isConnected() const {
+        return _connected;
+    }
+
+    bool send(const std::string &data) {
+        return ::send(_socket, data.data(), data.size(), 0) == (ssize_t)data.size();
+    }
+
+    /** Read one response with Content-Length framing. */
+    std::string readResponse() {
+        size_t headEnd;
+        while ((headEnd = _buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!fill())
+                return std::string();
+        }
+        headEnd += 4;
+
+        size_t contentLength = 0;
+        const size_t cl = _buffer.find("Content-Length: ");
+        if (cl != std::string::npos && cl < headEnd)
+            contentLength = std::stoul(_buffer.substr(cl + 16));
+
+        while (_buffer.size() < headEnd + contentLength) {
+            if (!fill())
+                return std::string();
+        }
+
+        const std::string response = _buffer.substr(0, headEnd + contentLength);
+        _buffer.erase(0, headEnd + contentLength);
+        return response;
+    }
+
+    /** True when the peer closed the connection. */
+    bool isClosedByPeer() {
+        char c;
+        return ::recv(_socket, &c, 1, 0) == 0;
+    }
+
+private:
+    void connect(const sockaddr *addr, socklen_t length) {
+        _socket = ::socket(addr->sa_family, SOCK_STREAM, 0);
+
+        timeval tv = { 5, 0 };
+        setsockopt(_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        _connected = ::connect(_socket, addr, length) == 0;
+    }
+
+    bool fill() {
+        char chunk[1024];
+        const ssize_t n = ::recv(_socket, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return false;
+        _buffer.append(chunk, (size_t)n);
+        return true;
+    }
+
+    int _socket;
+    bool _connected;
+    std::string _buffer;
+};
+
+static void requireKeepAlive(RawClient &client) {
+    REQUIRE(client.isConnected());
+
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(client.send("GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+        const std::string response = client.readResponse();
+        REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+        REQUIRE(response.find("Connection: keep-alive\r\n") != std::string::npos);
+        REQUIRE(response.substr(response.size() - 11) == "hello world");
+    }
+
+    REQUIRE(client.send("GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n"));
+    const std::string response = client.readResponse();
+    REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+    REQUIRE(response.find("Connection: close\r\n") != std::string::npos);
+    REQUIRE(client.isClosedByPeer());
+}
+
+static void requireKeepAlive(int port) {
+    RawClient client(port);
+    requireKeepAlive(client);
+}
+
+/** Start server listening on port and path with a stale socket file in the way, check both serve requests. */
+static void requireUnixListener(restify::Server &server, int port, const std::string &path) {
+    // Socket file of a process that exited without unlinking it.
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    const int stale = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(::bind(stale, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    ::close(stale);
+
+    server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    server.start();
+
+    struct stat st;
+    REQUIRE(::stat(path.c_str(), &st) == 0);
+    REQUIRE(S_ISSOCK(st.st_mode));
+    REQUIRE((st.st_mode & 0777) == 0660);
+
+    RawClient local(path);
+    requireKeepAlive(local);
+    requireKeepAlive(port);
+
+    server.stop();
+    ::unlink(path.c_str());
+}
+
+/** Add asynchronous routes to server, start it and check deferred responses on port. */
+static void requireAsyncHandlers(restify::Server &server, int port) {
+    struct Parked {
+        std::mutex mutex;
+        restify::Response *response = nullptr;
+        std::unique_ptr<restify::ResponseCompletion> done;
+    };
+    std::shared_ptr<Parked> parked = std::make_shared<Parked>();
+
+    server.routeAsync(
+        restify::json()("path", "/later"),
+        [](const restify::Request &req, restify::Response &rep, const restify::ResponseCompletion &done) {
+        std::thread([&rep, done]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            rep.setCode(200).setBody("later");
+            done.complete();
+        }).detach();
+    });
+    server.routeAsync(
+        restify::json()("path", "/parked"),
+        [parked](const restify::Request &req, restify::Response &rep, const restify::ResponseCompletion &done) {
+        std::lock_guard<std::mutex> lock(parked->mutex);
+        parked->response = &rep;
+        parked->done.reset(new restify::ResponseCompletion(done));
+    });
+    server.route(
+        restify::json()("path", "/release"),
+        [parked](const restify::Request &req, restify::Response &rep) {
+        std::lock_guard<std::mutex> lock(parked->mutex);
+        parked->response->setCode(200).setBody("released");
+        parked->done->complete();
+        parked->done.reset();
+        rep.setCode(200).setBody("ok");
+        return true;
+    });
+    server.routeAsync(
+        restify::json()("path", "/dropped"),
+        [](const restify::Request &req, restify::Response &rep, const restify::ResponseCompletion &done) {
+    });
+    server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    server.start();
+
+    RawClient a(port);
+    REQUIRE(a.isConnected());
+    for (int i = 0; i < 2; ++i) {
+        REQUIRE(a.send("GET /later HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+        const std::string response = a.readResponse();
+        REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+        REQUIRE(response.find("Connection: keep-alive\r\n") != std::string::npos);
+        REQUIRE(response.substr(response.size() - 5) == "later");
+    }
+
+    // A parked response does not keep other connections from being served.
+    REQUIRE(a.send("GET /parked HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+    for (int i = 0; i < 500; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(parked->mutex);
+            if (parked->done)
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    RawClient b(port);
+    REQUIRE(b.isConnected());
+    REQUIRE(b.send("GET /release HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+    std::string response = b.readResponse();
+    REQUIRE(response.substr(response.size() - 2) == "ok");
+
+    response = a.readResponse();
+    REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+    REQUIRE(response.substr(response.size() - 8) == "released");
+
+    REQUIRE(a.send("GET /dropped HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+    response = a.readResponse();
+    REQUIRE(response.find("HTTP/1.1 500 ") == 0);
+
+    requireKeepAlive(port);
+}
+
+/** Poll backend admission statistics until key reaches value. */
+static Json::Value waitForBackendStatistics(restify::Server &server, const char *group, const char *key, int value) {
+    Json::Value stats;
+    for (int i = 0; i < 500; ++i) {
+        stats = server.getStatistics()["backend"][group];
+        if (stats[key].asInt() == value)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return stats;
+}
+
+static Json::Value waitForAdmission(restify::Server &server, const char *key, int value) {
+    return waitForBackendStatistics(server, "admission", key, value);
+}
+
+/** Add a route parking its response, start server with max_in_flight 1 and check shedding on port. */
+static void requireLoadShedding(restify::Server &server, int port) {
+    struct Parked {
+        std::mutex mutex;
+        restify::Response *response = nullptr;
+        std::unique_ptr<restify::ResponseCompletion> done;
+    };
+    std::shared_ptr<Parked> parked = std::make_shared<Parked>();
+
+    server.routeAsync(
+        restify::json()("path", "/parked"),
+        [parked](const restify::Request &req, restify::Response &rep, const restify::ResponseCompletion &done) {
+        std::lock_guard<std::mutex> lock(parked->mutex);
+        parked->response = &rep;
+        parked->done.reset(new restify::ResponseCompletion(done));
+    });
+    server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    server.start();
+
+    RawClient a(port);
+    REQUIRE(a.isConnected());
+    REQUIRE(a.send("GET /parked HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+    REQUIRE(waitForAdmission(server, "inFlight", 1)["inFlight"].asInt() == 1);
+
+    {
+        RawClient b(port);
+        REQUIRE(b.isConnected());
+        REQUIRE(b.send("GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+        const std::string response = b.readResponse();
+        REQUIRE(response.find("HTTP/1.1 503 ") == 0);
+        REQUIRE(response.find("Retry-After: 2\r\n") != std::string::npos);
+        REQUIRE(b.isClosedByPeer());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(parked->mutex);
+        parked->response->setCode(200).setBody("released");
+        parked->done->complete();
+        parked->done.reset();
+    }
+    std::string response = a.readResponse();
+    REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+
+    Json::Value stats = waitForAdmission(server, "inFlight", 0);
+    REQUIRE(stats["inFlight"].asInt() == 0);
+    REQUIRE(stats["shed"]["inFlight"].asInt() == 1);
+
+    requireKeepAlive(port);
+}
+
+/** Add a slow route, start server and check draining completes requests in flight and closes idle connections. */
+static void requireDrain(restify::Server &server, int port) {
+    std::shared_ptr<std::promise<void>> entered = std::make_shared<std::promise<void>>();
+    server.route(
+        restify::json()("path", "/slow"),
+        [entered](const restify::Request &req, restify::Response &rep) {
+        entered->set_value();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        rep.setCode(200).setBody("slow");
+        return true;
+    });
+    server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    server.start();
+
+    RawClient idle(port);
+    REQUIRE(idle.send("GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+    REQUIRE(idle.readResponse().find("HTTP/1.1 200 OK\r\n") == 0);
+
+    RawClient busy(port);
+    REQUIRE(busy.send("GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+    CPPRESTIFY_REQUIRE_RESPOND(entered->get_future(), 5000);
+
+    std::vector<size_t> progress;
+    std::future<bool> drained = std::async(std::launch::async, [&server, &progress]() {
+        return server.drain(5000, [&progress](size_t open) { progress.push_back(open); });
+    });
+
+    REQUIRE(idle.isClosedByPeer());
+
+    const std::string response = busy.readResponse();
+    REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+    REQUIRE(response.find("Connection: close\r\n") != std::string::npos);
+    REQUIRE(response.substr(response.size() - 4) == "slow");
+    REQUIRE(busy.isClosedByPeer());
+
+    REQUIRE(drained.get());
+    REQUIRE(progress.size() >= 2);
+    REQUIRE(progress.front() >= 1);
+    REQUIRE(progress.back() == 0);
+
+    RawClient late(port);
+    REQUIRE(!late.isConnected());
+}
+
+/** Start first, hand its listeners to second and drain first. Requests keep being served on port. */
+static void requireListenerHandoff(restify::Server &first, restify::Server &second, int port) {
+    first.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("first");
+        return true;
+    });
+    second.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("second");
+        return true;
+    });
+    first.start();
+
+    RawClient before(port);
+    REQUIRE(before.send("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+    std::string response = before.readResponse();
+    REQUIRE(response.substr(response.size() - 5) == "first");
+
+    const std::string path = "/tmp/cpp-restify-test-" + std::to_string(getpid()) + ".handoff";
+    const std::vector<int> offered = first.getListeningSockets();
+    REQUIRE(!offered.empty());
+    std::future<bool> handedOff = std::async(std::launch::async, [&path, &offered]() {
+        return restify::ListenerHandoff::offer(path, offered, 5000);
+    });
+
+    std::vector<int> sockets;
+    REQUIRE(restify::ListenerHandoff::claim(path, sockets, 5000));
+    REQUIRE(handedOff.get());
+    REQUIRE(sockets.size() == offered.size());
+
+    second.setConfig(restify::json()("backend.listening_sockets", restify::ListenerHandoff::toJson(sockets)));
+    second.start();
+    REQUIRE(first.drain(5000));
+    REQUIRE(before.isClosedByPeer());
+
+    for (int i = 0; i < 3; ++i) {
+        RawClient after(port);
+        REQUIRE(after.isConnected());
+        REQUIRE(after.send("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+        response = after.readResponse();
+        REQUIRE(response.substr(response.size() - 6) == "second");
+    }
+    second.stop();
+}
+
+/** Start server pinned to cpus and check handlers run there. */
+static void requireThreadPlacement(restify::Server &server, int port, const std::string &cpus) {
+    server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody(restify::ThreadPlacement::formatCpuList(restify::ThreadPlacement::getCurrentThreadCpus()));
+        return true;
+    });
+    server.start();
+
+    RawClient client(port);
+    REQUIRE(client.send("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+    const std::string response = client.readResponse();
+    REQUIRE(response.find("HTTP/1.1 200 OK\r\n") == 0);
+    REQUIRE(response.substr(response.size() - cpus.size()) == cpus);
+}
+
+/** Expects backend header_timeout_ms to be short, checks slow clients and handlers are cut off. */
+static void requireRequestTimeouts(restify::Server &server, int port) {
+    server.routeAsync(
+        restify::json()
+        ("path", "/stalled")
+        ("timeouts.handler", 200),
+        [](const restify::Request &req, restify::Response &rep, const restify::ResponseCompletion &done) {
+        // Never completes, the handler deadline answers instead.
+        static std::vector<restify::ResponseCompletion> parked;
+        static std::mutex mutex;
+        std::lock_guard<std::mutex> lock(mutex);
+        parked.push_back(done);
+    });
+    server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    server.start();
+
+    // A head trickling in too slowly.
+    RawClient slow(port);
+    REQUIRE(slow.isConnected());
+    REQUIRE(slow.send("GET /hello HTTP/1.1\r\n"));
+    std::string response = slow.readResponse();
+    REQUIRE(response.find("HTTP/1.1 408 ") == 0);
+    REQUIRE(slow.isClosedByPeer());
+
+    // An idle connection is closed without a response.
+    RawClient idle(port);
+    REQUIRE(idle.isConnected());
+    REQUIRE(idle.isClosedByPeer());
+
+    RawClient stalled(port);
+    REQUIRE(stalled.isConnected());
+    REQUIRE(stalled.send("GET /stalled HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+    response = stalled.readResponse();
+    REQUIRE(response.find("HTTP/1.1 503 ") == 0);
+
+    requireKeepAlive(port);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-async-handler") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+    );
+    requireAsyncHandlers(_server, 8080);
+}
+
+#ifdef CPPRESTIFY_WITH_COROUTINES
+TEST_CASE_METHOD(ServerFixture, "server-coroutine-handler") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+    );
+    _server.routeAsync(
+        restify::json()("path", "/users/:id"),
+        restify::coroutineHandler([](const restify::Request &req, restify::Response &rep) -> restify::Task<void> {
+        co_await restify::sleepFor(std::chrono::milliseconds(10));
+        rep.setCode(200).setBody(req.getParam("id"));
+    }));
+    _server.start();
+
+    for (int i = 0; i < 3; ++i) {
+        Json::Value response = restify::Client::invoke(
+            restify::json()
+            ("url", "http://127.0.0.1:8080/users/7"));
+
+        REQUIRE(response["success"] == true);
+        REQUIRE(response["statusCode"] == 200);
+        REQUIRE(response["body"] == "7");
+    }
+}
+#endif
+
+TEST_CASE_METHOD(ServerFixture, "server-arena-statistics") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("arena.statistics", true)
+    );
+    _server.route(
+        restify::json()("path", "/items/:id")("methods", "POST"),
+        [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody(restify::json()("id", req.getParams()["id"])("echo", req.getBody()));
+        return true;
+    });
+    _server.start();
+
+    for (int i = 0; i < 3; ++i) {
+        Json::Value response = restify::Client::invoke(
+            restify::json()
+            ("url", "http://127.0.0.1:8080/items/42")
+            ("method", "POST")
+            ("body.value", std::string(1000, 'x'))
+        );
+        REQUIRE(response["statusCode"] == 200);
+        REQUIRE(response["body"]["id"] == "42");
+        REQUIRE(response["body"]["echo"]["value"].asString().size() == 1000);
+    }
+
+    // Usage is recorded once the response is written, which may be after the client received it.
+    Json::Value stats = _server.getStatistics();
+    for (int i = 0; i < 100 && stats["arena"]["requests"].asUInt64() < 3; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stats = _server.getStatistics();
+    }
+    REQUIRE(stats["arena"]["requests"].asUInt64() == 3);
+    REQUIRE(stats["arena"]["meanHighWaterMark"].asUInt64() > 1000);
+    REQUIRE(stats["arena"]["maxHighWaterMark"].asUInt64() >= stats["arena"]["meanHighWaterMark"].asUInt64());
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-keep-alive") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+    );
+    _server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    _server.start();
+
+    requireKeepAlive(8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-executor") {
+    _server.setExecutor(std::make_shared<restify::WorkStealingExecutor>(2));
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+    );
+    _server.route(
+        restify::json()("path", "/pinned")("affinity", 1),
+        [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("pinned");
+        return true;
+    });
+    _server.route(
+        restify::json()("path", "/fails"),
+        [](const restify::Request &req, restify::Response &rep) -> bool {
+        throw restify::Error(restify::StatusCode::Conflict, "conflict");
+    });
+    _server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    _server.start();
+
+    Json::Value response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/pinned"));
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["statusCode"] == 200);
+    REQUIRE(response["body"] == "pinned");
+
+    response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/fails"));
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["statusCode"] == 409);
+
+    requireKeepAlive(8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-reuse-port-shards") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_shards", 3)
+        ("backend.num_threads", 6)
+    );
+    _server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    _server.start();
+
+    for (int i = 0; i < 10; ++i) {
+        Json::Value response = restify::Client::invoke(
+            restify::json()
+            ("url", "http://127.0.0.1:8080"));
+
+        REQUIRE(response["success"] == true);
+        REQUIRE(response["body"] == "hello world");
+    }
+
+    requireKeepAlive(8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-request-timeouts") {
+    _server.setExecutor(std::make_shared<restify::WorkStealingExecutor>(2));
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 1)
+        ("backend.header_timeout_ms", 300)
+    );
+    requireRequestTimeouts(_server, 8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-load-shedding") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 2)
+        ("backend.max_in_flight", 1)
+        ("backend.retry_after", 2)
+    );
+    requireLoadShedding(_server, 8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-load-shedding-queue") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 1)
+        ("backend.max_queued", 1)
+    );
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    _server.route(
+        restify::json()("path", "/blocked"),
+        [released](const restify::Request &req, restify::Response &rep) {
+        released.wait();
+        rep.setCode(200).setBody("released");
+        return true;
+    });
+    _server.start();
+
+    // The only worker blocks on a, b waits in the queue and c finds it full.
+    RawClient a(8080);
+    REQUIRE(a.send("GET /blocked HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n"));
+    REQUIRE(waitForAdmission(_server, "inFlight", 1)["inFlight"].asInt() == 1);
+
+    RawClient b(8080);
+    REQUIRE(b.send("GET /blocked HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n"));
+    REQUIRE(waitForAdmission(_server, "queued", 1)["queued"].asInt() == 1);
+
+    RawClient c(8080);
+    std::string response = c.readResponse();
+    REQUIRE(response.find("HTTP/1.1 503 ") == 0);
+    REQUIRE(response.find("Retry-After: 1\r\n") != std::string::npos);
+
+    release.set_value();
+    REQUIRE(a.readResponse().find("HTTP/1.1 200 OK\r\n") == 0);
+    REQUIRE(b.readResponse().find("HTTP/1.1 200 OK\r\n") == 0);
+
+    Json::Value stats = waitForAdmission(_server, "queued", 0);
+    REQUIRE(stats["shed"]["queueFull"].asInt() == 1);
+    REQUIRE(stats["admitted"].asInt() == 2);
+}
+TEST_CASE_METHOD(ServerFixture, "server-elastic-workers") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 4)
+        ("backend.min_threads", 1)
+        ("backend.thread_spawn_wait_ms", 5)
+        ("backend.thread_idle_timeout_ms", 100)
+    );
+    _server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        rep.setCode(200).setBody("slow");
+        return true;
+    });
+    _server.start();
+
+    Json::Value workers = _server.getStatistics()["backend"]["workers"];
+    REQUIRE(workers["threads"].asInt() == 1);
+    REQUIRE(workers["min"].asInt() == 1);
+    REQUIRE(workers["max"].asInt() == 4);
+    REQUIRE(workers["spawned"].asInt() == 1);
+
+    {
+        // Connections queue up behind the only worker, the pool grows to serve them in parallel.
+        std::vector<std::unique_ptr<RawClient>> clients;
+        for (int i = 0; i < 4; ++i) {
+            clients.emplace_back(new RawClient(8080));
+            REQUIRE(clients.back()->send("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+        }
+        for (auto &c : clients)
+            REQUIRE(c->readResponse().find("HTTP/1.1 200 OK\r\n") == 0);
+
+        workers = _server.getStatistics()["backend"]["workers"];
+        REQUIRE(workers["threads"].asInt() == 4);
+        REQUIRE(workers["spawned"].asInt() == 4);
+    }
+
+    // Workers released by closed connections idle out down to min_threads.
+    workers = waitForBackendStatistics(_server, "workers", "threads", 1);
+    REQUIRE(workers["threads"].asInt() == 1);
+    REQUIRE(workers["retired"].asInt() == 3);
+    REQUIRE(waitForBackendStatistics(_server, "workers", "idle", 1)["idle"].asInt() == 1);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-elastic-workers-full-queue") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 3)
+        ("backend.min_threads", 1)
+        ("backend.socket_queue_size", 2)
+        ("backend.thread_spawn_wait_ms", 100)
+    );
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    _server.otherwise([released](const restify::Request &req, restify::Response &rep) {
+        released.wait();
+        rep.setCode(200).setBody("released");
+        return true;
+    });
+    _server.start();
+
+    // One connection is served, two fill the queue and the master waits to queue the last.
+    // Connections close after their response, workers are not held by idle keep-alives.
+    std::vector<std::unique_ptr<RawClient>> clients;
+    for (int i = 0; i < 4; ++i) {
+        clients.emplace_back(new RawClient(8080));
+        REQUIRE(clients.back()->send("GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n"));
+    }
+
+    // The pool grows while all workers are blocked.
+    Json::Value workers = waitForBackendStatistics(_server, "workers", "threads", 3);
+    REQUIRE(workers["threads"].asInt() == 3);
+
+    release.set_value();
+    for (auto &c : clients)
+        REQUIRE(c->readResponse().find("HTTP/1.1 200 OK\r\n") == 0);
+}
+
+#ifdef __linux__
+TEST_CASE_METHOD(ServerFixture, "server-thread-placement") {
+    const std::string cpu = std::to_string(restify::ThreadPlacement::getCurrentThreadCpus().front());
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 2)
+        ("backend.numa", true)
+        ("backend.cpu_affinity", cpu)
+    );
+    requireThreadPlacement(_server, 8080, cpu);
+    REQUIRE(_server.getStatistics()["backend"]["workers"]["max"].asInt() == 2);
+}
+#endif
+
+TEST_CASE_METHOD(ServerFixture, "server-drain") {
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+    );
+    requireDrain(_server, 8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-unix-listener") {
+    const std::string path = "/tmp/cpp-restify-test-" + std::to_string(getpid()) + ".sock";
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080,unix:" + path)
+        ("backend.unix_socket_mode", "0660")
+    );
+    requireUnixListener(_server, 8080, path);
+}
+
+TEST_CASE("server-listener-handoff") {
+    restify::Server first(restify::json()("backend.listening_ports", "127.0.0.1:8080"));
+    restify::Server second;
+    requireListenerHandoff(first, second, 8080);
+}
+#endif
+
+#ifdef CPPRESTIFY_WITH_EPOLL
+/** Run the started server on port out of file descriptors, check it pauses accepting and recovers. */
+static void requireAcceptPause(restify::Server &server, int port) {
+    RawClient a(port);
+    REQUIRE(a.isConnected());
+    REQUIRE(a.send("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+    REQUIRE(a.readResponse().find("HTTP/1.1 200 OK\r\n") == 0);
+
+    // Leave room for the client socket only, descriptors take the lowest free number.
+    rlimit saved;
+    REQUIRE(getrlimit(RLIMIT_NOFILE, &saved) == 0);
+    int highest = 0;
+    for (int fd = 0; fd < 4096; ++fd) {
+        if (fcntl(fd, F_GETFD) != -1)
+            highest = fd;
+    }
+    std::vector<int> fillers;
+    for (int fd = 0; fd < highest; ++fd) {
+        if (fcntl(fd, F_GETFD) == -1)
+            fillers.push_back(dup(0));
+    }
+    rlimit limited = saved;
+    limited.rlim_cur = (rlim_t)highest + 2;
+    REQUIRE(setrlimit(RLIMIT_NOFILE, &limited) == 0);
+
+    RawClient b(port);
+    const bool connected = b.isConnected() && b.send("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    Json::Value accept = waitForBackendStatistics(server, "accept", "pauses", 1);
+
+    // Accepting resumes once descriptors are available again.
+    setrlimit(RLIMIT_NOFILE, &saved);
+    for (int fd : fillers)
+        ::close(fd);
+
+    REQUIRE(connected);
+    REQUIRE(accept["pauses"].asInt() == 1);
+    REQUIRE(b.readResponse().find("HTTP/1.1 200 OK\r\n") == 0);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-epoll-backend") {
+    _server.setBackend(std::make_shared<restify::EpollBackend>());
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 2)
+    );
+    _server.route(
+        restify::json()("path", "/echo")("methods", "POST"),
+        [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody(restify::json()("echo", req.getBody()));
+        return true;
+    });
+    _server.route(
+        restify::json()("path", "/query"),
+        [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody(req.getParam("name"));
+        return true;
+    });
+    _server.start();
+
+    Json::Value response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/echo")
+        ("method", "POST")
+        ("body.value", 3)
+    );
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["statusCode"] == 200);
+    REQUIRE(response["body"]["echo"] == restify::json()("value", 3));
+
+    response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/query?name=a%20b"));
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["statusCode"] == 200);
+    REQUIRE(response["body"] == "a b");
+
+    response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/missing"));
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["statusCode"] == 404);
+
+    _server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    requireKeepAlive(8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-epoll-async-handler") {
+    _server.setBackend(std::make_shared<restify::EpollBackend>());
+    _server.setExecutor(std::make_shared<restify::WorkStealingExecutor>(2));
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 1)
+    );
+    requireAsyncHandlers(_server, 8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-epoll-reuse-port") {
+    _server.setBackend(std::make_shared<restify::EpollBackend>());
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 3)
+        ("backend.reuse_port", true)
+    );
+    _server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    _server.start();
+
+    for (int i = 0; i < 10; ++i) {
+        Json::Value response = restify::Client::invoke(
+            restify::json()
+            ("url", "http://127.0.0.1:8080"));
+
+        REQUIRE(response["success"] == true);
+        REQUIRE(response["body"] == "hello world");
+    }
+
+    requireKeepAlive(8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-epoll-load-shedding") {
+    _server.setBackend(std::make_shared<restify::EpollBackend>());
+    _server.setExecutor(std::make_shared<restify::WorkStealingExecutor>(2));
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 1)
+        ("backend.max_in_flight", 1)
+        ("backend.retry_after", 2)
+    );
+    requireLoadShedding(_server, 8080);
+}
+TEST_CASE_METHOD(ServerFixture, "server-epoll-request-timeouts") {
+    _server.setBackend(std::make_shared<restify::EpollBackend>());
+    _server.setExecutor(std::make_shared<restify::WorkStealingExecutor>(2));
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 1)
+        ("backend.header_timeout_ms", 300)
+    );
+    requireRequestTimeouts(_server, 8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-epoll-accept-pause") {
+    _server.setBackend(std::make_shared<restify::EpollBackend>());
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 1)
+    );
+    _server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    _server.start();
+    requireAcceptPause(_server, 8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-epoll-drain") {
+    // Loops notice draining while handlers run elsewhere.
+    _server.setBackend(std::make_shared<restify::EpollBackend>());
+    _server.setExecutor(std::make_shared<restify::WorkStealingExecutor>(2));
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 2)
+    );
+    requireDrain(_server, 8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-epoll-thread-placement") {
+    const std::string cpu = std::to_string(restify::ThreadPlacement::getCurrentThreadCpus().front());
+    _server.setBackend(std::make_shared<restify::EpollBackend>());
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 2)
+        ("backend.numa", true)
+        ("backend.cpu_affinity", cpu)
+    );
+    requireThreadPlacement(_server, 8080, cpu);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-epoll-unix-listener") {
+    const std::string path = "/tmp/cpp-restify-test-" + std::to_string(getpid()) + ".sock";
+    _server.setBackend(std::make_shared<restify::EpollBackend>());
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080,unix:" + path)
+        ("backend.unix_socket_mode", "0660")
+        ("backend.num_threads", 2)
+    );
+    requireUnixListener(_server, 8080, path);
+}
+
+TEST_CASE("server-epoll-listener-handoff") {
+    restify::Server first;
+    first.setBackend(std::make_shared<restify::EpollBackend>());
+    first.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 2)
+        ("backend.reuse_port", true)
+    );
+
+    restify::Server second;
+    second.setBackend(std::make_shared<restify::EpollBackend>());
+    second.setConfig(
+        restify::json()
+        ("backend.num_threads", 2)
+        ("backend.reuse_port", true)
+    );
+    requireListenerHandoff(first, second, 8080);
+}
+#endif
+
+TEST_CASE("server-backend-type") {
+    restify::Server server;
+    REQUIRE_THROWS_AS(server.setConfig(restify::json()("backend.type", "unknown")), restify::Error);
+    REQUIRE_NOTHROW(server.setConfig(restify::json()("backend.type", "mongoose")));
+}
+
+#ifdef CPPRESTIFY_WITH_URING
+TEST_CASE_METHOD(ServerFixture, "server-uring-backend") {
+    if (!restify::UringBackend::isSupported())
+        return;
+
+    // Options given before the type carry over to the new backend.
+    _server.setConfig(restify::json()("backend.listening_ports", "127.0.0.1:8080"));
+    _server.setConfig(
+        restify::json()
+        ("backend.type", "io_uring")
+        ("backend.num_threads", 2)
+        ("backend.send_buffer_size", 4096)
+    );
+    _server.route(
+        restify::json()("path", "/echo")("methods", "POST"),
+        [](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody(restify::json()("echo", req.getBody()));
+        return true;
+    });
+    _server.route(
+        restify::json()("path", "/large"),
+        [](const restify::Request &req, restify::Response &rep) {
+        // Sent in chunks of whole send buffers and a rest.
+        rep.setCode(200).setBody(std::string(4096 * 5 + 100, 'x'));
+        return true;
+    });
+    _server.start();
+
+    Json::Value response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/echo")
+        ("method", "POST")
+        ("body.value", 3)
+    );
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["statusCode"] == 200);
+    REQUIRE(response["body"]["echo"] == restify::json()("value", 3));
+
+    response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/large"));
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["statusCode"] == 200);
+    REQUIRE(response["body"].asString() == std::string(4096 * 5 + 100, 'x'));
+
+    response = restify::Client::invoke(
+        restify::json()
+        ("url", "http://127.0.0.1:8080/missing"));
+
+    REQUIRE(response["success"] == true);
+    REQUIRE(response["statusCode"] == 404);
+
+    const Json::Value stats = _server.getStatistics()["backend"]["io_uring"];
+    REQUIRE(stats["sends"].asUInt64() >= 8u);
+    if (stats["registeredSendBuffers"].asBool())
+        REQUIRE(stats["zeroCopySends"].asUInt64() >= 5u);
+
+    _server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    requireKeepAlive(8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-uring-async-handler") {
+    if (!restify::UringBackend::isSupported())
+        return;
+
+    _server.setBackend(std::make_shared<restify::UringBackend>());
+    _server.setExecutor(std::make_shared<restify::WorkStealingExecutor>(2));
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 1)
+    );
+    requireAsyncHandlers(_server, 8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-uring-reuse-port") {
+    if (!restify::UringBackend::isSupported())
+        return;
+
+    _server.setBackend(std::make_shared<restify::UringBackend>());
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 3)
+        ("backend.reuse_port", true)
+    );
+    _server.otherwise([](const restify::Request &req, restify::Response &rep) {
+        rep.setCode(200).setBody("hello world");
+        return true;
+    });
+    _server.start();
+
+    for (int i = 0; i < 10; ++i) {
+        Json::Value response = restify::Client::invoke(
+            restify::json()
+            ("url", "http://127.0.0.1:8080"));
+
+        REQUIRE(response["success"] == true);
+        REQUIRE(response["body"] == "hello world");
+    }
+
+    requireKeepAlive(8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-uring-load-shedding") {
+    if (!restify::UringBackend::isSupported())
+        return;
+
+    _server.setBackend(std::make_shared<restify::UringBackend>());
+    _server.setExecutor(std::make_shared<restify::WorkStealingExecutor>(2));
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 1)
+        ("backend.max_in_flight", 1)
+        ("backend.retry_after", 2)
+    );
+    requireLoadShedding(_server, 8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-uring-request-timeouts") {
+    if (!restify::UringBackend::isSupported())
+        return;
+
+    _server.setBackend(std::make_shared<restify::UringBackend>());
+    _server.setExecutor(std::make_shared<restify::WorkStealingExecutor>(2));
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 1)
+        ("backend.header_timeout_ms", 300)
+    );
+    requireRequestTimeouts(_server, 8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-uring-drain") {
+    if (!restify::UringBackend::isSupported())
+        return;
+
+    _server.setBackend(std::make_shared<restify::UringBackend>());
+    _server.setExecutor(std::make_shared<restify::WorkStealingExecutor>(2));
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 2)
+    );
+    requireDrain(_server, 8080);
+}
+
+TEST_CASE_METHOD(ServerFixture, "server-uring-unix-listener") {
+    if (!restify::UringBackend::isSupported())
+        return;
+
+    const std::string path = "/tmp/cpp-restify-test-" + std::to_string(getpid()) + ".sock";
+    _server.setBackend(std::make_shared<restify::UringBackend>());
+    _server.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080,unix:" + path)
+        ("backend.unix_socket_mode", "0660")
+        ("backend.num_threads", 2)
+    );
+    requireUnixListener(_server, 8080, path);
+}
+
+TEST_CASE("server-uring-listener-handoff") {
+    if (!restify::UringBackend::isSupported())
+        return;
+
+    restify::Server first;
+    first.setBackend(std::make_shared<restify::UringBackend>());
+    first.setConfig(
+        restify::json()
+        ("backend.listening_ports", "127.0.0.1:8080")
+        ("backend.num_threads", 2)
+    );
+
+    restify::Server second;
+    second.setBackend(std::make_shared<restify::UringBackend>());
+    second.setConfig(
+        restify::json()
+        ("backend.num_threads", 2)
+    );
+    requireListenerHandoff(first, second, 8080);
+}
+#endif
+
 /*
 TEST_CASE_METHOD(ServerFixture, "server-serve-image") {
     _server.setConfig(
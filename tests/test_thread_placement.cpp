@@ -0,0 +1,66 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/thread_placement.h>
+#include <thread>
+
+TEST_CASE("thread-placement-cpu-list")
+{
+    using restify::ThreadPlacement;
+
+    std::vector<int> cpus;
+    REQUIRE(ThreadPlacement::parseCpuList("0-3,8,10-11", cpus));
+    REQUIRE(cpus == std::vector<int>({ 0, 1, 2, 3, 8, 10, 11 }));
+    REQUIRE(ThreadPlacement::formatCpuList(cpus) == "0-3,8,10-11");
+
+    REQUIRE(ThreadPlacement::parseCpuList("5,1,2,1", cpus));
+    REQUIRE(cpus == std::vector<int>({ 1, 2, 5 }));
+    REQUIRE(ThreadPlacement::formatCpuList(cpus) == "1-2,5");
+
+    REQUIRE(ThreadPlacement::parseCpuList("", cpus));
+    REQUIRE(cpus.empty());
+    REQUIRE(ThreadPlacement::formatCpuList(cpus) == "");
+
+    REQUIRE(!ThreadPlacement::parseCpuList("3-1", cpus));
+    REQUIRE(!ThreadPlacement::parseCpuList("a", cpus));
+    REQUIRE(!ThreadPlacement::parseCpuList("1,", cpus));
+    REQUIRE(!ThreadPlacement::parseCpuList("1-", cpus));
+    REQUIRE(!ThreadPlacement::parseCpuList("-1", cpus));
+}
+
+TEST_CASE("thread-placement-nodes")
+{
+    using restify::ThreadPlacement;
+
+    const std::vector<std::vector<int>> nodes = ThreadPlacement::getNumaNodes();
+    REQUIRE(!nodes.empty());
+    for (const std::vector<int> &cpus : nodes)
+        REQUIRE(!cpus.empty());
+
+#ifdef __linux__
+    // Pinning is per thread, the test thread keeps its CPUs.
+    const std::vector<int> allowed = ThreadPlacement::getCurrentThreadCpus();
+    REQUIRE(!allowed.empty());
+
+    std::vector<int> pinned;
+    bool ok = false;
+    std::thread t([&]() {
+        ok = ThreadPlacement::pinCurrentThread({ allowed.front() }) && ThreadPlacement::useLocalMemory();
+        pinned = ThreadPlacement::getCurrentThreadCpus();
+    });
+    t.join();
+
+    REQUIRE(ok);
+    REQUIRE(pinned == std::vector<int>({ allowed.front() }));
+    REQUIRE(ThreadPlacement::getCurrentThreadCpus() == allowed);
+#endif
+}
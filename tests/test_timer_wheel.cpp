@@ -0,0 +1,129 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/timer_wheel.h>
+#include <restify/request_timeouts.h>
+#include <restify/helpers.h>
+#include <json/json.h>
+#include <memory>
+#include <vector>
+
+TEST_CASE("timer-wheel")
+{
+    using restify::TimerWheel;
+
+    TimerWheel wheel(10, 8, 1000);
+    int a = 1, b = 2, c = 3;
+    TimerWheel::Timer ta(&a), tb(&b), tc(&c);
+
+    std::vector<int> expired;
+    TimerWheel::ExpiryCallback collect = [&expired](TimerWheel::Timer &t) {
+        expired.push_back(*static_cast<int*>(t.getOwner()));
+    };
+
+    REQUIRE(wheel.getWaitTime(1000) == -1);
+
+    SECTION("expire-in-order") {
+        wheel.schedule(ta, 1000, 25);
+        wheel.schedule(tb, 1000, 10);
+        // Further away than a revolution of 80ms.
+        wheel.schedule(tc, 1000, 95);
+        REQUIRE(wheel.size() == 3);
+        REQUIRE(ta.isScheduled());
+        REQUIRE(wheel.getWaitTime(1000) == 10);
+
+        // Never early.
+        REQUIRE(wheel.advance(1009, collect) == 0);
+        REQUIRE(wheel.advance(1010, collect) == 1);
+        REQUIRE(expired == std::vector<int>({ 2 }));
+        REQUIRE_FALSE(tb.isScheduled());
+
+        REQUIRE(wheel.advance(1080, collect) == 1);
+        REQUIRE(expired == std::vector<int>({ 2, 1 }));
+
+        // Visited in its slot once already.
+        REQUIRE(wheel.advance(1090, collect) == 0);
+        REQUIRE(wheel.advance(1100, collect) == 1);
+        REQUIRE(expired == std::vector<int>({ 2, 1, 3 }));
+        REQUIRE(wheel.size() == 0);
+        REQUIRE(wheel.getWaitTime(1100) == -1);
+    }
+
+    SECTION("cancel-and-reschedule") {
+        wheel.schedule(ta, 1000, 20);
+        wheel.schedule(tb, 1000, 20);
+        wheel.cancel(ta);
+        REQUIRE_FALSE(ta.isScheduled());
+        REQUIRE(wheel.size() == 1);
+
+        wheel.schedule(tb, 1000, 50);
+        REQUIRE(wheel.size() == 1);
+        REQUIRE(wheel.advance(1040, collect) == 0);
+        REQUIRE(wheel.advance(1050, collect) == 1);
+    }
+
+    SECTION("long-pause") {
+        wheel.schedule(ta, 1000, 30);
+        wheel.schedule(tb, 1000, 500);
+        REQUIRE(wheel.advance(5000, collect) == 2);
+    }
+
+    SECTION("destroyed-timers") {
+        std::unique_ptr<TimerWheel::Timer> td(new TimerWheel::Timer(&c));
+        wheel.schedule(*td, 1000, 10);
+        td.reset();
+        REQUIRE(wheel.size() == 0);
+
+        // Callbacks may destroy timers expiring along.
+        td.reset(new TimerWheel::Timer(&c));
+        wheel.schedule(ta, 1000, 10);
+        wheel.schedule(*td, 1000, 10);
+        size_t calls = 0;
+        REQUIRE(wheel.advance(1010, [&](TimerWheel::Timer &t) {
+            ++calls;
+            td.reset();
+        }) == 1);
+        REQUIRE(calls == 1);
+        REQUIRE(wheel.size() == 0);
+    }
+
+    SECTION("timers-outliving-wheel") {
+        std::unique_ptr<TimerWheel> w(new TimerWheel(10, 8, 0));
+        w->schedule(ta, 0, 10);
+        w.reset();
+        REQUIRE_FALSE(ta.isScheduled());
+    }
+}
+
+TEST_CASE("request-timeouts")
+{
+    using restify::RequestTimeouts;
+    using restify::RequestPhase;
+
+    RequestTimeouts t = RequestTimeouts::fromConfig(
+        restify::json()
+        ("header_timeout_ms", 100)
+        ("body_timeout_ms", "200")
+        ("write_timeout_ms", 0)
+    );
+    REQUIRE(t.get(RequestPhase::ReadHeader) == 100);
+    REQUIRE(t.get(RequestPhase::ReadBody) == 200);
+    REQUIRE(t.get(RequestPhase::Handler) == 0);
+    REQUIRE(t.get(RequestPhase::WriteResponse) == 0);
+    REQUIRE(t.get(RequestPhase::None) == 0);
+
+    Json::Value config;
+    RequestTimeouts::addDefaultOptions(config);
+    REQUIRE(config["header_timeout_ms"].asInt() == 30000);
+    RequestTimeouts::removeOptions(config);
+    REQUIRE(config.empty());
+}
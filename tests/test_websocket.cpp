@@ -0,0 +1,337 @@
+/**
+This file is part of cpp-restify.
+
+Copyright(C) 2016 Christoph Heindl
+All rights reserved.
+
+This software may be modified and distributed under the terms
+of MIT license. See the LICENSE file for details.
+*/
+
+#include "catch.hpp"
+
+#include <restify/server.h>
+#include <restify/request.h>
+#include <restify/response.h>
+#include <restify/helpers.h>
+#include <restify/websocket.h>
+#include <json/json.h>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+namespace {
+
+    struct WsFrame {
+        int opcode;
+        bool fin;
+        std::string payload;
+    };
+
+    /** Minimal WebSocket client on a blocking socket. */
+    struct WsClient {
+        int s;
+        std::string input;
+
+        WsClient(int port)
+            :s(::socket(AF_INET, SOCK_STREAM, 0))
+        {
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons((uint16_t)port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            timeval tv = { 5, 0 };
+            setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            REQUIRE(::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        }
+
+        ~WsClient() {
+            ::close(s);
+        }
+
+        void sendRaw(const std::string &bytes) {
+            REQUIRE(::send(s, bytes.data(), bytes.size(), 0) == (ssize_t)bytes.size());
+        }
+
+        /** Read until the end of the response head, return head and keep what follows. */
+        std::string readHead() {
+            size_t end;
+            while ((end = input.find("\r\n\r\n")) == std::string::npos) {
+                if (!fill())
+                    return input;
+            }
+            std::string head = input.substr(0, end + 4);
+            input.erase(0, end + 4);
+            return head;
+        }
+
+        std::string upgrade(const std::string &path) {
+            sendRaw("GET " + path + " HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+            return readHead();
+        }
+
+        bool fill() {
+            char buffer[4096];
+            const ssize_t n = ::recv(s, buffer, sizeof(buffer), 0);
+            if (n <= 0)
+                return false;
+            input.append(buffer, (size_t)n);
+            return true;
+        }
+
+        /** Send masked frame as clients do. */
+        void sendFrame(int opcode, const std::string &payload, bool fin = true) {
+            std::string f;
+            f.push_back((char)((fin ? 0x80 : 0) | opcode));
+            if (payload.size() < 126) {
+                f.push_back((char)(0x80 | payload.size()));
+            } else {
+                f.push_back((char)(0x80 | 126));
+                f.push_back((char)(payload.size() >> 8));
+                f.push_back((char)payload.size());
+            }
+            const char mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+            f.append(mask, 4);
+            for (size_t i = 0; i < payload.size(); ++i)
+                f.push_back(payload[i] ^ mask[i % 4]);
+            sendRaw(f);
+        }
+
+        /** Receive next frame, opcode -1 when the connection closed. */
+        WsFrame receiveFrame() {
+            WsFrame f = { -1, true, std::string() };
+            for (;;) {
+                if (input.size() >= 2) {
+                    size_t length = (uint8_t)input[1] & 0x7f;
+                    size_t header = 2;
+                    if (length == 126 && input.size() >= 4) {
+                        length = ((size_t)(uint8_t)input[2] << 8) | (uint8_t)input[3];
+                        header = 4;
+                    }
+                    if (length < 126 || header == 4) {
+                        if (input.size() >= header + length) {
+                            f.opcode = input[0] & 0x0f;
+                            f.fin = (input[0] & 0x80) != 0;
+                            f.payload = input.substr(header, length);
+                            input.erase(0, header + length);
+                            return f;
+                        }
+                    }
+                }
+                if (!fill())
+                    return f;
+            }
+        }
+    };
+
+    std::string closePayload(int code) {
+        return std::string(1, (char)(code >> 8)) + std::string(1, (char)(code & 0xff));
+    }
+
+    int closeCode(const WsFrame &f) {
+        return f.payload.size() >= 2 ? (((uint8_t)f.payload[0] << 8) | (uint8_t)f.payload[1]) : -1;
+    }
+
+    /** Sockets of a route as seen by its handlers. */
+    struct Sockets {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<restify::WebSocket>> open;
+        int closed;
+
+        Sockets()
+            :closed(0)
+        {}
+
+        std::shared_ptr<restify::WebSocket> last() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return open.empty() ? nullptr : open.back();
+        }
+
+        size_t openCount() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return open.size();
+        }
+
+        int closedCount() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return closed;
+        }
+    };
+
+    void startServer(restify::Server &server, Sockets &sockets, int port, int maxMessageSize = 1024 * 1024) {
+        server.setConfig(restify::json()
+            ("backend.listening_ports", "127.0.0.1:" + std::to_string(port))
+            ("backend.num_threads", 4)
+            ("backend.websocket_max_message_size", maxMessageSize));
+
+        restify::WebSocketHandlers h;
+        h.onAccept = [](const restify::Request &req) {
+            return req.getParam("room").asString() != "private";
+        };
+        h.onOpen = [&sockets](const std::shared_ptr<restify::WebSocket> &ws) {
+            {
+                std::lock_guard<std::mutex> lock(sockets.mutex);
+                sockets.open.push_back(ws);
+            }
+            ws->send("welcome " + ws->getRequest().getParam("room").asString());
+        };
+        h.onMessage = [](const std::shared_ptr<restify::WebSocket> &ws, const std::string &message, bool binary) {
+            if (message == "fail")
+                throw std::runtime_error("fail");
+            ws->send(message, binary);
+        };
+        h.onClose = [&sockets](const std::shared_ptr<restify::WebSocket> &ws) {
+            std::lock_guard<std::mutex> lock(sockets.mutex);
+            ++sockets.closed;
+        };
+
+        server.websocket(restify::json()("path", "/rooms/:room"), h);
+        server.route(restify::json()("path", "/hello"), [](const restify::Request &req, restify::Response &rep) {
+            rep.setCode(200).setBody("hello world");
+            return true;
+        });
+        server.start();
+    }
+
+    template<class Pred>
+    bool waitFor(Pred pred) {
+        for (int i = 0; i < 500 && !pred(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return pred();
+    }
+}
+
+TEST_CASE("websocket-messages")
+{
+    // Handlers refer to sockets until the server is stopped.
+    Sockets sockets;
+    restify::Server server;
+    startServer(server, sockets, 8095);
+
+    WsClient c(8095);
+    const std::string head = c.upgrade("/rooms/lobby");
+    REQUIRE(head.find("HTTP/1.1 101 Switching Protocols\r\n") == 0);
+    // RFC 6455 1.3
+    REQUIRE(head.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") != std::string::npos);
+
+    WsFrame f = c.receiveFrame();
+    REQUIRE(f.opcode == 0x1);
+    REQUIRE(f.payload == "welcome lobby");
+
+    c.sendFrame(0x1, "hi");
+    f = c.receiveFrame();
+    REQUIRE(f.opcode == 0x1);
+    REQUIRE(f.payload == "hi");
+
+    // Fragments are joined, control frames may arrive in between.
+    c.sendFrame(0x2, "bin", false);
+    c.sendFrame(0x9, "ping");
+    c.sendFrame(0x0, std::string(300, 'x'));
+    f = c.receiveFrame();
+    REQUIRE(f.opcode == 0xa);
+    REQUIRE(f.payload == "ping");
+    f = c.receiveFrame();
+    REQUIRE(f.opcode == 0x2);
+    REQUIRE(f.payload == "bin" + std::string(300, 'x'));
+
+    // Messages are pushed from other threads.
+    std::shared_ptr<restify::WebSocket> ws = sockets.last();
+    REQUIRE(ws);
+    REQUIRE(ws->isOpen());
+    std::thread([ws]() { ws->send("pushed"); }).join();
+    f = c.receiveFrame();
+    REQUIRE(f.payload == "pushed");
+    REQUIRE(server.getStatistics()["backend"]["websockets"].asInt() == 1);
+
+    // Closing handshake started by the client.
+    c.sendFrame(0x8, closePayload(1000));
+    f = c.receiveFrame();
+    REQUIRE(f.opcode == 0x8);
+    REQUIRE(closeCode(f) == 1000);
+    REQUIRE(c.receiveFrame().opcode == -1);
+    REQUIRE(waitFor([&sockets]() { return sockets.closedCount() == 1; }));
+    REQUIRE(!ws->isOpen());
+    REQUIRE(!ws->send("gone"));
+    REQUIRE(server.getStatistics()["backend"]["websockets"].asInt() == 0);
+
+    // Handlers failing close the socket with 1011.
+    WsClient failing(8095);
+    REQUIRE(failing.upgrade("/rooms/a").find("HTTP/1.1 101 ") == 0);
+    failing.receiveFrame();
+    failing.sendFrame(0x1, "fail");
+    f = failing.receiveFrame();
+    REQUIRE(f.opcode == 0x8);
+    REQUIRE(closeCode(f) == 1011);
+
+    server.stop();
+}
+
+TEST_CASE("websocket-routing")
+{
+    // Handlers refer to sockets until the server is stopped.
+    Sockets sockets;
+    restify::Server server;
+    startServer(server, sockets, 8096, 64);
+
+    // Plain requests to the endpoint are asked to upgrade.
+    WsClient plain(8096);
+    plain.sendRaw("GET /rooms/lobby HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    std::string head = plain.readHead();
+    REQUIRE(head.find("HTTP/1.1 426 ") == 0);
+    REQUIRE(head.find("Upgrade: websocket\r\n") != std::string::npos);
+
+    // Rejected upgrades, missing endpoints and upgrades to plain routes.
+    WsClient rejected(8096);
+    REQUIRE(rejected.upgrade("/rooms/private").find("HTTP/1.1 403 ") == 0);
+    WsClient missing(8096);
+    REQUIRE(missing.upgrade("/nowhere").find("HTTP/1.1 404 ") == 0);
+    WsClient ignored(8096);
+    REQUIRE(ignored.upgrade("/hello").find("HTTP/1.1 200 ") == 0);
+
+    // Messages beyond websocket_max_message_size close the socket with 1009.
+    WsClient big(8096);
+    REQUIRE(big.upgrade("/rooms/big").find("HTTP/1.1 101 ") == 0);
+    big.receiveFrame();
+    big.sendFrame(0x1, std::string(65, 'x'));
+    WsFrame f = big.receiveFrame();
+    REQUIRE(f.opcode == 0x8);
+    REQUIRE(closeCode(f) == 1009);
+
+    // Closing handshake started by the server.
+    WsClient c(8096);
+    REQUIRE(c.upgrade("/rooms/lobby").find("HTTP/1.1 101 ") == 0);
+    c.receiveFrame();
+    REQUIRE(waitFor([&sockets]() { return sockets.openCount() == 2; }));
+    std::shared_ptr<restify::WebSocket> ws = sockets.last();
+    REQUIRE(ws->close(4000));
+    REQUIRE(!ws->isOpen());
+    REQUIRE(!ws->close());
+    f = c.receiveFrame();
+    REQUIRE(f.opcode == 0x8);
+    REQUIRE(closeCode(f) == 4000);
+    c.sendFrame(0x8, closePayload(4000));
+    REQUIRE(c.receiveFrame().opcode == -1);
+
+    // Stopping closes remaining sockets with 1001 without waiting for request_timeout_ms.
+    WsClient idle(8096);
+    REQUIRE(idle.upgrade("/rooms/idle").find("HTTP/1.1 101 ") == 0);
+    idle.receiveFrame();
+    REQUIRE(waitFor([&sockets]() { return sockets.openCount() == 3; }));
+
+    const auto start = std::chrono::steady_clock::now();
+    server.stop();
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+    f = idle.receiveFrame();
+    REQUIRE(f.opcode == 0x8);
+    REQUIRE(closeCode(f) == 1001);
+    REQUIRE(sockets.closedCount() == 3);
+}
+
+#endif